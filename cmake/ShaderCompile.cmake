@@ -44,6 +44,8 @@ function(compile_shaders TARGET SHADER_DIR OUTPUT_DIR)
         set(SPV_FILE "${OUTPUT_DIR}/${REL_PATH}.spv")
         get_filename_component(SPV_DIR ${SPV_FILE} DIRECTORY)
 
+        # glslc writes the #include files it read to a depfile, so editing one of
+        # shaders/common recompiles every shader that pulls it in
         add_custom_command(
             OUTPUT ${SPV_FILE}
             COMMAND ${CMAKE_COMMAND} -E make_directory ${SPV_DIR}
@@ -51,8 +53,10 @@ function(compile_shaders TARGET SHADER_DIR OUTPUT_DIR)
                 -I ${SHADER_DIR}/common
                 --target-env=vulkan1.3
                 -O
+                -MD -MF ${SPV_FILE}.d
                 ${SHADER} -o ${SPV_FILE}
             DEPENDS ${SHADER}
+            DEPFILE ${SPV_FILE}.d
             COMMENT "Compiling shader: ${REL_PATH}"
         )
         list(APPEND SPV_FILES ${SPV_FILE})
@@ -60,4 +64,6 @@ function(compile_shaders TARGET SHADER_DIR OUTPUT_DIR)
 
     add_custom_target(${TARGET}_shaders DEPENDS ${SPV_FILES})
     add_dependencies(${TARGET} ${TARGET}_shaders)
+    # For steps that consume the compiled shaders (the asset pack)
+    set(${TARGET}_SHADER_OUTPUTS ${SPV_FILES} PARENT_SCOPE)
 endfunction()
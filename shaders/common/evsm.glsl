@@ -0,0 +1,43 @@
+// Exponential variance shadow maps (Lauritzen & McCool 2008). Depth is warped by a
+// positive and a negative exponential; the filtered moments of both bound the fraction
+// of occluders in front of a receiver. Shared by evsm_resolve.comp and lighting.frag.
+
+#ifndef EVSM_GLSL
+#define EVSM_GLSL
+
+// Largest exponents whose squares still fit RGBA32F moments
+const float EVSM_POSITIVE_EXPONENT = 40.0;
+const float EVSM_NEGATIVE_EXPONENT = 5.0;
+// Variance floor, in depth units before warping
+const float EVSM_DEPTH_EPSILON = 1e-4;
+// Visibility below this is clamped to 0 to hide light bleeding between overlapping occluders
+const float EVSM_LIGHT_BLEED_REDUCTION = 0.2;
+
+vec2 evsmWarp(float depth) {
+    depth = 2.0 * clamp(depth, 0.0, 1.0) - 1.0;
+    return vec2(exp(EVSM_POSITIVE_EXPONENT * depth), -exp(-EVSM_NEGATIVE_EXPONENT * depth));
+}
+
+vec4 evsmMoments(float depth) {
+    vec2 w = evsmWarp(depth);
+    return vec4(w.x, w.x * w.x, w.y, w.y * w.y);
+}
+
+float chebyshevUpperBound(vec2 moments, float t, float minVariance) {
+    if (t <= moments.x) return 1.0;
+    float variance = max(moments.y - moments.x * moments.x, minVariance);
+    float d = t - moments.x;
+    return variance / (variance + d * d);
+}
+
+float evsmVisibility(vec4 moments, float depth) {
+    vec2 w = evsmWarp(depth);
+    // d(warp)/d(depth) scales the floor into each warped space
+    vec2 slope = vec2(EVSM_POSITIVE_EXPONENT, EVSM_NEGATIVE_EXPONENT) * abs(w) * EVSM_DEPTH_EPSILON;
+    float pPositive = chebyshevUpperBound(moments.xy, w.x, slope.x * slope.x);
+    float pNegative = chebyshevUpperBound(moments.zw, w.y, slope.y * slope.y);
+    float p = min(pPositive, pNegative);
+    return clamp((p - EVSM_LIGHT_BLEED_REDUCTION) / (1.0 - EVSM_LIGHT_BLEED_REDUCTION), 0.0, 1.0);
+}
+
+#endif // EVSM_GLSL
@@ -0,0 +1,68 @@
+// G-buffer fill shared by gbuffer.frag and gbuffer_no_feedback.frag, which differ only in
+// whether virtual texture lookups write feedback (VT_NO_FEEDBACK)
+
+#ifndef GBUFFER_FRAG_GLSL
+#define GBUFFER_FRAG_GLSL
+
+#include "virtual_texture.glsl"
+
+#ifndef VT_NO_FEEDBACK
+// Virtual texture feedback is a storage write; keep depth testing ahead of the shader
+layout(early_fragment_tests) in;
+#endif
+
+layout(set = 2, binding = 0) uniform sampler2D albedoMap;
+layout(set = 2, binding = 1) uniform sampler2D normalMap;
+layout(set = 2, binding = 2) uniform sampler2D metalRoughMap;
+layout(set = 2, binding = 3) uniform MaterialUBO {
+    vec4 albedoColor;
+    float metallic;
+    float roughness;
+    float normalScale;
+    int virtualTexture;  // -1: albedo comes from albedoMap
+};
+
+layout(location = 0) in vec3 fragWorldPos;
+layout(location = 1) in vec3 fragNormal;
+layout(location = 2) in vec2 fragUV;
+layout(location = 3) in vec3 fragTangent;
+layout(location = 4) in vec3 fragBitangent;
+
+layout(location = 0) out vec4 outAlbedoMetallic;    // RT0: RGB=albedo, A=metallic
+layout(location = 1) out vec4 outNormalRoughness;    // RT1: RGB=world normal, A=roughness
+
+void main() {
+    // Sample textures
+    vec4 albedoSample = virtualTexture >= 0 ? sampleVirtualTexture(uint(virtualTexture), fragUV)
+                                            : texture(albedoMap, fragUV);
+    vec3 albedo = albedoSample.rgb * albedoColor.rgb;
+
+    vec4 mrSample = texture(metalRoughMap, fragUV);
+    float finalMetallic = mrSample.b * metallic;
+    float finalRoughness = mrSample.g * roughness;
+
+    // Normal mapping
+    vec3 N = normalize(fragNormal);
+    vec3 T = normalize(fragTangent);
+    vec3 B = normalize(fragBitangent);
+    mat3 TBN = mat3(T, B, N);
+
+    // Only XY is read: cooked normal maps are two-channel (BC5 / RG8), Z is rebuilt
+    vec2 normalXY = texture(normalMap, fragUV).xy * 2.0 - 1.0;
+    vec3 tangentNormal = vec3(normalXY * normalScale, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)));
+    tangentNormal = normalize(tangentNormal);
+    vec3 worldNormal = normalize(TBN * tangentNormal);
+
+    // Specular AA: adjust roughness based on normal map frequency
+    vec3 dNdx = dFdx(worldNormal);
+    vec3 dNdy = dFdy(worldNormal);
+    float normalVariance = dot(dNdx, dNdx) + dot(dNdy, dNdy);
+    finalRoughness = sqrt(finalRoughness * finalRoughness + normalVariance * 0.18);
+    finalRoughness = min(finalRoughness, 1.0);
+
+    // Pack G-buffer
+    outAlbedoMetallic = vec4(albedo, finalMetallic);
+    outNormalRoughness = vec4(worldNormal * 0.5 + 0.5, finalRoughness);
+}
+
+#endif
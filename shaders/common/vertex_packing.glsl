@@ -0,0 +1,41 @@
+// Decoders for the packed vertex layouts (see src/assets/VertexFormat.h).
+// Keep in sync with VertexPacking::packTangentFrame / tangentBasis on the CPU side.
+
+#ifndef VERTEX_PACKING_GLSL
+#define VERTEX_PACKING_GLSL
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+// Duff et al. 2017 branchless orthonormal basis
+void tangentBasis(vec3 n, out vec3 b1, out vec3 b2) {
+    float s = n.z >= 0.0 ? 1.0 : -1.0;
+    float a = -1.0 / (s + n.z);
+    float b = n.x * n.y * a;
+    b1 = vec3(1.0 + s * n.x * n.x * a, s * b, -s * n.x);
+    b2 = vec3(b, s + n.y * n.y * a, -n.y);
+}
+
+// bits 0..9 / 10..19 = octahedral normal, 20..30 = tangent angle, 31 = bitangent sign
+void unpackTangentFrame(uint packed, out vec3 normal, out vec4 tangent) {
+    vec2 oct = vec2(packed & 0x3FFu, (packed >> 10) & 0x3FFu) / 1023.0 * 2.0 - 1.0;
+    normal = octDecode(oct);
+
+    vec3 b1, b2;
+    tangentBasis(normal, b1, b2);
+    float angle = float((packed >> 20) & 0x7FFu) * (6.28318530718 / 2048.0);
+    tangent.xyz = b1 * cos(angle) + b2 * sin(angle);
+    tangent.w = (packed & 0x80000000u) != 0u ? -1.0 : 1.0;
+}
+
+// UNORM16 positions are relative to the mesh AABB; float positions use scale 1 / offset 0
+vec3 dequantizePosition(vec4 encoded, vec4 scale, vec4 offset) {
+    return offset.xyz + encoded.xyz * scale.xyz;
+}
+
+#endif
@@ -0,0 +1,64 @@
+// Software virtual texturing lookup (VirtualTextureSystem). Set 1 of the G-buffer pass:
+// the physical page cache, the per-texture indirection tables (one array layer each, one
+// texel per page and mip: cache slot xy, mip of the page actually resident there) and a
+// feedback buffer receiving the page each sampled pixel wanted, one pixel per
+// VT_FEEDBACK_SCALE^2 cell per frame.
+
+#ifndef VIRTUAL_TEXTURE_GLSL
+#define VIRTUAL_TEXTURE_GLSL
+
+// Must match VirtualTextureSystem
+const uint VT_PAGE_SIZE = 128;
+const uint VT_PAGE_BORDER = 4;
+const uint VT_PAGE_PAYLOAD = VT_PAGE_SIZE - 2 * VT_PAGE_BORDER;
+const uint VT_MAX_TEXTURES = 8;
+const uint VT_FEEDBACK_SCALE = 16;
+
+layout(set = 1, binding = 0) uniform sampler2D vtCache;
+layout(set = 1, binding = 1) uniform usampler2DArray vtIndirection;
+layout(set = 1, binding = 2) uniform VirtualTextureParams {
+    uvec4 vtTextures[VT_MAX_TEXTURES];  // x = pages per side, y = mip count
+    uvec4 vtFeedback;                   // xy = feedback cells, zw = pixel of a cell that writes
+    vec4 vtCacheParams;                 // x = 1 / cache texels per side, y = LOD bias
+};
+// Without fragmentStoresAndAtomics every storage buffer of a fragment shader must be
+// NonWritable, so that variant declares it readonly and writes nothing
+#ifdef VT_NO_FEEDBACK
+layout(set = 1, binding = 3) readonly buffer VirtualTextureFeedback {
+#else
+layout(set = 1, binding = 3) writeonly buffer VirtualTextureFeedback {
+#endif
+    uint vtFeedbackPages[];  // x | y << 12 | mip << 24 | texture << 28, ~0 = none
+};
+
+vec4 sampleVirtualTexture(uint vt, vec2 uv) {
+    uint pages = vtTextures[vt].x;
+    uint mipCount = vtTextures[vt].y;
+
+    // LOD from the virtual texel footprint, before wrapping so tile seams keep their derivatives
+    vec2 texels = uv * float(pages * VT_PAGE_PAYLOAD);
+    vec2 dx = dFdx(texels);
+    vec2 dy = dFdy(texels);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + vtCacheParams.y;
+    uint mip = uint(clamp(floor(lod), 0.0, float(mipCount - 1)));
+
+    vec2 wrapped = fract(uv);
+    uint side = pages >> mip;
+    uvec2 page = min(uvec2(wrapped * float(side)), uvec2(side - 1));
+
+#ifndef VT_NO_FEEDBACK
+    uvec2 pixel = uvec2(gl_FragCoord.xy);
+    if (all(equal(pixel % VT_FEEDBACK_SCALE, vtFeedback.zw))) {
+        uvec2 cell = pixel / VT_FEEDBACK_SCALE;
+        vtFeedbackPages[cell.y * vtFeedback.x + cell.x] = page.x | (page.y << 12) | (mip << 24) | (vt << 28);
+    }
+#endif
+
+    // The entry names the page that covers this one: itself or its nearest resident ancestor
+    uvec4 entry = texelFetch(vtIndirection, ivec3(page, vt), int(mip));
+    vec2 inPage = fract(wrapped * float(pages >> entry.z));
+    vec2 cacheTexel = vec2(entry.xy * VT_PAGE_SIZE) + float(VT_PAGE_BORDER) + inPage * float(VT_PAGE_PAYLOAD);
+    return textureLod(vtCache, cacheTexel * vtCacheParams.x, 0.0);
+}
+
+#endif
@@ -14,7 +14,7 @@ layout(set = 0, binding = 0) uniform GlobalUBO {
     vec4 dirLightDir;
     vec4 dirLightColor;
     vec4 resolution;
-    mat4 cascadeViewProj[3];
+    mat4 cascadeViewProj[4];
     vec4 cascadeSplits;
     float iblIntensity;
     float ssaoRadius;
@@ -0,0 +1,7 @@
+#version 460
+
+// Fallback for gbuffer.frag on devices without fragmentStoresAndAtomics: the feedback
+// buffer is declared read-only and never written. Virtual texturing is off there, so no
+// material samples a virtual texture through this shader.
+#define VT_NO_FEEDBACK
+#include "gbuffer_frag.glsl"
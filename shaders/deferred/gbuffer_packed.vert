@@ -0,0 +1,60 @@
+#version 460
+
+#include "vertex_packing.glsl"
+
+layout(set = 0, binding = 0) uniform GlobalUBO {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    mat4 invViewProj;
+    mat4 prevViewProj;
+    vec4 cameraPos;
+    float time;
+    uint pointLightCount;
+    float jitterX;
+    float jitterY;
+    vec4 dirLightDir;
+    vec4 dirLightColor;
+    vec4 resolution;
+    mat4 cascadeViewProj[4];
+    vec4 cascadeSplits;
+    float iblIntensity;
+    float ssaoRadius;
+    float ssaoBias;
+    float bloomIntensity;
+};
+
+// Same push block as gbuffer.vert plus the mesh dequantization constants
+layout(push_constant) uniform PushConstants {
+    mat4 model;
+    vec4 positionScale;
+    vec4 positionOffset;
+};
+
+// Packed / PackedFloatPosition layouts (16 or 20 bytes per vertex)
+layout(location = 0) in vec4 inPosition;
+layout(location = 1) in uint inTangentFrame;
+layout(location = 2) in vec2 inUV;
+
+layout(location = 0) out vec3 fragWorldPos;
+layout(location = 1) out vec3 fragNormal;
+layout(location = 2) out vec2 fragUV;
+layout(location = 3) out vec3 fragTangent;
+layout(location = 4) out vec3 fragBitangent;
+
+void main() {
+    vec3 position = dequantizePosition(inPosition, positionScale, positionOffset);
+    vec3 normal;
+    vec4 tangent;
+    unpackTangentFrame(inTangentFrame, normal, tangent);
+
+    vec4 worldPos = model * vec4(position, 1.0);
+    gl_Position = viewProj * worldPos;
+
+    mat3 normalMat = mat3(model);
+    fragWorldPos = worldPos.xyz;
+    fragNormal = normalize(normalMat * normal);
+    fragTangent = normalize(normalMat * tangent.xyz);
+    fragBitangent = cross(fragNormal, fragTangent) * tangent.w;
+    fragUV = inUV;
+}
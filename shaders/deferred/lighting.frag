@@ -1,8 +1,42 @@
 #version 460
 
+#include "evsm.glsl"
+
+// Must match Engine::CLUSTER_GRID_* (src/core/Engine.h)
+const uint CLUSTER_GRID_X = 16;
+const uint CLUSTER_GRID_Y = 9;
+const uint CLUSTER_GRID_Z = 24;
+
+// Must match tile_classify.comp
+const uint TILE_CLASS_SKY = 0;
+const uint TILE_CLASS_UNLIT = 1;
+const uint TILE_CLASS_SIMPLE = 2;
+const uint TILE_CLASS_COMPLEX = 3;
+
+// Variant of this pipeline, see Engine::initLightingPass. SKY only shades the sky; UNLIT
+// drops the point light loop; SIMPLE evaluates point lights diffuse-only and reads the
+// irradiance map for specular IBL; COMPLEX is the full path.
+layout(constant_id = 0) const uint TILE_CLASS = TILE_CLASS_COMPLEX;
+
+// Must match Engine::MAX_SHADOW_CASCADES (src/core/Engine.h)
+const int MAX_SHADOW_CASCADES = 4;
+
+// Must match Engine::LOCAL_SHADOW_FACES (src/core/Engine.h)
+const uint LOCAL_SHADOW_FACES = 6;
+const uint NO_LOCAL_SHADOW = 0xFFFFFFFFu;
+
+// Must match Engine::ShadowFilter (src/core/Engine.h)
+const uint SHADOW_FILTER_PCF = 0;
+const uint SHADOW_FILTER_EVSM = 1;
+
 struct GPUPointLight {
     vec4 positionAndRange;   // xyz = position, w = range
     vec4 colorAndIntensity;  // xyz = color, w = intensity
+    vec4 spotDirAndCosOuter; // xyz = spot direction, w = cos(outer angle), -1 for point lights
+    float spotCosInner;
+    uint shadowSlot;         // LOCAL_SHADOW_FACES views from slot * LOCAL_SHADOW_FACES, ~0u = unshadowed
+    uint padding0;
+    uint padding1;
 };
 
 layout(set = 0, binding = 0) uniform GlobalUBO {
@@ -19,12 +53,15 @@ layout(set = 0, binding = 0) uniform GlobalUBO {
     vec4 dirLightDir;
     vec4 dirLightColor;
     vec4 resolution;
-    mat4 cascadeViewProj[3];
-    vec4 cascadeSplits; // xyz = split depths (view-space), w = shadow bias
+    mat4 cascadeViewProj[MAX_SHADOW_CASCADES];
+    vec4 cascadeSplits; // xyz = far depth (view-space) of cascades 0..2, w = shadow bias
     float iblIntensity;
     float ssaoRadius;
     float ssaoBias;
     float bloomIntensity;
+    vec4 clusterParams; // x = slice scale, y = slice bias, z = near, w = far
+    vec4 cascadeAtlasRects[MAX_SHADOW_CASCADES]; // xy = offset, zw = size in shadow atlas UV
+    uint cascadeCount;
 };
 
 layout(set = 0, binding = 1) readonly buffer PointLightSSBO {
@@ -34,14 +71,40 @@ layout(set = 0, binding = 1) readonly buffer PointLightSSBO {
 layout(set = 0, binding = 2) uniform sampler2D gAlbedoMetallic;
 layout(set = 0, binding = 3) uniform sampler2D gNormalRoughness;
 layout(set = 0, binding = 4) uniform sampler2D gDepth;
-layout(set = 0, binding = 5) uniform sampler2DArrayShadow shadowMap;
+layout(set = 0, binding = 5) uniform sampler2DShadow shadowMap; // all cascades, see cascadeAtlasRects
 layout(set = 0, binding = 6) uniform samplerCube irradianceMap;
 layout(set = 0, binding = 7) uniform samplerCube prefilteredMap;
 layout(set = 0, binding = 8) uniform sampler2D brdfLUT;
 layout(set = 0, binding = 9) uniform sampler2D ssaoTex;
 
+// Per-froxel light lists built by light_cluster.comp
+layout(set = 0, binding = 10) readonly buffer ClusterGrid {
+    uvec2 clusters[]; // x = first entry in lightIndices, y = light count
+};
+layout(set = 0, binding = 11) readonly buffer ClusterLightIndices {
+    uint lightIndexCount;
+    uint lightIndices[];
+};
+
+layout(set = 0, binding = 13) uniform samplerCube envMap;
+
+// Prefiltered EVSM moments per cascade, written by evsm_resolve/blur/downsample.comp
+layout(set = 0, binding = 15) uniform sampler2DArray shadowMoments;
+
+// Shadowed point and spot lights: every view (cube face or spot frustum) is a square tile
+// of one depth atlas. Must match Engine::GPULocalShadowView.
+struct LocalShadowView {
+    mat4 viewProj;
+    vec4 atlasRect; // xy = offset, zw = size in atlas UV
+};
+layout(set = 0, binding = 17) uniform sampler2DShadow localShadowAtlas;
+layout(set = 0, binding = 18) readonly buffer LocalShadowViews {
+    LocalShadowView localShadowViews[];
+};
+
 layout(push_constant) uniform LightingPC {
     uint debugMode;
+    uint shadowFilter;
 };
 
 layout(location = 0) in vec2 fragUV;
@@ -127,7 +190,7 @@ const vec2 poissonDisk[16] = vec2[](
     vec2( 0.1998,  0.7864), vec2( 0.1438, -0.1410)
 );
 
-float sampleShadowCascade(vec3 worldPos, int cascadeIdx) {
+float sampleShadowCascadePCF(vec3 worldPos, int cascadeIdx) {
     vec4 shadowCoord = cascadeViewProj[cascadeIdx] * vec4(worldPos, 1.0);
     shadowCoord.xyz /= shadowCoord.w;
     vec2 shadowUV = shadowCoord.xy * 0.5 + 0.5;
@@ -137,7 +200,8 @@ float sampleShadowCascade(vec3 worldPos, int cascadeIdx) {
     }
 
     float compareDepth = shadowCoord.z;
-    float texelSize = 1.0 / float(textureSize(shadowMap, 0).x);
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0));
+    vec4 rect = cascadeAtlasRects[cascadeIdx];
 
     // Per-pixel rotation angle from interleaved gradient noise
     float angle = interleavedGradientNoise(gl_FragCoord.xy) * 6.283185;
@@ -146,30 +210,67 @@ float sampleShadowCascade(vec3 worldPos, int cascadeIdx) {
     mat2 rotation = mat2(ca, sa, -sa, ca);
 
     // Spread radius: larger for far cascades (maintains consistent penumbra in world space)
-    float spread = texelSize * (1.5 + float(cascadeIdx) * 0.5);
+    vec2 spread = texelSize * (1.5 + float(cascadeIdx) * 0.5);
+
+    // Taps stay inside the cascade's region so they never compare against a neighbour
+    vec2 atlasUV = rect.xy + shadowUV * rect.zw;
+    vec2 uvMin = rect.xy + texelSize * 0.5;
+    vec2 uvMax = rect.xy + rect.zw - texelSize * 0.5;
 
     float shadow = 0.0;
     for (int i = 0; i < 16; i++) {
         vec2 offset = rotation * poissonDisk[i] * spread;
-        shadow += texture(shadowMap, vec4(shadowUV + offset, float(cascadeIdx), compareDepth));
+        shadow += texture(shadowMap, vec3(clamp(atlasUV + offset, uvMin, uvMax), compareDepth));
     }
     return shadow / 16.0;
 }
 
-float sampleShadowPCF(vec3 worldPos, float viewZ) {
+// One filtered tap of the prefiltered moments. The mip is chosen analytically from the
+// world size of a screen pixel vs. a moment texel, since deferred pixels have no
+// reliable derivatives.
+float sampleShadowCascadeEVSM(vec3 worldPos, int cascadeIdx, float viewZ) {
+    mat4 lightViewProj = cascadeViewProj[cascadeIdx];
+    vec4 shadowCoord = lightViewProj * vec4(worldPos, 1.0);
+    shadowCoord.xyz /= shadowCoord.w;
+    vec2 shadowUV = shadowCoord.xy * 0.5 + 0.5;
+
+    if (any(lessThan(shadowUV, vec2(0.0))) || any(greaterThan(shadowUV, vec2(1.0)))) {
+        return 1.0;
+    }
+
+    float pixelWorld = 2.0 * viewZ / (proj[1][1] * resolution.y);
+    float cascadeScale = length(vec3(lightViewProj[0][0], lightViewProj[1][0], lightViewProj[2][0]));
+    float texelWorld = 2.0 / (cascadeScale * float(textureSize(shadowMoments, 0).x));
+    float lod = max(log2(pixelWorld / texelWorld), 0.0);
+
+    vec4 moments = textureLod(shadowMoments, vec3(shadowUV, float(cascadeIdx)), lod);
+    return evsmVisibility(moments, shadowCoord.z);
+}
+
+float sampleShadowCascade(vec3 worldPos, int cascadeIdx, float viewZ) {
+    if (shadowFilter == SHADOW_FILTER_EVSM)
+        return sampleShadowCascadeEVSM(worldPos, cascadeIdx, viewZ);
+    return sampleShadowCascadePCF(worldPos, cascadeIdx);
+}
+
+int cascadeIndex(float viewZ) {
     int cascadeIdx = 0;
-    if (viewZ > cascadeSplits.x) cascadeIdx = 1;
-    if (viewZ > cascadeSplits.y) cascadeIdx = 2;
+    for (int i = 0; i < int(cascadeCount) - 1; i++)
+        if (viewZ > cascadeSplits[i]) cascadeIdx = i + 1;
+    return cascadeIdx;
+}
 
-    float shadow = sampleShadowCascade(worldPos, cascadeIdx);
+float sampleShadow(vec3 worldPos, float viewZ) {
+    int cascadeIdx = cascadeIndex(viewZ);
+    float shadow = sampleShadowCascade(worldPos, cascadeIdx, viewZ);
 
     // Blend between cascades at boundaries for smooth transitions
     float blendRange = 0.1; // 10% of cascade range as blend zone
-    if (cascadeIdx < 2) {
-        float splitDist = (cascadeIdx == 0) ? cascadeSplits.x : cascadeSplits.y;
+    if (cascadeIdx < int(cascadeCount) - 1) {
+        float splitDist = cascadeSplits[cascadeIdx];
         float fade = clamp((viewZ - splitDist * (1.0 - blendRange)) / (splitDist * blendRange), 0.0, 1.0);
         if (fade > 0.0) {
-            float nextShadow = sampleShadowCascade(worldPos, cascadeIdx + 1);
+            float nextShadow = sampleShadowCascade(worldPos, cascadeIdx + 1, viewZ);
             shadow = mix(shadow, nextShadow, fade);
         }
     }
@@ -177,18 +278,101 @@ float sampleShadowPCF(vec3 worldPos, float viewZ) {
     return shadow;
 }
 
+// Point lights pick the cube face of the major axis (+X, -X, +Y, -Y, +Z, -Z, matching
+// Engine::localShadowViewProj); spot lights have a single view. Four bilinear compare taps.
+float sampleLocalShadow(GPUPointLight light, vec3 worldPos, vec3 N) {
+    vec3 fromLight = worldPos - light.positionAndRange.xyz;
+    uint face = 0u;
+    if (light.spotDirAndCosOuter.w <= -1.0) {
+        vec3 a = abs(fromLight);
+        if (a.x >= a.y && a.x >= a.z) face = fromLight.x > 0.0 ? 0u : 1u;
+        else if (a.y >= a.z) face = fromLight.y > 0.0 ? 2u : 3u;
+        else face = fromLight.z > 0.0 ? 4u : 5u;
+    }
+    LocalShadowView shadowView = localShadowViews[light.shadowSlot * LOCAL_SHADOW_FACES + face];
+    vec4 rect = shadowView.atlasRect;
+    vec2 atlasSize = vec2(textureSize(localShadowAtlas, 0));
+
+    // Normal offset of about one texel at this distance (a 90 degree face spans 2 * dist)
+    float texelWorld = 2.0 * length(fromLight) / (rect.z * atlasSize.x);
+    vec4 shadowCoord = shadowView.viewProj * vec4(worldPos + N * texelWorld * 1.5, 1.0);
+    if (shadowCoord.w <= 0.0) return 1.0;
+    shadowCoord.xyz /= shadowCoord.w;
+    vec2 shadowUV = shadowCoord.xy * 0.5 + 0.5;
+    if (any(lessThan(shadowUV, vec2(0.0))) || any(greaterThan(shadowUV, vec2(1.0)))) return 1.0;
+
+    vec2 texelSize = 1.0 / atlasSize;
+    vec2 atlasUV = rect.xy + shadowUV * rect.zw;
+    vec2 uvMin = rect.xy + texelSize * 0.5;
+    vec2 uvMax = rect.xy + rect.zw - texelSize * 0.5;
+    float shadow = 0.0;
+    for (int i = 0; i < 4; i++) {
+        vec2 offset = (vec2(i & 1, i >> 1) - 0.5) * texelSize;
+        shadow += texture(localShadowAtlas, vec3(clamp(atlasUV + offset, uvMin, uvMax), shadowCoord.z));
+    }
+    return shadow * 0.25;
+}
+
+// Froxel of a pixel: screen tile x exponential depth slice
+uint clusterIndex(vec2 uv, float viewZ) {
+    uvec2 tile = min(uvec2(uv * vec2(CLUSTER_GRID_X, CLUSTER_GRID_Y)), uvec2(CLUSTER_GRID_X - 1, CLUSTER_GRID_Y - 1));
+    uint slice = uint(clamp(log(viewZ) * clusterParams.x + clusterParams.y, 0.0, float(CLUSTER_GRID_Z - 1)));
+    return (slice * CLUSTER_GRID_Y + tile.y) * CLUSTER_GRID_X + tile.x;
+}
+
+// Debug: lights per froxel, black (none) -> blue -> green -> red (32+)
+vec3 clusterHeatColor(uint count) {
+    if (count == 0u) return vec3(0.0);
+    float t = clamp(float(count) / 32.0, 0.0, 1.0);
+    return t < 0.5 ? mix(vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0), t * 2.0)
+                   : mix(vec3(0.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0), t * 2.0 - 1.0);
+}
+
+// Debug: tile classes, sky = blue, unlit = green, simple = yellow, complex = red
+vec3 tileClassColor() {
+    if (TILE_CLASS == TILE_CLASS_SKY) return vec3(0.0, 0.0, 1.0);
+    if (TILE_CLASS == TILE_CLASS_UNLIT) return vec3(0.0, 1.0, 0.0);
+    if (TILE_CLASS == TILE_CLASS_SIMPLE) return vec3(1.0, 1.0, 0.0);
+    return vec3(1.0, 0.0, 0.0);
+}
+
+vec4 finalColor(vec3 color) {
+    if (debugMode == 9u) color = mix(color, tileClassColor(), 0.35);
+    return vec4(color, 1.0);
+}
+
+// Environment seen through a screen UV. Uses the projection diagonal only, which TAA
+// jitter does not touch (jitter lives in proj[2][0/1]).
+vec3 skyColor(vec2 uv) {
+    vec2 ndc = uv * 2.0 - 1.0;
+    vec3 viewDir = vec3(ndc.x / proj[0][0], -ndc.y / proj[1][1], -1.0);
+    // Transpose of mat3(view) = inverse rotation
+    return texture(envMap, normalize(transpose(mat3(view)) * viewDir)).rgb;
+}
+
 // Debug: cascade index visualization
 vec3 cascadeDebugColor(float viewZ) {
-    if (viewZ <= cascadeSplits.x) return vec3(1.0, 0.2, 0.2);
-    if (viewZ <= cascadeSplits.y) return vec3(0.2, 1.0, 0.2);
-    return vec3(0.2, 0.2, 1.0);
+    const vec3 colors[MAX_SHADOW_CASCADES] = vec3[](
+        vec3(1.0, 0.2, 0.2), vec3(0.2, 1.0, 0.2), vec3(0.2, 0.2, 1.0), vec3(1.0, 1.0, 0.2));
+    return colors[cascadeIndex(viewZ)];
 }
 
 void main() {
+    if (TILE_CLASS == TILE_CLASS_SKY) {
+        outColor = finalColor(skyColor(fragUV));
+        return;
+    }
+
+    // Tiles with any geometry may still contain sky pixels (reversed-Z: depth == 0 is far plane)
+    float depth = texture(gDepth, fragUV).r;
+    if (depth == 0.0) {
+        outColor = finalColor(skyColor(fragUV));
+        return;
+    }
+
     // Sample G-buffer
     vec4 albedoMetallic = texture(gAlbedoMetallic, fragUV);
     vec4 normalRoughness = texture(gNormalRoughness, fragUV);
-    float depth = texture(gDepth, fragUV).r;
 
     vec3 albedo = albedoMetallic.rgb;
     float metallic = albedoMetallic.a;
@@ -213,11 +397,20 @@ void main() {
     // Cascade debug mode
     if (debugMode == 7u) {
         vec3 baseColor = cascadeDebugColor(viewZ);
-        float shadow = sampleShadowPCF(worldPos, viewZ);
+        float shadow = sampleShadow(worldPos, viewZ);
         outColor = vec4(baseColor * (shadow * 0.7 + 0.3), 1.0);
         return;
     }
 
+    // Point lights of this pixel's froxel (none anywhere in UNLIT tiles)
+    uvec2 cluster = (TILE_CLASS == TILE_CLASS_UNLIT) ? uvec2(0) : clusters[clusterIndex(fragUV, viewZ)];
+
+    // Light cluster debug mode
+    if (debugMode == 8u) {
+        outColor = vec4(mix(albedo * 0.2, clusterHeatColor(cluster.y), 0.8), 1.0);
+        return;
+    }
+
     // IBL ambient (split-sum approximation)
     vec3 F0 = mix(vec3(0.04), albedo, metallic);
     float NdotV = max(dot(N, V), 0.0);
@@ -232,7 +425,9 @@ void main() {
     // Specular IBL
     const float MAX_REFLECTION_LOD = 4.0;
     vec3 R = reflect(-V, N);
-    vec3 prefilteredColor = textureLod(prefilteredMap, R, roughness * MAX_REFLECTION_LOD).rgb;
+    // Rough surfaces sample the last prefiltered mips, which the irradiance map approximates
+    vec3 prefilteredColor = (TILE_CLASS == TILE_CLASS_SIMPLE) ? irradiance
+        : textureLod(prefilteredMap, R, roughness * MAX_REFLECTION_LOD).rgb;
     vec2 brdf = texture(brdfLUT, vec2(NdotV, roughness)).rg;
     vec3 specularIBL = prefilteredColor * (F * brdf.x + brdf.y);
 
@@ -241,7 +436,7 @@ void main() {
     vec3 color = (diffuseIBL + specularIBL) * iblIntensity * ao;
 
     // Shadow factor for directional light
-    float shadow = (depth == 0.0) ? 1.0 : sampleShadowPCF(worldPos, viewZ);
+    float shadow = sampleShadow(worldPos, viewZ);
 
     // Directional light
     {
@@ -251,11 +446,12 @@ void main() {
     }
 
     // Point lights
-    for (uint i = 0; i < pointLightCount; i++) {
-        vec3 lightPos = lights[i].positionAndRange.xyz;
-        float range = lights[i].positionAndRange.w;
-        vec3 lightColor = lights[i].colorAndIntensity.xyz;
-        float intensity = lights[i].colorAndIntensity.w;
+    for (uint i = 0; i < cluster.y; i++) {
+        GPUPointLight light = lights[lightIndices[cluster.x + i]];
+        vec3 lightPos = light.positionAndRange.xyz;
+        float range = light.positionAndRange.w;
+        vec3 lightColor = light.colorAndIntensity.xyz;
+        float intensity = light.colorAndIntensity.w;
 
         vec3 toLight = lightPos - worldPos;
         float dist = length(toLight);
@@ -266,8 +462,21 @@ void main() {
         float attenuation = clamp(1.0 - dist / range, 0.0, 1.0);
         attenuation *= attenuation;
 
-        color += cookTorranceBRDF(N, V, L, albedo, metallic, roughness, lightColor, intensity * attenuation);
+        float cosOuter = light.spotDirAndCosOuter.w;
+        if (cosOuter > -1.0) {
+            attenuation *= smoothstep(cosOuter, light.spotCosInner, dot(-L, light.spotDirAndCosOuter.xyz));
+            if (attenuation <= 0.0) continue;
+        }
+        if (light.shadowSlot != NO_LOCAL_SHADOW) {
+            attenuation *= sampleLocalShadow(light, worldPos, N);
+            if (attenuation <= 0.0) continue;
+        }
+
+        if (TILE_CLASS == TILE_CLASS_SIMPLE)
+            color += albedo / PI * lightColor * intensity * attenuation * max(dot(N, L), 0.0);
+        else
+            color += cookTorranceBRDF(N, V, L, albedo, metallic, roughness, lightColor, intensity * attenuation);
     }
 
-    outColor = vec4(color, 1.0);
+    outColor = finalColor(color);
 }
@@ -0,0 +1,20 @@
+#version 460
+
+#include "vertex_packing.glsl"
+
+// Shadowed local lights: one cube face or spot frustum per pass over the casters, with the
+// viewport set to the view's tile in the local shadow atlas. The light matrix is
+// premultiplied into transform (Engine::MeshPushConstants).
+
+layout(push_constant) uniform LocalShadowPC {
+    mat4 transform;
+    vec4 positionScale;
+    vec4 positionOffset;
+};
+
+layout(location = 0) in vec4 inPosition;
+
+void main() {
+    vec3 position = dequantizePosition(inPosition, positionScale, positionOffset);
+    gl_Position = transform * vec4(position, 1.0);
+}
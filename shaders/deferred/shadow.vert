@@ -1,14 +1,52 @@
 #version 460
+#extension GL_ARB_shader_viewport_layer_array : require
+
+#include "vertex_packing.glsl"
+
+// Single-pass cascaded shadows: every cascade owns a viewport over its region of the
+// shadow atlas and instance i of every draw renders cascade i. Meshlet-culled draws carry
+// their cascade in firstInstance instead (see meshlet_cull.comp).
+// Must match Engine::MAX_SHADOW_CASCADES (src/core/Engine.h)
+const uint MAX_SHADOW_CASCADES = 4;
+
+layout(set = 0, binding = 0) uniform GlobalUBO {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    mat4 invViewProj;
+    mat4 prevViewProj;
+    vec4 cameraPos;
+    float time;
+    uint pointLightCount;
+    float jitterX;
+    float jitterY;
+    vec4 dirLightDir;
+    vec4 dirLightColor;
+    vec4 resolution;
+    mat4 cascadeViewProj[MAX_SHADOW_CASCADES];
+};
 
 layout(push_constant) uniform ShadowPC {
-    mat4 mvp;
+    mat4 model;
+    vec4 positionScale;
+    vec4 positionOffset;
+    uint cascadeMask; // cascades redrawn this frame, the others keep their cached region
 };
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec2 inUV;
-layout(location = 3) in vec4 inTangent;
+// Only the position attribute is bound; it is float3 or UNORM16x4 depending on the
+// mesh vertex format (a missing w reads as 1.0 and is ignored by the dequantization)
+layout(location = 0) in vec4 inPosition;
 
 void main() {
-    gl_Position = mvp * vec4(inPosition, 1.0);
+    uint cascade = uint(gl_InstanceIndex);
+    gl_ViewportIndex = int(cascade);
+
+    // Instances of skipped cascades are placed outside the clip volume
+    if ((cascadeMask & (1u << cascade)) == 0u) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+
+    vec3 position = dequantizePosition(inPosition, positionScale, positionOffset);
+    gl_Position = cascadeViewProj[cascade] * (model * vec4(position, 1.0));
 }
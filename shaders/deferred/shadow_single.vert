@@ -0,0 +1,40 @@
+#version 460
+
+#include "vertex_packing.glsl"
+
+// Fallback for shadow.vert on devices without shaderOutputViewportIndex: one pass per
+// cascade with the viewport set to the cascade's atlas region. The instance index still
+// selects the cascade matrix (firstInstance = cascade, one instance).
+// Must match Engine::MAX_SHADOW_CASCADES (src/core/Engine.h)
+const uint MAX_SHADOW_CASCADES = 4;
+
+layout(set = 0, binding = 0) uniform GlobalUBO {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    mat4 invViewProj;
+    mat4 prevViewProj;
+    vec4 cameraPos;
+    float time;
+    uint pointLightCount;
+    float jitterX;
+    float jitterY;
+    vec4 dirLightDir;
+    vec4 dirLightColor;
+    vec4 resolution;
+    mat4 cascadeViewProj[MAX_SHADOW_CASCADES];
+};
+
+layout(push_constant) uniform ShadowPC {
+    mat4 model;
+    vec4 positionScale;
+    vec4 positionOffset;
+    uint cascadeMask; // unused, the engine only draws the cascades it refreshes
+};
+
+layout(location = 0) in vec4 inPosition;
+
+void main() {
+    vec3 position = dequantizePosition(inPosition, positionScale, positionOffset);
+    gl_Position = cascadeViewProj[gl_InstanceIndex] * (model * vec4(position, 1.0));
+}
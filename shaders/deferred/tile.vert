@@ -0,0 +1,56 @@
+#version 460
+
+// Screen tile quads for the classified lighting pass: instance i covers the i-th tile in
+// the list of TILE_CLASS, written by tile_classify.comp. Output matches fullscreen.vert.
+
+// Must match Engine::LIGHTING_TILE_SIZE / TILE_CLASS_COUNT (src/core/Engine.h)
+const uint LIGHTING_TILE_SIZE = 16;
+const uint TILE_CLASS_COUNT = 4;
+
+layout(constant_id = 0) const uint TILE_CLASS = 3;
+
+layout(set = 0, binding = 0) uniform GlobalUBO {
+    mat4 view;
+    mat4 proj;
+    mat4 viewProj;
+    mat4 invViewProj;
+    mat4 prevViewProj;
+    vec4 cameraPos;
+    float time;
+    uint pointLightCount;
+    float jitterX;
+    float jitterY;
+    vec4 dirLightDir;
+    vec4 dirLightColor;
+    vec4 resolution;
+};
+
+struct DrawCommand { // VkDrawIndirectCommand
+    uint vertexCount;
+    uint instanceCount;
+    uint firstVertex;
+    uint firstInstance;
+};
+
+layout(set = 0, binding = 12) readonly buffer TileClassification {
+    DrawCommand tileDraws[TILE_CLASS_COUNT];
+    uint tileLists[];
+};
+
+layout(location = 0) out vec2 fragUV;
+
+const uvec2 corners[6] = uvec2[](
+    uvec2(0, 0), uvec2(1, 0), uvec2(0, 1),
+    uvec2(0, 1), uvec2(1, 0), uvec2(1, 1)
+);
+
+void main() {
+    uint capacity = uint(tileLists.length()) / TILE_CLASS_COUNT;
+    uint packed = tileLists[TILE_CLASS * capacity + gl_InstanceIndex];
+    uvec2 tile = uvec2(packed & 0xFFFFu, packed >> 16);
+
+    // Edge tiles are clipped to the render area so no pixel is shaded twice
+    vec2 pixel = min(vec2((tile + corners[gl_VertexIndex]) * LIGHTING_TILE_SIZE), resolution.xy);
+    fragUV = pixel * resolution.zw;
+    gl_Position = vec4(fragUV * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+namespace lmao {
+
+class Mesh;
+class Texture;
+class Material;
+
+// Generational reference to an AssetRegistry slot. Slots are reused after eviction with a
+// bumped generation, so a handle to an evicted asset resolves to null instead of to
+// whatever took its place. Trivially copyable: cheap to keep in per-entity data.
+template <typename T>
+struct AssetHandle {
+    static constexpr uint32_t INVALID_INDEX = UINT32_MAX;
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != INVALID_INDEX; }
+    explicit operator bool() const { return valid(); }
+    bool operator==(const AssetHandle&) const = default;
+};
+
+using MeshHandle = AssetHandle<Mesh>;
+using TextureHandle = AssetHandle<Texture>;
+using MaterialHandle = AssetHandle<Material>;
+
+} // namespace lmao
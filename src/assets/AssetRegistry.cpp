@@ -0,0 +1,111 @@
+#include "assets/AssetRegistry.h"
+#include "assets/DerivedDataCache.h"
+#include "assets/MeshFile.h"
+#include "assets/ModelImporter.h"
+#include "assets/TextureLoader.h"
+#include "scene/Scene.h"
+#include "vulkan/VulkanContext.h"
+#include "core/Hash.h"
+#include "core/Log.h"
+
+namespace lmao {
+
+namespace {
+
+// Path keys carry the cook flags: one file loaded with different options is two assets
+std::string assetKey(const std::string& path, uint32_t flags) {
+    return path + "#" + std::to_string(flags);
+}
+
+// The file's content hash (memoized by the DerivedDataCache, which the loaders hash it for
+// anyway) mixed with the cook flags; NO_CONTENT_HASH when unreadable
+uint64_t hashFile(const std::string& path, uint32_t flags) {
+    uint64_t source;
+    if (!DerivedDataCache::hashSource(path, source)) return AssetPool<Mesh>::NO_CONTENT_HASH;
+    uint64_t hash = xxHash64(&source, sizeof(source), flags);
+    return hash != AssetPool<Mesh>::NO_CONTENT_HASH ? hash : 1;
+}
+
+bool hasExtension(const std::string& path, const char* ext) {
+    size_t len = std::char_traits<char>::length(ext);
+    return path.size() >= len && path.compare(path.size() - len, len, ext) == 0;
+}
+
+} // anonymous namespace
+
+bool AssetRegistry::init(VulkanContext& ctx, UploadManager& uploads) {
+    m_ctx = &ctx;
+    m_uploads = &uploads;
+    m_meshes.init(uploads, DEFAULT_MESH_BUDGET);
+    m_textures.init(uploads, DEFAULT_TEXTURE_BUDGET);
+    m_materials.init(uploads, DEFAULT_MATERIAL_BUDGET);
+    LOG(Assets, Info, "Asset registry: budgets %.0f MB meshes, %.0f MB textures, %.0f MB materials",
+        DEFAULT_MESH_BUDGET / (1024.0 * 1024.0), DEFAULT_TEXTURE_BUDGET / (1024.0 * 1024.0),
+        DEFAULT_MATERIAL_BUDGET / (1024.0 * 1024.0));
+    return true;
+}
+
+void AssetRegistry::shutdown() {
+    if (!m_uploads) return;
+    m_materials.clear();
+    m_textures.clear();
+    m_meshes.clear();
+    m_uploads = nullptr;
+    m_ctx = nullptr;
+}
+
+MeshHandle AssetRegistry::loadMesh(const std::string& path, const MeshOptions& options) {
+    bool cooked = hasExtension(path, ".lmesh");
+    uint32_t flags = cooked ? 0 : MeshFile::cookFlags(options) | static_cast<uint32_t>(options.vertexFormat) << 16;
+    std::string key = assetKey(path, flags);
+    if (MeshHandle handle = m_meshes.find(key)) return handle;
+
+    uint64_t contentHash = hashFile(path, flags);
+    if (MeshHandle handle = m_meshes.findContent(contentHash)) {
+        LOG(Assets, Debug, "%s has the content of an already loaded mesh", path.c_str());
+        m_meshes.alias(handle, key);
+        return handle;
+    }
+
+    std::shared_ptr<Mesh> mesh = cooked ? MeshFile::load(m_ctx->allocator(), *m_uploads, path)
+                                        : ModelImporter::loadOBJ(m_ctx->allocator(), *m_uploads, path, options);
+    if (!mesh) return {};
+    return m_meshes.add(std::move(mesh), key, contentHash);
+}
+
+TextureHandle AssetRegistry::loadTexture(const std::string& path, TextureUsage usage) {
+    TextureCookOptions options;
+    options.usage = usage;
+    options.compress = m_ctx->features().textureCompressionBC;
+    uint32_t flags = TextureCooker::cookFlags(options);
+    std::string key = assetKey(path, flags);
+    if (TextureHandle handle = m_textures.find(key)) return handle;
+
+    uint64_t contentHash = hashFile(path, flags);
+    if (TextureHandle handle = m_textures.findContent(contentHash)) {
+        LOG(Assets, Debug, "%s has the content of an already loaded texture", path.c_str());
+        m_textures.alias(handle, key);
+        return handle;
+    }
+
+    std::shared_ptr<Texture> texture = TextureLoader::loadCooked(*m_ctx, *m_uploads, path, usage);
+    if (!texture) return {};
+    return m_textures.add(std::move(texture), key, contentHash);
+}
+
+void AssetRegistry::collect(const Scene& scene) {
+    m_frame++;
+    for (const Entity& entity : scene.entities()) {
+        m_meshes.markUsed(entity.mesh, m_frame);
+        m_materials.markUsed(entity.material, m_frame);
+    }
+
+    uint32_t materials = m_materials.evict(m_frame);
+    uint32_t textures = m_textures.evict(m_frame);
+    uint32_t meshes = m_meshes.evict(m_frame);
+    if (materials + textures + meshes > 0)
+        LOG(Assets, Debug, "Asset registry: evicted %u materials, %u textures, %u meshes",
+            materials, textures, meshes);
+}
+
+} // namespace lmao
@@ -0,0 +1,263 @@
+#pragma once
+#include "assets/AssetHandle.h"
+#include "assets/Mesh.h"
+#include "assets/Texture.h"
+#include "assets/Material.h"
+#include "assets/TextureCooker.h"
+#include "vulkan/UploadManager.h"
+#include <volk.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lmao {
+
+class VulkanContext;
+class Scene;
+
+// One asset type's slots. Lookups by path or content hash are hash map hits; handles
+// resolve with an index and a generation compare. An asset counts as referenced while it
+// was marked used for the current frame (AssetRegistry::collect marks what the scene
+// draws) or something outside the pool still holds a shared_ptr to it (a material holding
+// its textures, TextureStreamer). Unreferenced assets stay cached until the pool exceeds
+// its budget; evict() then releases them least recently used first.
+template <typename T>
+class AssetPool {
+public:
+    using Handle = AssetHandle<T>;
+    static constexpr uint64_t NO_CONTENT_HASH = 0;
+
+    struct Stats {
+        uint32_t count = 0;
+        uint32_t referenced = 0;        // as of the last evict()
+        VkDeviceSize residentBytes = 0; // as of the last evict()
+        uint64_t evicted = 0;           // since init
+    };
+
+    void init(UploadManager& uploads, VkDeviceSize budget) {
+        m_uploads = &uploads;
+        m_budget = budget;
+    }
+
+    // Registers an asset under path (skipped when empty) and contentHash. It only becomes
+    // evictable once the upload batch current at this call completes, so no recorded copy
+    // ever targets a released resource.
+    Handle add(std::shared_ptr<T> asset, const std::string& path, uint64_t contentHash = NO_CONTENT_HASH) {
+        if (!asset) return {};
+        uint32_t index;
+        if (!m_free.empty()) {
+            index = m_free.back();
+            m_free.pop_back();
+        } else {
+            index = static_cast<uint32_t>(m_slots.size());
+            m_slots.emplace_back();
+        }
+        Slot& slot = m_slots[index];
+        slot.asset = std::move(asset);
+        slot.contentHash = contentHash;
+        slot.lastUsed = m_frame;
+        slot.uploaded = false;
+        m_count++;
+
+        Handle handle{index, slot.generation};
+        alias(handle, path);
+        if (contentHash != NO_CONTENT_HASH) m_byContent[contentHash] = index;
+        m_uploads->onComplete([this, handle]() {
+            if (Slot* uploaded = resolve(handle)) uploaded->uploaded = true;
+        });
+        return handle;
+    }
+
+    // Makes path find an existing asset too (same content reached under another name)
+    void alias(Handle handle, const std::string& path) {
+        Slot* slot = resolve(handle);
+        if (!slot || path.empty()) return;
+        auto [it, inserted] = m_byPath.try_emplace(path, handle.index);
+        if (!inserted) {
+            if (it->second == handle.index) return;
+            std::vector<std::string>& previous = m_slots[it->second].paths;
+            previous.erase(std::find(previous.begin(), previous.end(), path));
+            it->second = handle.index;
+        }
+        slot->paths.push_back(path);
+    }
+
+    Handle find(const std::string& path) const {
+        auto it = m_byPath.find(path);
+        return it != m_byPath.end() ? handleOf(it->second) : Handle{};
+    }
+    Handle findContent(uint64_t contentHash) const {
+        auto it = m_byContent.find(contentHash);
+        return it != m_byContent.end() ? handleOf(it->second) : Handle{};
+    }
+
+    // Null for invalid handles and evicted assets
+    T* get(Handle handle) const {
+        const Slot* slot = resolve(handle);
+        return slot ? slot->asset.get() : nullptr;
+    }
+    std::shared_ptr<T> shared(Handle handle) const {
+        const Slot* slot = resolve(handle);
+        return slot ? slot->asset : nullptr;
+    }
+
+    void markUsed(Handle handle, uint64_t frame) {
+        if (Slot* slot = resolve(handle)) slot->lastUsed = frame;
+    }
+
+    // Re-measures every asset and, over budget, releases unreferenced ones in LRU order
+    // until the pool fits. Released assets are destroyed on the spot: call when no pending
+    // GPU work can use an asset not marked for `frame`. Returns how many were released.
+    uint32_t evict(uint64_t frame) {
+        m_frame = frame;
+        m_referenced = 0;
+        m_residentBytes = 0;
+        std::vector<uint32_t> candidates;
+        for (uint32_t i = 0; i < m_slots.size(); i++) {
+            Slot& slot = m_slots[i];
+            if (!slot.asset) continue;
+            slot.bytes = slot.asset->memorySize();
+            m_residentBytes += slot.bytes;
+            if (slot.lastUsed == frame || slot.asset.use_count() > 1)
+                m_referenced++;
+            else if (slot.uploaded)
+                candidates.push_back(i);
+        }
+        if (m_residentBytes <= m_budget || candidates.empty()) return 0;
+
+        std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) {
+            return m_slots[a].lastUsed < m_slots[b].lastUsed;
+        });
+        uint32_t evicted = 0;
+        for (uint32_t index : candidates) {
+            if (m_residentBytes <= m_budget) break;
+            m_residentBytes -= m_slots[index].bytes;
+            release(index);
+            evicted++;
+        }
+        m_evicted += evicted;
+        return evicted;
+    }
+
+    // Calls fn(T&) for every resident asset
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const Slot& slot : m_slots)
+            if (slot.asset) fn(*slot.asset);
+    }
+
+    // Releases everything regardless of references; outstanding handles go stale
+    void clear() {
+        for (uint32_t i = 0; i < m_slots.size(); i++)
+            if (m_slots[i].asset) release(i);
+    }
+
+    void setBudget(VkDeviceSize bytes) { m_budget = bytes; }
+    VkDeviceSize budget() const { return m_budget; }
+    Stats stats() const { return {m_count, m_referenced, m_residentBytes, m_evicted}; }
+
+private:
+    struct Slot {
+        std::shared_ptr<T> asset;         // null while the slot is free
+        std::vector<std::string> paths;   // every key in m_byPath naming this slot
+        uint64_t contentHash = NO_CONTENT_HASH;
+        uint32_t generation = 0;
+        uint64_t lastUsed = 0;
+        VkDeviceSize bytes = 0;           // as of the last evict()
+        bool uploaded = false;
+    };
+
+    Slot* resolve(Handle handle) {
+        if (handle.index >= m_slots.size()) return nullptr;
+        Slot& slot = m_slots[handle.index];
+        return slot.asset && slot.generation == handle.generation ? &slot : nullptr;
+    }
+    const Slot* resolve(Handle handle) const {
+        return const_cast<AssetPool*>(this)->resolve(handle);
+    }
+    Handle handleOf(uint32_t index) const { return {index, m_slots[index].generation}; }
+
+    void release(uint32_t index) {
+        Slot& slot = m_slots[index];
+        for (const std::string& path : slot.paths)
+            m_byPath.erase(path);
+        if (slot.contentHash != NO_CONTENT_HASH) {
+            auto it = m_byContent.find(slot.contentHash);
+            if (it != m_byContent.end() && it->second == index) m_byContent.erase(it);
+        }
+        slot.asset.reset();
+        slot.paths.clear();
+        slot.contentHash = NO_CONTENT_HASH;
+        slot.uploaded = false;
+        slot.generation++;
+        m_free.push_back(index);
+        m_count--;
+    }
+
+    UploadManager* m_uploads = nullptr;
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_free;
+    std::unordered_map<std::string, uint32_t> m_byPath;
+    std::unordered_map<uint64_t, uint32_t> m_byContent;
+    VkDeviceSize m_budget = 0;
+    VkDeviceSize m_residentBytes = 0;
+    uint64_t m_frame = 0;
+    uint64_t m_evicted = 0;
+    uint32_t m_count = 0;
+    uint32_t m_referenced = 0;
+};
+
+// Owner of the engine's meshes, textures and materials.
+//
+// Everything is addressed by generational handles (Entity stores MeshHandle and
+// MaterialHandle), so per-frame code resolves assets with an array index instead of
+// chasing shared_ptr control blocks, and a long-running process can drop whole scenes:
+// once no entity references an asset it stays cached for a quick reload, until its type's
+// budget forces it out. Files are deduplicated twice: by path, then by an XXH64 of their
+// bytes, so the same file under two names is loaded once.
+class AssetRegistry {
+public:
+    static constexpr VkDeviceSize DEFAULT_MESH_BUDGET = 256ull << 20;
+    static constexpr VkDeviceSize DEFAULT_TEXTURE_BUDGET = 1024ull << 20;
+    static constexpr VkDeviceSize DEFAULT_MATERIAL_BUDGET = 4ull << 20;
+
+    AssetRegistry() = default;
+    ~AssetRegistry() { shutdown(); }
+
+    AssetRegistry(const AssetRegistry&) = delete;
+    AssetRegistry& operator=(const AssetRegistry&) = delete;
+
+    bool init(VulkanContext& ctx, UploadManager& uploads);
+    // Releases every asset; the device must be idle
+    void shutdown();
+
+    // .lmesh files load as cooked (MeshFile), anything else through ModelImporter::loadOBJ.
+    // Invalid handle on failure.
+    MeshHandle loadMesh(const std::string& path, const MeshOptions& options = {});
+    // TextureLoader::loadCooked; the same file used for two usages is two textures
+    TextureHandle loadTexture(const std::string& path, TextureUsage usage);
+
+    // After the fence wait, before anything is recorded: marks what the scene's entities
+    // use this frame and evicts unreferenced assets from pools over budget. Materials go
+    // first, so the textures only they held are released in the same call.
+    void collect(const Scene& scene);
+
+    AssetPool<Mesh>& meshes() { return m_meshes; }
+    AssetPool<Texture>& textures() { return m_textures; }
+    AssetPool<Material>& materials() { return m_materials; }
+    const AssetPool<Mesh>& meshes() const { return m_meshes; }
+    const AssetPool<Texture>& textures() const { return m_textures; }
+    const AssetPool<Material>& materials() const { return m_materials; }
+
+private:
+    VulkanContext* m_ctx = nullptr;
+    UploadManager* m_uploads = nullptr;
+    AssetPool<Mesh> m_meshes;
+    AssetPool<Texture> m_textures;
+    AssetPool<Material> m_materials;
+    uint64_t m_frame = 0;
+};
+
+} // namespace lmao
@@ -0,0 +1,372 @@
+#include "assets/BlockEncoder.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LMAO_BLOCK_SSE2 1
+#include <emmintrin.h>
+#else
+#define LMAO_BLOCK_SSE2 0
+#endif
+
+namespace lmao {
+
+namespace {
+constexpr uint32_t BLOCK_TEXELS = 16;
+
+// Texels as one plane per channel, the layout the index search vectorizes over
+struct BlockTexels {
+    alignas(16) float c[4][BLOCK_TEXELS];
+};
+
+void loadBlock(const uint8_t* rgba, BlockTexels& out) {
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+        for (uint32_t ch = 0; ch < 4; ch++)
+            out.c[ch][i] = static_cast<float>(rgba[i * 4 + ch]);
+}
+
+// Nearest palette entry (squared distance over the first `channels` channels) for every
+// texel. Ties keep the lower index. Returns the total error of the block.
+float selectIndices(const BlockTexels& texels, uint32_t channels, const float (*palette)[4],
+                    uint32_t paletteSize, uint8_t indices[BLOCK_TEXELS]) {
+#if LMAO_BLOCK_SSE2
+    __m128 total = _mm_setzero_ps();
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i += 4) {
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i bestIndex = _mm_setzero_si128();
+        for (uint32_t p = 0; p < paletteSize; p++) {
+            __m128 err = _mm_setzero_ps();
+            for (uint32_t ch = 0; ch < channels; ch++) {
+                __m128 d = _mm_sub_ps(_mm_load_ps(&texels.c[ch][i]), _mm_set1_ps(palette[p][ch]));
+                err = _mm_add_ps(err, _mm_mul_ps(d, d));
+            }
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(err, best));
+            best = _mm_min_ps(err, best);
+            bestIndex = _mm_or_si128(_mm_andnot_si128(closer, bestIndex),
+                                     _mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(p))));
+        }
+        total = _mm_add_ps(total, best);
+
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), bestIndex);
+        for (uint32_t l = 0; l < 4; l++)
+            indices[i + l] = static_cast<uint8_t>(lanes[l]);
+    }
+    alignas(16) float sums[4];
+    _mm_store_ps(sums, total);
+    return sums[0] + sums[1] + sums[2] + sums[3];
+#else
+    float total = 0.0f;
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        float best = FLT_MAX;
+        uint8_t bestIndex = 0;
+        for (uint32_t p = 0; p < paletteSize; p++) {
+            float err = 0.0f;
+            for (uint32_t ch = 0; ch < channels; ch++) {
+                float d = texels.c[ch][i] - palette[p][ch];
+                err += d * d;
+            }
+            if (err < best) {
+                best = err;
+                bestIndex = static_cast<uint8_t>(p);
+            }
+        }
+        indices[i] = bestIndex;
+        total += best;
+    }
+    return total;
+#endif
+}
+
+// Endpoints at the extremes of the block's projection onto its principal axis (dominant
+// eigenvector of the covariance, by power iteration)
+void fitEndpoints(const BlockTexels& texels, uint32_t channels, float e0[4], float e1[4]) {
+    float mean[4] = {};
+    for (uint32_t ch = 0; ch < channels; ch++) {
+        for (uint32_t i = 0; i < BLOCK_TEXELS; i++) mean[ch] += texels.c[ch][i];
+        mean[ch] /= BLOCK_TEXELS;
+    }
+
+    float cov[4][4] = {};
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        for (uint32_t a = 0; a < channels; a++) {
+            float da = texels.c[a][i] - mean[a];
+            for (uint32_t b = a; b < channels; b++)
+                cov[a][b] += da * (texels.c[b][i] - mean[b]);
+        }
+    }
+    for (uint32_t a = 0; a < channels; a++)
+        for (uint32_t b = 0; b < a; b++) cov[a][b] = cov[b][a];
+
+    // Start from the row of the widest channel so the iteration cannot begin orthogonal
+    // to the axis
+    uint32_t widest = 0;
+    for (uint32_t ch = 1; ch < channels; ch++)
+        if (cov[ch][ch] > cov[widest][widest]) widest = ch;
+    float axis[4] = {};
+    for (uint32_t ch = 0; ch < channels; ch++) axis[ch] = cov[widest][ch];
+
+    for (int iter = 0; iter < 8; iter++) {
+        float next[4] = {};
+        float lengthSq = 0.0f;
+        for (uint32_t a = 0; a < channels; a++) {
+            for (uint32_t b = 0; b < channels; b++) next[a] += cov[a][b] * axis[b];
+            lengthSq += next[a] * next[a];
+        }
+        if (lengthSq < 1e-12f) break;
+        float invLength = 1.0f / std::sqrt(lengthSq);
+        for (uint32_t ch = 0; ch < channels; ch++) axis[ch] = next[ch] * invLength;
+    }
+
+    float tMin = 0.0f, tMax = 0.0f;
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        float t = 0.0f;
+        for (uint32_t ch = 0; ch < channels; ch++) t += (texels.c[ch][i] - mean[ch]) * axis[ch];
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    for (uint32_t ch = 0; ch < 4; ch++) {
+        e0[ch] = ch < channels ? std::clamp(mean[ch] + axis[ch] * tMin, 0.0f, 255.0f) : 0.0f;
+        e1[ch] = ch < channels ? std::clamp(mean[ch] + axis[ch] * tMax, 0.0f, 255.0f) : 0.0f;
+    }
+}
+
+// Least-squares endpoints for fixed indices, where texel i decodes to
+// lerp(e0, e1, weights[indices[i]]). False when the system is singular (one weight used).
+bool refineEndpoints(const BlockTexels& texels, uint32_t channels, const uint8_t indices[BLOCK_TEXELS],
+                     const float* weights, float e0[4], float e1[4]) {
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[4] = {}, bx[4] = {};
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        float b = weights[indices[i]];
+        float a = 1.0f - b;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (uint32_t ch = 0; ch < channels; ch++) {
+            ax[ch] += a * texels.c[ch][i];
+            bx[ch] += b * texels.c[ch][i];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::abs(det) < 1e-6f) return false;
+
+    float invDet = 1.0f / det;
+    for (uint32_t ch = 0; ch < channels; ch++) {
+        e0[ch] = std::clamp((ax[ch] * bb - bx[ch] * ab) * invDet, 0.0f, 255.0f);
+        e1[ch] = std::clamp((bx[ch] * aa - ax[ch] * ab) * invDet, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+// Little-endian bit stream, the order BC7 fields are packed in
+struct BitWriter {
+    uint8_t* out;
+    uint32_t pos = 0;
+
+    void put(uint32_t value, uint32_t bits) {
+        for (uint32_t b = 0; b < bits; b++, pos++)
+            if ((value >> b) & 1u) out[pos >> 3] |= static_cast<uint8_t>(1u << (pos & 7));
+    }
+};
+
+// BC1 ------------------------------------------------------------------------------------
+
+// Fraction of color1 in each palette entry of the four-color mode
+constexpr float BC1_WEIGHTS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+struct BC1Block {
+    uint16_t color0 = 0;
+    uint16_t color1 = 0;
+    uint8_t indices[BLOCK_TEXELS] = {};
+    float error = FLT_MAX;
+};
+
+uint16_t pack565(const float c[4]) {
+    auto r = static_cast<uint16_t>(std::lround(c[0] * (31.0f / 255.0f)));
+    auto g = static_cast<uint16_t>(std::lround(c[1] * (63.0f / 255.0f)));
+    auto b = static_cast<uint16_t>(std::lround(c[2] * (31.0f / 255.0f)));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void unpack565(uint16_t v, float out[4]) {
+    uint32_t r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    out[0] = static_cast<float>((r << 3) | (r >> 2));
+    out[1] = static_cast<float>((g << 2) | (g >> 4));
+    out[2] = static_cast<float>((b << 3) | (b >> 2));
+    out[3] = 0.0f;
+}
+
+BC1Block evaluateBC1(const BlockTexels& texels, const float e0[4], const float e1[4]) {
+    BC1Block block;
+    block.color0 = pack565(e0);
+    block.color1 = pack565(e1);
+    // color0 > color1 selects the four-color mode
+    if (block.color0 < block.color1) std::swap(block.color0, block.color1);
+
+    float palette[4][4];
+    unpack565(block.color0, palette[0]);
+    unpack565(block.color1, palette[1]);
+    for (uint32_t ch = 0; ch < 3; ch++) {
+        palette[2][ch] = (2.0f * palette[0][ch] + palette[1][ch]) / 3.0f;
+        palette[3][ch] = (palette[0][ch] + 2.0f * palette[1][ch]) / 3.0f;
+    }
+    // Equal endpoints fall into the three-color mode, where index 0 still decodes to color0
+    uint32_t paletteSize = block.color0 == block.color1 ? 1 : 4;
+    block.error = selectIndices(texels, 3, palette, paletteSize, block.indices);
+    return block;
+}
+
+// BC7 mode 6 -----------------------------------------------------------------------------
+
+constexpr uint32_t BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct BC7Endpoint {
+    uint8_t q[4] = {};   // 7-bit channels
+    uint8_t p = 0;       // shared LSB
+};
+
+struct BC7Block {
+    BC7Endpoint e0, e1;
+    uint8_t indices[BLOCK_TEXELS] = {};
+    float error = FLT_MAX;
+};
+
+// Picks the p-bit whose 8-bit reconstruction is closest to the endpoint
+BC7Endpoint quantizeBC7(const float e[4], float decoded[4]) {
+    BC7Endpoint best;
+    float bestError = FLT_MAX;
+    for (uint8_t p = 0; p < 2; p++) {
+        BC7Endpoint candidate;
+        candidate.p = p;
+        float value[4];
+        float error = 0.0f;
+        for (uint32_t ch = 0; ch < 4; ch++) {
+            long q = std::clamp(std::lround((e[ch] - p) * 0.5f), 0L, 127L);
+            candidate.q[ch] = static_cast<uint8_t>(q);
+            value[ch] = static_cast<float>((q << 1) | p);
+            error += (value[ch] - e[ch]) * (value[ch] - e[ch]);
+        }
+        if (error < bestError) {
+            bestError = error;
+            best = candidate;
+            std::memcpy(decoded, value, sizeof(value));
+        }
+    }
+    return best;
+}
+
+BC7Block evaluateBC7(const BlockTexels& texels, const float e0[4], const float e1[4]) {
+    BC7Block block;
+    float v0[4], v1[4];
+    block.e0 = quantizeBC7(e0, v0);
+    block.e1 = quantizeBC7(e1, v1);
+
+    float palette[16][4];
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t w = BC7_WEIGHTS[i];
+        for (uint32_t ch = 0; ch < 4; ch++)
+            palette[i][ch] = static_cast<float>(((64 - w) * static_cast<uint32_t>(v0[ch]) +
+                                                 w * static_cast<uint32_t>(v1[ch]) + 32) >> 6);
+    }
+    block.error = selectIndices(texels, 4, palette, 16, block.indices);
+    return block;
+}
+} // anonymous namespace
+
+bool BlockEncoder::usesSIMD() { return LMAO_BLOCK_SSE2 != 0; }
+
+void BlockEncoder::encodeBC1(const uint8_t* rgba, uint8_t out[8]) {
+    BlockTexels texels;
+    loadBlock(rgba, texels);
+
+    float e0[4], e1[4];
+    fitEndpoints(texels, 3, e0, e1);
+    BC1Block block = evaluateBC1(texels, e0, e1);
+
+    float r0[4], r1[4];
+    unpack565(block.color0, r0);
+    unpack565(block.color1, r1);
+    if (block.error > 0.0f && refineEndpoints(texels, 3, block.indices, BC1_WEIGHTS, r0, r1)) {
+        BC1Block refined = evaluateBC1(texels, r0, r1);
+        if (refined.error < block.error) block = refined;
+    }
+
+    uint32_t indices = 0;
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++)
+        indices |= static_cast<uint32_t>(block.indices[i]) << (2 * i);
+    std::memcpy(out, &block.color0, 2);
+    std::memcpy(out + 2, &block.color1, 2);
+    std::memcpy(out + 4, &indices, 4);
+}
+
+void BlockEncoder::encodeBC4(const uint8_t* rgba, uint32_t channel, uint8_t out[8]) {
+    uint8_t lo = 255, hi = 0;
+    for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+        lo = std::min(lo, rgba[i * 4 + channel]);
+        hi = std::max(hi, rgba[i * 4 + channel]);
+    }
+
+    // Eight-value mode (red0 > red1): index 0 = hi, 1 = lo, 2..7 step from hi towards lo.
+    // The ramp is uniform, so the nearest entry is a rounded position along it.
+    uint64_t indices = 0;
+    if (hi > lo) {
+        float scale = 7.0f / static_cast<float>(hi - lo);
+        for (uint32_t i = 0; i < BLOCK_TEXELS; i++) {
+            auto t = static_cast<uint32_t>(std::lround((hi - rgba[i * 4 + channel]) * scale));
+            uint64_t index = t == 0 ? 0 : t == 7 ? 1 : t + 1;
+            indices |= index << (3 * i);
+        }
+    }
+    out[0] = hi;
+    out[1] = lo;
+    for (uint32_t b = 0; b < 6; b++)
+        out[2 + b] = static_cast<uint8_t>(indices >> (8 * b));
+}
+
+void BlockEncoder::encodeBC5(const uint8_t* rgba, uint8_t out[16]) {
+    encodeBC4(rgba, 0, out);
+    encodeBC4(rgba, 1, out + 8);
+}
+
+void BlockEncoder::encodeBC7(const uint8_t* rgba, uint8_t out[16]) {
+    BlockTexels texels;
+    loadBlock(rgba, texels);
+
+    float e0[4], e1[4];
+    fitEndpoints(texels, 4, e0, e1);
+    BC7Block block = evaluateBC7(texels, e0, e1);
+
+    if (block.error > 0.0f) {
+        float weights[16];
+        for (uint32_t i = 0; i < 16; i++) weights[i] = BC7_WEIGHTS[i] / 64.0f;
+        if (refineEndpoints(texels, 4, block.indices, weights, e0, e1)) {
+            BC7Block refined = evaluateBC7(texels, e0, e1);
+            if (refined.error < block.error) block = refined;
+        }
+    }
+
+    // The anchor (texel 0) index is stored without its MSB: flip the ramp if it is set
+    if (block.indices[0] & 8) {
+        std::swap(block.e0, block.e1);
+        for (uint8_t& index : block.indices) index = static_cast<uint8_t>(15 - index);
+    }
+
+    std::memset(out, 0, 16);
+    BitWriter bits{out};
+    bits.put(1u << 6, 7);  // mode 6
+    for (uint32_t ch = 0; ch < 4; ch++) {
+        bits.put(block.e0.q[ch], 7);
+        bits.put(block.e1.q[ch], 7);
+    }
+    bits.put(block.e0.p, 1);
+    bits.put(block.e1.p, 1);
+    bits.put(block.indices[0], 3);
+    for (uint32_t i = 1; i < BLOCK_TEXELS; i++)
+        bits.put(block.indices[i], 4);
+}
+
+} // namespace lmao
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstdint>
+
+namespace lmao {
+
+// 4x4 block encoders used by TextureCooker. Every encoder takes the 16 texels of one block
+// as RGBA8 in row order (edge blocks replicate their last row / column) and writes one
+// block in the layout of the matching VK_FORMAT_BC*_BLOCK format.
+//
+// Endpoints start on the principal axis of the block's texels and are refined once by
+// least squares for the chosen indices. The index search is the hot loop; it runs four
+// texels at a time with SSE2 when the target has it and falls back to scalar code.
+class BlockEncoder {
+public:
+    static constexpr uint32_t BLOCK_DIM = 4;
+
+    // RGB, 4 bpp. Alpha is ignored: always the opaque four-color mode.
+    static void encodeBC1(const uint8_t* rgba, uint8_t out[8]);
+    // One channel (0 = R .. 3 = A), 4 bpp
+    static void encodeBC4(const uint8_t* rgba, uint32_t channel, uint8_t out[8]);
+    // R and G as two BC4 blocks, 8 bpp
+    static void encodeBC5(const uint8_t* rgba, uint8_t out[16]);
+    // RGBA, 8 bpp. Mode 6 only: one subset, 7.7.7.7 endpoints plus a p-bit, 4-bit indices.
+    static void encodeBC7(const uint8_t* rgba, uint8_t out[16]);
+
+    // Whether the SSE2 index search was compiled in
+    static bool usesSIMD();
+};
+
+} // namespace lmao
@@ -0,0 +1,119 @@
+#include "assets/DerivedDataCache.h"
+#include "core/Hash.h"
+#include "core/MappedFile.h"
+#include "core/TempFile.h"
+#include "core/Log.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+namespace lmao {
+
+namespace {
+constexpr uint32_t MEMO_MAGIC = 0x4352534C; // "LSRC"
+constexpr uint32_t MEMO_VERSION = 1;
+
+// Contents of a .lsrc file
+struct SourceMemo {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;
+    int64_t time;
+    uint64_t hash;
+};
+static_assert(sizeof(SourceMemo) == 32, "SourceMemo is part of the .lsrc layout");
+
+// Size and mtime of a source, what a memo is validated against
+bool statSource(const std::string& path, uint64_t& size, int64_t& time) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    time = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+std::string& rootStorage() {
+    static std::string root = DerivedDataCache::DEFAULT_ROOT;
+    return root;
+}
+
+std::string hex(uint64_t value) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+// <root>/<dir><xx>/<name>.<extension>, creating the directory
+std::string shardedPath(const char* dir, uint64_t name, const char* extension) {
+    std::string id = hex(name);
+    std::filesystem::path directory = std::filesystem::path(rootStorage()) / dir / id.substr(0, 2);
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    return (directory / (id + extension)).string();
+}
+
+std::string memoPath(const std::string& path) {
+    std::error_code ec;
+    std::string absolute = std::filesystem::absolute(path, ec).lexically_normal().generic_string();
+    if (ec) absolute = path;
+    return shardedPath("sources", xxHash64(absolute.data(), absolute.size()), ".lsrc");
+}
+} // anonymous namespace
+
+void DerivedDataCache::setRoot(const std::string& root) { rootStorage() = root; }
+
+const std::string& DerivedDataCache::root() { return rootStorage(); }
+
+bool DerivedDataCache::hashSource(const std::string& path, uint64_t& hash) {
+    uint64_t size;
+    int64_t time;
+    if (!statSource(path, size, time)) return false;
+
+    std::string memoFile = root().empty() ? std::string() : memoPath(path);
+    if (!memoFile.empty()) {
+        SourceMemo memo{};
+        std::ifstream f(memoFile, std::ios::binary);
+        if (f.read(reinterpret_cast<char*>(&memo), sizeof(memo)) && memo.magic == MEMO_MAGIC &&
+            memo.version == MEMO_VERSION && memo.size == size && memo.time == time) {
+            hash = memo.hash;
+            return true;
+        }
+    }
+
+    MappedFile file;
+    if (!file.open(path)) return false;
+    hash = xxHash64(file.data(), file.size());
+    if (memoFile.empty()) return true;
+
+    // A lost memo only costs a rehash, so failures here are not reported
+    SourceMemo memo{MEMO_MAGIC, MEMO_VERSION, size, time, hash};
+    std::error_code ec;
+    std::string tmpFile = TempFile::pathFor(memoFile);
+    {
+        std::ofstream f(tmpFile, std::ios::binary | std::ios::trunc);
+        f.write(reinterpret_cast<const char*>(&memo), sizeof(memo));
+        if (!f) {
+            f.close();
+            std::filesystem::remove(tmpFile, ec);
+            return true;
+        }
+    }
+    TempFile::replace(tmpFile, memoFile, ec);
+    return true;
+}
+
+uint64_t DerivedDataCache::key(std::string_view kind, uint64_t source, uint32_t cookFlags, uint32_t version) {
+    struct {
+        uint64_t source;
+        uint32_t cookFlags;
+        uint32_t version;
+    } fields{source, cookFlags, version};
+    return xxHash64(&fields, sizeof(fields), xxHash64(kind.data(), kind.size()));
+}
+
+std::string DerivedDataCache::entryPath(uint64_t key, const char* extension) {
+    if (root().empty()) return {};
+    return shardedPath("", key, extension);
+}
+
+} // namespace lmao
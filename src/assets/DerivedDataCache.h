@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace lmao {
+
+// Content-addressed store of cooked assets ("derived data"), shared by the runtime loaders
+// (TextureLoader::loadCooked, ModelImporter::loadOBJ, MeshGenerator) and lmao_cook.
+//
+//   <root>/<xx>/<key>.<ext>               cooked file, key = 16 hex digits, xx = its first two
+//   <root>/sources/<xx>/<path hash>.lsrc  memo of a source's content hash by size and mtime
+//
+// A key hashes everything the output depends on: the source contents (or a generator's
+// parameters), the cook flags and the cooker version. Any change yields a new key, so
+// entries are never invalidated, only orphaned, and deleting the directory is always safe.
+// Cooked files are written through a temporary file renamed into place.
+class DerivedDataCache {
+public:
+    static constexpr const char* DEFAULT_ROOT = "ddc";
+
+    // Bump when a cooker's output changes for the same source and flags. Covers the
+    // importers, MeshGenerator, Mesh::cook and the .lmesh layout ...
+    static constexpr uint32_t MESH_VERSION = 1;
+    // ... and TextureCooker with the .ktx2 layout
+    static constexpr uint32_t TEXTURE_VERSION = 1;
+
+    // Set before any loader runs; empty disables the cache and every load cooks in memory
+    static void setRoot(const std::string& root);
+    static const std::string& root();
+
+    // XXH64 of the file's contents, memoized while its size and mtime stay the same
+    static bool hashSource(const std::string& path, uint64_t& hash);
+
+    // Key of what a cooker (kind, e.g. "texture") at version makes of source with cookFlags
+    static uint64_t key(std::string_view kind, uint64_t source, uint32_t cookFlags, uint32_t version);
+    // Where the entry of key lives, its directory created; empty while the cache is disabled
+    static std::string entryPath(uint64_t key, const char* extension);
+};
+
+} // namespace lmao
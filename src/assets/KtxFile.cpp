@@ -0,0 +1,288 @@
+#include "assets/KtxFile.h"
+#include "assets/PackFile.h"
+#include "core/Hash.h"
+#include "core/TempFile.h"
+#include "core/Log.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace lmao {
+
+static_assert(std::endian::native == std::endian::little, ".ktx2 files are stored little-endian");
+
+namespace {
+constexpr uint8_t KTX_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+constexpr const char* COOK_KEY = "LMAOcook";
+constexpr char WRITER[] = "LmaoEngine TextureCooker";
+
+// Khronos Data Format Specification, basic descriptor block
+constexpr uint32_t KHR_DF_VERSION = 2;
+constexpr uint32_t KHR_DF_MODEL_RGBSDA = 1;
+constexpr uint32_t KHR_DF_MODEL_BC1A = 128;
+constexpr uint32_t KHR_DF_MODEL_BC4 = 131;
+constexpr uint32_t KHR_DF_MODEL_BC5 = 132;
+constexpr uint32_t KHR_DF_MODEL_BC7 = 135;
+constexpr uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+constexpr uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+constexpr uint32_t KHR_DF_TRANSFER_SRGB = 2;
+constexpr uint32_t KHR_DF_CHANNEL_ALPHA = 15;
+constexpr uint32_t KHR_DF_SAMPLE_LINEAR = 0x10;
+
+struct DfdSample {
+    uint32_t bitOffset;
+    uint32_t bitLength;
+    uint32_t channel;
+    uint32_t upper;
+};
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Descriptor for the formats TextureCooker writes; empty for anything else
+std::vector<uint32_t> buildDfd(VkFormat format) {
+    uint32_t model = KHR_DF_MODEL_RGBSDA;
+    bool srgb = false;
+    std::vector<DfdSample> samples;
+    switch (format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK: model = KHR_DF_MODEL_BC1A; samples = {{0, 64, 0, ~0u}}; break;
+        case VK_FORMAT_BC4_UNORM_BLOCK:     model = KHR_DF_MODEL_BC4; samples = {{0, 64, 0, ~0u}}; break;
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            model = KHR_DF_MODEL_BC5;
+            samples = {{0, 64, 0, ~0u}, {64, 64, 1, ~0u}};
+            break;
+        case VK_FORMAT_BC7_SRGB_BLOCK: srgb = true; [[fallthrough]];
+        case VK_FORMAT_BC7_UNORM_BLOCK: model = KHR_DF_MODEL_BC7; samples = {{0, 128, 0, ~0u}}; break;
+        case VK_FORMAT_R8G8B8A8_SRGB: srgb = true; [[fallthrough]];
+        case VK_FORMAT_R8G8B8A8_UNORM:
+            samples = {{0, 8, 0, 255}, {8, 8, 1, 255}, {16, 8, 2, 255}, {24, 8, KHR_DF_CHANNEL_ALPHA, 255}};
+            break;
+        case VK_FORMAT_R8G8_UNORM: samples = {{0, 8, 0, 255}, {8, 8, 1, 255}}; break;
+        case VK_FORMAT_R8_UNORM:   samples = {{0, 8, 0, 255}}; break;
+        default: return {};
+    }
+
+    uint32_t dim = TextureCooker::blockDim(format) - 1;
+    uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+    std::vector<uint32_t> dfd = {
+        4 + blockSize,                       // dfdTotalSize
+        0,                                   // vendorId = Khronos, descriptorType = basic
+        KHR_DF_VERSION | (blockSize << 16),
+        model | (KHR_DF_PRIMARIES_BT709 << 8) | ((srgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR) << 16),
+        dim | (dim << 8),                    // texelBlockDimension0..3, stored minus one
+        TextureCooker::blockBytes(format),   // bytesPlane0..3
+        0,                                   // bytesPlane4..7
+    };
+    for (const DfdSample& s : samples) {
+        // Alpha stays linear in sRGB formats
+        uint32_t channelType = s.channel | (srgb && s.channel == KHR_DF_CHANNEL_ALPHA ? KHR_DF_SAMPLE_LINEAR : 0);
+        dfd.push_back(s.bitOffset | ((s.bitLength - 1) << 16) | (channelType << 24));
+        dfd.push_back(0);  // samplePosition0..3
+        dfd.push_back(0);  // sampleLower
+        dfd.push_back(s.upper);
+    }
+    return dfd;
+}
+
+void appendKeyValue(std::vector<uint8_t>& kvd, const char* key, const void* value, uint32_t size) {
+    auto keyLength = static_cast<uint32_t>(std::strlen(key) + 1);
+    uint32_t length = keyLength + size;
+    const auto* lengthBytes = reinterpret_cast<const uint8_t*>(&length);
+    kvd.insert(kvd.end(), lengthBytes, lengthBytes + sizeof(length));
+    kvd.insert(kvd.end(), key, key + keyLength);
+    kvd.insert(kvd.end(), static_cast<const uint8_t*>(value), static_cast<const uint8_t*>(value) + size);
+    kvd.resize(alignUp(kvd.size(), 4), 0);
+}
+} // anonymous namespace
+
+bool KtxFile::write(const std::string& path, const CookedTexture& texture, uint32_t cookFlags,
+                    const MeshFileSource& source) {
+    std::vector<uint32_t> dfd = buildDfd(texture.format);
+    if (dfd.empty() || texture.levels.empty()) {
+        LOG(Assets, Warn, "Cannot write texture file %s: unsupported format %d", path.c_str(), texture.format);
+        return false;
+    }
+
+    // Level data, smallest mip first, laid out relative to an aligned start
+    uint64_t alignment = TextureCooker::levelAlignment(texture.format);
+    auto levelCount = static_cast<uint32_t>(texture.levels.size());
+    std::vector<KtxLevel> levels(levelCount);
+    uint64_t dataSize = 0;
+    for (uint32_t mip = levelCount; mip-- > 0;) {
+        const CookedTextureLevel& level = texture.levels[mip];
+        dataSize = alignUp(dataSize, alignment);
+        levels[mip] = {dataSize, level.size, level.size};
+        dataSize += level.size;
+    }
+    std::vector<uint8_t> data(dataSize, 0);
+    for (uint32_t mip = 0; mip < levelCount; mip++)
+        std::memcpy(data.data() + levels[mip].byteOffset, texture.data.data() + texture.levels[mip].offset,
+                    texture.levels[mip].size);
+
+    // Keys are sorted by their bytes
+    KtxCookInfo info{COOK_VERSION, cookFlags, source.size, source.time, xxHash64(data.data(), data.size())};
+    std::vector<uint8_t> kvd;
+    appendKeyValue(kvd, "KTXwriter", WRITER, sizeof(WRITER));
+    appendKeyValue(kvd, COOK_KEY, &info, sizeof(info));
+
+    KtxHeader header{};
+    std::memcpy(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+    header.vkFormat = static_cast<uint32_t>(texture.format);
+    header.typeSize = 1;
+    header.pixelWidth = texture.width;
+    header.pixelHeight = texture.height;
+    header.faceCount = 1;
+    header.levelCount = levelCount;
+    header.dfdByteOffset = static_cast<uint32_t>(sizeof(KtxHeader) + sizeof(KtxLevel) * levelCount);
+    header.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+    header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+    header.kvdByteLength = static_cast<uint32_t>(kvd.size());
+
+    uint64_t dataBegin = alignUp(header.kvdByteOffset + header.kvdByteLength, alignment);
+    for (KtxLevel& level : levels) level.byteOffset += dataBegin;
+
+    std::vector<uint8_t> bytes(dataBegin + dataSize, 0);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    std::memcpy(bytes.data() + sizeof(header), levels.data(), sizeof(KtxLevel) * levelCount);
+    std::memcpy(bytes.data() + header.dfdByteOffset, dfd.data(), header.dfdByteLength);
+    std::memcpy(bytes.data() + header.kvdByteOffset, kvd.data(), kvd.size());
+    std::memcpy(bytes.data() + dataBegin, data.data(), data.size());
+
+    std::error_code ec;
+    std::string tmpFile = TempFile::pathFor(path);
+    {
+        std::ofstream f(tmpFile, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            LOG(Assets, Warn, "Cannot write texture file %s", path.c_str());
+            return false;
+        }
+        f.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!f) {
+            LOG(Assets, Warn, "Failed writing texture file %s", path.c_str());
+            f.close();
+            std::filesystem::remove(tmpFile, ec);
+            return false;
+        }
+    }
+    if (!TempFile::replace(tmpFile, path, ec)) {
+        LOG(Assets, Warn, "Failed to move texture file into place: %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool KtxFile::open(const std::string& path, bool verifyChecksum) {
+    close();
+    const PackFile* pack = PackFile::mounted();
+    if (const PackEntry* entry = pack ? pack->find(path) : nullptr) {
+        m_bytes = pack->view(*entry);
+        if (m_bytes.empty()) {
+            if (!pack->read(*entry, m_unpacked)) return false;
+            m_bytes = m_unpacked;
+        }
+    } else {
+        if (!m_file.open(path)) return false;
+        m_bytes = {m_file.data(), m_file.size()};
+    }
+    return parse(path, verifyChecksum);
+}
+
+bool KtxFile::open(std::span<const uint8_t> bytes, const std::string& name, bool verifyChecksum) {
+    close();
+    m_bytes = bytes;
+    return parse(name, verifyChecksum);
+}
+
+bool KtxFile::parse(const std::string& name, bool verifyChecksum) {
+    auto fail = [&](const char* reason) {
+        LOG(Assets, Warn, "Rejecting texture file %s: %s", name.c_str(), reason);
+        close();
+        return false;
+    };
+
+    const uint8_t* bytes = m_bytes.data();
+    uint64_t size = m_bytes.size();
+    if (size < sizeof(KtxHeader)) return fail("truncated header");
+    const auto* header = reinterpret_cast<const KtxHeader*>(bytes);
+    if (std::memcmp(header->identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0) return fail("not a KTX2 file");
+    if (header->pixelWidth == 0 || header->pixelHeight == 0 || header->pixelDepth != 0 ||
+        header->layerCount > 1 || header->faceCount != 1)
+        return fail("not a 2D texture");
+    if (header->supercompressionScheme != 0) return fail("supercompressed");
+    if (header->levelCount == 0 || header->levelCount > TextureCooker::mipCount(header->pixelWidth, header->pixelHeight))
+        return fail("bad level count");
+
+    uint64_t indexEnd = sizeof(KtxHeader) + uint64_t(sizeof(KtxLevel)) * header->levelCount;
+    if (indexEnd > size) return fail("truncated level index");
+    const auto* levels = reinterpret_cast<const KtxLevel*>(bytes + sizeof(KtxHeader));
+
+    auto format = static_cast<VkFormat>(header->vkFormat);
+    bool knownFormat = TextureCooker::blockBytes(format) != 0;
+    m_dataBegin = size;
+    m_dataEnd = 0;
+    for (uint32_t mip = 0; mip < header->levelCount; mip++) {
+        const KtxLevel& level = levels[mip];
+        if (level.byteOffset < indexEnd || level.byteOffset > size || level.byteLength > size - level.byteOffset)
+            return fail("level out of range");
+        uint32_t width = std::max(header->pixelWidth >> mip, 1u);
+        uint32_t height = std::max(header->pixelHeight >> mip, 1u);
+        if (knownFormat && level.byteLength != TextureCooker::levelSize(format, width, height))
+            return fail("level size mismatch");
+        m_dataBegin = std::min(m_dataBegin, level.byteOffset);
+        m_dataEnd = std::max(m_dataEnd, level.byteOffset + level.byteLength);
+    }
+
+    m_hasCookInfo = false;
+    uint64_t kvdEnd = uint64_t(header->kvdByteOffset) + header->kvdByteLength;
+    if (kvdEnd > size) return fail("key/value data out of range");
+    for (uint64_t pos = header->kvdByteOffset; pos + 4 <= kvdEnd;) {
+        uint32_t length;
+        std::memcpy(&length, bytes + pos, 4);
+        if (length > kvdEnd - pos - 4) return fail("bad key/value entry");
+        const char* key = reinterpret_cast<const char*>(bytes + pos + 4);
+        size_t keyLength = std::find(key, key + length, '\0') - key;
+        if (keyLength < length && std::strcmp(key, COOK_KEY) == 0 &&
+            length - keyLength - 1 == sizeof(KtxCookInfo)) {
+            std::memcpy(&m_cookInfo, key + keyLength + 1, sizeof(KtxCookInfo));
+            m_hasCookInfo = m_cookInfo.version == COOK_VERSION;
+        }
+        pos = alignUp(pos + 4 + length, 4);
+    }
+
+    if (verifyChecksum && m_hasCookInfo &&
+        xxHash64(bytes + m_dataBegin, m_dataEnd - m_dataBegin) != m_cookInfo.checksum)
+        return fail("checksum mismatch");
+
+    m_header = header;
+    m_levels = levels;
+    return true;
+}
+
+void KtxFile::close() {
+    m_header = nullptr;
+    m_levels = nullptr;
+    m_hasCookInfo = false;
+    m_bytes = {};
+    m_unpacked = {};
+    m_file.close();
+}
+
+std::span<const uint8_t> KtxFile::levelData() const {
+    return m_bytes.subspan(static_cast<size_t>(m_dataBegin), static_cast<size_t>(m_dataEnd - m_dataBegin));
+}
+
+std::vector<CookedTextureLevel> KtxFile::levels() const {
+    std::vector<CookedTextureLevel> out(m_header->levelCount);
+    for (uint32_t mip = 0; mip < m_header->levelCount; mip++) {
+        out[mip].width = std::max(m_header->pixelWidth >> mip, 1u);
+        out[mip].height = std::max(m_header->pixelHeight >> mip, 1u);
+        out[mip].offset = m_levels[mip].byteOffset - m_dataBegin;
+        out[mip].size = m_levels[mip].byteLength;
+    }
+    return out;
+}
+
+} // namespace lmao
@@ -0,0 +1,105 @@
+#pragma once
+#include "assets/MeshFile.h"
+#include "assets/TextureCooker.h"
+#include "core/MappedFile.h"
+#include <span>
+#include <string>
+#include <vector>
+
+namespace lmao {
+
+// .ktx2 (Khronos KTX 2.0) container for cooked textures: one 2D image with its mip chain,
+// no supercompression, levels stored smallest first as the format requires. The cooker
+// records its provenance under the "LMAOcook" key so loaders can tell a stale or corrupt
+// file; everything else is plain KTX2 and opens in standard tools. Little-endian only.
+//
+//   [KtxHeader, 80 B] [KtxLevel * levelCount] [data format descriptor] [key/value data]
+//   [mip N-1] ... [mip 0] -- each level starts on TextureCooker::levelAlignment
+struct KtxHeader {
+    uint8_t identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+static_assert(sizeof(KtxHeader) == 80, "KtxHeader is part of the .ktx2 layout");
+
+struct KtxLevel {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+static_assert(sizeof(KtxLevel) == 24, "KtxLevel is part of the .ktx2 layout");
+
+// Value of the "LMAOcook" key
+struct KtxCookInfo {
+    uint32_t version;
+    uint32_t cookFlags;      // TextureCooker::cookFlags of the options used to cook
+    uint64_t sourceSize;     // size / mtime of the file this was cooked from (0 if none)
+    int64_t sourceTime;
+    uint64_t checksum;       // XXH64 of the level data range
+};
+static_assert(sizeof(KtxCookInfo) == 32, "KtxCookInfo is part of the .ktx2 layout");
+
+class KtxFile {
+public:
+    static constexpr uint32_t COOK_VERSION = 1;
+
+    KtxFile() = default;
+    KtxFile(const KtxFile&) = delete;
+    KtxFile& operator=(const KtxFile&) = delete;
+
+    // Validates the file, from the mounted PackFile when it holds the path (raw entries in
+    // place, compressed ones decompressed into memory) and mapped otherwise. Checksums are
+    // only verified on files this engine cooked.
+    bool open(const std::string& path, bool verifyChecksum = true);
+    // Same, over bytes already in memory (e.g. a staging buffer) that outlive the KtxFile;
+    // name is for messages
+    bool open(std::span<const uint8_t> bytes, const std::string& name, bool verifyChecksum = true);
+    void close();
+
+    bool isOpen() const { return m_header != nullptr; }
+    const KtxHeader& header() const { return *m_header; }
+    VkFormat format() const { return static_cast<VkFormat>(m_header->vkFormat); }
+
+    bool hasCookInfo() const { return m_hasCookInfo; }
+    const KtxCookInfo& cookInfo() const { return m_cookInfo; }
+    MeshFileSource source() const { return {m_cookInfo.sourceSize, m_cookInfo.sourceTime}; }
+
+    // Every level in one range (smallest mip first), and where each mip sits inside it.
+    // Valid while the file (and a pack it was opened from) stays open.
+    std::span<const uint8_t> levelData() const;
+    std::vector<CookedTextureLevel> levels() const;
+    // Where levelData() starts in the file, for readers that bypass the mapping or pack
+    uint64_t levelDataOffset() const { return m_dataBegin; }
+
+    // Writes through a temporary file and renames it into place
+    static bool write(const std::string& path, const CookedTexture& texture, uint32_t cookFlags = 0,
+                      const MeshFileSource& source = {});
+
+private:
+    bool parse(const std::string& name, bool verifyChecksum);
+
+    MappedFile m_file;
+    std::vector<uint8_t> m_unpacked;     // compressed pack entry
+    std::span<const uint8_t> m_bytes;    // whichever of the sources holds the file
+    const KtxHeader* m_header = nullptr;
+    const KtxLevel* m_levels = nullptr;
+    KtxCookInfo m_cookInfo{};
+    bool m_hasCookInfo = false;
+    uint64_t m_dataBegin = 0;
+    uint64_t m_dataEnd = 0;
+};
+
+} // namespace lmao
@@ -25,19 +25,13 @@ bool Material::init(VulkanContext& ctx, DescriptorManager& descMgr,
     m_paramsBuffer.upload(&m_params, sizeof(MaterialParams));
 
     // Allocate descriptor set
+    m_descriptors = &descMgr;
     m_descriptorSet = descMgr.allocate(layout);
 
-    // Write albedo texture (binding 0)
-    DescriptorManager::writeImage(ctx.device(), m_descriptorSet, 0,
-        m_albedoTex->imageView(), m_albedoTex->sampler());
-
-    // Write normal map (binding 1)
-    DescriptorManager::writeImage(ctx.device(), m_descriptorSet, 1,
-        m_normalTex->imageView(), m_normalTex->sampler());
-
-    // Write metallic-roughness map (binding 2)
-    DescriptorManager::writeImage(ctx.device(), m_descriptorSet, 2,
-        m_metalRoughTex->imageView(), m_metalRoughTex->sampler());
+    // Textures: albedo (binding 0), normal map (1), metallic-roughness (2)
+    writeTexture(ctx.device(), 0, *m_albedoTex);
+    writeTexture(ctx.device(), 1, *m_normalTex);
+    writeTexture(ctx.device(), 2, *m_metalRoughTex);
 
     // Write params UBO (binding 3)
     DescriptorManager::writeBuffer(ctx.device(), m_descriptorSet, 3,
@@ -49,11 +43,28 @@ bool Material::init(VulkanContext& ctx, DescriptorManager& descMgr,
     return true;
 }
 
+void Material::refreshTextures(VkDevice device) {
+    const Texture* textures[3] = {m_albedoTex.get(), m_normalTex.get(), m_metalRoughTex.get()};
+    for (uint32_t binding = 0; binding < 3; binding++) {
+        if (textures[binding] && textures[binding]->imageView() != m_boundViews[binding])
+            writeTexture(device, binding, *textures[binding]);
+    }
+}
+
+void Material::writeTexture(VkDevice device, uint32_t binding, const Texture& texture) {
+    DescriptorManager::writeImage(device, m_descriptorSet, binding, texture.imageView(), texture.sampler());
+    m_boundViews[binding] = texture.imageView();
+}
+
 void Material::shutdown() {
     m_paramsBuffer.shutdown();
     m_albedoTex.reset();
     m_normalTex.reset();
     m_metalRoughTex.reset();
+    // Materials released at runtime (AssetRegistry eviction) hand their set back to the pool
+    if (m_descriptors && m_descriptorSet)
+        m_descriptors->free(m_descriptorSet);
+    m_descriptors = nullptr;
     m_descriptorSet = VK_NULL_HANDLE;
 }
 
@@ -15,13 +15,16 @@ struct MaterialParams {
     float metallic = 0.0f;
     float roughness = 0.5f;
     float normalScale = 1.0f;
-    float _pad{};
+    int32_t virtualTexture = -1;  // VirtualTextureSystem id replacing albedoMap (must match gbuffer.frag)
 };
 
 class Material {
 public:
     Material() = default;
-    ~Material() = default;
+    ~Material() { shutdown(); }
+
+    Material(const Material&) = delete;
+    Material& operator=(const Material&) = delete;
 
     bool init(VulkanContext& ctx, DescriptorManager& descMgr,
               VkDescriptorSetLayout layout,
@@ -31,16 +34,29 @@ public:
               const MaterialParams& params = {});
     void shutdown();
 
+    // Rewrites the texture bindings whose image view changed since they were written (a
+    // streamed texture swapped its image). The set must not be in use by pending work.
+    void refreshTextures(VkDevice device);
+
     VkDescriptorSet descriptorSet() const { return m_descriptorSet; }
     const MaterialParams& params() const { return m_params; }
+    const std::shared_ptr<Texture>& albedoTexture() const { return m_albedoTex; }
+    const std::shared_ptr<Texture>& normalTexture() const { return m_normalTex; }
+    const std::shared_ptr<Texture>& metalRoughTexture() const { return m_metalRoughTex; }
+    // Bytes of GPU memory the material owns itself (its textures are shared)
+    VkDeviceSize memorySize() const { return m_paramsBuffer.size(); }
 
 private:
+    void writeTexture(VkDevice device, uint32_t binding, const Texture& texture);
+
     std::shared_ptr<Texture> m_albedoTex;
     std::shared_ptr<Texture> m_normalTex;
     std::shared_ptr<Texture> m_metalRoughTex;
     MaterialParams m_params;
     Buffer m_paramsBuffer;
+    DescriptorManager* m_descriptors = nullptr;
     VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+    VkImageView m_boundViews[3] = {};  // per texture binding, as last written
 };
 
 } // namespace lmao
@@ -1,60 +1,146 @@
 #include "assets/Mesh.h"
-#include "vulkan/CommandPool.h"
+#include "assets/MeshProcessor.h"
+#include "vulkan/UploadManager.h"
 #include "core/Log.h"
+#include <cmath>
+#include <cstring>
 
 namespace lmao {
 
-bool Mesh::init(VmaAllocator allocator, VkQueue graphicsQueue, CommandPool& cmdPool,
-                const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
-    m_indexCount = static_cast<uint32_t>(indices.size());
+void Mesh::cook(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                const MeshOptions& options, CookedMesh& out) {
+    out = CookedMesh{};
+    out.vertexFormat = options.vertexFormat;
+
+    // Processing stages work on copies; untouched input is packed directly
+    const std::vector<Vertex>* srcVertices = &vertices;
+    const std::vector<uint32_t>* srcIndices = &indices;
+    std::vector<Vertex> workVertices;
+    std::vector<uint32_t> workIndices;
+    auto makeWorkCopy = [&]() {
+        if (srcVertices == &workVertices) return;
+        workVertices = vertices;
+        workIndices = indices;
+        srcVertices = &workVertices;
+        srcIndices = &workIndices;
+    };
+
+    if (options.optimize) {
+        makeWorkCopy();
+        MeshProcessor::optimize(workVertices, workIndices);
+    }
+
+    // Split oversized meshes into 16-bit addressable ranges when requested
+    bool fitsIndex16 = srcVertices->size() <= MeshProcessor::MAX_INDEX16_VERTICES;
+    if (options.index16 && !fitsIndex16 && options.splitForIndex16) {
+        makeWorkCopy();
+        MeshProcessor::splitForIndex16(workVertices, workIndices, out.submeshes);
+        fitsIndex16 = true;
+    } else {
+        out.submeshes.push_back({0, static_cast<uint32_t>(srcIndices->size()), 0});
+    }
+
+    out.vertexCount = static_cast<uint32_t>(srcVertices->size());
+    out.indexCount = static_cast<uint32_t>(srcIndices->size());
+    out.indexType = (options.index16 && fitsIndex16) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
 
     // Compute AABB
-    m_bounds = AABB{};
-    for (const auto& v : vertices)
-        m_bounds.expand(v.position);
-
-    VkDeviceSize vbSize = vertices.size() * sizeof(Vertex);
-    VkDeviceSize ibSize = indices.size() * sizeof(uint32_t);
-
-    // Vertex buffer
-    m_vertexBuffer.init(allocator, vbSize,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
-
-    Buffer staging;
-    staging.init(allocator, vbSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VMA_MEMORY_USAGE_AUTO,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
-    staging.upload(vertices.data(), vbSize);
-
-    cmdPool.submitImmediate(graphicsQueue, [&](VkCommandBuffer cmd) {
-        VkBufferCopy copy{};
-        copy.size = vbSize;
-        vkCmdCopyBuffer(cmd, staging.handle(), m_vertexBuffer.handle(), 1, &copy);
-    });
-    staging.shutdown();
+    for (const auto& v : *srcVertices)
+        out.bounds.expand(v.position);
+
+    // Texture density for streaming: area-weighted over every triangle
+    double uvArea = 0.0, surfaceArea = 0.0;
+    for (const Submesh& range : out.submeshes) {
+        const uint32_t* idx = srcIndices->data() + range.firstIndex;
+        const Vertex* base = srcVertices->data() + range.vertexOffset;
+        for (uint32_t i = 0; i + 2 < range.indexCount; i += 3) {
+            const Vertex& a = base[idx[i]];
+            const Vertex& b = base[idx[i + 1]];
+            const Vertex& c = base[idx[i + 2]];
+            surfaceArea += 0.5 * glm::length(glm::cross(b.position - a.position, c.position - a.position));
+            vec2 e1 = b.uv - a.uv, e2 = c.uv - a.uv;
+            uvArea += 0.5 * std::abs(e1.x * e2.y - e1.y * e2.x);
+        }
+    }
+    if (surfaceArea > 0.0 && uvArea > 0.0)
+        out.uvDensity = static_cast<float>(std::sqrt(uvArea / surfaceArea));
+
+    // Convert to the GPU layout (quantization is relative to the AABB above)
+    out.vertices = VertexPacking::pack(*srcVertices, out.vertexFormat, out.bounds);
+
+    // Position-only stream
+    if (options.positionStream)
+        out.positions = VertexPacking::packPositions(*srcVertices, out.vertexFormat, out.bounds);
+
+    // Meshlets index the final (uploaded) index order, so they are built last
+    if (options.buildMeshlets && out.indexCount > 0) {
+        MeshProcessor::buildMeshlets(*srcVertices, *srcIndices, out.submeshes, out.meshlets);
+
+        // UNORM16 positions can land up to half a quantization step away on each axis
+        if (out.vertexFormat == VertexFormat::Packed) {
+            float slack = 0.5f * glm::length(out.bounds.max - out.bounds.min) / 65535.0f;
+            for (auto& m : out.meshlets)
+                m.boundingSphere.w += slack;
+        }
+    }
 
     // Index buffer
-    m_indexBuffer.init(allocator, ibSize,
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
-
-    staging.init(allocator, ibSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VMA_MEMORY_USAGE_AUTO,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
-    staging.upload(indices.data(), ibSize);
-
-    cmdPool.submitImmediate(graphicsQueue, [&](VkCommandBuffer cmd) {
-        VkBufferCopy copy{};
-        copy.size = ibSize;
-        vkCmdCopyBuffer(cmd, staging.handle(), m_indexBuffer.handle(), 1, &copy);
-    });
-    staging.shutdown();
-
-    LOG(Assets, Debug, "Mesh created: %zu verts, %u indices, AABB(%.1f,%.1f,%.1f)-(%.1f,%.1f,%.1f)",
-        vertices.size(), m_indexCount,
+    if (out.indexType == VK_INDEX_TYPE_UINT16) {
+        out.indices.resize(srcIndices->size() * sizeof(uint16_t));
+        uint16_t* dst = reinterpret_cast<uint16_t*>(out.indices.data());
+        for (size_t i = 0; i < srcIndices->size(); i++)
+            dst[i] = static_cast<uint16_t>((*srcIndices)[i]);
+    } else {
+        out.indices.resize(srcIndices->size() * sizeof(uint32_t));
+        if (!srcIndices->empty())
+            std::memcpy(out.indices.data(), srcIndices->data(), out.indices.size());
+    }
+}
+
+bool Mesh::init(VmaAllocator allocator, UploadManager& uploads,
+                const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                const MeshOptions& options) {
+    CookedMesh cooked;
+    cook(vertices, indices, options, cooked);
+    return init(allocator, uploads, cooked.data());
+}
+
+bool Mesh::init(VmaAllocator allocator, UploadManager& uploads, const MeshData& data) {
+    if (data.vertices.empty() || data.indices.empty() || data.submeshes.empty()) {
+        LOG(Assets, Error, "Mesh data has no vertices, indices or draw ranges");
+        return false;
+    }
+
+    m_vertexFormat = data.vertexFormat;
+    m_vertexCount = data.vertexCount;
+    m_indexCount = data.indexCount;
+    m_indexType = data.indexType;
+    m_bounds = data.bounds;
+    m_uvDensity = data.uvDensity;
+    m_submeshes.assign(data.submeshes.begin(), data.submeshes.end());
+    m_positionScale = VertexPacking::positionScale(m_vertexFormat, m_bounds);
+    m_positionOffset = VertexPacking::positionOffset(m_vertexFormat, m_bounds);
+
+    auto upload = [&](Buffer& dst, std::span<const uint8_t> src, VkBufferUsageFlags usage) {
+        if (src.empty()) return;
+        dst.init(allocator, src.size(),
+            usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+        uploads.uploadBuffer(dst.handle(), src.data(), src.size());
+    };
+
+    upload(m_vertexBuffer, data.vertices, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    upload(m_positionBuffer, data.positions, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    upload(m_indexBuffer, data.indices, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+    upload(m_meshletBuffer, {reinterpret_cast<const uint8_t*>(data.meshlets.data()), data.meshlets.size_bytes()},
+           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT);
+
+    m_meshletCount = static_cast<uint32_t>(data.meshlets.size());
+    m_meshletAddress = m_meshletCount > 0 ? m_meshletBuffer.deviceAddress() : 0;
+
+    LOG(Assets, Debug, "Mesh created: %u verts (%u B/vert), %u indices (%s, %zu ranges, %u meshlets), AABB(%.1f,%.1f,%.1f)-(%.1f,%.1f,%.1f)",
+        m_vertexCount, VertexPacking::vertexStride(m_vertexFormat), m_indexCount,
+        m_indexType == VK_INDEX_TYPE_UINT16 ? "u16" : "u32", m_submeshes.size(), m_meshletCount,
         m_bounds.min.x, m_bounds.min.y, m_bounds.min.z,
         m_bounds.max.x, m_bounds.max.y, m_bounds.max.z);
     return true;
@@ -63,6 +149,12 @@ bool Mesh::init(VmaAllocator allocator, VkQueue graphicsQueue, CommandPool& cmdP
 void Mesh::shutdown() {
     m_vertexBuffer.shutdown();
     m_indexBuffer.shutdown();
+    m_positionBuffer.shutdown();
+    m_meshletBuffer.shutdown();
+    m_submeshes.clear();
+    m_meshletCount = 0;
+    m_meshletAddress = 0;
+    m_vertexCount = 0;
     m_indexCount = 0;
 }
 
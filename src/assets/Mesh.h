@@ -1,11 +1,83 @@
 #pragma once
 #include "vulkan/Buffer.h"
+#include "assets/VertexFormat.h"
 #include "math/MathUtils.h"
+#include <span>
 #include <vector>
 
 namespace lmao {
 
-class CommandPool;
+class UploadManager;
+
+struct MeshOptions {
+    VertexFormat vertexFormat = VertexFormat::Standard;
+    // Emit a separate tightly packed position stream for depth-only passes
+    bool positionStream = true;
+    // Store 16-bit indices whenever every draw range addresses at most 65536 vertices
+    bool index16 = true;
+    // Split meshes above the 16-bit limit into <=64k-vertex sub-ranges (duplicates
+    // boundary vertices). Used by importers; generated primitives never need it.
+    bool splitForIndex16 = false;
+    // Run MeshProcessor::optimize (vertex cache, overdraw, vertex fetch) before upload
+    bool optimize = true;
+    // Partition the index buffer into meshlets for GPU cluster culling
+    bool buildMeshlets = true;
+};
+
+// Contiguous index range drawn with its own base vertex
+struct Submesh {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    int32_t vertexOffset = 0;
+};
+
+// Cluster of at most 64 vertices / 124 triangles occupying a contiguous index range.
+// Uploaded as-is (std430, 48 bytes) and read by shaders/deferred/meshlet_cull.comp.
+struct Meshlet {
+    vec4 boundingSphere;  // xyz = object-space center, w = radius
+    vec4 cone;            // xyz = normal cone axis, w = sin of the cone spread (>= 1 never culls)
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    int32_t vertexOffset = 0;
+    uint32_t padding = 0;
+};
+static_assert(sizeof(Meshlet) == 48, "Meshlet must match the std430 layout in meshlet_cull.comp");
+
+// GPU-ready mesh content: every stream is already in the layout the device consumes, so
+// uploading is a straight copy. Views into memory owned by a CookedMesh or a mapped MeshFile.
+struct MeshData {
+    VertexFormat vertexFormat = VertexFormat::Standard;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    AABB bounds;
+    std::span<const uint8_t> vertices;   // vertexCount * VertexPacking::vertexStride(vertexFormat)
+    std::span<const uint8_t> positions;  // optional position-only stream
+    std::span<const uint8_t> indices;    // uint16 or uint32 per indexType
+    std::span<const Submesh> submeshes;
+    std::span<const Meshlet> meshlets;   // optional
+    float uvDensity = 0.0f;              // see Mesh::uvDensity
+};
+
+// Owning output of Mesh::cook
+struct CookedMesh {
+    VertexFormat vertexFormat = VertexFormat::Standard;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    AABB bounds;
+    std::vector<uint8_t> vertices;
+    std::vector<uint8_t> positions;
+    std::vector<uint8_t> indices;
+    std::vector<Submesh> submeshes;
+    std::vector<Meshlet> meshlets;
+    float uvDensity = 0.0f;
+
+    MeshData data() const {
+        return {vertexFormat, indexType, vertexCount, indexCount, bounds,
+                vertices, positions, indices, submeshes, meshlets, uvDensity};
+    }
+};
 
 class Mesh {
 public:
@@ -17,20 +89,76 @@ public:
     Mesh(const Mesh&) = delete;
     Mesh& operator=(const Mesh&) = delete;
 
-    bool init(VmaAllocator allocator, VkQueue graphicsQueue, CommandPool& cmdPool,
-              const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+    // Vertices are converted to options.vertexFormat before upload. Uploads are recorded
+    // into the current UploadManager batch; the mesh is drawable by any graphics submission
+    // made after that batch is submitted.
+    bool init(VmaAllocator allocator, UploadManager& uploads,
+              const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+              const MeshOptions& options = {});
+    // Uploads pre-cooked streams as-is, without conversion
+    bool init(VmaAllocator allocator, UploadManager& uploads, const MeshData& data);
     void shutdown();
 
+    // Runs the CPU side of init (optimize, 16-bit split, packing, meshlets) without uploading
+    static void cook(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                     const MeshOptions& options, CookedMesh& out);
+
     VkBuffer vertexBuffer() const { return m_vertexBuffer.handle(); }
     VkBuffer indexBuffer() const { return m_indexBuffer.handle(); }
+    uint32_t vertexCount() const { return m_vertexCount; }
     uint32_t indexCount() const { return m_indexCount; }
+    VkIndexType indexType() const { return m_indexType; }
+    // Always at least one range; more than one only when split for 16-bit indices
+    const std::vector<Submesh>& submeshes() const { return m_submeshes; }
     const AABB& bounds() const { return m_bounds; }
+    // Texture coordinate units per object-space unit, sqrt(UV area / surface area) over all
+    // triangles; drives texture streaming. 0 when unknown (meshes cooked before it existed).
+    float uvDensity() const { return m_uvDensity; }
+
+    VertexFormat vertexFormat() const { return m_vertexFormat; }
+    // Object-space position = positionOffset + decoded position * positionScale
+    const vec4& positionScale() const { return m_positionScale; }
+    const vec4& positionOffset() const { return m_positionOffset; }
+
+    // Position-only stream for depth-only passes (shadows, depth prepass). Falls back to
+    // the interleaved buffer when none was emitted; position is at offset 0 in every layout.
+    bool hasPositionStream() const { return m_positionBuffer.handle() != VK_NULL_HANDLE; }
+    VkBuffer positionBuffer() const {
+        return hasPositionStream() ? m_positionBuffer.handle() : m_vertexBuffer.handle();
+    }
+    VkDeviceSize positionStride() const {
+        return hasPositionStream() ? VertexPacking::positionStride(positionEncoding())
+                                   : VertexPacking::vertexStride(m_vertexFormat);
+    }
+    PositionEncoding positionEncoding() const { return VertexPacking::positionEncoding(m_vertexFormat); }
+
+    // Meshlet records in a device-address storage buffer; zero when built without meshlets
+    bool hasMeshlets() const { return m_meshletCount > 0; }
+    uint32_t meshletCount() const { return m_meshletCount; }
+    VkDeviceAddress meshletAddress() const { return m_meshletAddress; }
+
+    // Bytes of every GPU buffer the mesh owns
+    VkDeviceSize memorySize() const {
+        return m_vertexBuffer.size() + m_indexBuffer.size() + m_positionBuffer.size() + m_meshletBuffer.size();
+    }
 
 private:
     Buffer m_vertexBuffer;
     Buffer m_indexBuffer;
+    Buffer m_positionBuffer;
+    Buffer m_meshletBuffer;
+    uint32_t m_meshletCount = 0;
+    VkDeviceAddress m_meshletAddress = 0;
+    uint32_t m_vertexCount = 0;
     uint32_t m_indexCount = 0;
+    VkIndexType m_indexType = VK_INDEX_TYPE_UINT32;
+    std::vector<Submesh> m_submeshes;
     AABB m_bounds;
+    float m_uvDensity = 0.0f;
+
+    VertexFormat m_vertexFormat = VertexFormat::Standard;
+    vec4 m_positionScale{1.0f, 1.0f, 1.0f, 0.0f};
+    vec4 m_positionOffset{0.0f};
 };
 
 } // namespace lmao
@@ -0,0 +1,243 @@
+#include "assets/MeshFile.h"
+#include "core/Hash.h"
+#include "core/TempFile.h"
+#include "core/Log.h"
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace lmao {
+
+static_assert(std::endian::native == std::endian::little, ".lmesh sections are stored little-endian");
+
+namespace {
+constexpr uint32_t COOK_OPTIMIZED      = 1u << 0;
+constexpr uint32_t COOK_POSITIONS      = 1u << 1;
+constexpr uint32_t COOK_INDEX16        = 1u << 2;
+constexpr uint32_t COOK_SPLIT_INDEX16  = 1u << 3;
+constexpr uint32_t COOK_MESHLETS       = 1u << 4;
+
+uint64_t alignUp(uint64_t value) {
+    return (value + MeshFile::ALIGNMENT - 1) & ~(MeshFile::ALIGNMENT - 1);
+}
+
+uint32_t sectionIndex(MeshSection s) { return static_cast<uint32_t>(s); }
+
+// Byte size every section must have for the counts in the header
+bool expectedSectionSize(const MeshFileHeader& h, MeshSection s, uint64_t& size) {
+    auto format = static_cast<VertexFormat>(h.vertexFormat);
+    switch (s) {
+        case MeshSection::Lods:      size = uint64_t(h.lodCount) * sizeof(MeshFileLod); return true;
+        case MeshSection::Bounds:    size = sizeof(MeshFileBounds); return true;
+        case MeshSection::Vertices:  size = uint64_t(h.vertexCount) * VertexPacking::vertexStride(format); return true;
+        case MeshSection::Indices:   size = uint64_t(h.indexCount) * h.indexSize; return true;
+        case MeshSection::Submeshes: size = uint64_t(h.submeshCount) * sizeof(Submesh); return true;
+        case MeshSection::Meshlets:  size = uint64_t(h.meshletCount) * sizeof(Meshlet); return true;
+        case MeshSection::Positions:
+            // Optional stream: either absent or complete
+            size = uint64_t(h.vertexCount) * VertexPacking::positionStride(VertexPacking::positionEncoding(format));
+            if (h.sections[sectionIndex(s)].size == 0) size = 0;
+            return true;
+        default: return false;
+    }
+}
+} // anonymous namespace
+
+bool MeshFileSource::stat(const std::string& path, MeshFileSource& out) {
+    std::error_code ec;
+    out.size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    out.time = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+uint32_t MeshFile::cookFlags(const MeshOptions& options) {
+    uint32_t flags = 0;
+    if (options.optimize) flags |= COOK_OPTIMIZED;
+    if (options.positionStream) flags |= COOK_POSITIONS;
+    if (options.index16) flags |= COOK_INDEX16;
+    if (options.splitForIndex16) flags |= COOK_SPLIT_INDEX16;
+    if (options.buildMeshlets) flags |= COOK_MESHLETS;
+    return flags;
+}
+
+bool MeshFile::write(const std::string& path, const MeshData& data, uint32_t cookFlags,
+                     const MeshFileSource& source) {
+    MeshFileHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.headerSize = sizeof(MeshFileHeader);
+    header.cookFlags = cookFlags;
+    header.vertexFormat = static_cast<uint32_t>(data.vertexFormat);
+    header.indexSize = data.indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4;
+    header.vertexCount = data.vertexCount;
+    header.indexCount = data.indexCount;
+    header.lodCount = 1;
+    header.submeshCount = static_cast<uint32_t>(data.submeshes.size());
+    header.meshletCount = static_cast<uint32_t>(data.meshlets.size());
+    header.sourceSize = source.size;
+    header.sourceTime = source.time;
+
+    MeshFileLod lod;
+    lod.submeshCount = header.submeshCount;
+    lod.meshletCount = header.meshletCount;
+
+    MeshFileBounds bounds;
+    bounds.min = vec4(data.bounds.min, data.uvDensity);
+    bounds.max = vec4(data.bounds.max, 0.0f);
+    bounds.sphere = vec4(data.bounds.center(), 0.5f * glm::length(data.bounds.max - data.bounds.min));
+
+    const std::span<const uint8_t> payload[] = {
+        {reinterpret_cast<const uint8_t*>(&lod), sizeof(lod)},
+        {reinterpret_cast<const uint8_t*>(&bounds), sizeof(bounds)},
+        data.vertices,
+        data.positions,
+        data.indices,
+        {reinterpret_cast<const uint8_t*>(data.submeshes.data()), data.submeshes.size_bytes()},
+        {reinterpret_cast<const uint8_t*>(data.meshlets.data()), data.meshlets.size_bytes()},
+    };
+    static_assert(std::size(payload) == static_cast<size_t>(MeshSection::Count));
+
+    uint64_t offset = alignUp(sizeof(MeshFileHeader));
+    for (uint32_t i = 0; i < std::size(payload); i++) {
+        header.sections[i].offset = offset;
+        header.sections[i].size = payload[i].size();
+        offset = alignUp(offset + payload[i].size());
+    }
+    header.fileSize = offset;
+
+    // Assemble the whole file so the checksum can go into the header in one write
+    std::vector<uint8_t> bytes(header.fileSize, 0);
+    for (uint32_t i = 0; i < std::size(payload); i++) {
+        if (!payload[i].empty())
+            std::memcpy(bytes.data() + header.sections[i].offset, payload[i].data(), payload[i].size());
+    }
+    header.checksum = xxHash64(bytes.data() + header.headerSize, bytes.size() - header.headerSize);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    std::error_code ec;
+    std::string tmpFile = TempFile::pathFor(path);
+    {
+        std::ofstream f(tmpFile, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            LOG(Assets, Warn, "Cannot write mesh file %s", path.c_str());
+            return false;
+        }
+        f.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!f) {
+            LOG(Assets, Warn, "Failed writing mesh file %s", path.c_str());
+            f.close();
+            std::filesystem::remove(tmpFile, ec);
+            return false;
+        }
+    }
+    if (!TempFile::replace(tmpFile, path, ec)) {
+        LOG(Assets, Warn, "Failed to move mesh file into place: %s", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool MeshFile::open(const std::string& path, bool verifyChecksum) {
+    close();
+    if (!m_file.open(path)) return false;
+
+    auto fail = [&](const char* reason) {
+        LOG(Assets, Warn, "Rejecting mesh file %s: %s", path.c_str(), reason);
+        close();
+        return false;
+    };
+
+    if (m_file.size() < sizeof(MeshFileHeader)) return fail("truncated header");
+    // The mapping is page aligned, and so is every section relative to it
+    const auto* header = reinterpret_cast<const MeshFileHeader*>(m_file.data());
+    if (header->magic != MAGIC) return fail("bad magic");
+    if (header->version != VERSION) return fail("unsupported version");
+    if (header->headerSize != sizeof(MeshFileHeader)) return fail("bad header size");
+    if (header->fileSize != m_file.size()) return fail("size mismatch");
+    if (header->indexSize != 2 && header->indexSize != 4) return fail("bad index size");
+    if (header->vertexFormat >= VERTEX_FORMAT_COUNT)
+        return fail("unknown vertex format");
+    if (header->lodCount == 0 || header->submeshCount == 0) return fail("no draw ranges");
+
+    for (uint32_t i = 0; i < sectionIndex(MeshSection::Count); i++) {
+        const MeshFileSectionEntry& entry = header->sections[i];
+        uint64_t expected = 0;
+        if (!expectedSectionSize(*header, static_cast<MeshSection>(i), expected) || entry.size != expected)
+            return fail("section size mismatch");
+        if (entry.offset % ALIGNMENT != 0 || entry.offset < header->headerSize ||
+            entry.offset > header->fileSize || entry.size > header->fileSize - entry.offset)
+            return fail("section out of range");
+    }
+
+    auto lods = reinterpret_cast<const MeshFileLod*>(m_file.data() + header->sections[sectionIndex(MeshSection::Lods)].offset);
+    for (uint32_t i = 0; i < header->lodCount; i++) {
+        const MeshFileLod& lod = lods[i];
+        if (lod.submeshCount == 0 ||
+            uint64_t(lod.firstSubmesh) + lod.submeshCount > header->submeshCount ||
+            uint64_t(lod.firstMeshlet) + lod.meshletCount > header->meshletCount)
+            return fail("LOD range out of bounds");
+    }
+
+    if (verifyChecksum &&
+        xxHash64(m_file.data() + header->headerSize, m_file.size() - header->headerSize) != header->checksum)
+        return fail("checksum mismatch");
+
+    m_header = header;
+    return true;
+}
+
+void MeshFile::close() {
+    m_header = nullptr;
+    m_file.close();
+}
+
+std::span<const uint8_t> MeshFile::section(MeshSection s) const {
+    const MeshFileSectionEntry& entry = m_header->sections[sectionIndex(s)];
+    return {m_file.data() + entry.offset, static_cast<size_t>(entry.size)};
+}
+
+MeshData MeshFile::data(uint32_t lod) const {
+    MeshData data;
+    if (!m_header || lod >= m_header->lodCount) return data;
+
+    const auto* lods = reinterpret_cast<const MeshFileLod*>(section(MeshSection::Lods).data());
+    const auto* bounds = reinterpret_cast<const MeshFileBounds*>(section(MeshSection::Bounds).data());
+    const auto* submeshes = reinterpret_cast<const Submesh*>(section(MeshSection::Submeshes).data());
+    const auto* meshlets = reinterpret_cast<const Meshlet*>(section(MeshSection::Meshlets).data());
+
+    data.vertexFormat = static_cast<VertexFormat>(m_header->vertexFormat);
+    data.indexType = m_header->indexSize == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    data.vertexCount = m_header->vertexCount;
+    data.indexCount = m_header->indexCount;
+    data.bounds.min = vec3(bounds->min);
+    data.bounds.max = vec3(bounds->max);
+    data.uvDensity = bounds->min.w;
+    data.vertices = section(MeshSection::Vertices);
+    data.positions = section(MeshSection::Positions);
+    data.indices = section(MeshSection::Indices);
+    data.submeshes = {submeshes + lods[lod].firstSubmesh, lods[lod].submeshCount};
+    data.meshlets = {meshlets + lods[lod].firstMeshlet, lods[lod].meshletCount};
+    return data;
+}
+
+std::shared_ptr<Mesh> MeshFile::load(VmaAllocator allocator, UploadManager& uploads,
+                                     const std::string& path) {
+    auto start = std::chrono::steady_clock::now();
+
+    MeshFile file;
+    if (!file.open(path)) return nullptr;
+
+    auto mesh = std::make_shared<Mesh>();
+    if (!mesh->init(allocator, uploads, file.data()))
+        return nullptr;
+
+    LOG(Assets, Debug, "Loaded %s: %.2f MB in %.1f ms", path.c_str(),
+        file.header().fileSize / (1024.0 * 1024.0),
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return mesh;
+}
+
+} // namespace lmao
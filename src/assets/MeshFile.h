@@ -0,0 +1,119 @@
+#pragma once
+#include "assets/Mesh.h"
+#include "core/MappedFile.h"
+#include <memory>
+#include <string>
+
+namespace lmao {
+
+class UploadManager;
+
+// .lmesh: engine-native cooked mesh. Every section is stored exactly as Mesh uploads it
+// (packed vertices, position stream, 16/32-bit indices, Submesh and Meshlet records), so
+// loading is mmap + checksum + one memcpy per section into the staging buffer.
+//
+//   [MeshFileHeader, 256 B] [section]* -- each section starts on a MeshFile::ALIGNMENT
+//   boundary, padding is zero. Little-endian only.
+enum class MeshSection : uint32_t {
+    Lods,       // MeshFileLod[lodCount]
+    Bounds,     // MeshFileBounds
+    Vertices,   // vertexCount * VertexPacking::vertexStride(vertexFormat)
+    Positions,  // vertexCount * VertexPacking::positionStride(...), or empty
+    Indices,    // indexCount * (2 or 4)
+    Submeshes,  // Submesh[submeshCount]
+    Meshlets,   // Meshlet[meshletCount], or empty
+    Count
+};
+
+struct MeshFileSectionEntry {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+// A level of detail is a run of submeshes (and the meshlets built from them) inside the
+// shared vertex and index streams. Meshes cooked today carry a single level.
+struct MeshFileLod {
+    uint32_t firstSubmesh = 0;
+    uint32_t submeshCount = 0;
+    uint32_t firstMeshlet = 0;
+    uint32_t meshletCount = 0;
+    float error = 0.0f;          // object-space simplification error
+    uint32_t reserved[3] = {};
+};
+static_assert(sizeof(MeshFileLod) == 32, "MeshFileLod is part of the .lmesh layout");
+
+struct MeshFileBounds {
+    vec4 min;     // w = Mesh::uvDensity (0 = unknown)
+    vec4 max;     // w unused
+    vec4 sphere;  // xyz = center, w = radius
+};
+static_assert(sizeof(MeshFileBounds) == 48, "MeshFileBounds is part of the .lmesh layout");
+
+struct MeshFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint64_t fileSize;
+    uint64_t checksum;           // XXH64 of bytes [headerSize, fileSize)
+    uint32_t cookFlags;          // MeshFile::cookFlags() of the options used to cook
+    uint32_t vertexFormat;       // VertexFormat
+    uint32_t indexSize;          // 2 or 4
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t lodCount;
+    uint32_t submeshCount;
+    uint32_t meshletCount;
+    uint64_t sourceSize;         // size / mtime of the file this was cooked from (0 if none)
+    int64_t sourceTime;
+    MeshFileSectionEntry sections[static_cast<uint32_t>(MeshSection::Count)];
+    uint8_t reserved[256 - 72 - 16 * static_cast<uint32_t>(MeshSection::Count)];
+};
+static_assert(sizeof(MeshFileHeader) == 256, "MeshFileHeader must stay 256 bytes");
+
+// Provenance recorded in the header so importers can tell a stale cooked file
+struct MeshFileSource {
+    uint64_t size = 0;
+    int64_t time = 0;
+
+    static bool stat(const std::string& path, MeshFileSource& out);
+    bool operator==(const MeshFileSource&) const = default;
+};
+
+class MeshFile {
+public:
+    static constexpr uint32_t MAGIC = 0x48534D4C; // "LMSH"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint64_t ALIGNMENT = 256;
+
+    MeshFile() = default;
+    MeshFile(const MeshFile&) = delete;
+    MeshFile& operator=(const MeshFile&) = delete;
+
+    // Maps and validates the file; data() then views straight into the mapping
+    bool open(const std::string& path, bool verifyChecksum = true);
+    void close();
+
+    bool isOpen() const { return m_header != nullptr; }
+    const MeshFileHeader& header() const { return *m_header; }
+    MeshFileSource source() const { return {m_header->sourceSize, m_header->sourceTime}; }
+    // Streams of one level of detail; valid while the file stays open
+    MeshData data(uint32_t lod = 0) const;
+
+    // Writes through a temporary file and renames it into place
+    static bool write(const std::string& path, const MeshData& data, uint32_t cookFlags = 0,
+                      const MeshFileSource& source = {});
+
+    // Bits of MeshOptions that change the cooked content
+    static uint32_t cookFlags(const MeshOptions& options);
+
+    static std::shared_ptr<Mesh> load(VmaAllocator allocator, UploadManager& uploads,
+                                      const std::string& path);
+
+private:
+    std::span<const uint8_t> section(MeshSection s) const;
+
+    MappedFile m_file;
+    const MeshFileHeader* m_header = nullptr;
+};
+
+} // namespace lmao
@@ -1,62 +1,19 @@
 #include "assets/MeshGenerator.h"
-#include "vulkan/CommandPool.h"
+#include "assets/DerivedDataCache.h"
+#include "assets/MeshFile.h"
+#include "assets/MeshProcessor.h"
+#include "core/Hash.h"
 #include "core/Log.h"
+#include <charconv>
 #include <cmath>
+#include <cstdio>
+#include <filesystem>
 
 namespace lmao {
 
-void MeshGenerator::computeTangents(std::vector<Vertex>& vertices,
-                                     const std::vector<uint32_t>& indices) {
-    // Accumulate tangents per triangle
-    std::vector<vec3> tan(vertices.size(), vec3(0));
-
-    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
-        uint32_t i0 = indices[i], i1 = indices[i+1], i2 = indices[i+2];
-        const vec3& p0 = vertices[i0].position;
-        const vec3& p1 = vertices[i1].position;
-        const vec3& p2 = vertices[i2].position;
-        const vec2& uv0 = vertices[i0].uv;
-        const vec2& uv1 = vertices[i1].uv;
-        const vec2& uv2 = vertices[i2].uv;
-
-        vec3 e1 = p1 - p0, e2 = p2 - p0;
-        vec2 duv1 = uv1 - uv0, duv2 = uv2 - uv0;
-
-        float denom = duv1.x * duv2.y - duv2.x * duv1.y;
-        if (std::abs(denom) < 1e-8f) continue;
-        float r = 1.0f / denom;
-
-        vec3 t = (e1 * duv2.y - e2 * duv1.y) * r;
-        tan[i0] += t;
-        tan[i1] += t;
-        tan[i2] += t;
-    }
-
-    // Orthogonalize and store
-    for (size_t i = 0; i < vertices.size(); i++) {
-        const vec3& n = vertices[i].normal;
-        vec3 t = tan[i];
-        // Gram-Schmidt: project out normal component
-        t = t - n * glm::dot(n, t);
-        float len = glm::length(t);
-        if (len > 1e-6f) {
-            t /= len;
-        } else {
-            // Fallback: pick an arbitrary tangent perpendicular to normal
-            if (std::abs(n.x) < 0.9f)
-                t = glm::normalize(glm::cross(n, vec3(1, 0, 0)));
-            else
-                t = glm::normalize(glm::cross(n, vec3(0, 1, 0)));
-        }
-        vertices[i].tangent = vec4(t, 1.0f);
-    }
-}
-
-std::shared_ptr<Mesh> MeshGenerator::createCube(VmaAllocator alloc, VkQueue queue,
-                                                  CommandPool& pool, float size) {
+namespace {
+void buildCube(float size, std::vector<Vertex>& verts, std::vector<uint32_t>& idx) {
     float h = size * 0.5f;
-    std::vector<Vertex> verts;
-    std::vector<uint32_t> idx;
 
     // 6 faces, 4 vertices each
     struct Face { vec3 normal; vec3 up; vec3 right; };
@@ -89,20 +46,13 @@ std::shared_ptr<Mesh> MeshGenerator::createCube(VmaAllocator alloc, VkQueue queu
         idx.push_back(base + 2); idx.push_back(base + 3); idx.push_back(base + 0);
     }
 
-    computeTangents(verts, idx);
+    MeshProcessor::computeTangents(verts, idx);
 
-    auto mesh = std::make_shared<Mesh>();
-    mesh->init(alloc, queue, pool, verts, idx);
     LOG(Assets, Debug, "Generated cube: size=%.2f, %zu verts, %zu indices", size, verts.size(), idx.size());
-    return mesh;
 }
 
-std::shared_ptr<Mesh> MeshGenerator::createSphere(VmaAllocator alloc, VkQueue queue,
-                                                    CommandPool& pool,
-                                                    float radius, uint32_t segments, uint32_t rings) {
-    std::vector<Vertex> verts;
-    std::vector<uint32_t> idx;
-
+void buildSphere(float radius, uint32_t segments, uint32_t rings,
+                 std::vector<Vertex>& verts, std::vector<uint32_t>& idx) {
     for (uint32_t y = 0; y <= rings; y++) {
         float theta = static_cast<float>(y) / rings * PI;
         float sinT = std::sin(theta), cosT = std::cos(theta);
@@ -129,21 +79,13 @@ std::shared_ptr<Mesh> MeshGenerator::createSphere(VmaAllocator alloc, VkQueue qu
         }
     }
 
-    computeTangents(verts, idx);
+    MeshProcessor::computeTangents(verts, idx);
 
-    auto mesh = std::make_shared<Mesh>();
-    mesh->init(alloc, queue, pool, verts, idx);
     LOG(Assets, Debug, "Generated sphere: r=%.2f, %ux%u, %zu verts", radius, segments, rings, verts.size());
-    return mesh;
 }
 
-std::shared_ptr<Mesh> MeshGenerator::createPlane(VmaAllocator alloc, VkQueue queue,
-                                                   CommandPool& pool,
-                                                   float width, float depth,
-                                                   uint32_t subdivX, uint32_t subdivZ) {
-    std::vector<Vertex> verts;
-    std::vector<uint32_t> idx;
-
+void buildPlane(float width, float depth, uint32_t subdivX, uint32_t subdivZ,
+                std::vector<Vertex>& verts, std::vector<uint32_t>& idx) {
     for (uint32_t z = 0; z <= subdivZ; z++) {
         for (uint32_t x = 0; x <= subdivX; x++) {
             float u = static_cast<float>(x) / subdivX;
@@ -166,18 +108,12 @@ std::shared_ptr<Mesh> MeshGenerator::createPlane(VmaAllocator alloc, VkQueue que
         }
     }
 
-    computeTangents(verts, idx);
+    MeshProcessor::computeTangents(verts, idx);
 
-    auto mesh = std::make_shared<Mesh>();
-    mesh->init(alloc, queue, pool, verts, idx);
-    return mesh;
 }
 
-std::shared_ptr<Mesh> MeshGenerator::createCylinder(VmaAllocator alloc, VkQueue queue,
-                                                      CommandPool& pool,
-                                                      float radius, float height, uint32_t segments) {
-    std::vector<Vertex> verts;
-    std::vector<uint32_t> idx;
+void buildCylinder(float radius, float height, uint32_t segments,
+                   std::vector<Vertex>& verts, std::vector<uint32_t>& idx) {
     float halfH = height * 0.5f;
 
     // Side vertices
@@ -239,18 +175,12 @@ std::shared_ptr<Mesh> MeshGenerator::createCylinder(VmaAllocator alloc, VkQueue
         idx.push_back(botCenter + 2 + i);
     }
 
-    computeTangents(verts, idx);
+    MeshProcessor::computeTangents(verts, idx);
 
-    auto mesh = std::make_shared<Mesh>();
-    mesh->init(alloc, queue, pool, verts, idx);
-    return mesh;
 }
 
-std::shared_ptr<Mesh> MeshGenerator::createCone(VmaAllocator alloc, VkQueue queue,
-                                                  CommandPool& pool,
-                                                  float radius, float height, uint32_t segments) {
-    std::vector<Vertex> verts;
-    std::vector<uint32_t> idx;
+void buildCone(float radius, float height, uint32_t segments,
+               std::vector<Vertex>& verts, std::vector<uint32_t>& idx) {
     float halfH = height * 0.5f;
     float slope = radius / height;
 
@@ -299,20 +229,12 @@ std::shared_ptr<Mesh> MeshGenerator::createCone(VmaAllocator alloc, VkQueue queu
         idx.push_back(center + 2 + i);
     }
 
-    computeTangents(verts, idx);
+    MeshProcessor::computeTangents(verts, idx);
 
-    auto mesh = std::make_shared<Mesh>();
-    mesh->init(alloc, queue, pool, verts, idx);
-    return mesh;
 }
 
-std::shared_ptr<Mesh> MeshGenerator::createTorus(VmaAllocator alloc, VkQueue queue,
-                                                   CommandPool& pool,
-                                                   float majorR, float minorR,
-                                                   uint32_t majorSeg, uint32_t minorSeg) {
-    std::vector<Vertex> verts;
-    std::vector<uint32_t> idx;
-
+void buildTorus(float majorR, float minorR, uint32_t majorSeg, uint32_t minorSeg,
+                std::vector<Vertex>& verts, std::vector<uint32_t>& idx) {
     for (uint32_t i = 0; i <= majorSeg; i++) {
         float u = static_cast<float>(i) / majorSeg * TWO_PI;
         float cu = std::cos(u), su = std::sin(u);
@@ -341,12 +263,184 @@ std::shared_ptr<Mesh> MeshGenerator::createTorus(VmaAllocator alloc, VkQueue que
         }
     }
 
-    computeTangents(verts, idx);
+    MeshProcessor::computeTangents(verts, idx);
 
-    auto mesh = std::make_shared<Mesh>();
-    mesh->init(alloc, queue, pool, verts, idx);
     LOG(Assets, Debug, "Generated torus: R=%.2f r=%.2f, %zu verts", majorR, minorR, verts.size());
+}
+
+// Must match MeshPreset::Shape
+struct ShapeInfo {
+    const char* name;
+    uint32_t sizes;     // float arguments
+    uint32_t segments;  // integer arguments
+};
+constexpr ShapeInfo SHAPES[] = {
+    {"cube", 1, 0},
+    {"sphere", 1, 2},
+    {"plane", 2, 2},
+    {"cylinder", 2, 1},
+    {"cone", 2, 1},
+    {"torus", 2, 2},
+};
+static_assert(std::size(SHAPES) == static_cast<size_t>(MeshPreset::Shape::Count));
+
+template <typename T>
+bool parseNumber(std::string_view text, T& out) {
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+    return ec == std::errc() && end == text.data() + text.size();
+}
+} // anonymous namespace
+
+MeshPreset MeshPreset::cube(float size) { return {Shape::Cube, {size, 0.0f}, {0, 0}}; }
+
+MeshPreset MeshPreset::sphere(float radius, uint32_t segments, uint32_t rings) {
+    return {Shape::Sphere, {radius, 0.0f}, {segments, rings}};
+}
+
+MeshPreset MeshPreset::plane(float width, float depth, uint32_t subdivX, uint32_t subdivZ) {
+    return {Shape::Plane, {width, depth}, {subdivX, subdivZ}};
+}
+
+MeshPreset MeshPreset::cylinder(float radius, float height, uint32_t segments) {
+    return {Shape::Cylinder, {radius, height}, {segments, 0}};
+}
+
+MeshPreset MeshPreset::cone(float radius, float height, uint32_t segments) {
+    return {Shape::Cone, {radius, height}, {segments, 0}};
+}
+
+MeshPreset MeshPreset::torus(float majorRadius, float minorRadius, uint32_t majorSeg, uint32_t minorSeg) {
+    return {Shape::Torus, {majorRadius, minorRadius}, {majorSeg, minorSeg}};
+}
+
+bool MeshPreset::parse(std::string_view text, MeshPreset& out) {
+    size_t colon = text.find(':');
+    std::string_view name = text.substr(0, colon);
+    std::string_view arguments = colon == std::string_view::npos ? std::string_view() : text.substr(colon + 1);
+
+    static const MeshPreset defaults[] = {cube(), sphere(), plane(), cylinder(), cone(), torus()};
+    uint32_t shape = 0;
+    while (shape < std::size(SHAPES) && name != SHAPES[shape].name) shape++;
+    if (shape == std::size(SHAPES)) return false;
+    MeshPreset preset = defaults[shape];
+
+    const ShapeInfo& info = SHAPES[shape];
+    for (uint32_t i = 0; !arguments.empty(); i++) {
+        size_t comma = arguments.find(',');
+        std::string_view argument = arguments.substr(0, comma);
+        arguments = comma == std::string_view::npos ? std::string_view() : arguments.substr(comma + 1);
+        bool ok = i < info.sizes                  ? parseNumber(argument, preset.size[i])
+                  : i < info.sizes + info.segments ? parseNumber(argument, preset.segments[i - info.sizes])
+                                                   : false;
+        if (!ok) return false;
+    }
+    out = preset;
+    return true;
+}
+
+std::string MeshPreset::toString() const {
+    const ShapeInfo& info = SHAPES[static_cast<uint32_t>(shape)];
+    std::string text = info.name;
+    char argument[32];
+    for (uint32_t i = 0; i < info.sizes + info.segments; i++) {
+        if (i < info.sizes)
+            std::snprintf(argument, sizeof(argument), "%c%g", i == 0 ? ':' : ',', size[i]);
+        else
+            std::snprintf(argument, sizeof(argument), "%c%u", i == 0 ? ':' : ',', segments[i - info.sizes]);
+        text += argument;
+    }
+    return text;
+}
+
+void MeshGenerator::build(const MeshPreset& preset, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    vertices.clear();
+    indices.clear();
+    switch (preset.shape) {
+    case MeshPreset::Shape::Cube:
+        buildCube(preset.size[0], vertices, indices);
+        break;
+    case MeshPreset::Shape::Sphere:
+        buildSphere(preset.size[0], preset.segments[0], preset.segments[1], vertices, indices);
+        break;
+    case MeshPreset::Shape::Plane:
+        buildPlane(preset.size[0], preset.size[1], preset.segments[0], preset.segments[1], vertices, indices);
+        break;
+    case MeshPreset::Shape::Cylinder:
+        buildCylinder(preset.size[0], preset.size[1], preset.segments[0], vertices, indices);
+        break;
+    case MeshPreset::Shape::Cone:
+        buildCone(preset.size[0], preset.size[1], preset.segments[0], vertices, indices);
+        break;
+    case MeshPreset::Shape::Torus:
+        buildTorus(preset.size[0], preset.size[1], preset.segments[0], preset.segments[1], vertices, indices);
+        break;
+    case MeshPreset::Shape::Count:
+        break;
+    }
+}
+
+std::string MeshGenerator::cookedPath(const MeshPreset& preset, const MeshOptions& options) {
+    uint64_t source = xxHash64(&preset, sizeof(preset));
+    uint32_t flags = MeshFile::cookFlags(options) | static_cast<uint32_t>(options.vertexFormat) << 16;
+    return DerivedDataCache::entryPath(
+        DerivedDataCache::key("generated", source, flags, DerivedDataCache::MESH_VERSION), ".lmesh");
+}
+
+std::shared_ptr<Mesh> MeshGenerator::create(VmaAllocator alloc, UploadManager& uploads, const MeshPreset& preset,
+                                            const MeshOptions& options) {
+    uint32_t cookFlags = MeshFile::cookFlags(options);
+    std::string cookedFile = cookedPath(preset, options);
+    auto mesh = std::make_shared<Mesh>();
+    if (!cookedFile.empty()) {
+        std::error_code ec;
+        MeshFile cached;
+        if (std::filesystem::exists(cookedFile, ec) && cached.open(cookedFile) &&
+            cached.header().cookFlags == cookFlags &&
+            cached.header().vertexFormat == static_cast<uint32_t>(options.vertexFormat) &&
+            mesh->init(alloc, uploads, cached.data()))
+            return mesh;
+    }
+
+    std::vector<Vertex> verts;
+    std::vector<uint32_t> idx;
+    build(preset, verts, idx);
+    CookedMesh cooked;
+    Mesh::cook(verts, idx, options, cooked);
+    if (!cookedFile.empty())
+        MeshFile::write(cookedFile, cooked.data(), cookFlags);
+    mesh->init(alloc, uploads, cooked.data());
     return mesh;
 }
 
+std::shared_ptr<Mesh> MeshGenerator::createCube(VmaAllocator alloc, UploadManager& uploads, float size,
+                                                const MeshOptions& options) {
+    return create(alloc, uploads, MeshPreset::cube(size), options);
+}
+
+std::shared_ptr<Mesh> MeshGenerator::createSphere(VmaAllocator alloc, UploadManager& uploads, float radius,
+                                                  uint32_t segments, uint32_t rings, const MeshOptions& options) {
+    return create(alloc, uploads, MeshPreset::sphere(radius, segments, rings), options);
+}
+
+std::shared_ptr<Mesh> MeshGenerator::createPlane(VmaAllocator alloc, UploadManager& uploads, float width,
+                                                 float depth, uint32_t subdivX, uint32_t subdivZ,
+                                                 const MeshOptions& options) {
+    return create(alloc, uploads, MeshPreset::plane(width, depth, subdivX, subdivZ), options);
+}
+
+std::shared_ptr<Mesh> MeshGenerator::createCylinder(VmaAllocator alloc, UploadManager& uploads, float radius,
+                                                    float height, uint32_t segments, const MeshOptions& options) {
+    return create(alloc, uploads, MeshPreset::cylinder(radius, height, segments), options);
+}
+
+std::shared_ptr<Mesh> MeshGenerator::createCone(VmaAllocator alloc, UploadManager& uploads, float radius,
+                                                float height, uint32_t segments, const MeshOptions& options) {
+    return create(alloc, uploads, MeshPreset::cone(radius, height, segments), options);
+}
+
+std::shared_ptr<Mesh> MeshGenerator::createTorus(VmaAllocator alloc, UploadManager& uploads, float majorRadius,
+                                                 float minorRadius, uint32_t majorSeg, uint32_t minorSeg,
+                                                 const MeshOptions& options) {
+    return create(alloc, uploads, MeshPreset::torus(majorRadius, minorRadius, majorSeg, minorSeg), options);
+}
 } // namespace lmao
@@ -1,34 +1,73 @@
 #pragma once
 #include "assets/Mesh.h"
 #include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace lmao {
 
-class CommandPool;
+class UploadManager;
 
+// A generated primitive by value: its shape and the create* arguments that follow
+// `uploads`, floats first. MeshGenerator keys the cooked mesh in the DerivedDataCache by
+// these bytes, and lmao_cook takes them as text, e.g. "sphere:1,32,16".
+struct MeshPreset {
+    enum class Shape : uint32_t { Cube, Sphere, Plane, Cylinder, Cone, Torus, Count };
+
+    Shape shape = Shape::Cube;
+    float size[2] = {1.0f, 0.0f};   // unused arguments stay 0
+    uint32_t segments[2] = {0, 0};
+
+    static MeshPreset cube(float size = 1.0f);
+    static MeshPreset sphere(float radius = 1.0f, uint32_t segments = 32, uint32_t rings = 16);
+    static MeshPreset plane(float width = 10.0f, float depth = 10.0f, uint32_t subdivX = 1, uint32_t subdivZ = 1);
+    static MeshPreset cylinder(float radius = 1.0f, float height = 2.0f, uint32_t segments = 32);
+    static MeshPreset cone(float radius = 1.0f, float height = 2.0f, uint32_t segments = 32);
+    static MeshPreset torus(float majorRadius = 1.0f, float minorRadius = 0.3f,
+                            uint32_t majorSeg = 48, uint32_t minorSeg = 24);
+
+    // "<shape>[:<arg>,...]" with the arguments in create* order; missing ones take the defaults
+    static bool parse(std::string_view text, MeshPreset& out);
+    std::string toString() const;
+};
+static_assert(sizeof(MeshPreset) == 20, "MeshPreset is hashed as bytes and must have no padding");
+
+// Every create* goes through create(): the cooked mesh comes from the DerivedDataCache when
+// it holds one for the preset and options, and is stored there otherwise.
 class MeshGenerator {
 public:
-    static std::shared_ptr<Mesh> createCube(VmaAllocator alloc, VkQueue queue, CommandPool& pool,
-                                             float size = 1.0f);
-    static std::shared_ptr<Mesh> createSphere(VmaAllocator alloc, VkQueue queue, CommandPool& pool,
+    static std::shared_ptr<Mesh> create(VmaAllocator alloc, UploadManager& uploads, const MeshPreset& preset,
+                                        const MeshOptions& options = {});
+    // CPU only, thread-safe: the preset's triangles with tangents, before Mesh::cook
+    static void build(const MeshPreset& preset, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+    // DerivedDataCache entry (MeshFile) of the preset cooked with options; empty when the
+    // cache is disabled
+    static std::string cookedPath(const MeshPreset& preset, const MeshOptions& options);
+
+    static std::shared_ptr<Mesh> createCube(VmaAllocator alloc, UploadManager& uploads,
+                                             float size = 1.0f,
+                                             const MeshOptions& options = {});
+    static std::shared_ptr<Mesh> createSphere(VmaAllocator alloc, UploadManager& uploads,
                                                float radius = 1.0f,
-                                               uint32_t segments = 32, uint32_t rings = 16);
-    static std::shared_ptr<Mesh> createPlane(VmaAllocator alloc, VkQueue queue, CommandPool& pool,
+                                               uint32_t segments = 32, uint32_t rings = 16,
+                                               const MeshOptions& options = {});
+    static std::shared_ptr<Mesh> createPlane(VmaAllocator alloc, UploadManager& uploads,
                                               float width = 10.0f, float depth = 10.0f,
-                                              uint32_t subdivX = 1, uint32_t subdivZ = 1);
-    static std::shared_ptr<Mesh> createCylinder(VmaAllocator alloc, VkQueue queue, CommandPool& pool,
+                                              uint32_t subdivX = 1, uint32_t subdivZ = 1,
+                                              const MeshOptions& options = {});
+    static std::shared_ptr<Mesh> createCylinder(VmaAllocator alloc, UploadManager& uploads,
                                                  float radius = 1.0f, float height = 2.0f,
-                                                 uint32_t segments = 32);
-    static std::shared_ptr<Mesh> createCone(VmaAllocator alloc, VkQueue queue, CommandPool& pool,
+                                                 uint32_t segments = 32,
+                                                 const MeshOptions& options = {});
+    static std::shared_ptr<Mesh> createCone(VmaAllocator alloc, UploadManager& uploads,
                                              float radius = 1.0f, float height = 2.0f,
-                                             uint32_t segments = 32);
-    static std::shared_ptr<Mesh> createTorus(VmaAllocator alloc, VkQueue queue, CommandPool& pool,
+                                             uint32_t segments = 32,
+                                             const MeshOptions& options = {});
+    static std::shared_ptr<Mesh> createTorus(VmaAllocator alloc, UploadManager& uploads,
                                               float majorRadius = 1.0f, float minorRadius = 0.3f,
-                                              uint32_t majorSeg = 48, uint32_t minorSeg = 24);
-
-private:
-    static void computeTangents(std::vector<Vertex>& vertices,
-                                 const std::vector<uint32_t>& indices);
+                                              uint32_t majorSeg = 48, uint32_t minorSeg = 24,
+                                              const MeshOptions& options = {});
 };
 
 } // namespace lmao
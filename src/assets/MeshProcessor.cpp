@@ -0,0 +1,499 @@
+#include "assets/MeshProcessor.h"
+#include "core/Log.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace lmao {
+
+namespace {
+constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+// FIFO cache simulated with timestamps: a vertex is resident while fewer than
+// cacheSize misses happened since it was inserted. Returns the misses of one triangle.
+uint32_t updateCache(uint32_t a, uint32_t b, uint32_t c, uint32_t cacheSize,
+                     std::vector<uint32_t>& timestamps, uint32_t& timestamp) {
+    uint32_t misses = 0;
+    for (uint32_t v : {a, b, c}) {
+        if (timestamp - timestamps[v] > cacheSize) {
+            timestamps[v] = timestamp++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+// Bounding sphere (AABB center, farthest vertex) and normal cone of triangles [triBegin, triEnd).
+// Cone cutoff as in meshoptimizer: every triangle normal lies within acos(minDot) of the axis,
+// so a view direction d sees only back faces when dot(d, axis) >= sqrt(1 - minDot^2).
+Meshlet makeMeshlet(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                    uint32_t triBegin, uint32_t triEnd, int32_t vertexOffset,
+                    std::vector<vec3>& normals) {
+    auto position = [&](uint32_t i) -> const vec3& {
+        return vertices[static_cast<size_t>(vertexOffset) + indices[i]].position;
+    };
+
+    AABB box;
+    for (uint32_t i = triBegin * 3; i < triEnd * 3; i++)
+        box.expand(position(i));
+    vec3 center = (box.min + box.max) * 0.5f;
+    float radiusSq = 0.0f;
+    for (uint32_t i = triBegin * 3; i < triEnd * 3; i++) {
+        vec3 d = position(i) - center;
+        radiusSq = std::max(radiusSq, glm::dot(d, d));
+    }
+
+    normals.clear();
+    vec3 axis(0.0f);
+    for (uint32_t t = triBegin; t < triEnd; t++) {
+        const vec3& p0 = position(t * 3 + 0);
+        vec3 n = glm::cross(position(t * 3 + 1) - p0, position(t * 3 + 2) - p0);
+        float len = glm::length(n);
+        if (len <= 0.0f) continue;
+        normals.push_back(n / len);
+        axis += normals.back();
+    }
+
+    float cutoff = 1.0f;
+    float axisLen = glm::length(axis);
+    if (axisLen > 0.0f) {
+        axis /= axisLen;
+        float minDot = 1.0f;
+        for (const vec3& n : normals)
+            minDot = std::min(minDot, glm::dot(axis, n));
+        // Spread close to or beyond a hemisphere can never be fully back-facing
+        if (minDot > 0.1f)
+            cutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+
+    Meshlet m;
+    m.boundingSphere = vec4(center, std::sqrt(radiusSq));
+    m.cone = vec4(axis, cutoff);
+    m.firstIndex = triBegin * 3;
+    m.indexCount = (triEnd - triBegin) * 3;
+    m.vertexOffset = vertexOffset;
+    return m;
+}
+} // anonymous namespace
+
+void MeshProcessor::computeNormals(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+    // Only vertices that arrived without a normal are generated
+    std::vector<uint8_t> missing(vertices.size(), 0);
+    bool anyMissing = false;
+    for (size_t i = 0; i < vertices.size(); i++) {
+        if (glm::dot(vertices[i].normal, vertices[i].normal) == 0.0f) {
+            missing[i] = 1;
+            anyMissing = true;
+        }
+    }
+    if (!anyMissing) return;
+
+    // Area-weighted face normals (unnormalized cross product)
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        uint32_t i0 = indices[i], i1 = indices[i+1], i2 = indices[i+2];
+        const vec3& p0 = vertices[i0].position;
+        vec3 n = glm::cross(vertices[i1].position - p0, vertices[i2].position - p0);
+        for (uint32_t v : {i0, i1, i2}) {
+            if (missing[v]) vertices[v].normal += n;
+        }
+    }
+
+    for (size_t i = 0; i < vertices.size(); i++) {
+        if (!missing[i]) continue;
+        float len = glm::length(vertices[i].normal);
+        vertices[i].normal = len > 0.0f ? vertices[i].normal / len : vec3(0, 1, 0);
+    }
+}
+
+void MeshProcessor::computeTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices) {
+    // Accumulate tangents per triangle
+    std::vector<vec3> tan(vertices.size(), vec3(0));
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        uint32_t i0 = indices[i], i1 = indices[i+1], i2 = indices[i+2];
+        const vec3& p0 = vertices[i0].position;
+        const vec3& p1 = vertices[i1].position;
+        const vec3& p2 = vertices[i2].position;
+        const vec2& uv0 = vertices[i0].uv;
+        const vec2& uv1 = vertices[i1].uv;
+        const vec2& uv2 = vertices[i2].uv;
+
+        vec3 e1 = p1 - p0, e2 = p2 - p0;
+        vec2 duv1 = uv1 - uv0, duv2 = uv2 - uv0;
+
+        float denom = duv1.x * duv2.y - duv2.x * duv1.y;
+        if (std::abs(denom) < 1e-8f) continue;
+        float r = 1.0f / denom;
+
+        vec3 t = (e1 * duv2.y - e2 * duv1.y) * r;
+        tan[i0] += t;
+        tan[i1] += t;
+        tan[i2] += t;
+    }
+
+    // Orthogonalize and store
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const vec3& n = vertices[i].normal;
+        vec3 t = tan[i];
+        // Gram-Schmidt: project out normal component
+        t = t - n * glm::dot(n, t);
+        float len = glm::length(t);
+        if (len > 1e-6f) {
+            t /= len;
+        } else {
+            // Fallback: pick an arbitrary tangent perpendicular to normal
+            if (std::abs(n.x) < 0.9f)
+                t = glm::normalize(glm::cross(n, vec3(1, 0, 0)));
+            else
+                t = glm::normalize(glm::cross(n, vec3(0, 1, 0)));
+        }
+        vertices[i].tangent = vec4(t, 1.0f);
+    }
+}
+
+void MeshProcessor::splitForIndex16(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                                    std::vector<Submesh>& submeshes, uint32_t maxVertices) {
+    constexpr uint32_t INVALID = INVALID_INDEX;
+
+    submeshes.clear();
+    std::vector<Vertex> outVertices;
+    outVertices.reserve(vertices.size());
+
+    std::vector<uint32_t> remap(vertices.size(), INVALID);
+    std::vector<uint32_t> touched;
+    touched.reserve(maxVertices);
+
+    Submesh current{};
+    auto flush = [&]() {
+        current.indexCount = 0;
+        for (uint32_t v : touched) remap[v] = INVALID;
+        touched.clear();
+    };
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        uint32_t newVerts = 0;
+        for (int k = 0; k < 3; k++) {
+            if (remap[indices[i + k]] == INVALID) newVerts++;
+        }
+        if (touched.size() + newVerts > maxVertices) {
+            submeshes.push_back(current);
+            flush();
+            current.firstIndex = static_cast<uint32_t>(i);
+            current.vertexOffset = static_cast<int32_t>(outVertices.size());
+        }
+
+        for (int k = 0; k < 3; k++) {
+            uint32_t& idx = indices[i + k];
+            if (remap[idx] == INVALID) {
+                remap[idx] = static_cast<uint32_t>(touched.size());
+                touched.push_back(idx);
+                outVertices.push_back(vertices[idx]);
+            }
+            idx = remap[idx];
+        }
+        current.indexCount += 3;
+    }
+    if (current.indexCount > 0) submeshes.push_back(current);
+
+    LOG(Assets, Debug, "Split mesh for 16-bit indices: %zu -> %zu verts in %zu ranges",
+        vertices.size(), outVertices.size(), submeshes.size());
+    vertices = std::move(outVertices);
+}
+
+void MeshProcessor::optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                             const char* name) {
+    if (indices.size() < 3 || vertices.empty()) return;
+
+    VertexCacheStats before = analyzeVertexCache(indices, vertices.size());
+
+    optimizeVertexCache(indices, vertices.size());
+    optimizeOverdraw(indices, vertices);
+    optimizeVertexFetch(vertices, indices);
+
+    VertexCacheStats after = analyzeVertexCache(indices, vertices.size());
+    LOG(Assets, Debug, "Mesh optimized%s%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f (%zu tris)",
+        name ? " " : "", name ? name : "",
+        before.acmr, after.acmr, before.atvr, after.atvr, indices.size() / 3);
+}
+
+VertexCacheStats MeshProcessor::analyzeVertexCache(const std::vector<uint32_t>& indices,
+                                                    size_t vertexCount, uint32_t cacheSize) {
+    VertexCacheStats stats;
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return stats;
+
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    uint32_t timestamp = cacheSize + 1;
+    size_t misses = 0;
+    size_t uniqueVertices = 0;
+
+    for (size_t t = 0; t < triangleCount; t++) {
+        const uint32_t* tri = &indices[t * 3];
+        misses += updateCache(tri[0], tri[1], tri[2], cacheSize, timestamps, timestamp);
+        for (int k = 0; k < 3; k++) {
+            if (!referenced[tri[k]]) {
+                referenced[tri[k]] = 1;
+                uniqueVertices++;
+            }
+        }
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(triangleCount);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(std::max<size_t>(uniqueVertices, 1));
+    return stats;
+}
+
+void MeshProcessor::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount,
+                                        uint32_t cacheSize) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return;
+
+    // Vertex -> triangle adjacency (CSR)
+    std::vector<uint32_t> live(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; i++) live[indices[i]]++;
+
+    std::vector<uint32_t> adjOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) adjOffsets[v + 1] = adjOffsets[v] + live[v];
+    std::vector<uint32_t> adjacency(adjOffsets[vertexCount]);
+    {
+        std::vector<uint32_t> fill(adjOffsets.begin(), adjOffsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++) {
+            for (int k = 0; k < 3; k++)
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(triangleCount * 3);
+    deadEnd.reserve(triangleCount * 3);
+
+    uint32_t timestamp = cacheSize + 1;
+    size_t cursor = 0;
+
+    auto skipDeadEnd = [&]() -> uint32_t {
+        while (!deadEnd.empty()) {
+            uint32_t d = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[d] > 0) return d;
+        }
+        while (cursor < vertexCount) {
+            if (live[cursor] > 0) return static_cast<uint32_t>(cursor);
+            cursor++;
+        }
+        return INVALID_INDEX;
+    };
+
+    uint32_t fanning = skipDeadEnd();
+    while (fanning != INVALID_INDEX) {
+        candidates.clear();
+
+        for (uint32_t a = adjOffsets[fanning]; a < adjOffsets[fanning + 1]; a++) {
+            uint32_t t = adjacency[a];
+            if (emitted[t]) continue;
+            emitted[t] = 1;
+
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = indices[t * 3 + k];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (timestamp - cacheTime[v] > cacheSize)
+                    cacheTime[v] = timestamp++;
+            }
+        }
+
+        // Next fanning vertex: the candidate that stays in cache longest without being
+        // evicted while its remaining triangles are emitted
+        uint32_t best = INVALID_INDEX;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (live[v] == 0) continue;
+            int64_t priority = 0;
+            int64_t age = static_cast<int64_t>(timestamp) - cacheTime[v];
+            if (age + 2 * static_cast<int64_t>(live[v]) <= cacheSize) priority = age;
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+        fanning = (best != INVALID_INDEX) ? best : skipDeadEnd();
+    }
+
+    indices.swap(output);
+}
+
+void MeshProcessor::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                                     uint32_t cacheSize, float threshold) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2) return;
+
+    std::vector<uint32_t> timestamps(vertices.size(), 0);
+    uint32_t timestamp = cacheSize + 1;
+
+    // Hard boundaries: a triangle missing all three vertices restarts the cache,
+    // which after Tipsify means a new, mostly disjoint patch begins
+    std::vector<uint32_t> hard;
+    for (size_t t = 0; t < triangleCount; t++) {
+        const uint32_t* tri = &indices[t * 3];
+        uint32_t misses = updateCache(tri[0], tri[1], tri[2], cacheSize, timestamps, timestamp);
+        if (t == 0 || misses == 3) hard.push_back(static_cast<uint32_t>(t));
+    }
+    hard.push_back(static_cast<uint32_t>(triangleCount));
+
+    // Soft boundaries: split each hard cluster further as long as every piece stays
+    // within `threshold` of the hard cluster's own ACMR
+    std::vector<uint32_t> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); h++) {
+        uint32_t start = hard[h], end = hard[h + 1];
+
+        timestamp += cacheSize + 1;
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = start; t < end; t++) {
+            const uint32_t* tri = &indices[t * 3];
+            clusterMisses += updateCache(tri[0], tri[1], tri[2], cacheSize, timestamps, timestamp);
+        }
+        float targetAcmr = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+        size_t first = clusters.size();
+        clusters.push_back(start);
+        timestamp += cacheSize + 1;
+        uint32_t runningMisses = 0, runningFaces = 0;
+        for (uint32_t t = start; t < end; t++) {
+            const uint32_t* tri = &indices[t * 3];
+            runningMisses += updateCache(tri[0], tri[1], tri[2], cacheSize, timestamps, timestamp);
+            runningFaces++;
+            if (static_cast<float>(runningMisses) / static_cast<float>(runningFaces) <= targetAcmr) {
+                clusters.push_back(t + 1);
+                timestamp += cacheSize + 1;
+                runningMisses = 0;
+                runningFaces = 0;
+            }
+        }
+        // Drop the empty trailing cluster, or fold a high-ACMR tail into its predecessor
+        if (clusters.back() == end || (runningFaces > 0 && clusters.size() - first > 1))
+            clusters.pop_back();
+    }
+    clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+    // Area-weighted mesh centroid
+    vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t t = 0; t < triangleCount; t++) {
+        const vec3& p0 = vertices[indices[t * 3 + 0]].position;
+        const vec3& p1 = vertices[indices[t * 3 + 1]].position;
+        const vec3& p2 = vertices[indices[t * 3 + 2]].position;
+        float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+        meshCentroid += (p0 + p1 + p2) * (area / 3.0f);
+        meshArea += area;
+    }
+    meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : vertices[indices[0]].position;
+
+    // Sort key: how far the cluster faces away from the mesh center (outer surfaces first)
+    size_t clusterCount = clusters.size() - 1;
+    std::vector<float> sortKey(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        vec3 centroid(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (uint32_t t = clusters[c]; t < clusters[c + 1]; t++) {
+            const vec3& p0 = vertices[indices[t * 3 + 0]].position;
+            const vec3& p1 = vertices[indices[t * 3 + 1]].position;
+            const vec3& p2 = vertices[indices[t * 3 + 2]].position;
+            vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float a = glm::length(n);
+            centroid += (p0 + p1 + p2) * (a / 3.0f);
+            normal += n;
+            area += a;
+        }
+        float nLen = glm::length(normal);
+        if (area <= 0.0f || nLen <= 0.0f) {
+            sortKey[c] = 0.0f;
+            continue;
+        }
+        sortKey[c] = glm::dot(centroid / area - meshCentroid, normal / nLen);
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(),
+        [&](uint32_t a, uint32_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (uint32_t c : order) {
+        output.insert(output.end(),
+                      indices.begin() + clusters[c] * 3,
+                      indices.begin() + clusters[c + 1] * 3);
+    }
+    indices.swap(output);
+}
+
+void MeshProcessor::buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                                  const std::vector<Submesh>& submeshes, std::vector<Meshlet>& meshlets,
+                                  uint32_t maxVertices, uint32_t maxTriangles) {
+    meshlets.clear();
+    // marker[v] == current meshlet id when v is already counted in the open meshlet
+    std::vector<uint32_t> marker(vertices.size(), INVALID_INDEX);
+    std::vector<vec3> normals;
+    normals.reserve(maxTriangles);
+    uint32_t meshletId = 0;
+
+    for (const auto& sm : submeshes) {
+        uint32_t triBegin = sm.firstIndex / 3;
+        uint32_t triEnd = (sm.firstIndex + sm.indexCount) / 3;
+        uint32_t start = triBegin;
+        uint32_t vertexCount = 0;
+
+        auto newVertices = [&](uint32_t t) {
+            uint32_t count = 0;
+            for (uint32_t k = 0; k < 3; k++) {
+                uint32_t v = static_cast<uint32_t>(sm.vertexOffset) + indices[t * 3 + k];
+                bool repeated = (k > 0 && indices[t * 3 + k] == indices[t * 3]) ||
+                                (k > 1 && indices[t * 3 + k] == indices[t * 3 + 1]);
+                if (marker[v] != meshletId && !repeated) count++;
+            }
+            return count;
+        };
+
+        for (uint32_t t = triBegin; t < triEnd; t++) {
+            uint32_t added = newVertices(t);
+            if (t - start == maxTriangles || vertexCount + added > maxVertices) {
+                meshlets.push_back(makeMeshlet(vertices, indices, start, t, sm.vertexOffset, normals));
+                start = t;
+                vertexCount = 0;
+                meshletId++;
+                added = newVertices(t);
+            }
+            for (uint32_t k = 0; k < 3; k++)
+                marker[static_cast<uint32_t>(sm.vertexOffset) + indices[t * 3 + k]] = meshletId;
+            vertexCount += added;
+        }
+        if (start < triEnd) {
+            meshlets.push_back(makeMeshlet(vertices, indices, start, triEnd, sm.vertexOffset, normals));
+            meshletId++;
+        }
+    }
+}
+
+void MeshProcessor::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (uint32_t& idx : indices) {
+        if (remap[idx] == INVALID_INDEX) {
+            remap[idx] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[idx]);
+        }
+        idx = remap[idx];
+    }
+    vertices.swap(reordered);
+}
+
+} // namespace lmao
@@ -0,0 +1,71 @@
+#pragma once
+#include "assets/Mesh.h"
+#include "math/MathUtils.h"
+#include <vector>
+
+namespace lmao {
+
+// Post-transform vertex cache statistics for a FIFO cache of a given size.
+// ACMR = cache misses per triangle (0.5 ideal for regular grids, 3.0 worst case)
+// ATVR = cache misses per referenced vertex (1.0 ideal)
+struct VertexCacheStats {
+    float acmr = 0.0f;
+    float atvr = 0.0f;
+};
+
+// CPU-side mesh processing shared by Mesh::init, MeshGenerator and importers.
+class MeshProcessor {
+public:
+    static constexpr uint32_t DEFAULT_CACHE_SIZE = 16;
+    // Largest vertex count addressable by VK_INDEX_TYPE_UINT16
+    static constexpr uint32_t MAX_INDEX16_VERTICES = 65536;
+    // Meshlet limits (64 / 124 fit the common mesh shader output sizes)
+    static constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+    static constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+    // Smooth area-weighted normals for vertices whose normal is zero (e.g. OBJ faces without vn)
+    static void computeNormals(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+    // Per-vertex tangents from UV derivatives, Gram-Schmidt orthogonalized against the normal
+    static void computeTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+    // Partitions the triangle list, in order, into sub-ranges that each reference at most
+    // maxVertices vertices. Every range gets its own contiguous block of vertices (shared
+    // vertices on range boundaries are duplicated) and indices are rewritten relative to
+    // that block, so the result can be drawn with 16-bit indices and per-range vertexOffset.
+    static void splitForIndex16(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                                std::vector<Submesh>& submeshes,
+                                uint32_t maxVertices = MAX_INDEX16_VERTICES);
+
+    // Full optimization stage: vertex cache -> overdraw -> vertex fetch. Logs ACMR/ATVR
+    // before and after. Triangle winding is preserved; unreferenced vertices are dropped.
+    static void optimize(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices,
+                         const char* name = nullptr);
+
+    static VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount,
+                                               uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+    // Tipsify (Sander, Nehab, Barczak 2007): reorders triangles for post-transform cache locality
+    static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount,
+                                    uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+    // Splits a cache-optimized triangle list into clusters (at cache restarts, then further
+    // while each piece stays within `threshold` x the cluster ACMR) and sorts the clusters
+    // outside-in so front-most surfaces tend to be drawn first.
+    static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                                 uint32_t cacheSize = DEFAULT_CACHE_SIZE, float threshold = 1.05f);
+
+    // Scans each submesh's triangles in order and cuts a new meshlet whenever the vertex or
+    // triangle limit would be exceeded, so every meshlet is a contiguous index range drawable
+    // with a plain vkCmdDrawIndexed. Run after optimize(): the cache-ordered triangle list
+    // keeps consecutive triangles spatially close, which keeps the bounds tight.
+    static void buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices,
+                              const std::vector<Submesh>& submeshes, std::vector<Meshlet>& meshlets,
+                              uint32_t maxVertices = MAX_MESHLET_VERTICES,
+                              uint32_t maxTriangles = MAX_MESHLET_TRIANGLES);
+
+    // Reorders vertices by first use in the index buffer so vertex fetch walks memory linearly
+    static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+};
+
+} // namespace lmao
@@ -0,0 +1,420 @@
+#include "assets/ModelImporter.h"
+#include "assets/DerivedDataCache.h"
+#include "assets/MeshFile.h"
+#include "assets/MeshProcessor.h"
+#include "core/Log.h"
+#include "core/MappedFile.h"
+#include "core/ThreadPool.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+
+namespace lmao {
+
+namespace {
+constexpr size_t TARGET_CHUNK_SIZE = 1u << 20;
+constexpr uint32_t MAX_CHUNKS = 4096;
+constexpr uint32_t SHARD_COUNT = 64;
+constexpr uint32_t MISSING = UINT32_MAX;
+
+// Cook flags of an OBJ's .lmesh: importers always split for 16-bit indices
+uint32_t objCookFlags(const MeshOptions& options) {
+    MeshOptions cookOptions = options;
+    cookOptions.splitForIndex16 = true;
+    return MeshFile::cookFlags(cookOptions);
+}
+
+// Dedup key. Adding 0.0f folds -0.0 into +0.0 so equal keys always hash equally.
+struct VertexKey {
+    vec3 position;
+    vec3 normal;
+    vec2 uv;
+
+    bool operator==(const VertexKey& o) const {
+        return position == o.position && normal == o.normal && uv == o.uv;
+    }
+};
+
+size_t hashKey(const VertexKey& k) {
+    size_t h = std::hash<vec3>()(k.position);
+    h ^= std::hash<vec3>()(k.normal) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    h ^= std::hash<vec2>()(k.uv) + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+struct VertexKeyHash {
+    size_t operator()(const VertexKey& k) const { return hashKey(k); }
+};
+
+struct Corner {
+    uint32_t position;
+    uint32_t uv;
+    uint32_t normal;
+};
+
+struct Chunk {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+
+    // Pass 1: element counts, then global bases from the prefix sum
+    uint32_t positionCount = 0, uvCount = 0, normalCount = 0;
+    uint32_t positionBase = 0, uvBase = 0, normalBase = 0;
+
+    // Pass 2: triangle corners with resolved absolute indices
+    std::vector<Corner> corners;
+    uint32_t invalidFaces = 0;
+
+    // Pass 3: chunk-local unique vertices and corner -> local vertex
+    std::vector<VertexKey> unique;
+    std::vector<uint8_t> shard;
+    std::vector<uint32_t> localIndices;
+    std::vector<uint32_t> shardMembers[SHARD_COUNT];
+
+    // Pass 4: local vertex -> vertex id inside its shard
+    std::vector<uint32_t> shardIds;
+    uint32_t indexBase = 0;
+};
+
+bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+const char* skipSpaces(const char* p, const char* end) {
+    while (p < end && isSpace(*p)) p++;
+    return p;
+}
+
+const char* lineEnd(const char* p, const char* end) {
+    const void* nl = std::memchr(p, '\n', static_cast<size_t>(end - p));
+    return nl ? static_cast<const char*>(nl) : end;
+}
+
+const char* nextLine(const char* eol, const char* end) {
+    return eol < end ? eol + 1 : end;
+}
+
+// Statement type at a line start: 'v' position, 't' uv, 'n' normal, 'f' face, 0 other
+char statementType(const char* p, const char* end) {
+    if (end - p < 2) return 0;
+    if (p[0] == 'f' && isSpace(p[1])) return 'f';
+    if (p[0] != 'v') return 0;
+    if (isSpace(p[1])) return 'v';
+    if (end - p >= 3 && isSpace(p[2]) && (p[1] == 't' || p[1] == 'n')) return p[1];
+    return 0;
+}
+
+const char* parseFloats(const char* p, const char* end, float* out, int count) {
+    for (int i = 0; i < count; i++) {
+        p = skipSpaces(p, end);
+        if (p < end && *p == '+') p++;
+        auto [next, ec] = std::from_chars(p, end, out[i]);
+        if (ec != std::errc()) out[i] = 0.0f;
+        else p = next;
+    }
+    return p;
+}
+
+// OBJ indices are 1-based; negative ones count back from the elements defined so far
+uint32_t resolveIndex(int64_t index, uint32_t definedSoFar, uint32_t total) {
+    int64_t resolved = index > 0 ? index - 1 : static_cast<int64_t>(definedSoFar) + index;
+    return (index != 0 && resolved >= 0 && resolved < total) ? static_cast<uint32_t>(resolved) : MISSING;
+}
+
+void countChunk(Chunk& chunk) {
+    for (const char* p = chunk.begin; p < chunk.end;) {
+        const char* eol = lineEnd(p, chunk.end);
+        switch (statementType(skipSpaces(p, eol), eol)) {
+            case 'v': chunk.positionCount++; break;
+            case 't': chunk.uvCount++; break;
+            case 'n': chunk.normalCount++; break;
+            default: break;
+        }
+        p = nextLine(eol, chunk.end);
+    }
+}
+
+void parseChunk(Chunk& chunk, std::vector<vec3>& positions, std::vector<vec2>& uvs,
+                std::vector<vec3>& normals) {
+    uint32_t positionIndex = chunk.positionBase;
+    uint32_t uvIndex = chunk.uvBase;
+    uint32_t normalIndex = chunk.normalBase;
+    std::vector<Corner> polygon;
+
+    for (const char* p = chunk.begin; p < chunk.end;) {
+        const char* eol = lineEnd(p, chunk.end);
+        const char* s = skipSpaces(p, eol);
+        char type = statementType(s, eol);
+        p = nextLine(eol, chunk.end);
+
+        if (type == 'v') {
+            float v[3];
+            parseFloats(s + 1, eol, v, 3);
+            positions[positionIndex++] = vec3(v[0], v[1], v[2]);
+        } else if (type == 't') {
+            float v[2];
+            parseFloats(s + 2, eol, v, 2);
+            // OBJ has v = 0 at the bottom, Vulkan samples with v = 0 at the top
+            uvs[uvIndex++] = vec2(v[0], 1.0f - v[1]);
+        } else if (type == 'n') {
+            float v[3];
+            parseFloats(s + 2, eol, v, 3);
+            normals[normalIndex++] = vec3(v[0], v[1], v[2]);
+        } else if (type == 'f') {
+            polygon.clear();
+            bool valid = true;
+            const char* q = s + 1;
+            for (;;) {
+                q = skipSpaces(q, eol);
+                if (q >= eol || *q == '\r' || *q == '#') break;
+
+                int64_t idx[3] = {0, 0, 0};
+                bool present[3] = {false, false, false};
+                for (int k = 0; k < 3; k++) {
+                    if (k > 0) {
+                        if (q >= eol || *q != '/') break;
+                        q++;
+                    }
+                    auto [next, ec] = std::from_chars(q, eol, idx[k]);
+                    if (ec == std::errc()) {
+                        present[k] = true;
+                        q = next;
+                    }
+                }
+                while (q < eol && !isSpace(*q) && *q != '\r') q++;
+
+                Corner c;
+                c.position = present[0] ? resolveIndex(idx[0], positionIndex, static_cast<uint32_t>(positions.size())) : MISSING;
+                c.uv = present[1] ? resolveIndex(idx[1], uvIndex, static_cast<uint32_t>(uvs.size())) : MISSING;
+                c.normal = present[2] ? resolveIndex(idx[2], normalIndex, static_cast<uint32_t>(normals.size())) : MISSING;
+                if (c.position == MISSING || (present[1] && c.uv == MISSING) || (present[2] && c.normal == MISSING))
+                    valid = false;
+                polygon.push_back(c);
+            }
+
+            if (!valid || polygon.size() < 3) {
+                chunk.invalidFaces++;
+                continue;
+            }
+            // Fan triangulation keeps the OBJ winding (counter-clockwise front faces)
+            for (size_t k = 1; k + 1 < polygon.size(); k++) {
+                chunk.corners.push_back(polygon[0]);
+                chunk.corners.push_back(polygon[k]);
+                chunk.corners.push_back(polygon[k + 1]);
+            }
+        }
+    }
+}
+
+void dedupChunk(Chunk& chunk, const std::vector<vec3>& positions, const std::vector<vec2>& uvs,
+                const std::vector<vec3>& normals) {
+    std::unordered_map<VertexKey, uint32_t, VertexKeyHash> lookup;
+    lookup.reserve(chunk.corners.size() / 2);
+    chunk.localIndices.resize(chunk.corners.size());
+
+    for (size_t i = 0; i < chunk.corners.size(); i++) {
+        const Corner& c = chunk.corners[i];
+        VertexKey key;
+        key.position = positions[c.position] + 0.0f;
+        key.normal = c.normal != MISSING ? normals[c.normal] + 0.0f : vec3(0.0f);
+        key.uv = c.uv != MISSING ? uvs[c.uv] + 0.0f : vec2(0.0f);
+
+        auto [it, inserted] = lookup.try_emplace(key, static_cast<uint32_t>(chunk.unique.size()));
+        if (inserted) {
+            uint8_t shard = static_cast<uint8_t>((hashKey(key) >> 7) % SHARD_COUNT);
+            chunk.shardMembers[shard].push_back(it->second);
+            chunk.shard.push_back(shard);
+            chunk.unique.push_back(key);
+        }
+        chunk.localIndices[i] = it->second;
+    }
+    chunk.corners = {};
+}
+} // anonymous namespace
+
+std::shared_ptr<Mesh> ModelImporter::loadOBJ(VmaAllocator allocator, UploadManager& uploads,
+                                             const std::string& path, const MeshOptions& options,
+                                             bool useCache) {
+    uint32_t cookFlags = objCookFlags(options);
+
+    // A cached .lmesh is uploaded straight from the mapping
+    std::string cookedFile = useCache ? cookedPath(path, options) : std::string();
+    if (!cookedFile.empty()) {
+        std::error_code ec;
+        MeshFile cooked;
+        if (std::filesystem::exists(cookedFile, ec) && cooked.open(cookedFile)) {
+            const MeshFileHeader& header = cooked.header();
+            if (header.cookFlags == cookFlags && header.vertexFormat == static_cast<uint32_t>(options.vertexFormat)) {
+                auto mesh = std::make_shared<Mesh>();
+                if (mesh->init(allocator, uploads, cooked.data())) {
+                    LOG(Assets, Info, "Loaded %s from %s", path.c_str(), cookedFile.c_str());
+                    return mesh;
+                }
+            }
+            LOG(Assets, Debug, "Unusable cache entry %s, re-importing", cookedFile.c_str());
+        }
+    }
+
+    CookedMesh cooked;
+    if (!cookOBJ(path, options, cooked)) return nullptr;
+    if (!cookedFile.empty())
+        MeshFile::write(cookedFile, cooked.data(), cookFlags);
+
+    auto mesh = std::make_shared<Mesh>();
+    if (!mesh->init(allocator, uploads, cooked.data()))
+        return nullptr;
+    return mesh;
+}
+
+bool ModelImporter::cookOBJ(const std::string& path, const MeshOptions& options, CookedMesh& out) {
+    ImportOptions importOptions;
+    importOptions.optimize = options.optimize;
+
+    ImportedMesh imported;
+    if (!importOBJ(path, imported, importOptions)) return false;
+
+    // Optimization ran during import; large models may exceed 16-bit ranges
+    MeshOptions meshOptions = options;
+    meshOptions.optimize = false;
+    meshOptions.splitForIndex16 = true;
+    Mesh::cook(imported.vertices, imported.indices, meshOptions, out);
+    return true;
+}
+
+bool ModelImporter::importOBJ(const std::string& path, ImportedMesh& out, const ImportOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsedMs = [&]() {
+        return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    MappedFile file;
+    if (!file.open(path)) return false;
+    if (!parseOBJ(file.data(), file.size(), out)) {
+        LOG(Assets, Error, "No triangles in %s", path.c_str());
+        return false;
+    }
+    file.close();
+
+    MeshProcessor::computeNormals(out.vertices, out.indices);
+    MeshProcessor::computeTangents(out.vertices, out.indices);
+    if (options.optimize)
+        MeshProcessor::optimize(out.vertices, out.indices, path.c_str());
+
+    LOG(Assets, Info, "Imported %s: %zu verts, %zu tris in %.1f ms",
+        path.c_str(), out.vertices.size(), out.indices.size() / 3, elapsedMs());
+    return true;
+}
+
+bool ModelImporter::parseOBJ(const uint8_t* data, size_t size, ImportedMesh& out) {
+    out.vertices.clear();
+    out.indices.clear();
+    if (!data || size == 0) return false;
+
+    ThreadPool& pool = ThreadPool::shared();
+    const char* text = reinterpret_cast<const char*>(data);
+    const char* textEnd = text + size;
+
+    // Split at line boundaries into roughly equal chunks
+    uint32_t chunkCount = static_cast<uint32_t>(std::clamp<size_t>(size / TARGET_CHUNK_SIZE, 1, MAX_CHUNKS));
+    std::vector<Chunk> chunks(chunkCount);
+    const char* cursor = text;
+    for (uint32_t i = 0; i < chunkCount; i++) {
+        const char* split = (i + 1 == chunkCount) ? textEnd : text + size * (i + 1) / chunkCount;
+        split = std::max(split, cursor);
+        if (split < textEnd) split = nextLine(lineEnd(split, textEnd), textEnd);
+        chunks[i].begin = cursor;
+        chunks[i].end = split;
+        cursor = chunks[i].end;
+    }
+
+    // 1. Count attributes per chunk so every chunk knows where its elements land globally
+    pool.parallelFor(chunkCount, [&](uint32_t i) { countChunk(chunks[i]); });
+
+    uint32_t positionTotal = 0, uvTotal = 0, normalTotal = 0;
+    for (auto& chunk : chunks) {
+        chunk.positionBase = positionTotal;
+        chunk.uvBase = uvTotal;
+        chunk.normalBase = normalTotal;
+        positionTotal += chunk.positionCount;
+        uvTotal += chunk.uvCount;
+        normalTotal += chunk.normalCount;
+    }
+
+    // 2. Parse attributes straight into the shared arrays, faces into per-chunk corner lists
+    std::vector<vec3> positions(positionTotal);
+    std::vector<vec2> uvs(uvTotal);
+    std::vector<vec3> normals(normalTotal);
+    pool.parallelFor(chunkCount, [&](uint32_t i) { parseChunk(chunks[i], positions, uvs, normals); });
+
+    // 3. Chunk-local deduplication
+    pool.parallelFor(chunkCount, [&](uint32_t i) { dedupChunk(chunks[i], positions, uvs, normals); });
+
+    // 4. Global merge, sharded by key hash: each shard owns a disjoint key set and visits
+    //    chunks in file order, so the result is deterministic
+    for (auto& chunk : chunks)
+        chunk.shardIds.resize(chunk.unique.size());
+    std::vector<std::vector<VertexKey>> shardVertices(SHARD_COUNT);
+    pool.parallelFor(SHARD_COUNT, [&](uint32_t s) {
+        std::unordered_map<VertexKey, uint32_t, VertexKeyHash> lookup;
+        for (auto& chunk : chunks) {
+            for (uint32_t local : chunk.shardMembers[s]) {
+                const VertexKey& key = chunk.unique[local];
+                auto [it, inserted] = lookup.try_emplace(key, static_cast<uint32_t>(shardVertices[s].size()));
+                if (inserted) shardVertices[s].push_back(key);
+                chunk.shardIds[local] = it->second;
+            }
+        }
+    });
+
+    uint32_t shardBase[SHARD_COUNT];
+    uint32_t vertexTotal = 0;
+    for (uint32_t s = 0; s < SHARD_COUNT; s++) {
+        shardBase[s] = vertexTotal;
+        vertexTotal += static_cast<uint32_t>(shardVertices[s].size());
+    }
+    uint32_t indexTotal = 0;
+    uint32_t invalidFaces = 0;
+    for (auto& chunk : chunks) {
+        chunk.indexBase = indexTotal;
+        indexTotal += static_cast<uint32_t>(chunk.localIndices.size());
+        invalidFaces += chunk.invalidFaces;
+    }
+    if (indexTotal == 0) return false;
+
+    // 5. Emit final vertices and remapped indices
+    out.vertices.resize(vertexTotal);
+    out.indices.resize(indexTotal);
+    pool.parallelFor(SHARD_COUNT, [&](uint32_t s) {
+        for (size_t k = 0; k < shardVertices[s].size(); k++) {
+            const VertexKey& key = shardVertices[s][k];
+            Vertex& v = out.vertices[shardBase[s] + k];
+            v = Vertex{};
+            v.position = key.position;
+            v.normal = key.normal;
+            v.uv = key.uv;
+        }
+    });
+    pool.parallelFor(chunkCount, [&](uint32_t i) {
+        const Chunk& chunk = chunks[i];
+        for (size_t k = 0; k < chunk.localIndices.size(); k++) {
+            uint32_t local = chunk.localIndices[k];
+            out.indices[chunk.indexBase + k] = shardBase[chunk.shard[local]] + chunk.shardIds[local];
+        }
+    });
+
+    if (invalidFaces > 0)
+        LOG(Assets, Warn, "OBJ: skipped %u faces with missing or out-of-range indices", invalidFaces);
+    LOG(Assets, Debug, "OBJ parsed: %u positions, %u uvs, %u normals -> %u unique verts (%u chunks, %u threads)",
+        positionTotal, uvTotal, normalTotal, vertexTotal, chunkCount, pool.threadCount() + 1);
+    return true;
+}
+
+std::string ModelImporter::cookedPath(const std::string& path, const MeshOptions& options) {
+    uint64_t source;
+    if (DerivedDataCache::root().empty() || !DerivedDataCache::hashSource(path, source)) return {};
+    uint32_t flags = objCookFlags(options) | static_cast<uint32_t>(options.vertexFormat) << 16;
+    return DerivedDataCache::entryPath(DerivedDataCache::key("obj", source, flags, DerivedDataCache::MESH_VERSION),
+                                       ".lmesh");
+}
+
+} // namespace lmao
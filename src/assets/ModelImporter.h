@@ -0,0 +1,51 @@
+#pragma once
+#include "assets/Mesh.h"
+#include "math/MathUtils.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lmao {
+
+class UploadManager;
+
+// CPU-side result of an import: one indexed triangle list with normals and tangents
+struct ImportedMesh {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+struct ImportOptions {
+    // Run MeshProcessor::optimize on the imported mesh
+    bool optimize = true;
+};
+
+// Wavefront OBJ importer. The file is memory-mapped and parsed in parallel chunks on
+// ThreadPool::shared(); identical (position, normal, uv) corners are merged through
+// per-chunk hash maps followed by a hash-sharded global merge. Missing normals are
+// generated, tangents come from MeshProcessor::computeTangents.
+// Supports v / vt / vn / f (polygons fan-triangulated, negative indices); materials,
+// groups and smoothing groups are ignored and everything lands in one mesh.
+class ModelImporter {
+public:
+    // Loads the .lmesh the DerivedDataCache holds for this source and these options,
+    // otherwise imports, cooks and stores it there (useCache = false skips both)
+    static std::shared_ptr<Mesh> loadOBJ(VmaAllocator allocator, UploadManager& uploads,
+                                         const std::string& path, const MeshOptions& options = {},
+                                         bool useCache = true);
+
+    // CPU only, thread-safe: imports and cooks as loadOBJ does
+    static bool cookOBJ(const std::string& path, const MeshOptions& options, CookedMesh& out);
+
+    // Always parses the source; loadOBJ caches the cooked result in the DerivedDataCache
+    static bool importOBJ(const std::string& path, ImportedMesh& out, const ImportOptions& options = {});
+
+    // Parses OBJ text already in memory (no cache, no post-processing)
+    static bool parseOBJ(const uint8_t* data, size_t size, ImportedMesh& out);
+
+    // DerivedDataCache entry (MeshFile) of path cooked with options; empty when the cache
+    // is disabled or the source is unreadable
+    static std::string cookedPath(const std::string& path, const MeshOptions& options);
+};
+
+} // namespace lmao
@@ -0,0 +1,357 @@
+#include "assets/PackFile.h"
+#include "core/Hash.h"
+#include "core/Lz4.h"
+#include "core/ThreadPool.h"
+#include "core/TempFile.h"
+#include "core/Log.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace lmao {
+
+static_assert(std::endian::native == std::endian::little, ".lpak is stored little-endian");
+
+namespace {
+std::atomic<const PackFile*> g_mounted{nullptr};
+
+uint64_t alignUp(uint64_t value) {
+    return (value + PackFile::ALIGNMENT - 1) & ~(PackFile::ALIGNMENT - 1);
+}
+
+uint32_t blockCountFor(uint64_t size, uint32_t blockSize) {
+    return static_cast<uint32_t>((size + blockSize - 1) / blockSize);
+}
+
+// One input after compression, before layout
+struct PackedEntry {
+    std::string name;
+    uint64_t hash = 0;
+    uint64_t size = 0;
+    uint64_t checksum = 0;
+    PackCompression compression = PackCompression::None;
+    uint32_t blockCount = 0;
+    std::vector<uint8_t> data;  // as stored
+    bool ok = false;
+};
+
+void packEntry(const PackInput& input, PackedEntry& out) {
+    out.name = PackFile::normalizeName(input.name);
+    out.hash = PackFile::hashName(out.name);
+
+    MappedFile file;
+    if (!file.open(input.path)) {
+        LOG(Assets, Error, "Cannot pack %s: failed to open %s", out.name.c_str(), input.path.c_str());
+        return;
+    }
+    const uint8_t* src = file.data();
+    out.size = file.size();
+    out.checksum = xxHash64(src, file.size());
+    out.ok = true;
+
+    // Block table, then every block compressed on its own (or kept raw if LZ4 cannot shrink it)
+    uint32_t blockCount = blockCountFor(out.size, PackFile::BLOCK_SIZE);
+    std::vector<uint8_t> compressed(blockCount * sizeof(uint32_t));
+    std::vector<uint8_t> scratch(lz4CompressBound(PackFile::BLOCK_SIZE));
+    for (uint32_t i = 0; i < blockCount; i++) {
+        const uint8_t* block = src + uint64_t(i) * PackFile::BLOCK_SIZE;
+        size_t rawSize = std::min<uint64_t>(PackFile::BLOCK_SIZE, out.size - uint64_t(i) * PackFile::BLOCK_SIZE);
+        size_t storedSize = lz4Compress(block, rawSize, scratch.data(), rawSize - 1);
+        const uint8_t* stored = storedSize ? scratch.data() : block;
+        if (!storedSize) storedSize = rawSize;
+        uint32_t size32 = static_cast<uint32_t>(storedSize);
+        std::memcpy(compressed.data() + i * sizeof(uint32_t), &size32, sizeof(size32));
+        compressed.insert(compressed.end(), stored, stored + storedSize);
+    }
+
+    // Already-compressed formats gain nothing; keep them raw so they can be used in place
+    if (blockCount > 0 && compressed.size() <= out.size - out.size / 16) {
+        out.compression = PackCompression::LZ4;
+        out.blockCount = blockCount;
+        out.data = std::move(compressed);
+    } else {
+        out.data.assign(src, src + out.size);
+    }
+}
+} // anonymous namespace
+
+std::string PackFile::normalizeName(std::string_view name) {
+    std::string out(name);
+    std::replace(out.begin(), out.end(), '\\', '/');
+    size_t start = 0;
+    while (true) {
+        if (out.compare(start, 2, "./") == 0) start += 2;
+        else if (out.compare(start, 1, "/") == 0) start += 1;
+        else break;
+    }
+    return out.substr(start);
+}
+
+uint64_t PackFile::hashName(std::string_view normalizedName) {
+    return xxHash64(normalizedName.data(), normalizedName.size());
+}
+
+void PackFile::mount(const PackFile* pack) { g_mounted.store(pack, std::memory_order_release); }
+
+const PackFile* PackFile::mounted() { return g_mounted.load(std::memory_order_acquire); }
+
+bool PackFile::open(const std::string& path) {
+    close();
+    if (!m_file.open(path)) return false;
+
+    auto fail = [&](const char* reason) {
+        LOG(Assets, Warn, "Rejecting pack %s: %s", path.c_str(), reason);
+        close();
+        return false;
+    };
+
+    if (m_file.size() < sizeof(PackHeader)) return fail("truncated header");
+    const auto* header = reinterpret_cast<const PackHeader*>(m_file.data());
+    if (header->magic != MAGIC) return fail("bad magic");
+    if (header->version != VERSION) return fail("unsupported version");
+    if (header->headerSize != sizeof(PackHeader)) return fail("bad header size");
+    if (header->fileSize != m_file.size()) return fail("size mismatch");
+    if (header->blockSize == 0) return fail("bad block size");
+    if (header->tocOffset % alignof(PackEntry) != 0 || header->tocOffset < header->headerSize ||
+        header->tocOffset > header->fileSize ||
+        uint64_t(header->entryCount) * sizeof(PackEntry) > header->fileSize - header->tocOffset)
+        return fail("table of contents out of range");
+    if (header->namesOffset != header->tocOffset + uint64_t(header->entryCount) * sizeof(PackEntry) ||
+        header->namesSize > header->fileSize - header->namesOffset)
+        return fail("names out of range");
+    if (xxHash64(m_file.data() + header->tocOffset, header->fileSize - header->tocOffset) != header->tocChecksum)
+        return fail("table of contents checksum mismatch");
+
+    auto entries = std::span(reinterpret_cast<const PackEntry*>(m_file.data() + header->tocOffset), header->entryCount);
+    for (size_t i = 0; i < entries.size(); i++) {
+        const PackEntry& entry = entries[i];
+        if (i > 0 && entries[i - 1].pathHash > entry.pathHash) return fail("entries not sorted");
+        if (uint64_t(entry.nameOffset) + entry.nameLength > header->namesSize) return fail("name out of range");
+        if (entry.offset % ALIGNMENT != 0 || entry.offset < header->headerSize ||
+            entry.offset > header->tocOffset || entry.storedSize > header->tocOffset - entry.offset)
+            return fail("entry out of range");
+        bool valid = false;
+        switch (static_cast<PackCompression>(entry.compression)) {
+            case PackCompression::None:
+                valid = entry.blockCount == 0 && entry.storedSize == entry.size;
+                break;
+            case PackCompression::LZ4:
+                valid = entry.blockCount == blockCountFor(entry.size, header->blockSize) &&
+                        entry.storedSize >= uint64_t(entry.blockCount) * sizeof(uint32_t);
+                break;
+        }
+        if (!valid) return fail("bad entry encoding");
+    }
+
+    m_header = header;
+    m_entries = entries;
+    m_names = std::string_view(reinterpret_cast<const char*>(m_file.data() + header->namesOffset), header->namesSize);
+    LOG(Assets, Info, "Opened pack %s: %u entries, %.1f MB", path.c_str(), header->entryCount,
+        header->fileSize / (1024.0 * 1024.0));
+    return true;
+}
+
+void PackFile::close() {
+    m_header = nullptr;
+    m_entries = {};
+    m_names = {};
+    m_file.close();
+}
+
+std::string_view PackFile::name(const PackEntry& entry) const {
+    return m_names.substr(entry.nameOffset, entry.nameLength);
+}
+
+const PackEntry* PackFile::find(std::string_view name) const {
+    if (!m_header) return nullptr;
+    std::string normalized = normalizeName(name);
+    uint64_t hash = hashName(normalized);
+    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), hash,
+        [](const PackEntry& entry, uint64_t h) { return entry.pathHash < h; });
+    for (; it != m_entries.end() && it->pathHash == hash; ++it)
+        if (this->name(*it) == normalized) return &*it;
+    return nullptr;
+}
+
+std::span<const uint8_t> PackFile::view(const PackEntry& entry) const {
+    if (static_cast<PackCompression>(entry.compression) != PackCompression::None) return {};
+    return {m_file.data() + entry.offset, entry.size};
+}
+
+bool PackFile::read(const PackEntry& entry, void* dst) const {
+    const uint8_t* stored = m_file.data() + entry.offset;
+    auto* out = static_cast<uint8_t*>(dst);
+    bool ok = true;
+
+    if (static_cast<PackCompression>(entry.compression) == PackCompression::None) {
+        std::memcpy(out, stored, entry.size);
+    } else {
+        // Block start offsets from the size table; the sizes were not validated at open()
+        const uint32_t blockSize = m_header->blockSize;
+        std::vector<uint64_t> starts(entry.blockCount + 1);
+        starts[0] = uint64_t(entry.blockCount) * sizeof(uint32_t);
+        for (uint32_t i = 0; i < entry.blockCount; i++) {
+            uint32_t size;
+            std::memcpy(&size, stored + i * sizeof(uint32_t), sizeof(size));
+            starts[i + 1] = starts[i] + size;
+        }
+        if (starts.back() > entry.storedSize) ok = false;
+
+        auto decodeBlock = [&](uint32_t i) {
+            uint64_t outOffset = uint64_t(i) * blockSize;
+            size_t rawSize = std::min<uint64_t>(blockSize, entry.size - outOffset);
+            size_t storedSize = starts[i + 1] - starts[i];
+            if (storedSize == rawSize) {
+                std::memcpy(out + outOffset, stored + starts[i], rawSize);
+                return true;
+            }
+            return lz4Decompress(stored + starts[i], storedSize, out + outOffset, rawSize);
+        };
+
+        if (ok && entry.blockCount == 1) {
+            ok = decodeBlock(0);
+        } else if (ok) {
+            std::atomic<bool> failed{false};
+            ThreadPool::shared().parallelFor(entry.blockCount, [&](uint32_t i) {
+                if (!decodeBlock(i)) failed.store(true, std::memory_order_relaxed);
+            });
+            ok = !failed.load();
+        }
+    }
+
+    if (!ok || xxHash64(out, entry.size) != entry.checksum) {
+        LOG(Assets, Error, "Corrupt pack entry %.*s", static_cast<int>(entry.nameLength),
+            m_names.data() + entry.nameOffset);
+        return false;
+    }
+    return true;
+}
+
+bool PackFile::read(const PackEntry& entry, std::vector<uint8_t>& out) const {
+    out.resize(entry.size);
+    return read(entry, out.data());
+}
+
+bool PackFile::readToStaging(VmaAllocator allocator, const PackEntry& entry, Buffer& out) const {
+    if (entry.size == 0) return false;
+    // Host-cached: LZ4 matches copy from earlier output
+    Buffer staging;
+    if (!staging.init(allocator, entry.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_AUTO,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT))
+        return false;
+    if (!read(entry, staging.mapped())) return false;
+    vmaFlushAllocation(allocator, staging.allocation(), 0, VK_WHOLE_SIZE);
+    out = std::move(staging);
+    return true;
+}
+
+std::vector<std::future<Buffer>> PackFile::readToStagingAsync(VmaAllocator allocator,
+                                                              std::span<const PackEntry* const> entries) const {
+    std::vector<std::future<Buffer>> futures;
+    futures.reserve(entries.size());
+    for (const PackEntry* entry : entries) {
+        futures.push_back(ThreadPool::shared().submit([this, allocator, entry]() {
+            Buffer staging;
+            if (entry) readToStaging(allocator, *entry, staging);
+            return staging;
+        }));
+    }
+    return futures;
+}
+
+bool PackFile::write(const std::string& path, std::span<const PackInput> inputs) {
+    std::vector<PackedEntry> packed(inputs.size());
+    ThreadPool::shared().parallelFor(static_cast<uint32_t>(inputs.size()),
+        [&](uint32_t i) { packEntry(inputs[i], packed[i]); });
+    for (const PackedEntry& entry : packed)
+        if (!entry.ok) return false;
+
+    std::sort(packed.begin(), packed.end(), [](const PackedEntry& a, const PackedEntry& b) {
+        return a.hash != b.hash ? a.hash < b.hash : a.name < b.name;
+    });
+    for (size_t i = 1; i < packed.size(); i++) {
+        if (packed[i].name == packed[i - 1].name) {
+            LOG(Assets, Error, "Cannot write pack %s: %s added twice", path.c_str(), packed[i].name.c_str());
+            return false;
+        }
+    }
+
+    // Layout: entries in hash order, then the table of contents and the names
+    std::vector<PackEntry> toc(packed.size());
+    std::string names;
+    uint64_t offset = alignUp(sizeof(PackHeader));
+    for (size_t i = 0; i < packed.size(); i++) {
+        PackEntry& entry = toc[i];
+        entry = {};
+        entry.pathHash = packed[i].hash;
+        entry.offset = offset;
+        entry.storedSize = packed[i].data.size();
+        entry.size = packed[i].size;
+        entry.checksum = packed[i].checksum;
+        entry.nameOffset = static_cast<uint32_t>(names.size());
+        entry.nameLength = static_cast<uint32_t>(packed[i].name.size());
+        entry.compression = static_cast<uint32_t>(packed[i].compression);
+        entry.blockCount = packed[i].blockCount;
+        names += packed[i].name;
+        offset = alignUp(offset + entry.storedSize);
+    }
+
+    PackHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.headerSize = sizeof(PackHeader);
+    header.entryCount = static_cast<uint32_t>(toc.size());
+    header.blockSize = BLOCK_SIZE;
+    header.tocOffset = offset;
+    header.namesOffset = offset + toc.size() * sizeof(PackEntry);
+    header.namesSize = names.size();
+    header.fileSize = header.namesOffset + header.namesSize;
+
+    std::vector<uint8_t> tail(header.fileSize - header.tocOffset);
+    std::memcpy(tail.data(), toc.data(), toc.size() * sizeof(PackEntry));
+    std::memcpy(tail.data() + toc.size() * sizeof(PackEntry), names.data(), names.size());
+    header.tocChecksum = xxHash64(tail.data(), tail.size());
+
+    std::error_code ec;
+    std::string tmpFile = TempFile::pathFor(path);
+    {
+        std::ofstream f(tmpFile, std::ios::binary | std::ios::trunc);
+        if (!f) {
+            LOG(Assets, Error, "Cannot write pack %s", path.c_str());
+            return false;
+        }
+        static const uint8_t padding[ALIGNMENT] = {};
+        auto pad = [&](uint64_t to) {
+            uint64_t at = static_cast<uint64_t>(f.tellp());
+            f.write(reinterpret_cast<const char*>(padding), static_cast<std::streamsize>(to - at));
+        };
+        f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (size_t i = 0; i < packed.size(); i++) {
+            pad(toc[i].offset);
+            f.write(reinterpret_cast<const char*>(packed[i].data.data()), static_cast<std::streamsize>(packed[i].data.size()));
+        }
+        pad(header.tocOffset);
+        f.write(reinterpret_cast<const char*>(tail.data()), static_cast<std::streamsize>(tail.size()));
+        if (!f) {
+            LOG(Assets, Error, "Failed writing pack %s", path.c_str());
+            f.close();
+            std::filesystem::remove(tmpFile, ec);
+            return false;
+        }
+    }
+    if (!TempFile::replace(tmpFile, path, ec)) {
+        LOG(Assets, Error, "Cannot replace pack %s: %s", path.c_str(), ec.message().c_str());
+        return false;
+    }
+
+    uint64_t rawBytes = 0;
+    for (const PackedEntry& entry : packed) rawBytes += entry.size;
+    LOG(Assets, Info, "Wrote pack %s: %zu entries, %.1f MB -> %.1f MB", path.c_str(), packed.size(),
+        rawBytes / (1024.0 * 1024.0), header.fileSize / (1024.0 * 1024.0));
+    return true;
+}
+
+} // namespace lmao
@@ -0,0 +1,122 @@
+#pragma once
+#include "core/MappedFile.h"
+#include "vulkan/Buffer.h"
+#include <future>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lmao {
+
+// .lpak: read-only archive of the loose files under assets/ and the compiled shaders, so
+// startup maps one file instead of opening thousands.
+//
+//   [PackHeader, 64 B] [entry data]* -- each entry starts on a PackFile::ALIGNMENT
+//   boundary, padding is zero -- [PackEntry[entryCount], sorted by pathHash] [names]
+//
+// Compressed entries are split into independent LZ4 blocks of at most PackHeader::blockSize
+// bytes, led by a uint32 table of their stored sizes; a block stored as large as its output
+// is kept raw. Entries LZ4 does not shrink (PNG, JPEG, BC-compressed KTX2) are stored raw and
+// can be read straight from the mapping. Little-endian only.
+enum class PackCompression : uint32_t {
+    None,
+    LZ4,
+};
+
+struct PackEntry {
+    uint64_t pathHash;     // PackFile::hashName of the name
+    uint64_t offset;       // of the stored data
+    uint64_t storedSize;
+    uint64_t size;         // once decompressed
+    uint64_t checksum;     // XXH64 of the decompressed bytes
+    uint32_t nameOffset;   // into the names section, not null-terminated
+    uint32_t nameLength;
+    uint32_t compression;  // PackCompression
+    uint32_t blockCount;   // LZ4 blocks, 0 for raw entries
+    uint8_t reserved[8];
+};
+static_assert(sizeof(PackEntry) == 64, "PackEntry is part of the .lpak layout");
+
+struct PackHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint64_t fileSize;
+    uint32_t entryCount;
+    uint32_t blockSize;
+    uint64_t tocOffset;    // PackEntry[entryCount]
+    uint64_t namesOffset;
+    uint64_t namesSize;
+    uint64_t tocChecksum;  // XXH64 of bytes [tocOffset, fileSize): entries and names
+    uint8_t reserved[8];
+};
+static_assert(sizeof(PackHeader) == 64, "PackHeader must stay 64 bytes");
+
+// A file to pack: stored under name, read from path
+struct PackInput {
+    std::string name;
+    std::string path;
+};
+
+class PackFile {
+public:
+    static constexpr uint32_t MAGIC = 0x4B41504C; // "LPAK"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr uint64_t ALIGNMENT = 256;
+    static constexpr uint32_t BLOCK_SIZE = 256 * 1024;
+
+    PackFile() = default;
+    PackFile(const PackFile&) = delete;
+    PackFile& operator=(const PackFile&) = delete;
+
+    // Maps the pack and validates the header and table of contents. Entry data is
+    // verified against its checksum as it is read.
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return m_header != nullptr; }
+    std::span<const PackEntry> entries() const { return m_entries; }
+    std::string_view name(const PackEntry& entry) const;
+
+    // Null when the pack has no entry of that name (see normalizeName)
+    const PackEntry* find(std::string_view name) const;
+
+    // The entry's bytes inside the mapping for raw entries, empty for compressed ones
+    std::span<const uint8_t> view(const PackEntry& entry) const;
+
+    // Decompresses into dst (entry.size bytes) and verifies the checksum. Thread-safe;
+    // entries of several blocks are split over ThreadPool::shared(). dst is read back by
+    // the decoder, so it must not be write-combined memory.
+    bool read(const PackEntry& entry, void* dst) const;
+    bool read(const PackEntry& entry, std::vector<uint8_t>& out) const;
+
+    // Reads an entry into a new host-cached staging buffer (TRANSFER_SRC) for
+    // UploadManager::uploadImage / adoption. Thread-safe: meant for worker threads.
+    bool readToStaging(VmaAllocator allocator, const PackEntry& entry, Buffer& out) const;
+    // One ThreadPool::shared() task per entry; failed reads yield an empty buffer. The
+    // pack must stay open until every future is ready.
+    std::vector<std::future<Buffer>> readToStagingAsync(VmaAllocator allocator,
+                                                        std::span<const PackEntry* const> entries) const;
+
+    // Packs inputs in parallel and writes through a temporary file renamed into place.
+    // Names are normalized; duplicates are an error.
+    static bool write(const std::string& path, std::span<const PackInput> inputs);
+
+    // Forward slashes, no leading "./" or "/": how names are stored and looked up
+    static std::string normalizeName(std::string_view name);
+    static uint64_t hashName(std::string_view normalizedName);
+
+    // Process-wide pack that file loaders (ShaderModule, TextureLoader::decode) look in
+    // before the loose file. Not owned; unmount before closing it.
+    static void mount(const PackFile* pack);
+    static const PackFile* mounted();
+
+private:
+    MappedFile m_file;
+    const PackHeader* m_header = nullptr;
+    std::span<const PackEntry> m_entries;
+    std::string_view m_names;
+};
+
+} // namespace lmao
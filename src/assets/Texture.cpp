@@ -36,7 +36,7 @@ bool Texture::initFromImage(VkDevice device, Image&& image, bool linearFilter, f
     ci.anisotropyEnable = maxAniso > 1.0f ? VK_TRUE : VK_FALSE;
     ci.maxAnisotropy = maxAniso;
     ci.minLod = 0.0f;
-    ci.maxLod = static_cast<float>(m_image.mipLevels());
+    ci.maxLod = VK_LOD_CLAMP_NONE;  // the image view bounds the mips, see swapImage
     ci.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
 
     VkResult r = vkCreateSampler(m_device, &ci, nullptr, &m_sampler);
@@ -49,6 +49,12 @@ bool Texture::initFromImage(VkDevice device, Image&& image, bool linearFilter, f
     return true;
 }
 
+Image Texture::swapImage(Image&& image) {
+    Image old = std::move(m_image);
+    m_image = std::move(image);
+    return old;
+}
+
 void Texture::shutdown() { release(); }
 
 void Texture::release() {
@@ -17,9 +17,14 @@ public:
     bool initFromImage(VkDevice device, Image&& image, bool linearFilter = true, float maxAniso = 16.0f);
     void shutdown();
 
+    // Replaces the image (e.g. with one holding a different mip range) and returns the old
+    // one; the caller keeps it alive until no submitted work samples it
+    Image swapImage(Image&& image);
+
     VkImageView imageView() const { return m_image.view(); }
     VkSampler sampler() const { return m_sampler; }
     const Image& image() const { return m_image; }
+    VkDeviceSize memorySize() const { return m_image.memorySize(); }
 
 private:
     void release();
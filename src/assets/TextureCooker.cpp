@@ -0,0 +1,313 @@
+#include "assets/TextureCooker.h"
+#include "assets/BlockEncoder.h"
+#include "core/ThreadPool.h"
+#include "core/Log.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+
+namespace lmao {
+
+namespace {
+constexpr uint32_t COOK_USAGE_MASK = 0xF;
+constexpr uint32_t COOK_MIPS       = 1u << 4;
+constexpr uint32_t COOK_COMPRESSED = 1u << 5;
+constexpr uint32_t COOK_WRAP       = 1u << 6;
+
+// Mip filter: Kaiser-windowed sinc, radius in destination texels
+constexpr float FILTER_RADIUS = 2.0f;
+constexpr float KAISER_ALPHA = 4.0f;
+
+// Linear RGBA, four floats per texel
+struct FloatImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<float> texels;
+};
+
+float besselI0(float x) {
+    float sum = 1.0f, term = 1.0f, halfX = 0.5f * x;
+    for (int k = 1; k < 32 && term > sum * 1e-8f; k++) {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+    }
+    return sum;
+}
+
+float mipFilter(float x) {
+    if (std::abs(x) >= FILTER_RADIUS) return 0.0f;
+    float px = 3.14159265f * x;
+    float sinc = x == 0.0f ? 1.0f : std::sin(px) / px;
+    float r = x / FILTER_RADIUS;
+    return sinc * besselI0(KAISER_ALPHA * std::sqrt(1.0f - r * r)) / besselI0(KAISER_ALPHA);
+}
+
+struct FilterTap {
+    uint32_t src;
+    float weight;
+};
+
+// Normalized taps of a 1D resample: destination texel d reads taps[first[d], first[d + 1])
+struct Resampler {
+    std::vector<FilterTap> taps;
+    std::vector<uint32_t> first;
+};
+
+Resampler buildResampler(uint32_t srcSize, uint32_t dstSize, bool wrap) {
+    Resampler r;
+    r.first.reserve(dstSize + 1);
+    float scale = static_cast<float>(srcSize) / static_cast<float>(dstSize);
+    int n = static_cast<int>(srcSize);
+    for (uint32_t d = 0; d < dstSize; d++) {
+        r.first.push_back(static_cast<uint32_t>(r.taps.size()));
+        float center = (d + 0.5f) * scale;
+        int lo = static_cast<int>(std::floor(center - FILTER_RADIUS * scale));
+        int hi = static_cast<int>(std::ceil(center + FILTER_RADIUS * scale));
+
+        size_t begin = r.taps.size();
+        float sum = 0.0f;
+        for (int s = lo; s <= hi; s++) {
+            float w = mipFilter((s + 0.5f - center) / scale);
+            if (w == 0.0f) continue;
+            int src = wrap ? ((s % n) + n) % n : std::clamp(s, 0, n - 1);
+            r.taps.push_back({static_cast<uint32_t>(src), w});
+            sum += w;
+        }
+        for (size_t t = begin; t < r.taps.size(); t++) r.taps[t].weight /= sum;
+    }
+    r.first.push_back(static_cast<uint32_t>(r.taps.size()));
+    return r;
+}
+
+// Separable 2:1 downsample (odd sizes resample to floor(size / 2))
+FloatImage downsample(const FloatImage& src, bool wrap) {
+    uint32_t width = std::max(src.width / 2, 1u);
+    uint32_t height = std::max(src.height / 2, 1u);
+    Resampler rx = buildResampler(src.width, width, wrap);
+    Resampler ry = buildResampler(src.height, height, wrap);
+    ThreadPool& pool = ThreadPool::shared();
+
+    std::vector<float> rows(size_t(width) * src.height * 4);
+    pool.parallelFor(src.height, [&](uint32_t y) {
+        const float* in = src.texels.data() + size_t(y) * src.width * 4;
+        float* out = rows.data() + size_t(y) * width * 4;
+        for (uint32_t x = 0; x < width; x++) {
+            float acc[4] = {};
+            for (uint32_t t = rx.first[x]; t < rx.first[x + 1]; t++) {
+                const float* texel = in + size_t(rx.taps[t].src) * 4;
+                for (uint32_t ch = 0; ch < 4; ch++) acc[ch] += texel[ch] * rx.taps[t].weight;
+            }
+            std::copy(acc, acc + 4, out + size_t(x) * 4);
+        }
+    });
+
+    FloatImage dst{width, height, std::vector<float>(size_t(width) * height * 4, 0.0f)};
+    size_t rowFloats = size_t(width) * 4;
+    pool.parallelFor(height, [&](uint32_t y) {
+        float* out = dst.texels.data() + y * rowFloats;
+        for (uint32_t t = ry.first[y]; t < ry.first[y + 1]; t++) {
+            const float* in = rows.data() + ry.taps[t].src * rowFloats;
+            for (size_t i = 0; i < rowFloats; i++) out[i] += in[i] * ry.taps[t].weight;
+        }
+    });
+    return dst;
+}
+
+float linearToSrgb(float v) {
+    return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+}
+
+const std::array<float, 256>& srgbToLinearTable() {
+    static const std::array<float, 256> table = []() {
+        std::array<float, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            float v = i / 255.0f;
+            t[i] = v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+        }
+        return t;
+    }();
+    return table;
+}
+
+// Normals live in [-1, 1], everything else in [0, 1]; albedo RGB is linearized
+FloatImage decode(const uint8_t* rgba, uint32_t width, uint32_t height, TextureUsage usage) {
+    FloatImage image{width, height, std::vector<float>(size_t(width) * height * 4)};
+    const auto& toLinear = srgbToLinearTable();
+    for (size_t i = 0; i < image.texels.size(); i++) {
+        bool color = (i & 3) != 3;
+        float v = rgba[i] / 255.0f;
+        if (usage == TextureUsage::Albedo && color) v = toLinear[rgba[i]];
+        else if (usage == TextureUsage::Normal && color) v = v * 2.0f - 1.0f;
+        image.texels[i] = v;
+    }
+    return image;
+}
+
+// Filtering overshoots (negative lobes) and shortens averaged normals
+void normalizeLevel(FloatImage& image, TextureUsage usage) {
+    for (size_t i = 0; i < image.texels.size(); i += 4) {
+        float* t = &image.texels[i];
+        if (usage == TextureUsage::Normal) {
+            float length = std::sqrt(t[0] * t[0] + t[1] * t[1] + t[2] * t[2]);
+            if (length > 1e-6f)
+                for (uint32_t ch = 0; ch < 3; ch++) t[ch] /= length;
+            else
+                t[0] = t[1] = 0.0f, t[2] = 1.0f;
+            t[3] = std::clamp(t[3], 0.0f, 1.0f);
+        } else {
+            for (uint32_t ch = 0; ch < 4; ch++) t[ch] = std::clamp(t[ch], 0.0f, 1.0f);
+        }
+    }
+}
+
+void quantize(const FloatImage& image, TextureUsage usage, std::vector<uint8_t>& out) {
+    out.resize(image.texels.size());
+    for (size_t i = 0; i < image.texels.size(); i++) {
+        bool color = (i & 3) != 3;
+        float v = image.texels[i];
+        if (usage == TextureUsage::Albedo && color) v = linearToSrgb(v);
+        else if (usage == TextureUsage::Normal && color) v = v * 0.5f + 0.5f;
+        out[i] = static_cast<uint8_t>(std::lround(std::clamp(v, 0.0f, 1.0f) * 255.0f));
+    }
+}
+
+void encodeLevel(const uint8_t* rgba, uint32_t width, uint32_t height, VkFormat format, uint8_t* out) {
+    uint32_t bytes = TextureCooker::blockBytes(format);
+    if (TextureCooker::blockDim(format) == 1) {
+        for (size_t i = 0; i < size_t(width) * height; i++)
+            std::copy(rgba + i * 4, rgba + i * 4 + bytes, out + i * bytes);
+        return;
+    }
+
+    uint32_t blocksX = (width + 3) / 4;
+    uint32_t blocksY = (height + 3) / 4;
+    ThreadPool::shared().parallelFor(blocksY, [&](uint32_t by) {
+        uint8_t block[16 * 4];
+        for (uint32_t bx = 0; bx < blocksX; bx++) {
+            // Edge blocks replicate the last row / column
+            for (uint32_t y = 0; y < 4; y++) {
+                uint32_t sy = std::min(by * 4 + y, height - 1);
+                for (uint32_t x = 0; x < 4; x++) {
+                    uint32_t sx = std::min(bx * 4 + x, width - 1);
+                    std::copy_n(rgba + (size_t(sy) * width + sx) * 4, 4, block + (y * 4 + x) * 4);
+                }
+            }
+            uint8_t* dst = out + (size_t(by) * blocksX + bx) * bytes;
+            switch (format) {
+                case VK_FORMAT_BC1_RGB_UNORM_BLOCK: BlockEncoder::encodeBC1(block, dst); break;
+                case VK_FORMAT_BC4_UNORM_BLOCK:     BlockEncoder::encodeBC4(block, 0, dst); break;
+                case VK_FORMAT_BC5_UNORM_BLOCK:     BlockEncoder::encodeBC5(block, dst); break;
+                default:                            BlockEncoder::encodeBC7(block, dst); break;
+            }
+        }
+    });
+}
+} // anonymous namespace
+
+VkFormat TextureCooker::format(TextureUsage usage, bool compressed) {
+    switch (usage) {
+        case TextureUsage::Normal:    return compressed ? VK_FORMAT_BC5_UNORM_BLOCK : VK_FORMAT_R8G8_UNORM;
+        case TextureUsage::Mask:      return compressed ? VK_FORMAT_BC1_RGB_UNORM_BLOCK : VK_FORMAT_R8G8B8A8_UNORM;
+        case TextureUsage::Grayscale: return compressed ? VK_FORMAT_BC4_UNORM_BLOCK : VK_FORMAT_R8_UNORM;
+        default:                      return compressed ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_R8G8B8A8_SRGB;
+    }
+}
+
+uint32_t TextureCooker::cookFlags(const TextureCookOptions& options) {
+    uint32_t flags = static_cast<uint32_t>(options.usage) & COOK_USAGE_MASK;
+    if (options.generateMips) flags |= COOK_MIPS;
+    if (options.compress) flags |= COOK_COMPRESSED;
+    if (options.wrap) flags |= COOK_WRAP;
+    return flags;
+}
+
+uint32_t TextureCooker::mipCount(uint32_t width, uint32_t height) {
+    return static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+}
+
+uint32_t TextureCooker::blockBytes(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+            return 8;
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return 16;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            return 4;
+        case VK_FORMAT_R8G8_UNORM: return 2;
+        case VK_FORMAT_R8_UNORM:   return 1;
+        default:                   return 0;
+    }
+}
+
+uint32_t TextureCooker::blockDim(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return 4;
+        default:
+            return 1;
+    }
+}
+
+uint64_t TextureCooker::levelSize(VkFormat format, uint32_t width, uint32_t height) {
+    uint32_t dim = blockDim(format);
+    return uint64_t((width + dim - 1) / dim) * ((height + dim - 1) / dim) * blockBytes(format);
+}
+
+uint64_t TextureCooker::levelAlignment(VkFormat format) {
+    return std::lcm(uint64_t(std::max(blockBytes(format), 1u)), uint64_t(4));
+}
+
+bool TextureCooker::cook(const uint8_t* rgba, uint32_t width, uint32_t height,
+                         const TextureCookOptions& options, CookedTexture& out) {
+    if (!rgba || width == 0 || height == 0 || options.usage >= TextureUsage::Count) return false;
+    auto start = std::chrono::steady_clock::now();
+
+    out.format = format(options.usage, options.compress);
+    out.width = width;
+    out.height = height;
+    out.levels.resize(options.generateMips ? mipCount(width, height) : 1);
+
+    uint64_t alignment = levelAlignment(out.format);
+    uint64_t total = 0;
+    for (uint32_t mip = 0; mip < out.levels.size(); mip++) {
+        CookedTextureLevel& level = out.levels[mip];
+        level.width = std::max(width >> mip, 1u);
+        level.height = std::max(height >> mip, 1u);
+        level.offset = (total + alignment - 1) / alignment * alignment;
+        level.size = levelSize(out.format, level.width, level.height);
+        total = level.offset + level.size;
+    }
+    out.data.assign(total, 0);
+
+    FloatImage image = decode(rgba, width, height, options.usage);
+    normalizeLevel(image, options.usage);
+    std::vector<uint8_t> texels;
+    for (uint32_t mip = 0; mip < out.levels.size(); mip++) {
+        // Every level filters the previous one in float, so rounding never accumulates
+        if (mip > 0) {
+            image = downsample(image, options.wrap);
+            normalizeLevel(image, options.usage);
+        }
+        quantize(image, options.usage, texels);
+        encodeLevel(texels.data(), image.width, image.height, out.format,
+                    out.data.data() + out.levels[mip].offset);
+    }
+
+    LOG(Assets, Debug, "Cooked %ux%u texture: %zu mips, %.2f MB (%s), %.1f ms", width, height,
+        out.levels.size(), out.data.size() / (1024.0 * 1024.0),
+        options.compress ? (BlockEncoder::usesSIMD() ? "BC, SSE2" : "BC") : "uncompressed",
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return true;
+}
+
+} // namespace lmao
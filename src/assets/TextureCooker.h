@@ -0,0 +1,63 @@
+#pragma once
+#include <volk.h>
+#include <cstdint>
+#include <vector>
+
+namespace lmao {
+
+// What a texture holds: picks the cooked format and how its mips are filtered
+enum class TextureUsage : uint32_t {
+    Albedo,     // sRGB color + alpha                      -> BC7 (sRGB)
+    Normal,     // tangent-space normal, Z rebuilt on use  -> BC5
+    Mask,       // linear RGB data (occlusion, roughness, metallic) -> BC1
+    Grayscale,  // one linear channel in R                 -> BC4
+    Count
+};
+
+struct TextureCookOptions {
+    TextureUsage usage = TextureUsage::Albedo;
+    bool generateMips = true;
+    bool compress = true;  // false cooks RGBA8 / RG8 / R8 for devices without BC support
+    bool wrap = true;      // mip filter addressing: repeat, or clamp to edge
+};
+
+struct CookedTextureLevel {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint64_t offset = 0;  // into the level data, a multiple of TextureCooker::levelAlignment
+    uint64_t size = 0;
+};
+
+struct CookedTexture {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<CookedTextureLevel> levels;  // mip 0 first
+    std::vector<uint8_t> data;
+};
+
+// CPU texture cooker. The mip chain is built in linear float with a Kaiser-windowed sinc
+// (sRGB albedo is decoded first and re-encoded per level, normals are renormalized per
+// level), then every level is block compressed by BlockEncoder with one row of blocks per
+// ThreadPool::shared() task. The result uploads as-is (TextureLoader) or goes to a .ktx2
+// (KtxFile).
+class TextureCooker {
+public:
+    // rgba: width * height tightly packed RGBA8 texels
+    static bool cook(const uint8_t* rgba, uint32_t width, uint32_t height,
+                     const TextureCookOptions& options, CookedTexture& out);
+
+    static VkFormat format(TextureUsage usage, bool compressed);
+    // Bits of TextureCookOptions that change the cooked content
+    static uint32_t cookFlags(const TextureCookOptions& options);
+    static uint32_t mipCount(uint32_t width, uint32_t height);
+
+    // Formats the cooker writes: bytes per texel block and block edge (1 or 4)
+    static uint32_t blockBytes(VkFormat format);
+    static uint32_t blockDim(VkFormat format);
+    static uint64_t levelSize(VkFormat format, uint32_t width, uint32_t height);
+    // Level offsets satisfy both vkCmdCopyBufferToImage and KTX2: lcm(block bytes, 4)
+    static uint64_t levelAlignment(VkFormat format);
+};
+
+} // namespace lmao
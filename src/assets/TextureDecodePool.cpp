@@ -0,0 +1,269 @@
+#include "assets/TextureDecodePool.h"
+#include "assets/KtxFile.h"
+#include "assets/PackFile.h"
+#include "vulkan/VulkanContext.h"
+#include "vulkan/UploadManager.h"
+#include "core/AsyncFileReader.h"
+#include "core/Hash.h"
+#include "core/ThreadPool.h"
+#include "core/Log.h"
+#include <chrono>
+
+namespace lmao {
+
+namespace {
+template <typename T>
+bool isReady(const std::future<T>& future) {
+    return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+} // anonymous namespace
+
+TextureDecodePool::~TextureDecodePool() { shutdown(); }
+
+bool TextureDecodePool::init(VulkanContext& ctx, UploadManager& uploads, AsyncFileReader& reader) {
+    m_ctx = &ctx;
+    m_uploads = &uploads;
+    m_reader = &reader;
+
+    // Host-cached: the checksum pass reads the level data back
+    if (m_staging.init(ctx.allocator(), STAGING_SLAB_SIZE * STAGING_SLAB_COUNT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT)) {
+        for (uint32_t i = STAGING_SLAB_COUNT; i-- > 0;) m_freeSlabs.push_back(i);
+        reader.registerBuffer(m_staging.mapped(), static_cast<size_t>(m_staging.size()));
+    } else {
+        LOG(Assets, Warn, "No .ktx2 staging slabs, every texture file gets its own staging buffer");
+    }
+    LOG(Assets, Debug, "Texture decode pool: %u workers, %s reads", ThreadPool::shared().threadCount(),
+        reader.usesIoUring() ? "io_uring" : "thread-pool");
+    return true;
+}
+
+void TextureDecodePool::shutdown() {
+    if (!m_uploads) return;
+    finish();
+    if (m_staging.mapped()) m_reader->unregisterBuffer(m_staging.mapped());
+    m_staging.shutdown();
+    m_freeSlabs.clear();
+    m_uploads = nullptr;
+    m_reader = nullptr;
+    m_ctx = nullptr;
+}
+
+std::vector<TextureFuture> TextureDecodePool::load(std::span<const TextureLoadRequest> requests) {
+    std::vector<TextureFuture> futures;
+    futures.reserve(requests.size());
+    VmaAllocator allocator = m_ctx->allocator();
+    const PackFile* pack = PackFile::mounted();
+    std::vector<Job*> packedJobs;
+    std::vector<const PackEntry*> packedEntries;
+    for (const TextureLoadRequest& request : requests) {
+        Job& job = m_jobs.emplace_back();
+        job.request = request;
+        job.texture = std::make_shared<std::promise<std::shared_ptr<Texture>>>();
+        futures.push_back(job.texture->get_future().share());
+
+        const PackEntry* entry = pack ? pack->find(request.path) : nullptr;
+        if (request.path.ends_with(".ktx2") && entry) {
+            packedJobs.push_back(&job);
+            packedEntries.push_back(entry);
+        } else if (request.path.ends_with(".ktx2")) {
+            job.failed = !openKtx2(job);
+        } else if (entry) {
+            job.decoded = ThreadPool::shared().submit([allocator, path = request.path]() {
+                auto image = std::make_unique<DecodedImage>();
+                if (!TextureLoader::decode(allocator, path, *image)) image.reset();
+                return image;
+            });
+        } else {
+            readFile(job);
+        }
+    }
+
+    if (!packedJobs.empty()) {
+        std::vector<std::future<Buffer>> staged = pack->readToStagingAsync(allocator, packedEntries);
+        for (size_t i = 0; i < packedJobs.size(); i++)
+            packedJobs[i]->packed = std::move(staged[i]);
+    }
+    startStagedReads();
+    return futures;
+}
+
+TextureFuture TextureDecodePool::load(const std::string& path, bool genMipmaps, bool sRGB) {
+    TextureLoadRequest request{path, genMipmaps, sRGB};
+    return load(std::span(&request, 1))[0];
+}
+
+void TextureDecodePool::readFile(Job& job) {
+    uint64_t size = 0;
+    if (!AsyncFileReader::fileSize(job.request.path, size) || size == 0) {
+        LOG(Assets, Error, "Failed to load texture: %s", job.request.path.c_str());
+        job.failed = true;
+        return;
+    }
+    job.encoded.resize(static_cast<size_t>(size));
+    VmaAllocator allocator = m_ctx->allocator();
+    m_reader->read({job.request.path, 0, size, job.encoded.data(), [&job, allocator](bool ok) {
+        if (!ok) {
+            job.failed = true;
+            return;
+        }
+        job.decoded = ThreadPool::shared().submit(
+            [allocator, path = job.request.path, bytes = std::move(job.encoded)]() {
+                auto image = std::make_unique<DecodedImage>();
+                if (!TextureLoader::decode(allocator, path, bytes, *image)) image.reset();
+                return image;
+            });
+    }});
+}
+
+bool TextureDecodePool::openKtx2(Job& job) {
+    // Only the header and level index are touched here; the level data is read later
+    KtxFile file;
+    if (!file.open(job.request.path, false)) {
+        LOG(Assets, Error, "Failed to load texture: %s", job.request.path.c_str());
+        return false;
+    }
+    job.ktx2 = true;
+    job.format = file.format();
+    job.levels = file.levels();
+    job.dataOffset = file.levelDataOffset();
+    job.dataSize = file.levelData().size();
+    job.hasChecksum = file.hasCookInfo();
+    job.checksum = file.cookInfo().checksum;
+    return true;
+}
+
+void TextureDecodePool::startStagedReads() {
+    VmaAllocator allocator = m_ctx->allocator();
+    for (Job& job : m_jobs) {
+        if (!job.ktx2 || job.failed || job.slab >= 0 || job.dedicated) continue;
+
+        StagingAllocation dst;
+        VmaAllocation allocation;
+        if (job.dataSize <= STAGING_SLAB_SIZE && m_staging.mapped()) {
+            if (m_freeSlabs.empty()) continue;  // wait for an upload batch to hand one back
+            job.slab = static_cast<int>(m_freeSlabs.back());
+            m_freeSlabs.pop_back();
+            dst.buffer = m_staging.handle();
+            dst.offset = STAGING_SLAB_SIZE * static_cast<uint32_t>(job.slab);
+            dst.data = static_cast<uint8_t*>(m_staging.mapped()) + dst.offset;
+            allocation = m_staging.allocation();
+        } else {
+            job.dedicated = std::make_shared<Buffer>();
+            if (!job.dedicated->init(allocator, job.dataSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT)) {
+                job.failed = true;
+                continue;
+            }
+            dst.buffer = job.dedicated->handle();
+            dst.data = job.dedicated->mapped();
+            allocation = job.dedicated->allocation();
+        }
+
+        m_reader->read({job.request.path, job.dataOffset, job.dataSize, dst.data,
+            [&job, allocator, allocation, dst](bool ok) {
+                if (!ok) {
+                    job.failed = true;
+                    return;
+                }
+                job.verified = ThreadPool::shared().submit(
+                    [allocator, allocation, dst, size = job.dataSize, hasChecksum = job.hasChecksum,
+                     checksum = job.checksum]() {
+                        vmaFlushAllocation(allocator, allocation, dst.offset, size);
+                        return !hasChecksum || xxHash64(dst.data, static_cast<size_t>(size)) == checksum;
+                    });
+            }});
+    }
+}
+
+void TextureDecodePool::releaseStaging(Job& job) {
+    if (job.slab >= 0) m_freeSlabs.push_back(static_cast<uint32_t>(job.slab));
+    job.slab = -1;
+    job.dedicated.reset();
+}
+
+uint32_t TextureDecodePool::update() {
+    m_reader->poll();
+    startStagedReads();
+
+    uint32_t handed = 0;
+    for (auto it = m_jobs.begin(); it != m_jobs.end();) {
+        std::shared_ptr<Texture> texture;
+        if (it->failed) {
+            releaseStaging(*it);
+        } else if (isReady(it->decoded)) {
+            std::unique_ptr<DecodedImage> image = it->decoded.get();
+            if (image)
+                texture = TextureLoader::createFromDecoded(*m_ctx, *m_uploads, std::move(*image),
+                    it->request.genMipmaps, it->request.sRGB);
+            if (texture) {
+                m_uploads->onComplete([promise = it->texture, texture]() { promise->set_value(texture); });
+                handed++;
+                it = m_jobs.erase(it);
+                continue;
+            }
+        } else if (isReady(it->packed)) {
+            // The pack verified the entry's checksum as it decompressed it
+            Buffer staging = it->packed.get();
+            KtxFile file;
+            if (staging.mapped() &&
+                file.open({static_cast<const uint8_t*>(staging.mapped()), static_cast<size_t>(staging.size())},
+                          it->request.path, false)) {
+                texture = TextureLoader::createFromStaged(*m_ctx, *m_uploads, file.format(), std::move(staging),
+                    file.levelDataOffset(), file.levels());
+            } else {
+                LOG(Assets, Error, "Failed to load texture: %s", it->request.path.c_str());
+            }
+            if (texture) {
+                m_uploads->onComplete([promise = it->texture, texture]() { promise->set_value(texture); });
+                handed++;
+                it = m_jobs.erase(it);
+                continue;
+            }
+        } else if (isReady(it->verified)) {
+            if (it->verified.get()) {
+                StagingAllocation src;
+                src.buffer = it->dedicated ? it->dedicated->handle() : m_staging.handle();
+                src.offset = it->dedicated ? 0 : STAGING_SLAB_SIZE * static_cast<uint32_t>(it->slab);
+                texture = TextureLoader::createFromStaged(*m_ctx, *m_uploads, it->format, src, it->levels);
+            } else {
+                LOG(Assets, Error, "Rejecting texture file %s: checksum mismatch", it->request.path.c_str());
+            }
+            if (texture) {
+                // The staging memory is the copy source until the batch completes
+                m_uploads->onComplete([this, promise = it->texture, texture, slab = it->slab,
+                                       dedicated = it->dedicated]() {
+                    if (slab >= 0) m_freeSlabs.push_back(static_cast<uint32_t>(slab));
+                    promise->set_value(texture);
+                });
+                handed++;
+                it = m_jobs.erase(it);
+                continue;
+            }
+            releaseStaging(*it);
+        } else {
+            ++it;
+            continue;
+        }
+        it->texture->set_value(nullptr);
+        it = m_jobs.erase(it);
+    }
+    return handed;
+}
+
+void TextureDecodePool::finish() {
+    while (!m_jobs.empty()) {
+        m_reader->wait();
+        for (Job& job : m_jobs) {
+            if (job.decoded.valid()) job.decoded.wait();
+            if (job.verified.valid()) job.verified.wait();
+            if (job.packed.valid()) job.packed.wait();
+        }
+        update();
+        // Completed batches hand their staging slabs to .ktx2 files still waiting for one
+        m_uploads->flush();
+    }
+    m_uploads->flush();
+}
+
+} // namespace lmao
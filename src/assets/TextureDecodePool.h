@@ -0,0 +1,108 @@
+#pragma once
+#include "assets/Texture.h"
+#include "assets/TextureLoader.h"
+#include <future>
+#include <list>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace lmao {
+
+class VulkanContext;
+class UploadManager;
+class AsyncFileReader;
+
+struct TextureLoadRequest {
+    std::string path;
+    bool genMipmaps = true;  // image files only: a .ktx2 brings its own mips and format
+    bool sRGB = true;
+};
+
+// Ready once the texture is resident (its upload batch has completed); null on failure
+using TextureFuture = std::shared_future<std::shared_ptr<Texture>>;
+
+// Parallel texture file loading: TextureLoader::load's image formats and cooked .ktx2.
+//
+// Each file goes through three stages that overlap across files, so a level load keeps the
+// disk, the workers and the copy queue busy at once:
+//   read    AsyncFileReader pulls the file in. Image files land in host memory; the level
+//           data of a .ktx2 lands straight in a staging slab, persistently mapped and
+//           registered with the reader, which is what the GPU copy reads.
+//   decode  update() sees the read complete and queues a ThreadPool::shared() task that
+//           decodes the image with TextureLoader::decode into its own staging buffer, or
+//           checks the .ktx2 level data against its cook checksum.
+//   upload  update(), on the thread that records uploads, hands finished work to
+//           UploadManager and resolves the future from the batch's completion callback.
+// Files held by the mounted PackFile skip the read stage: images decode from the pack, and
+// a .ktx2 is decompressed on the workers (PackFile::readToStagingAsync) straight into a
+// staging buffer of its own, which the copy reads.
+// Poll the futures with wait_for(0) or call finish(): blocking on one from the recording
+// thread without update() and UploadManager::poll() running never returns.
+class TextureDecodePool {
+public:
+    // Staging for .ktx2 level data, reused once a slab's upload batch completes. Larger
+    // files get a buffer of their own.
+    static constexpr VkDeviceSize STAGING_SLAB_SIZE = 16 * 1024 * 1024;
+    static constexpr uint32_t STAGING_SLAB_COUNT = 4;
+
+    TextureDecodePool() = default;
+    ~TextureDecodePool();
+
+    TextureDecodePool(const TextureDecodePool&) = delete;
+    TextureDecodePool& operator=(const TextureDecodePool&) = delete;
+
+    bool init(VulkanContext& ctx, UploadManager& uploads, AsyncFileReader& reader);
+    // Finishes everything queued so no future is left unresolved
+    void shutdown();
+
+    std::vector<TextureFuture> load(std::span<const TextureLoadRequest> requests);
+    TextureFuture load(const std::string& path, bool genMipmaps = true, bool sRGB = true);
+
+    // Polls the reader, starts the decode of finished reads and records the uploads of
+    // finished decodes into the current batch; returns how many uploads were recorded
+    uint32_t update();
+    // Blocks until every queued texture is resident
+    void finish();
+
+    uint32_t pending() const { return static_cast<uint32_t>(m_jobs.size()); }
+
+private:
+    struct Job {
+        TextureLoadRequest request;
+        bool failed = false;              // the file could not be opened or read
+        std::vector<uint8_t> encoded;     // image file bytes while they are read
+        std::future<std::unique_ptr<DecodedImage>> decoded;  // null when decoding failed
+
+        // .ktx2: level data is read into a staging slab (or dedicated buffer) as-is
+        bool ktx2 = false;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        std::vector<CookedTextureLevel> levels;
+        uint64_t dataOffset = 0;          // KtxFile::levelDataOffset
+        uint64_t dataSize = 0;
+        uint64_t checksum = 0;            // KtxCookInfo::checksum when hasChecksum
+        bool hasChecksum = false;
+        int slab = -1;
+        std::shared_ptr<Buffer> dedicated;
+        std::future<bool> verified;
+        std::future<Buffer> packed;       // whole file, when the mounted PackFile holds it
+
+        std::shared_ptr<std::promise<std::shared_ptr<Texture>>> texture;
+    };
+
+    void readFile(Job& job);
+    bool openKtx2(Job& job);
+    // Gives waiting .ktx2 jobs staging memory and queues their reads
+    void startStagedReads();
+    void releaseStaging(Job& job);
+
+    VulkanContext* m_ctx = nullptr;
+    UploadManager* m_uploads = nullptr;
+    AsyncFileReader* m_reader = nullptr;
+    Buffer m_staging;                    // STAGING_SLAB_COUNT slabs, registered with the reader
+    std::vector<uint32_t> m_freeSlabs;
+    std::list<Job> m_jobs;               // reader callbacks hold pointers to their job
+};
+
+} // namespace lmao
@@ -1,87 +1,325 @@
+#include <cstddef>
+
+namespace lmao {
+namespace {
+void* stbiMalloc(size_t size);
+void* stbiRealloc(void* p, size_t size);
+void stbiFree(void* p);
+} // anonymous namespace
+} // namespace lmao
+
+#define STBI_MALLOC(size) lmao::stbiMalloc(size)
+#define STBI_REALLOC(p, size) lmao::stbiRealloc(p, size)
+#define STBI_FREE(p) lmao::stbiFree(p)
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #include "assets/TextureLoader.h"
+#include "assets/DerivedDataCache.h"
+#include "assets/KtxFile.h"
+#include "assets/PackFile.h"
 #include "vulkan/VulkanContext.h"
-#include "vulkan/CommandPool.h"
-#include "vulkan/Buffer.h"
+#include "vulkan/UploadManager.h"
 #include "core/Log.h"
+#include "core/MappedFile.h"
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
 #include <vector>
 
 namespace lmao {
 
-std::shared_ptr<Texture> TextureLoader::load(VulkanContext& ctx, CommandPool& cmdPool,
+namespace {
+// stb_image allocates its own output. While decode() runs on a thread, the first allocation
+// of exactly the decoded size is served from the staging buffer instead, so the decoder
+// writes its output where the GPU copies from. Everything else (zlib buffers, intermediate
+// images before a channel conversion) stays on the heap.
+struct DecodeTarget {
+    void* memory = nullptr;
+    size_t size = 0;
+    bool taken = false;
+};
+thread_local DecodeTarget t_decodeTarget;
+
+void* stbiMalloc(size_t size) {
+    DecodeTarget& target = t_decodeTarget;
+    if (target.memory && !target.taken && size == target.size) {
+        target.taken = true;
+        return target.memory;
+    }
+    return std::malloc(size);
+}
+
+void* stbiRealloc(void* p, size_t size) {
+    DecodeTarget& target = t_decodeTarget;
+    if (p && p == target.memory) {
+        // Growing buffers are never the output: move it to the heap and free the target
+        void* moved = std::malloc(size);
+        if (moved) std::memcpy(moved, p, std::min(size, target.size));
+        target.taken = false;
+        return moved;
+    }
+    return std::realloc(p, size);
+}
+
+void stbiFree(void* p) {
+    DecodeTarget& target = t_decodeTarget;
+    if (p && p == target.memory) {
+        target.taken = false;
+        return;
+    }
+    std::free(p);
+}
+} // anonymous namespace
+
+std::shared_ptr<Texture> TextureLoader::load(VulkanContext& ctx, UploadManager& uploads,
                                               const std::string& path,
                                               bool genMipmaps, bool sRGB) {
+    DecodedImage image;
+    if (!decode(ctx.allocator(), path, image)) return nullptr;
+    return createFromDecoded(ctx, uploads, std::move(image), genMipmaps, sRGB);
+}
+
+bool TextureLoader::decode(VmaAllocator allocator, const std::string& path, DecodedImage& out) {
+    // Images in the mounted pack are stored raw and decode straight from its mapping
+    MappedFile file;
+    std::vector<uint8_t> packed;
+    std::span<const uint8_t> bytes;
+    const PackFile* pack = PackFile::mounted();
+    if (const PackEntry* entry = pack ? pack->find(path) : nullptr) {
+        bytes = pack->view(*entry);
+        if (bytes.empty() && pack->read(*entry, packed)) bytes = packed;
+    } else if (file.open(path)) {
+        bytes = {file.data(), file.size()};
+    }
+    return decode(allocator, path, bytes, out);
+}
+
+bool TextureLoader::decode(VmaAllocator allocator, const std::string& path, std::span<const uint8_t> bytes,
+                           DecodedImage& out) {
     int w, h, channels;
-    stbi_uc* pixels = stbi_load(path.c_str(), &w, &h, &channels, STBI_rgb_alpha);
-    if (!pixels) {
+    if (bytes.empty() || bytes.size() > INT32_MAX ||
+        !stbi_info_from_memory(bytes.data(), static_cast<int>(bytes.size()), &w, &h, &channels)) {
         LOG(Assets, Error, "Failed to load texture: %s", path.c_str());
-        return nullptr;
+        return false;
     }
 
-    VkFormat format = sRGB ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
-    uint32_t mipLevels = genMipmaps
-        ? static_cast<uint32_t>(std::floor(std::log2(std::max(w, h)))) + 1
-        : 1;
-
-    VkDeviceSize imageSize = static_cast<VkDeviceSize>(w) * h * 4;
-
-    // Staging buffer
+    // Host-cached: PNG unfiltering reads back the previous row of the output
+    size_t size = static_cast<size_t>(w) * h * 4;
     Buffer staging;
-    staging.init(ctx.allocator(), imageSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VMA_MEMORY_USAGE_AUTO,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
-    staging.upload(pixels, imageSize);
-    stbi_image_free(pixels);
+    if (!staging.init(allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_AUTO,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT))
+        return false;
+
+    t_decodeTarget = {staging.mapped(), size, false};
+    stbi_uc* pixels = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &w, &h, &channels,
+        STBI_rgb_alpha);
+    bool inPlace = pixels == staging.mapped();
+    if (pixels && !inPlace)
+        std::memcpy(staging.mapped(), pixels, size);
+    t_decodeTarget = {};
+    if (!pixels) {
+        LOG(Assets, Error, "Failed to decode texture: %s (%s)", path.c_str(), stbi_failure_reason());
+        return false;
+    }
+    if (!inPlace) stbi_image_free(pixels);
+    vmaFlushAllocation(allocator, staging.allocation(), 0, VK_WHOLE_SIZE);
+
+    out.path = path;
+    out.staging = std::move(staging);
+    out.width = static_cast<uint32_t>(w);
+    out.height = static_cast<uint32_t>(h);
+    return true;
+}
+
+std::shared_ptr<Texture> TextureLoader::createFromDecoded(VulkanContext& ctx, UploadManager& uploads,
+                                                           DecodedImage&& decoded,
+                                                           bool genMipmaps, bool sRGB) {
+    const uint32_t w = decoded.width, h = decoded.height;
+    VkFormat format = sRGB ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    uint32_t mipLevels = genMipmaps ? TextureCooker::mipCount(w, h) : 1;
 
     // Create image
     Image::CreateInfo imgCI{};
-    imgCI.width = static_cast<uint32_t>(w);
-    imgCI.height = static_cast<uint32_t>(h);
+    imgCI.width = w;
+    imgCI.height = h;
     imgCI.format = format;
     imgCI.mipLevels = mipLevels;
     imgCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     if (genMipmaps) imgCI.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 
     Image image;
-    image.init(ctx.allocator(), ctx.device(), imgCI);
+    if (!image.init(ctx.allocator(), ctx.device(), imgCI)) return nullptr;
+
+    // Copy to mip 0, then finish on the graphics queue (blits need graphics)
+    uploads.uploadImage(image.handle(), std::move(decoded.staging), w, h, mipLevels);
 
-    cmdPool.submitImmediate(ctx.graphicsQueue(), [&](VkCommandBuffer cmd) {
-        // Transition to transfer dst
+    VkCommandBuffer cmd = uploads.graphicsCommands();
+    if (genMipmaps && mipLevels > 1) {
+        generateMipmaps(cmd, image.handle(), format, static_cast<int32_t>(w), static_cast<int32_t>(h), mipLevels);
+    } else {
         Image::transitionLayout(cmd, image.handle(),
-            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
             VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
+    }
 
-        // Copy buffer to mip 0
-        VkBufferImageCopy region{};
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = 0;
-        region.imageSubresource.layerCount = 1;
-        region.imageExtent = {static_cast<uint32_t>(w), static_cast<uint32_t>(h), 1};
-        vkCmdCopyBufferToImage(cmd, staging.handle(), image.handle(),
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-        if (genMipmaps && mipLevels > 1) {
-            generateMipmaps(cmd, image.handle(), format, w, h, mipLevels);
-        } else {
-            Image::transitionLayout(cmd, image.handle(),
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
+    auto tex = std::make_shared<Texture>();
+    tex->initFromImage(ctx.device(), std::move(image));
+    LOG(Assets, Info, "Texture loaded: %s (%ux%u, %u mips)", decoded.path.c_str(), w, h, mipLevels);
+    return tex;
+}
+
+std::shared_ptr<Texture> TextureLoader::loadCooked(VulkanContext& ctx, UploadManager& uploads,
+                                                    const std::string& path, TextureUsage usage,
+                                                    bool useCache) {
+    auto start = std::chrono::steady_clock::now();
+
+    TextureCookOptions options;
+    options.usage = usage;
+    options.compress = ctx.features().textureCompressionBC;
+    uint32_t cookFlags = TextureCooker::cookFlags(options);
+
+    // A cached .ktx2 is uploaded straight from the mapping
+    std::string cookedFile = useCache ? cookedPath(path, cookFlags) : std::string();
+    if (!cookedFile.empty()) {
+        std::error_code ec;
+        KtxFile cooked;
+        if (std::filesystem::exists(cookedFile, ec) && cooked.open(cookedFile)) {
+            if (cooked.hasCookInfo() && cooked.cookInfo().cookFlags == cookFlags) {
+                std::span<const uint8_t> data = cooked.levelData();
+                auto tex = createFromLevels(ctx, uploads, cooked.format(), data.data(), data.size(), cooked.levels());
+                if (tex) {
+                    LOG(Assets, Info, "Loaded %s from %s (%.1f ms)", path.c_str(), cookedFile.c_str(),
+                        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+                    return tex;
+                }
+            }
+            LOG(Assets, Debug, "Unusable cache entry %s, re-cooking", cookedFile.c_str());
         }
-    });
-    staging.shutdown();
+    }
+
+    CookedTexture cooked;
+    if (!cookFile(path, options, cooked)) return nullptr;
+    if (!cookedFile.empty())
+        KtxFile::write(cookedFile, cooked, cookFlags);
+
+    auto tex = createFromCooked(ctx, uploads, cooked);
+    if (tex)
+        LOG(Assets, Info, "Texture cooked: %s (%ux%u, %zu mips, %.1f ms)", path.c_str(), cooked.levels[0].width,
+            cooked.levels[0].height, cooked.levels.size(),
+            std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return tex;
+}
+
+std::shared_ptr<Texture> TextureLoader::loadKTX2(VulkanContext& ctx, UploadManager& uploads,
+                                                  const std::string& path) {
+    KtxFile file;
+    if (!file.open(path)) {
+        LOG(Assets, Error, "Failed to load texture: %s", path.c_str());
+        return nullptr;
+    }
+    std::span<const uint8_t> data = file.levelData();
+    auto tex = createFromLevels(ctx, uploads, file.format(), data.data(), data.size(), file.levels());
+    if (tex)
+        LOG(Assets, Info, "Texture loaded: %s (%ux%u, %u mips)", path.c_str(),
+            file.header().pixelWidth, file.header().pixelHeight, file.header().levelCount);
+    return tex;
+}
+
+bool TextureLoader::cookFile(const std::string& path, const TextureCookOptions& options, CookedTexture& out) {
+    int w, h, channels;
+    stbi_uc* pixels = stbi_load(path.c_str(), &w, &h, &channels, STBI_rgb_alpha);
+    if (!pixels) {
+        LOG(Assets, Error, "Failed to load texture: %s", path.c_str());
+        return false;
+    }
+    bool ok = TextureCooker::cook(pixels, static_cast<uint32_t>(w), static_cast<uint32_t>(h), options, out);
+    stbi_image_free(pixels);
+    return ok;
+}
+
+std::string TextureLoader::cookedPath(const std::string& path, uint32_t cookFlags) {
+    uint64_t source;
+    if (DerivedDataCache::root().empty() || !DerivedDataCache::hashSource(path, source)) return {};
+    uint64_t key = DerivedDataCache::key("texture", source, cookFlags, DerivedDataCache::TEXTURE_VERSION);
+    return DerivedDataCache::entryPath(key, ".ktx2");
+}
+
+bool TextureLoader::isSampleable(VulkanContext& ctx, VkFormat format) {
+    VkFormatProperties props{};
+    vkGetPhysicalDeviceFormatProperties(ctx.physicalDevice(), format, &props);
+    bool blockCompressed = TextureCooker::blockDim(format) > 1;
+    return (props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) &&
+           (!blockCompressed || ctx.features().textureCompressionBC);
+}
+
+std::shared_ptr<Texture> TextureLoader::createFromCooked(VulkanContext& ctx, UploadManager& uploads,
+                                                          const CookedTexture& cooked) {
+    return createFromLevels(ctx, uploads, cooked.format, cooked.data.data(), cooked.data.size(), cooked.levels);
+}
+
+std::shared_ptr<Texture> TextureLoader::createFromStaged(VulkanContext& ctx, UploadManager& uploads,
+                                                          VkFormat format, Buffer&& staging, VkDeviceSize offset,
+                                                          const std::vector<CookedTextureLevel>& levels) {
+    return createFromLevels(ctx, uploads, format, levels,
+        [&](VkImage image, std::span<const ImageUploadLevel> uploadLevels) {
+            uploads.uploadImageLevels(image, std::move(staging), offset, uploadLevels);
+        });
+}
+
+std::shared_ptr<Texture> TextureLoader::createFromLevels(VulkanContext& ctx, UploadManager& uploads,
+                                                          VkFormat format, const uint8_t* data, size_t size,
+                                                          const std::vector<CookedTextureLevel>& levels) {
+    return createFromLevels(ctx, uploads, format, levels,
+        [&](VkImage image, std::span<const ImageUploadLevel> uploadLevels) {
+            uploads.uploadImageLevels(image, data, size, uploadLevels);
+        });
+}
+
+std::shared_ptr<Texture> TextureLoader::createFromStaged(VulkanContext& ctx, UploadManager& uploads,
+                                                          VkFormat format, const StagingAllocation& src,
+                                                          const std::vector<CookedTextureLevel>& levels) {
+    return createFromLevels(ctx, uploads, format, levels,
+        [&](VkImage image, std::span<const ImageUploadLevel> uploadLevels) {
+            uploads.uploadImageLevels(image, src, uploadLevels);
+        });
+}
+
+std::shared_ptr<Texture> TextureLoader::createFromLevels(
+    VulkanContext& ctx, UploadManager& uploads, VkFormat format, const std::vector<CookedTextureLevel>& levels,
+    const std::function<void(VkImage, std::span<const ImageUploadLevel>)>& upload) {
+    if (!isSampleable(ctx, format)) {
+        LOG(Assets, Error, "Texture format %d is not sampleable on this device", format);
+        return nullptr;
+    }
+
+    Image::CreateInfo imgCI{};
+    imgCI.width = levels[0].width;
+    imgCI.height = levels[0].height;
+    imgCI.format = format;
+    imgCI.mipLevels = static_cast<uint32_t>(levels.size());
+    imgCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+    Image image;
+    if (!image.init(ctx.allocator(), ctx.device(), imgCI)) return nullptr;
+
+    std::vector<ImageUploadLevel> uploadLevels(levels.size());
+    for (size_t i = 0; i < levels.size(); i++)
+        uploadLevels[i] = {levels[i].offset, levels[i].width, levels[i].height};
+    upload(image.handle(), uploadLevels);
+    Image::transitionLayout(uploads.graphicsCommands(), image.handle(),
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT, imgCI.mipLevels);
 
     auto tex = std::make_shared<Texture>();
     tex->initFromImage(ctx.device(), std::move(image));
-    LOG(Assets, Info, "Texture loaded: %s (%dx%d, %u mips)", path.c_str(), w, h, mipLevels);
     return tex;
 }
 
-std::shared_ptr<Texture> TextureLoader::createSolidColor(VulkanContext& ctx, CommandPool& cmdPool,
+std::shared_ptr<Texture> TextureLoader::createSolidColor(VulkanContext& ctx, UploadManager& uploads,
                                                           const vec4& color, bool sRGB) {
     uint8_t r = static_cast<uint8_t>(std::clamp(color.r, 0.0f, 1.0f) * 255.0f);
     uint8_t g = static_cast<uint8_t>(std::clamp(color.g, 0.0f, 1.0f) * 255.0f);
@@ -91,13 +329,6 @@ std::shared_ptr<Texture> TextureLoader::createSolidColor(VulkanContext& ctx, Com
 
     VkFormat format = sRGB ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
 
-    Buffer staging;
-    staging.init(ctx.allocator(), 4,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VMA_MEMORY_USAGE_AUTO,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
-    staging.upload(pixel, 4);
-
     Image::CreateInfo imgCI{};
     imgCI.width = 1;
     imgCI.height = 1;
@@ -107,28 +338,16 @@ std::shared_ptr<Texture> TextureLoader::createSolidColor(VulkanContext& ctx, Com
     Image image;
     image.init(ctx.allocator(), ctx.device(), imgCI);
 
-    cmdPool.submitImmediate(ctx.graphicsQueue(), [&](VkCommandBuffer cmd) {
-        Image::transitionLayout(cmd, image.handle(),
-            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-        VkBufferImageCopy region{};
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.layerCount = 1;
-        region.imageExtent = {1, 1, 1};
-        vkCmdCopyBufferToImage(cmd, staging.handle(), image.handle(),
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-        Image::transitionLayout(cmd, image.handle(),
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    });
-    staging.shutdown();
+    uploads.uploadImage(image.handle(), pixel, sizeof(pixel), 1, 1);
+    Image::transitionLayout(uploads.graphicsCommands(), image.handle(),
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
     auto tex = std::make_shared<Texture>();
     tex->initFromImage(ctx.device(), std::move(image), true, 1.0f);
     return tex;
 }
 
-std::shared_ptr<Texture> TextureLoader::createCheckerboard(VulkanContext& ctx, CommandPool& cmdPool,
+std::shared_ptr<Texture> TextureLoader::createCheckerboard(VulkanContext& ctx, UploadManager& uploads,
                                                             uint32_t size, uint32_t tileSize,
                                                             const vec4& color1, const vec4& color2) {
     std::vector<uint8_t> pixels(size * size * 4);
@@ -147,13 +366,6 @@ std::shared_ptr<Texture> TextureLoader::createCheckerboard(VulkanContext& ctx, C
     VkDeviceSize imageSize = size * size * 4;
     uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(size))) + 1;
 
-    Buffer staging;
-    staging.init(ctx.allocator(), imageSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VMA_MEMORY_USAGE_AUTO,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
-    staging.upload(pixels.data(), imageSize);
-
     Image::CreateInfo imgCI{};
     imgCI.width = size;
     imgCI.height = size;
@@ -164,22 +376,9 @@ std::shared_ptr<Texture> TextureLoader::createCheckerboard(VulkanContext& ctx, C
     Image image;
     image.init(ctx.allocator(), ctx.device(), imgCI);
 
-    cmdPool.submitImmediate(ctx.graphicsQueue(), [&](VkCommandBuffer cmd) {
-        Image::transitionLayout(cmd, image.handle(),
-            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
-
-        VkBufferImageCopy region{};
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.layerCount = 1;
-        region.imageExtent = {size, size, 1};
-        vkCmdCopyBufferToImage(cmd, staging.handle(), image.handle(),
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-        generateMipmaps(cmd, image.handle(), VK_FORMAT_R8G8B8A8_SRGB,
-            static_cast<int32_t>(size), static_cast<int32_t>(size), mipLevels);
-    });
-    staging.shutdown();
+    uploads.uploadImage(image.handle(), pixels.data(), imageSize, size, size, mipLevels);
+    generateMipmaps(uploads.graphicsCommands(), image.handle(), VK_FORMAT_R8G8B8A8_SRGB,
+        static_cast<int32_t>(size), static_cast<int32_t>(size), mipLevels);
 
     auto tex = std::make_shared<Texture>();
     tex->initFromImage(ctx.device(), std::move(image));
@@ -1,29 +1,97 @@
 #pragma once
 #include "assets/Texture.h"
+#include "assets/TextureCooker.h"
 #include "math/MathUtils.h"
+#include "vulkan/Buffer.h"
+#include "vulkan/UploadManager.h"
+#include <functional>
 #include <memory>
+#include <span>
 #include <string>
+#include <vector>
 
 namespace lmao {
 
 class VulkanContext;
-class CommandPool;
+
+// An image file decoded to RGBA8, held in its own staging buffer (see TextureLoader::decode)
+struct DecodedImage {
+    std::string path;
+    Buffer staging;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
 
 class TextureLoader {
 public:
-    static std::shared_ptr<Texture> load(VulkanContext& ctx, CommandPool& cmdPool,
+    // Texture contents arrive with the UploadManager batch the call was recorded into
+    static std::shared_ptr<Texture> load(VulkanContext& ctx, UploadManager& uploads,
                                           const std::string& path,
                                           bool genMipmaps = true, bool sRGB = true);
 
-    static std::shared_ptr<Texture> createSolidColor(VulkanContext& ctx, CommandPool& cmdPool,
+    // Thread-safe, no GPU work: decodes an image file (stb_image; from the mounted PackFile
+    // when it holds the path) into a host-cached staging buffer. The decoder writes its output there directly, except for the rare images
+    // whose output stb_image reallocates, which are copied over once.
+    static bool decode(VmaAllocator allocator, const std::string& path, DecodedImage& out);
+    // Same, from the encoded file already in memory (e.g. read by AsyncFileReader)
+    static bool decode(VmaAllocator allocator, const std::string& path, std::span<const uint8_t> bytes,
+                       DecodedImage& out);
+    // Uploads a decoded image from its staging buffer; mips are generated on the graphics queue
+    static std::shared_ptr<Texture> createFromDecoded(VulkanContext& ctx, UploadManager& uploads,
+                                                       DecodedImage&& image,
+                                                       bool genMipmaps = true, bool sRGB = true);
+
+    // Loads the .ktx2 the DerivedDataCache holds for this source and usage, otherwise
+    // decodes the source, cooks it (TextureCooker) and stores the result there (useCache =
+    // false skips both). Mips come prebuilt; nothing runs on the GPU but copies.
+    static std::shared_ptr<Texture> loadCooked(VulkanContext& ctx, UploadManager& uploads,
+                                                const std::string& path, TextureUsage usage,
+                                                bool useCache = true);
+
+    // Uploads a .ktx2 as-is, every level straight from the mapping
+    static std::shared_ptr<Texture> loadKTX2(VulkanContext& ctx, UploadManager& uploads,
+                                              const std::string& path);
+
+    // Uploads a mip chain laid out like KtxFile::levelData() that already sits in staging
+    // memory the caller keeps untouched until the upload batch completes
+    static std::shared_ptr<Texture> createFromStaged(VulkanContext& ctx, UploadManager& uploads,
+                                                      VkFormat format, const StagingAllocation& src,
+                                                      const std::vector<CookedTextureLevel>& levels);
+    // Same, from a staging buffer (e.g. a .ktx2 from PackFile::readToStaging) whose mip chain
+    // starts at offset; the upload batch adopts the buffer
+    static std::shared_ptr<Texture> createFromStaged(VulkanContext& ctx, UploadManager& uploads,
+                                                      VkFormat format, Buffer&& staging, VkDeviceSize offset,
+                                                      const std::vector<CookedTextureLevel>& levels);
+
+    // Uploads a TextureCooker result (e.g. cooked from generated pixels)
+    static std::shared_ptr<Texture> createFromCooked(VulkanContext& ctx, UploadManager& uploads,
+                                                      const CookedTexture& cooked);
+
+    // CPU only, thread-safe: decodes an image file and cooks it as loadCooked does
+    static bool cookFile(const std::string& path, const TextureCookOptions& options, CookedTexture& out);
+    // DerivedDataCache entry (.ktx2) of path cooked with cookFlags; empty when the cache is
+    // disabled or the source is unreadable
+    static std::string cookedPath(const std::string& path, uint32_t cookFlags);
+    // Whether the device can sample format (BC formats need textureCompressionBC)
+    static bool isSampleable(VulkanContext& ctx, VkFormat format);
+
+    static std::shared_ptr<Texture> createSolidColor(VulkanContext& ctx, UploadManager& uploads,
                                                       const vec4& color, bool sRGB = true);
 
-    static std::shared_ptr<Texture> createCheckerboard(VulkanContext& ctx, CommandPool& cmdPool,
+    static std::shared_ptr<Texture> createCheckerboard(VulkanContext& ctx, UploadManager& uploads,
                                                         uint32_t size = 256, uint32_t tileSize = 32,
                                                         const vec4& color1 = vec4(0.9f, 0.9f, 0.9f, 1.0f),
                                                         const vec4& color2 = vec4(0.3f, 0.3f, 0.3f, 1.0f));
 
 private:
+    // data holds every level at its CookedTextureLevel::offset
+    static std::shared_ptr<Texture> createFromLevels(VulkanContext& ctx, UploadManager& uploads,
+                                                      VkFormat format, const uint8_t* data, size_t size,
+                                                      const std::vector<CookedTextureLevel>& levels);
+    // Creates the image and records upload(image, levels) into it
+    static std::shared_ptr<Texture> createFromLevels(
+        VulkanContext& ctx, UploadManager& uploads, VkFormat format, const std::vector<CookedTextureLevel>& levels,
+        const std::function<void(VkImage, std::span<const ImageUploadLevel>)>& upload);
     static void generateMipmaps(VkCommandBuffer cmd, VkImage image, VkFormat format,
                                  int32_t width, int32_t height, uint32_t mipLevels);
 };
@@ -0,0 +1,284 @@
+#include "assets/TextureStreamer.h"
+#include "assets/TextureLoader.h"
+#include "vulkan/VulkanContext.h"
+#include "vulkan/UploadManager.h"
+#include "core/Log.h"
+#include <algorithm>
+#include <cmath>
+
+namespace lmao {
+
+TextureStreamer::~TextureStreamer() { shutdown(); }
+
+bool TextureStreamer::init(VulkanContext& ctx, UploadManager& uploads, VkDeviceSize budget,
+                           uint32_t framesInFlight) {
+    m_ctx = &ctx;
+    m_uploads = &uploads;
+    m_budget = budget;
+    m_framesInFlight = std::max(framesInFlight, 1u);
+    LOG(Assets, Info, "Texture streaming: %.0f MB budget, %u px mip tail",
+        m_budget / (1024.0 * 1024.0), TAIL_SIZE);
+    return true;
+}
+
+void TextureStreamer::shutdown() {
+    if (!m_uploads) return;
+    // Pending transitions' callbacks point at entries
+    m_uploads->flush();
+    m_lookup.clear();
+    m_entries.clear();
+    m_retired.clear();
+    m_committedBytes = 0;
+    m_uploads = nullptr;
+    m_ctx = nullptr;
+}
+
+std::shared_ptr<Texture> TextureStreamer::load(const std::string& path) {
+    auto entry = std::make_unique<Entry>();
+    entry->file = std::make_unique<KtxFile>();
+    if (!entry->file->open(path)) {
+        LOG(Assets, Error, "Failed to stream texture: %s", path.c_str());
+        return nullptr;
+    }
+    entry->data = entry->file->levelData().data();
+    entry->levels = entry->file->levels();
+    entry->format = entry->file->format();
+    return addEntry(std::move(entry), path.c_str());
+}
+
+std::shared_ptr<Texture> TextureStreamer::add(CookedTexture&& cooked, const char* name) {
+    auto entry = std::make_unique<Entry>();
+    entry->cooked = std::move(cooked);
+    entry->data = entry->cooked.data.data();
+    entry->levels = entry->cooked.levels;
+    entry->format = entry->cooked.format;
+    return addEntry(std::move(entry), name);
+}
+
+std::shared_ptr<Texture> TextureStreamer::addEntry(std::unique_ptr<Entry> entry, const char* name) {
+    Entry& e = *entry;
+    if (e.levels.empty() || !TextureLoader::isSampleable(*m_ctx, e.format)) {
+        LOG(Assets, Error, "Cannot stream %s: no levels or format %d is not sampleable", name, e.format);
+        return nullptr;
+    }
+
+    const uint32_t levelCount = static_cast<uint32_t>(e.levels.size());
+    while (e.tailMip + 1 < levelCount &&
+           std::max(e.levels[e.tailMip].width, e.levels[e.tailMip].height) > TAIL_SIZE)
+        e.tailMip++;
+
+    Image image;
+    if (!createImage(e, e.tailMip, image)) return nullptr;
+    const uint32_t imageLevels = levelCount - e.tailMip;
+    uploadLevels(e, image.handle(), e.tailMip, levelCount, imageLevels);
+    Image::transitionLayout(m_uploads->graphicsCommands(), image.handle(),
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT, imageLevels);
+
+    e.texture = std::make_shared<Texture>();
+    e.texture->initFromImage(m_ctx->device(), std::move(image));
+    e.residentMip = e.committedMip = e.wantedMip = e.tailMip;
+    e.lastNeeded.assign(levelCount, 0);
+    m_committedBytes += residentSize(e, e.tailMip);
+
+    LOG(Assets, Info, "Streaming %s: %ux%u, %u mips, %u resident (%.1f of %.1f KB)", name,
+        e.levels[0].width, e.levels[0].height, levelCount, imageLevels,
+        residentSize(e, e.tailMip) / 1024.0, residentSize(e, 0) / 1024.0);
+
+    std::shared_ptr<Texture> texture = e.texture;
+    m_lookup[texture.get()] = entry.get();
+    m_entries.push_back(std::move(entry));
+    return texture;
+}
+
+void TextureStreamer::request(const Texture* texture, float uvPerPixel) {
+    auto it = m_lookup.find(texture);
+    if (it == m_lookup.end()) return;
+    Entry& e = *it->second;
+
+    // Mip whose texels are about one pixel apart
+    float texelsPerPixel = uvPerPixel * static_cast<float>(std::max(e.levels[0].width, e.levels[0].height));
+    int mip = texelsPerPixel > 1.0f ? static_cast<int>(std::floor(std::log2(texelsPerPixel))) : 0;
+    mip = std::clamp(mip + m_mipBias, 0, static_cast<int>(e.levels.size()) - 1);
+    e.requestedMip = std::min(e.requestedMip, static_cast<uint32_t>(mip));
+}
+
+void TextureStreamer::update() {
+    if (!m_uploads) return;
+    m_frame++;
+    m_uploadedBytes = 0;
+
+    // Finished transitions: the new image takes over, the old one waits out the frames
+    // that may still sample it
+    for (auto& entry : m_entries) {
+        Entry& e = *entry;
+        if (!e.pending || !e.ready) continue;
+        m_retired.push_back({e.texture->swapImage(std::move(e.pendingImage)), m_frame});
+        e.residentMip = e.committedMip;
+        e.pending = false;
+        e.ready = false;
+    }
+    std::erase_if(m_retired, [&](const RetiredImage& r) { return m_frame >= r.frame + m_framesInFlight; });
+
+    // This frame's needs; the tail always counts as needed
+    std::vector<Entry*> upgrades;
+    for (auto& entry : m_entries) {
+        Entry& e = *entry;
+        e.wantedMip = std::min(e.requestedMip, e.tailMip);
+        for (uint32_t m = e.wantedMip; m < e.tailMip; m++)
+            e.lastNeeded[m] = m_frame;
+        e.requestedMip = NO_REQUEST;
+        if (!e.pending && e.wantedMip < e.committedMip)
+            upgrades.push_back(&e);
+    }
+
+    // A lowered budget gives back what is not in use right away
+    if (m_committedBytes > m_budget)
+        evict(m_committedBytes - m_budget);
+
+    // Furthest from their wanted resolution first
+    std::sort(upgrades.begin(), upgrades.end(), [](const Entry* a, const Entry* b) {
+        return a->committedMip - a->wantedMip > b->committedMip - b->wantedMip;
+    });
+    for (Entry* e : upgrades) {
+        // Within the per-frame upload cap, but every texture can always add one mip
+        uint32_t target = e->wantedMip;
+        auto growth = [&](uint32_t mip) { return residentSize(*e, mip) - residentSize(*e, e->committedMip); };
+        while (target + 1 < e->committedMip && m_uploadedBytes + growth(target) > m_uploadPerFrame)
+            target++;
+        if (m_uploadedBytes > 0 && m_uploadedBytes + growth(target) > m_uploadPerFrame)
+            break;
+
+        VkDeviceSize bytes = growth(target);
+        if (m_committedBytes + bytes > m_budget)
+            evict(m_committedBytes + bytes - m_budget);
+        if (m_committedBytes + bytes > m_budget)
+            continue;  // everything resident is in use; wait for something to fall out of view
+
+        if (startTransition(*e, target))
+            m_uploadedBytes += bytes;
+    }
+}
+
+// Shrinks textures holding mips that were not requested this frame, least recently needed
+// first, until bytes are released
+void TextureStreamer::evict(VkDeviceSize bytes) {
+    std::vector<Entry*> victims;
+    for (auto& entry : m_entries) {
+        if (!entry->pending && entry->committedMip < entry->wantedMip)
+            victims.push_back(entry.get());
+    }
+    std::sort(victims.begin(), victims.end(), [](const Entry* a, const Entry* b) {
+        return a->lastNeeded[a->committedMip] < b->lastNeeded[b->committedMip];
+    });
+
+    VkDeviceSize released = 0;
+    for (Entry* e : victims) {
+        if (released >= bytes) break;
+        VkDeviceSize freed = residentSize(*e, e->committedMip) - residentSize(*e, e->wantedMip);
+        uint32_t dropped = e->wantedMip - e->committedMip;
+        if (!startTransition(*e, e->wantedMip)) continue;
+        released += freed;
+        m_evictedMips += dropped;
+    }
+}
+
+bool TextureStreamer::createImage(const Entry& entry, uint32_t firstMip, Image& out) const {
+    Image::CreateInfo ci{};
+    ci.width = entry.levels[firstMip].width;
+    ci.height = entry.levels[firstMip].height;
+    ci.format = entry.format;
+    ci.mipLevels = static_cast<uint32_t>(entry.levels.size()) - firstMip;
+    ci.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    return out.init(m_ctx->allocator(), m_ctx->device(), ci);
+}
+
+void TextureStreamer::uploadLevels(const Entry& entry, VkImage image, uint32_t firstMip, uint32_t endMip,
+                                   uint32_t imageLevels) {
+    // The levels are contiguous in either source order (.ktx2 stores the smallest first)
+    uint64_t begin = UINT64_MAX, end = 0;
+    for (uint32_t m = firstMip; m < endMip; m++) {
+        begin = std::min(begin, entry.levels[m].offset);
+        end = std::max(end, entry.levels[m].offset + entry.levels[m].size);
+    }
+    std::vector<ImageUploadLevel> levels;
+    for (uint32_t m = firstMip; m < endMip; m++)
+        levels.push_back({entry.levels[m].offset - begin, entry.levels[m].width, entry.levels[m].height});
+    m_uploads->uploadImageLevels(image, entry.data + begin, end - begin, levels, imageLevels);
+}
+
+// Records a new image holding mips [targetMip, levelCount) into the current upload batch:
+// levels finer than the resident ones come from the source, the rest from the current image
+bool TextureStreamer::startTransition(Entry& e, uint32_t targetMip) {
+    Image image;
+    if (!createImage(e, targetMip, image)) return false;
+
+    const uint32_t levelCount = static_cast<uint32_t>(e.levels.size());
+    const uint32_t imageLevels = levelCount - targetMip;
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    if (targetMip < e.residentMip) {
+        uploadLevels(e, image.handle(), targetMip, e.residentMip, imageLevels);
+        cmd = m_uploads->graphicsCommands();
+        m_streamedMips += e.residentMip - targetMip;
+    } else {
+        cmd = m_uploads->graphicsCommands();
+        Image::transitionLayout(cmd, image.handle(),
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_ASPECT_COLOR_BIT, imageLevels);
+    }
+
+    const Image& current = e.texture->image();
+    const uint32_t copyFirst = std::max(targetMip, e.residentMip);
+    std::vector<VkImageCopy> regions;
+    for (uint32_t m = copyFirst; m < levelCount; m++) {
+        VkImageCopy region{};
+        region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, m - e.residentMip, 0, 1};
+        region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, m - targetMip, 0, 1};
+        region.extent = {e.levels[m].width, e.levels[m].height, 1};
+        regions.push_back(region);
+    }
+    Image::transitionLayout(cmd, current.handle(),
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT, current.mipLevels());
+    vkCmdCopyImage(cmd, current.handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        image.handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(regions.size()), regions.data());
+    Image::transitionLayout(cmd, current.handle(),
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT, current.mipLevels());
+    Image::transitionLayout(cmd, image.handle(),
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT, imageLevels);
+
+    Entry* entry = &e;
+    m_uploads->onComplete([entry] { entry->ready = true; });
+
+    m_committedBytes = m_committedBytes - residentSize(e, e.committedMip) + residentSize(e, targetMip);
+    e.committedMip = targetMip;
+    e.pendingImage = std::move(image);
+    e.pending = true;
+    return true;
+}
+
+VkDeviceSize TextureStreamer::residentSize(const Entry& entry, uint32_t firstMip) {
+    VkDeviceSize size = 0;
+    for (size_t m = firstMip; m < entry.levels.size(); m++)
+        size += entry.levels[m].size;
+    return size;
+}
+
+TextureStreamer::Stats TextureStreamer::stats() const {
+    Stats s;
+    s.textures = static_cast<uint32_t>(m_entries.size());
+    s.residentBytes = m_committedBytes;
+    s.uploadedBytes = m_uploadedBytes;
+    s.streamedMips = m_streamedMips;
+    s.evictedMips = m_evictedMips;
+    for (const auto& entry : m_entries) {
+        s.pending += entry->pending ? 1 : 0;
+        s.fullBytes += residentSize(*entry, 0);
+    }
+    return s;
+}
+
+} // namespace lmao
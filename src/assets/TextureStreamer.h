@@ -0,0 +1,137 @@
+#pragma once
+#include "assets/KtxFile.h"
+#include "assets/Texture.h"
+#include "assets/TextureCooker.h"
+#include <volk.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lmao {
+
+class VulkanContext;
+class UploadManager;
+
+// Mip-level residency for cooked textures under a global memory budget.
+//
+// A streamed texture starts with only its mip tail (levels no larger than TAIL_SIZE)
+// resident. Each frame the renderer reports how much of every texture it can show
+// (request), and update() moves each image toward the finest mip requested: a new image
+// covering that mip range is allocated, the missing levels are uploaded from the source
+// (a mapped .ktx2, or an in-memory cook) and the levels both images share are copied on
+// the GPU. The Texture object stays the same; its image is swapped once the upload batch
+// has completed and materials pick the new view up through Material::refreshTextures.
+//
+// Growing never takes residency past the budget: mips nobody requested this frame are
+// evicted first, least recently needed texture first, and requests that still do not fit
+// wait. Uploads per frame are capped so a camera cut streams in over a few frames.
+//
+// update() swaps images and retires old ones, so it must run after the frame fence wait,
+// when no recorded work still samples them (the engine keeps one frame in flight).
+class TextureStreamer {
+public:
+    // Levels up to this size (largest edge, texels) stay resident
+    static constexpr uint32_t TAIL_SIZE = 64;
+    static constexpr VkDeviceSize DEFAULT_BUDGET = 256ull * 1024 * 1024;
+    static constexpr VkDeviceSize DEFAULT_UPLOAD_PER_FRAME = 32ull * 1024 * 1024;
+
+    struct Stats {
+        uint32_t textures = 0;
+        uint32_t pending = 0;           // transitions waiting for their upload batch
+        VkDeviceSize residentBytes = 0; // including pending transitions' targets
+        VkDeviceSize fullBytes = 0;     // every mip of every texture
+        VkDeviceSize uploadedBytes = 0; // by the last update()
+        uint64_t streamedMips = 0;
+        uint64_t evictedMips = 0;
+    };
+
+    TextureStreamer() = default;
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    bool init(VulkanContext& ctx, UploadManager& uploads, VkDeviceSize budget = DEFAULT_BUDGET,
+              uint32_t framesInFlight = 1);
+    void shutdown();
+
+    // Streams a .ktx2, which stays mapped as the source of the higher mips
+    std::shared_ptr<Texture> load(const std::string& path);
+    // Streams a TextureCooker result, kept in memory as the source
+    std::shared_ptr<Texture> add(CookedTexture&& cooked, const char* name = "generated");
+
+    bool isStreamed(const Texture* texture) const { return m_lookup.count(texture) != 0; }
+
+    // Reports that texture is drawn this frame with uvPerPixel texture coordinate units
+    // across one screen pixel; the finest such request per frame wins. Ignores textures
+    // that are not streamed.
+    void request(const Texture* texture, float uvPerPixel);
+
+    // Applies finished transitions and starts new ones for this frame's requests
+    void update();
+
+    void setBudget(VkDeviceSize budget) { m_budget = budget; }
+    VkDeviceSize budget() const { return m_budget; }
+    void setUploadPerFrame(VkDeviceSize bytes) { m_uploadPerFrame = bytes; }
+    // Added to every requested mip; positive values trade sharpness for memory
+    void setMipBias(int bias) { m_mipBias = bias; }
+    int mipBias() const { return m_mipBias; }
+
+    Stats stats() const;
+
+private:
+    static constexpr uint32_t NO_REQUEST = UINT32_MAX;
+
+    struct Entry {
+        std::shared_ptr<Texture> texture;
+        std::unique_ptr<KtxFile> file;  // source of a .ktx2 texture, or
+        CookedTexture cooked;           // of an in-memory one
+        const uint8_t* data = nullptr;
+        std::vector<CookedTextureLevel> levels;  // mip 0 first, offsets into data
+        VkFormat format = VK_FORMAT_UNDEFINED;
+
+        uint32_t tailMip = 0;       // first mip that is always resident
+        uint32_t residentMip = 0;   // first mip of the texture's current image
+        uint32_t committedMip = 0;  // residentMip, or where the pending transition goes
+        uint32_t requestedMip = NO_REQUEST;
+        uint32_t wantedMip = 0;
+        std::vector<uint64_t> lastNeeded;  // per mip: update() that last requested it
+
+        Image pendingImage;
+        bool pending = false;
+        bool ready = false;  // set when the pending transition's upload batch completes
+    };
+
+    struct RetiredImage {
+        Image image;
+        uint64_t frame;
+    };
+
+    std::shared_ptr<Texture> addEntry(std::unique_ptr<Entry> entry, const char* name);
+    bool createImage(const Entry& entry, uint32_t firstMip, Image& out) const;
+    // Uploads source mips [firstMip, endMip) into an image whose level 0 is firstMip
+    void uploadLevels(const Entry& entry, VkImage image, uint32_t firstMip, uint32_t endMip, uint32_t imageLevels);
+    bool startTransition(Entry& entry, uint32_t targetMip);
+    void evict(VkDeviceSize bytes);
+    static VkDeviceSize residentSize(const Entry& entry, uint32_t firstMip);
+
+    VulkanContext* m_ctx = nullptr;
+    UploadManager* m_uploads = nullptr;
+    VkDeviceSize m_budget = DEFAULT_BUDGET;
+    VkDeviceSize m_uploadPerFrame = DEFAULT_UPLOAD_PER_FRAME;
+    uint32_t m_framesInFlight = 1;
+    int m_mipBias = 0;
+
+    std::vector<std::unique_ptr<Entry>> m_entries;
+    std::unordered_map<const Texture*, Entry*> m_lookup;
+    std::vector<RetiredImage> m_retired;
+
+    uint64_t m_frame = 0;
+    VkDeviceSize m_committedBytes = 0;
+    VkDeviceSize m_uploadedBytes = 0;
+    uint64_t m_streamedMips = 0;
+    uint64_t m_evictedMips = 0;
+};
+
+} // namespace lmao
@@ -0,0 +1,220 @@
+#include "assets/VertexFormat.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace lmao {
+
+namespace {
+constexpr uint32_t OCT_BITS = 10;
+constexpr uint32_t ANGLE_BITS = 11;
+constexpr uint32_t OCT_MAX = (1u << OCT_BITS) - 1;
+constexpr uint32_t ANGLE_STEPS = 1u << ANGLE_BITS;
+
+// Duff et al. 2017, "Building an Orthonormal Basis, Revisited".
+// Must match tangentBasis() in shaders/common/vertex_packing.glsl.
+void tangentBasis(const vec3& n, vec3& b1, vec3& b2) {
+    float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+    float a = -1.0f / (sign + n.z);
+    float b = n.x * n.y * a;
+    b1 = vec3(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+    b2 = vec3(b, sign + n.y * n.y * a, -n.y);
+}
+
+uint32_t quantizeUnorm(float v, uint32_t maxValue) {
+    v = std::clamp(v, 0.0f, 1.0f);
+    return static_cast<uint32_t>(std::lround(v * static_cast<float>(maxValue)));
+}
+
+float signNotZero(float v) { return v >= 0.0f ? 1.0f : -1.0f; }
+
+vec3 inverseExtent(const AABB& bounds) {
+    vec3 extent = bounds.max - bounds.min;
+    return vec3(extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+                extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+                extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+}
+
+void quantizePosition(const vec3& p, const AABB& bounds, const vec3& invExtent, uint16_t out[4]) {
+    vec3 rel = (p - bounds.min) * invExtent;
+    out[0] = static_cast<uint16_t>(quantizeUnorm(rel.x, 0xFFFF));
+    out[1] = static_cast<uint16_t>(quantizeUnorm(rel.y, 0xFFFF));
+    out[2] = static_cast<uint16_t>(quantizeUnorm(rel.z, 0xFFFF));
+    out[3] = 0;
+}
+} // anonymous namespace
+
+uint32_t VertexPacking::vertexStride(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Packed:              return sizeof(PackedVertex);
+        case VertexFormat::PackedFloatPosition: return sizeof(PackedVertexFloatPos);
+        case VertexFormat::Standard:
+        default:                                return sizeof(Vertex);
+    }
+}
+
+VkVertexInputBindingDescription VertexPacking::bindingDesc(VertexFormat format) {
+    return {0, vertexStride(format), VK_VERTEX_INPUT_RATE_VERTEX};
+}
+
+std::vector<VkVertexInputAttributeDescription> VertexPacking::attributeDescs(VertexFormat format) {
+    switch (format) {
+        case VertexFormat::Packed:
+            return {
+                {0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(PackedVertex, position)},
+                {1, 0, VK_FORMAT_R32_UINT,           offsetof(PackedVertex, tangentFrame)},
+                {2, 0, VK_FORMAT_R16G16_SFLOAT,      offsetof(PackedVertex, uv)},
+            };
+        case VertexFormat::PackedFloatPosition:
+            return {
+                {0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(PackedVertexFloatPos, position)},
+                {1, 0, VK_FORMAT_R32_UINT,         offsetof(PackedVertexFloatPos, tangentFrame)},
+                {2, 0, VK_FORMAT_R16G16_SFLOAT,    offsetof(PackedVertexFloatPos, uv)},
+            };
+        case VertexFormat::Standard:
+        default: {
+            auto attrs = Vertex::attributeDescs();
+            return {attrs.begin(), attrs.end()};
+        }
+    }
+}
+
+PositionEncoding VertexPacking::positionEncoding(VertexFormat format) {
+    return format == VertexFormat::Packed ? PositionEncoding::Unorm16 : PositionEncoding::Float3;
+}
+
+VkFormat VertexPacking::positionFormat(PositionEncoding encoding) {
+    return encoding == PositionEncoding::Unorm16 ? VK_FORMAT_R16G16B16A16_UNORM
+                                                 : VK_FORMAT_R32G32B32_SFLOAT;
+}
+
+uint32_t VertexPacking::positionStride(PositionEncoding encoding) {
+    return encoding == PositionEncoding::Unorm16 ? 4 * sizeof(uint16_t) : sizeof(vec3);
+}
+
+vec2 VertexPacking::octEncode(const vec3& n) {
+    float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    vec2 p = vec2(n.x, n.y) / std::max(l1, 1e-20f);
+    if (n.z < 0.0f) {
+        p = vec2((1.0f - std::abs(p.y)) * signNotZero(p.x),
+                 (1.0f - std::abs(p.x)) * signNotZero(p.y));
+    }
+    return p;
+}
+
+vec3 VertexPacking::octDecode(const vec2& e) {
+    vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+uint32_t VertexPacking::packTangentFrame(const vec3& normal, const vec4& tangent) {
+    vec3 n = glm::normalize(normal);
+    vec2 oct = octEncode(n);
+    uint32_t ox = quantizeUnorm(oct.x * 0.5f + 0.5f, OCT_MAX);
+    uint32_t oy = quantizeUnorm(oct.y * 0.5f + 0.5f, OCT_MAX);
+
+    // Measure the tangent in the basis the decoder will rebuild, not the source normal
+    vec3 nd = octDecode(vec2(static_cast<float>(ox), static_cast<float>(oy)) /
+                        static_cast<float>(OCT_MAX) * 2.0f - 1.0f);
+    vec3 b1, b2;
+    tangentBasis(nd, b1, b2);
+
+    vec3 t = vec3(tangent);
+    t -= nd * glm::dot(nd, t);
+    float angle = 0.0f;
+    if (glm::dot(t, t) > 1e-12f) {
+        angle = std::atan2(glm::dot(t, b2), glm::dot(t, b1));
+        if (angle < 0.0f) angle += TWO_PI;
+    }
+    uint32_t a = static_cast<uint32_t>(std::lround(angle / TWO_PI * ANGLE_STEPS)) & (ANGLE_STEPS - 1);
+
+    uint32_t packed = ox | (oy << OCT_BITS) | (a << (2 * OCT_BITS));
+    if (tangent.w < 0.0f) packed |= 1u << 31;
+    return packed;
+}
+
+void VertexPacking::unpackTangentFrame(uint32_t packed, vec3& normal, vec4& tangent) {
+    float ox = static_cast<float>(packed & OCT_MAX);
+    float oy = static_cast<float>((packed >> OCT_BITS) & OCT_MAX);
+    float a = static_cast<float>((packed >> (2 * OCT_BITS)) & (ANGLE_STEPS - 1));
+
+    normal = octDecode(vec2(ox, oy) / static_cast<float>(OCT_MAX) * 2.0f - 1.0f);
+    vec3 b1, b2;
+    tangentBasis(normal, b1, b2);
+    float angle = a / static_cast<float>(ANGLE_STEPS) * TWO_PI;
+    tangent = vec4(b1 * std::cos(angle) + b2 * std::sin(angle),
+                   (packed & (1u << 31)) ? -1.0f : 1.0f);
+}
+
+std::vector<uint8_t> VertexPacking::pack(const std::vector<Vertex>& vertices, VertexFormat format,
+                                         const AABB& bounds) {
+    uint32_t stride = vertexStride(format);
+    std::vector<uint8_t> out(vertices.size() * stride);
+
+    if (format == VertexFormat::Standard) {
+        if (!vertices.empty())
+            std::memcpy(out.data(), vertices.data(), out.size());
+        return out;
+    }
+
+    vec3 invExtent = inverseExtent(bounds);
+
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const Vertex& v = vertices[i];
+        uint32_t frame = packTangentFrame(v.normal, v.tangent);
+        uint32_t uv = glm::packHalf2x16(v.uv);
+        uint8_t* dst = out.data() + i * stride;
+
+        if (format == VertexFormat::Packed) {
+            PackedVertex pv{};
+            quantizePosition(v.position, bounds, invExtent, pv.position);
+            pv.tangentFrame = frame;
+            pv.uv = uv;
+            std::memcpy(dst, &pv, sizeof(pv));
+        } else {
+            PackedVertexFloatPos pv{};
+            pv.position = v.position;
+            pv.tangentFrame = frame;
+            pv.uv = uv;
+            std::memcpy(dst, &pv, sizeof(pv));
+        }
+    }
+    return out;
+}
+
+std::vector<uint8_t> VertexPacking::packPositions(const std::vector<Vertex>& vertices,
+                                                  VertexFormat format, const AABB& bounds) {
+    PositionEncoding encoding = positionEncoding(format);
+    uint32_t stride = positionStride(encoding);
+    std::vector<uint8_t> out(vertices.size() * stride);
+
+    vec3 invExtent = inverseExtent(bounds);
+    for (size_t i = 0; i < vertices.size(); i++) {
+        uint8_t* dst = out.data() + i * stride;
+        if (encoding == PositionEncoding::Unorm16) {
+            uint16_t q[4];
+            quantizePosition(vertices[i].position, bounds, invExtent, q);
+            std::memcpy(dst, q, sizeof(q));
+        } else {
+            std::memcpy(dst, &vertices[i].position, sizeof(vec3));
+        }
+    }
+    return out;
+}
+
+vec4 VertexPacking::positionScale(VertexFormat format, const AABB& bounds) {
+    if (format == VertexFormat::Packed)
+        return vec4(bounds.max - bounds.min, 0.0f);
+    return vec4(1.0f, 1.0f, 1.0f, 0.0f);
+}
+
+vec4 VertexPacking::positionOffset(VertexFormat format, const AABB& bounds) {
+    if (format == VertexFormat::Packed)
+        return vec4(bounds.min, 0.0f);
+    return vec4(0.0f);
+}
+
+} // namespace lmao
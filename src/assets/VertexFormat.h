@@ -0,0 +1,92 @@
+#pragma once
+#include "math/MathUtils.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace lmao {
+
+// GPU vertex layouts a Mesh can be stored in.
+//   Standard            - lmao::Vertex, 48 bytes (float everything, padded)
+//   Packed              - PackedVertex, 16 bytes (UNORM16 position relative to the mesh AABB)
+//   PackedFloatPosition - PackedVertexFloatPos, 20 bytes (float3 position)
+// Both packed layouts share the same tangent frame and UV encoding and are
+// decoded by shaders/common/vertex_packing.glsl.
+enum class VertexFormat : uint32_t {
+    Standard = 0,
+    Packed = 1,
+    PackedFloatPosition = 2,
+};
+
+constexpr uint32_t VERTEX_FORMAT_COUNT = 3;
+
+// Encoding of the position-only stream used by depth-only passes. Packed meshes keep
+// their UNORM16 quantization (8 bytes), every other format stores float3 (12 bytes).
+enum class PositionEncoding : uint32_t {
+    Float3 = 0,
+    Unorm16 = 1,
+};
+
+constexpr uint32_t POSITION_ENCODING_COUNT = 2;
+
+// Quantized vertex: 8 + 4 + 4 = 16 bytes.
+// position: xyz = UNORM16 relative to the mesh AABB, w unused.
+// tangentFrame: see packTangentFrame().
+// uv: two IEEE half floats.
+struct PackedVertex {
+    uint16_t position[4];
+    uint32_t tangentFrame;
+    uint32_t uv;
+};
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay 16 bytes");
+
+// Same as PackedVertex but keeps full float positions: 12 + 4 + 4 = 20 bytes.
+struct PackedVertexFloatPos {
+    vec3 position;
+    uint32_t tangentFrame;
+    uint32_t uv;
+};
+static_assert(sizeof(PackedVertexFloatPos) == 20, "PackedVertexFloatPos must stay 20 bytes");
+
+class VertexPacking {
+public:
+    static uint32_t vertexStride(VertexFormat format);
+
+    static VkVertexInputBindingDescription bindingDesc(VertexFormat format);
+    // Location 0 = position, 1 = normal / tangent frame, 2 = uv, 3 = tangent (Standard only)
+    static std::vector<VkVertexInputAttributeDescription> attributeDescs(VertexFormat format);
+
+    static PositionEncoding positionEncoding(VertexFormat format);
+    static VkFormat positionFormat(PositionEncoding encoding);
+    static uint32_t positionStride(PositionEncoding encoding);
+
+    // Octahedral mapping of a unit vector onto [-1, 1]^2.
+    static vec2 octEncode(const vec3& n);
+    static vec3 octDecode(const vec2& e);
+
+    // Normal + tangent + bitangent sign in 32 bits:
+    //   bits  0..9  octahedral normal x (UNORM10)
+    //   bits 10..19 octahedral normal y (UNORM10)
+    //   bits 20..30 tangent angle around the decoded normal (UNORM11 over [0, 2pi))
+    //   bit  31     set when the bitangent sign is negative
+    // The tangent angle is measured in a branchless orthonormal basis built from the
+    // *decoded* normal so the shader reconstructs exactly the same frame.
+    static uint32_t packTangentFrame(const vec3& normal, const vec4& tangent);
+    static void unpackTangentFrame(uint32_t packed, vec3& normal, vec4& tangent);
+
+    // Converts interleaved Vertex data into the requested layout. For Packed, positions
+    // are quantized against `bounds`; the matching dequantization is positionScale/Offset().
+    static std::vector<uint8_t> pack(const std::vector<Vertex>& vertices, VertexFormat format,
+                                     const AABB& bounds);
+
+    // Tightly packed positions in positionEncoding(format), quantized like pack()
+    static std::vector<uint8_t> packPositions(const std::vector<Vertex>& vertices, VertexFormat format,
+                                              const AABB& bounds);
+
+    // Dequantization constants pushed to the vertex shader: pos = offset + encoded * scale.
+    // Identity for Standard and PackedFloatPosition.
+    static vec4 positionScale(VertexFormat format, const AABB& bounds);
+    static vec4 positionOffset(VertexFormat format, const AABB& bounds);
+};
+
+} // namespace lmao
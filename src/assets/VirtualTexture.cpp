@@ -0,0 +1,545 @@
+#include "assets/VirtualTexture.h"
+#include "assets/BlockEncoder.h"
+#include "assets/KtxFile.h"
+#include "assets/TextureCooker.h"
+#include "math/MathUtils.h"
+#include "vulkan/VulkanContext.h"
+#include "vulkan/VulkanUtils.h"
+#include "vulkan/UploadManager.h"
+#include "vulkan/DescriptorManager.h"
+#include "core/ThreadPool.h"
+#include "core/Log.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+
+namespace lmao {
+
+namespace {
+// Must match the VirtualTextureParams block in shaders/common/virtual_texture.glsl
+struct VirtualTextureParams {
+    uvec4 textures[VirtualTextureSystem::MAX_TEXTURES];  // x = pages per side, y = mip count
+    uvec4 feedback;  // xy = feedback cells, zw = pixel inside a cell that writes this frame
+    vec4 cache;      // x = 1 / cache texels per side, y = LOD bias
+};
+
+uint32_t log2u(uint32_t v) { return static_cast<uint32_t>(std::bit_width(v)) - 1; }
+
+uint32_t keyX(uint32_t key) { return key & 0xFFFu; }
+uint32_t keyY(uint32_t key) { return (key >> 12) & 0xFFFu; }
+uint32_t keyMip(uint32_t key) { return (key >> 24) & 0xFu; }
+uint32_t keyTexture(uint32_t key) { return key >> 28; }
+
+constexpr uint32_t NO_FEEDBACK = 0xFFFFFFFFu;
+} // anonymous namespace
+
+VirtualTextureSystem::~VirtualTextureSystem() { shutdown(); }
+
+bool VirtualTextureSystem::init(VulkanContext& ctx, UploadManager& uploads, DescriptorManager& descriptors,
+                                VkExtent2D extent, uint32_t cachePages) {
+    m_ctx = &ctx;
+    m_uploads = &uploads;
+    m_device = ctx.device();
+    m_enabled = ctx.features().fragmentStoresAndAtomics;
+
+    // BC7 keeps a 4096^2 cache at 16 MB; pages are transcoded on the workers that produce them
+    m_cacheFormat = ctx.features().textureCompressionBC ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_R8G8B8A8_SRGB;
+    m_cachePages = std::clamp(cachePages, 1u, 255u);
+    m_pageBytes = TextureCooker::levelSize(m_cacheFormat, PAGE_SIZE, PAGE_SIZE);
+    m_slots.assign(m_cachePages * m_cachePages, CacheSlot{});
+
+    Image::CreateInfo cacheCI{};
+    cacheCI.width = m_cachePages * PAGE_SIZE;
+    cacheCI.height = m_cachePages * PAGE_SIZE;
+    cacheCI.format = m_cacheFormat;
+    cacheCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    if (!m_cache.init(ctx.allocator(), m_device, cacheCI)) return false;
+
+    Image::CreateInfo indirectionCI{};
+    indirectionCI.width = MAX_PAGES;
+    indirectionCI.height = MAX_PAGES;
+    indirectionCI.mipLevels = log2u(MAX_PAGES) + 1;
+    indirectionCI.arrayLayers = MAX_TEXTURES;
+    indirectionCI.format = VK_FORMAT_R8G8B8A8_UINT;
+    indirectionCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    indirectionCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    if (!m_indirection.init(ctx.allocator(), m_device, indirectionCI)) return false;
+
+    // Both start empty; updateImage keeps them in SHADER_READ_ONLY_OPTIMAL from here on
+    VkCommandBuffer cmd = uploads.graphicsCommands();
+    Image::transitionLayout(cmd, m_cache.handle(),
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    Image::transitionLayout(cmd, m_indirection.handle(),
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT, indirectionCI.mipLevels, MAX_TEXTURES);
+
+    // Pages are sampled at level 0 only; their borders cover the bilinear footprint
+    {
+        VkSamplerCreateInfo sampCI{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+        sampCI.magFilter = VK_FILTER_LINEAR;
+        sampCI.minFilter = VK_FILTER_LINEAR;
+        sampCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        sampCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        VK_CHECK(vkCreateSampler(m_device, &sampCI, nullptr, &m_cacheSampler));
+    }
+    {
+        VkSamplerCreateInfo sampCI{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+        sampCI.magFilter = VK_FILTER_NEAREST;
+        sampCI.minFilter = VK_FILTER_NEAREST;
+        sampCI.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        sampCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampCI.maxLod = VK_LOD_CLAMP_NONE;
+        VK_CHECK(vkCreateSampler(m_device, &sampCI, nullptr, &m_indirectionSampler));
+    }
+
+    if (!m_params.init(ctx.allocator(), sizeof(VirtualTextureParams),
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_AUTO,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT))
+        return false;
+
+    // Set 1 of the G-buffer pass: cache (0), indirection (1), params (2), feedback (3)
+    VkDescriptorSetLayoutBinding bindings[4] = {
+        {0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+        {1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+        {2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+        {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+    };
+    m_setLayout = descriptors.getOrCreateLayout(bindings, 4);
+    m_set = descriptors.allocate(m_setLayout);
+
+    DescriptorManager::writeImage(m_device, m_set, 0, m_cache.view(), m_cacheSampler);
+    DescriptorManager::writeImage(m_device, m_set, 1, m_indirection.view(), m_indirectionSampler);
+    DescriptorManager::writeBuffer(m_device, m_set, 2, m_params.handle(), sizeof(VirtualTextureParams));
+    if (!createFeedbackBuffers(extent)) return false;
+    writeParams();
+
+    LOG(Assets, Info, "Virtual texturing: %ux%u page cache (%s, %.1f MB), %u px pages",
+        m_cachePages, m_cachePages, m_cacheFormat == VK_FORMAT_BC7_SRGB_BLOCK ? "BC7" : "RGBA8",
+        m_pageBytes * m_slots.size() / (1024.0 * 1024.0), PAGE_SIZE);
+    if (!m_enabled)
+        LOG(Assets, Warn, "Virtual texturing disabled: fragmentStoresAndAtomics not supported");
+    return true;
+}
+
+void VirtualTextureSystem::shutdown() {
+    if (!m_device) return;
+    // Workers hold the sources; let them finish before anything goes away
+    for (auto& load : m_pending)
+        load.data.wait();
+    m_pending.clear();
+    m_requests.clear();
+    m_resident.clear();
+    m_slots.clear();
+    m_textures.clear();
+
+    m_feedbackReadback.shutdown();
+    m_feedback.shutdown();
+    m_params.shutdown();
+    if (m_indirectionSampler) vkDestroySampler(m_device, m_indirectionSampler, nullptr);
+    if (m_cacheSampler) vkDestroySampler(m_device, m_cacheSampler, nullptr);
+    m_indirectionSampler = VK_NULL_HANDLE;
+    m_cacheSampler = VK_NULL_HANDLE;
+    m_indirection.shutdown();
+    m_cache.shutdown();
+
+    // The layout belongs to the DescriptorManager cache, the set to its pool
+    m_setLayout = VK_NULL_HANDLE;
+    m_set = VK_NULL_HANDLE;
+    m_feedbackPending = false;
+    m_enabled = false;
+    m_device = VK_NULL_HANDLE;
+    m_uploads = nullptr;
+    m_ctx = nullptr;
+}
+
+bool VirtualTextureSystem::createFeedbackBuffers(VkExtent2D extent) {
+    m_feedbackExtent = {(extent.width + FEEDBACK_SCALE - 1) / FEEDBACK_SCALE,
+                        (extent.height + FEEDBACK_SCALE - 1) / FEEDBACK_SCALE};
+    VkDeviceSize size = VkDeviceSize(m_feedbackExtent.width) * m_feedbackExtent.height * sizeof(uint32_t);
+
+    m_feedback.shutdown();
+    m_feedbackReadback.shutdown();
+    if (!m_feedback.init(m_ctx->allocator(), size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE))
+        return false;
+    if (!m_feedbackReadback.init(m_ctx->allocator(), size,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT))
+        return false;
+    DescriptorManager::writeBuffer(m_device, m_set, 3, m_feedback.handle(), size,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    m_feedbackPending = false;
+    return true;
+}
+
+void VirtualTextureSystem::resize(VkExtent2D extent) {
+    if (!m_device) return;
+    if (createFeedbackBuffers(extent))
+        writeParams();
+}
+
+int32_t VirtualTextureSystem::add(const std::string& name, uint32_t pagesPerSide, VirtualTextureSource source) {
+    if (!m_device || !source) return -1;
+    if (!m_enabled) {
+        LOG(Assets, Warn, "Virtual texture %s not added: fragmentStoresAndAtomics not supported", name.c_str());
+        return -1;
+    }
+    if (m_textures.size() >= MAX_TEXTURES) {
+        LOG(Assets, Error, "Cannot add virtual texture %s: all %u slots in use", name.c_str(), MAX_TEXTURES);
+        return -1;
+    }
+    if (pagesPerSide == 0 || pagesPerSide > MAX_PAGES || !std::has_single_bit(pagesPerSide)) {
+        LOG(Assets, Error, "Cannot add virtual texture %s: %u pages per side is not a power of two up to %u",
+            name.c_str(), pagesPerSide, MAX_PAGES);
+        return -1;
+    }
+
+    const uint32_t id = static_cast<uint32_t>(m_textures.size());
+    VirtualTexture& vt = m_textures.emplace_back();
+    vt.name = name;
+    vt.source = std::make_shared<VirtualTextureSource>(std::move(source));
+    vt.pagesPerSide = pagesPerSide;
+    vt.mipCount = log2u(pagesPerSide) + 1;
+    vt.slots.resize(vt.mipCount);
+    for (uint32_t m = 0; m < vt.mipCount; m++) {
+        uint32_t side = pagesPerSide >> m;
+        vt.slots[m].assign(size_t(side) * side, NO_SLOT);
+    }
+
+    // The one-page top mip is what every missing page falls back to: made now, never evicted
+    const uint32_t top = vt.mipCount - 1;
+    uint32_t slot = allocateSlot();
+    if (slot == NO_SLOT) {
+        LOG(Assets, Error, "Cannot add virtual texture %s: page cache is full of pinned pages", name.c_str());
+        m_textures.pop_back();
+        return -1;
+    }
+    std::vector<uint8_t> page = producePage(*vt.source, top, 0, 0);
+    uint32_t key = pageKey(id, top, 0, 0);
+    m_slots[slot] = {key, m_frame, true};
+    m_resident[key] = slot;
+    vt.slots[top][0] = slot;
+
+    ImageUploadRegion region{};
+    region.x = static_cast<int32_t>((slot % m_cachePages) * PAGE_SIZE);
+    region.y = static_cast<int32_t>((slot / m_cachePages) * PAGE_SIZE);
+    region.width = PAGE_SIZE;
+    region.height = PAGE_SIZE;
+    m_uploads->updateImage(m_cache.handle(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, 1,
+        page.data(), page.size(), std::span(&region, 1));
+    uploadIndirection(id);
+    writeParams();
+
+    LOG(Assets, Info, "Virtual texture %s: %u x %u pages (%u px), %u mips", name.c_str(),
+        pagesPerSide, pagesPerSide, pagesPerSide * PAGE_PAYLOAD, vt.mipCount);
+    return static_cast<int32_t>(id);
+}
+
+VirtualTextureSource VirtualTextureSystem::fileSource(const std::string& path, uint32_t& pagesPerSide) {
+    auto file = std::make_shared<KtxFile>();
+    if (!file->open(path)) {
+        LOG(Assets, Error, "Failed to open virtual texture: %s", path.c_str());
+        return {};
+    }
+    const KtxHeader& header = file->header();
+    VkFormat format = file->format();
+    if (format != VK_FORMAT_R8G8B8A8_SRGB && format != VK_FORMAT_R8G8B8A8_UNORM) {
+        LOG(Assets, Error, "Virtual texture %s: format %d is not RGBA8 (cook it uncompressed)", path.c_str(), format);
+        return {};
+    }
+    uint32_t pages = header.pixelWidth / PAGE_PAYLOAD;
+    std::vector<CookedTextureLevel> levels = file->levels();
+    if (header.pixelWidth != header.pixelHeight || header.pixelWidth % PAGE_PAYLOAD != 0 ||
+        pages == 0 || pages > MAX_PAGES || !std::has_single_bit(pages) || levels.size() < log2u(pages) + 1) {
+        LOG(Assets, Error, "Virtual texture %s: %ux%u with %zu mips is not a full mip chain of %u px pages",
+            path.c_str(), header.pixelWidth, header.pixelHeight, levels.size(), PAGE_PAYLOAD);
+        return {};
+    }
+    pagesPerSide = pages;
+
+    const uint8_t* data = file->levelData().data();
+    return [file, levels = std::move(levels), data](uint32_t mip, int32_t x, int32_t y, uint32_t size, uint8_t* rgba) {
+        const CookedTextureLevel& level = levels[mip];
+        const int32_t dim = static_cast<int32_t>(level.width);
+        const uint8_t* texels = data + level.offset;
+        for (uint32_t row = 0; row < size; row++) {
+            int32_t sy = ((y + static_cast<int32_t>(row)) % dim + dim) % dim;
+            for (uint32_t col = 0; col < size; col++) {
+                int32_t sx = ((x + static_cast<int32_t>(col)) % dim + dim) % dim;
+                std::memcpy(rgba + (size_t(row) * size + col) * 4, texels + (size_t(sy) * dim + sx) * 4, 4);
+            }
+        }
+    };
+}
+
+void VirtualTextureSystem::recordFeedbackClear(VkCommandBuffer cmd) {
+    if (!m_enabled) return;
+    vkCmdFillBuffer(cmd, m_feedback.handle(), 0, VK_WHOLE_SIZE, NO_FEEDBACK);
+
+    VkMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+    barrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+    barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    barrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    VkDependencyInfo dep{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dep.memoryBarrierCount = 1;
+    dep.pMemoryBarriers = &barrier;
+    vkCmdPipelineBarrier2(cmd, &dep);
+}
+
+void VirtualTextureSystem::recordFeedbackReadback(VkCommandBuffer cmd) {
+    if (!m_enabled) return;
+    VkMemoryBarrier2 barriers[2]{};
+    barriers[0].sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    barriers[0].srcStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    barriers[0].srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    barriers[0].dstStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+    barriers[0].dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
+    VkDependencyInfo dep{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dep.memoryBarrierCount = 1;
+    dep.pMemoryBarriers = &barriers[0];
+    vkCmdPipelineBarrier2(cmd, &dep);
+
+    VkBufferCopy copy{0, 0, m_feedback.size()};
+    vkCmdCopyBuffer(cmd, m_feedback.handle(), m_feedbackReadback.handle(), 1, &copy);
+
+    // Read in update() after the fence wait
+    barriers[1].sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+    barriers[1].srcStageMask = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+    barriers[1].srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barriers[1].dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+    barriers[1].dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+    dep.pMemoryBarriers = &barriers[1];
+    vkCmdPipelineBarrier2(cmd, &dep);
+    m_feedbackPending = true;
+}
+
+void VirtualTextureSystem::update() {
+    if (!m_device) return;
+    m_frame++;
+    m_uploadedPages = 0;
+
+    readFeedback();
+
+    // Finished pages, coarsest first as they were scheduled. A page whose slot cannot be
+    // found (every slot was used this frame) is dropped and requested again later.
+    std::vector<uint8_t> staging;
+    std::vector<ImageUploadRegion> regions;
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (m_uploadedPages >= MAX_UPLOADS_PER_FRAME) break;
+        if (it->data.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            ++it;
+            continue;
+        }
+        std::vector<uint8_t> page = it->data.get();
+        const uint32_t key = it->page;
+        it = m_pending.erase(it);
+
+        VirtualTexture& vt = m_textures[keyTexture(key)];
+        uint32_t slot = allocateSlot();
+        if (slot == NO_SLOT) continue;
+        m_slots[slot] = {key, m_frame, false};
+        m_resident[key] = slot;
+        uint32_t side = vt.pagesPerSide >> keyMip(key);
+        vt.slots[keyMip(key)][keyY(key) * side + keyX(key)] = slot;
+        vt.dirty = true;
+
+        ImageUploadRegion region{};
+        region.offset = staging.size();
+        region.x = static_cast<int32_t>((slot % m_cachePages) * PAGE_SIZE);
+        region.y = static_cast<int32_t>((slot / m_cachePages) * PAGE_SIZE);
+        region.width = PAGE_SIZE;
+        region.height = PAGE_SIZE;
+        regions.push_back(region);
+        staging.insert(staging.end(), page.begin(), page.end());
+        m_uploadedPages++;
+    }
+    if (!regions.empty())
+        m_uploads->updateImage(m_cache.handle(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, 1,
+            staging.data(), staging.size(), regions);
+
+    // New loads: coarse mips first, so the fallback sharpens progressively
+    std::sort(m_requests.begin(), m_requests.end(), [](uint32_t a, uint32_t b) {
+        return keyMip(a) != keyMip(b) ? keyMip(a) > keyMip(b) : a < b;
+    });
+    for (uint32_t key : m_requests) {
+        if (m_pending.size() >= MAX_PENDING_LOADS) break;
+        if (m_resident.count(key)) continue;
+        bool loading = std::any_of(m_pending.begin(), m_pending.end(),
+            [key](const PendingLoad& load) { return load.page == key; });
+        if (!loading)
+            m_pending.push_back({key, loadPage(key)});
+    }
+    m_requests.clear();
+
+    for (uint32_t i = 0; i < m_textures.size(); i++) {
+        if (m_textures[i].dirty)
+            uploadIndirection(i);
+    }
+    writeParams();
+}
+
+// Picks up the pages gbuffer.frag asked for in the last submitted frame, whose fence has
+// been waited on
+void VirtualTextureSystem::readFeedback() {
+    m_requestedPages = 0;
+    if (!m_feedbackPending) return;
+    m_feedbackPending = false;
+
+    vmaInvalidateAllocation(m_ctx->allocator(), m_feedbackReadback.allocation(), 0, VK_WHOLE_SIZE);
+    const uint32_t* cells = static_cast<const uint32_t*>(m_feedbackReadback.mapped());
+    std::vector<uint32_t> keys(cells, cells + m_feedbackReadback.size() / sizeof(uint32_t));
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    for (uint32_t key : keys) {
+        if (key == NO_FEEDBACK) continue;
+        uint32_t tex = keyTexture(key), mip = keyMip(key), x = keyX(key), y = keyY(key);
+        if (tex >= m_textures.size() || mip >= m_textures[tex].mipCount) continue;
+        uint32_t side = m_textures[tex].pagesPerSide >> mip;
+        if (x >= side || y >= side) continue;
+        m_requestedPages++;
+        touch(tex, mip, x, y);
+    }
+}
+
+// Keeps the page, or what stands in for it, in the cache and requests it and the missing
+// ancestors between it and its stand-in
+void VirtualTextureSystem::touch(uint32_t texture, uint32_t mip, uint32_t x, uint32_t y) {
+    const VirtualTexture& vt = m_textures[texture];
+    for (; mip < vt.mipCount; mip++, x >>= 1, y >>= 1) {
+        uint32_t side = vt.pagesPerSide >> mip;
+        uint32_t slot = vt.slots[mip][y * side + x];
+        if (slot != NO_SLOT) {
+            m_slots[slot].lastUsed = m_frame;
+            return;
+        }
+        m_requests.push_back(pageKey(texture, mip, x, y));
+    }
+}
+
+std::future<std::vector<uint8_t>> VirtualTextureSystem::loadPage(uint32_t page) {
+    std::shared_ptr<VirtualTextureSource> source = m_textures[keyTexture(page)].source;
+    return ThreadPool::shared().submit([this, source, page]() {
+        return producePage(*source, keyMip(page), keyX(page), keyY(page));
+    });
+}
+
+// Page (x, y) of a mip with its border, in the cache format
+std::vector<uint8_t> VirtualTextureSystem::producePage(const VirtualTextureSource& source, uint32_t mip,
+                                                       uint32_t x, uint32_t y) const {
+    std::vector<uint8_t> rgba(size_t(PAGE_SIZE) * PAGE_SIZE * 4);
+    source(mip, static_cast<int32_t>(x * PAGE_PAYLOAD) - static_cast<int32_t>(PAGE_BORDER),
+           static_cast<int32_t>(y * PAGE_PAYLOAD) - static_cast<int32_t>(PAGE_BORDER), PAGE_SIZE, rgba.data());
+    if (m_cacheFormat != VK_FORMAT_BC7_SRGB_BLOCK) return rgba;
+
+    constexpr uint32_t blocks = PAGE_SIZE / BlockEncoder::BLOCK_DIM;
+    std::vector<uint8_t> encoded(m_pageBytes);
+    uint8_t block[16 * 4];
+    for (uint32_t by = 0; by < blocks; by++) {
+        for (uint32_t bx = 0; bx < blocks; bx++) {
+            for (uint32_t row = 0; row < 4; row++)
+                std::memcpy(block + row * 16, rgba.data() + ((size_t(by) * 4 + row) * PAGE_SIZE + bx * 4) * 4, 16);
+            BlockEncoder::encodeBC7(block, encoded.data() + (size_t(by) * blocks + bx) * 16);
+        }
+    }
+    return encoded;
+}
+
+// A free slot, or the least recently used unpinned one that was not needed this frame
+uint32_t VirtualTextureSystem::allocateSlot() {
+    uint32_t victim = NO_SLOT;
+    for (uint32_t i = 0; i < m_slots.size(); i++) {
+        const CacheSlot& s = m_slots[i];
+        if (s.page == NO_PAGE) return i;
+        if (s.pinned || s.lastUsed >= m_frame) continue;
+        if (victim == NO_SLOT || s.lastUsed < m_slots[victim].lastUsed)
+            victim = i;
+    }
+    if (victim == NO_SLOT) return NO_SLOT;
+
+    uint32_t key = m_slots[victim].page;
+    VirtualTexture& vt = m_textures[keyTexture(key)];
+    uint32_t side = vt.pagesPerSide >> keyMip(key);
+    vt.slots[keyMip(key)][keyY(key) * side + keyX(key)] = NO_SLOT;
+    vt.dirty = true;
+    m_resident.erase(key);
+    m_slots[victim] = CacheSlot{};
+    return victim;
+}
+
+// Rebuilds every level of a texture's indirection layer: texel = cache slot xy and the mip
+// of the page it holds, inherited from the parent where the page is missing
+void VirtualTextureSystem::uploadIndirection(uint32_t texture) {
+    VirtualTexture& vt = m_textures[texture];
+    vt.dirty = false;
+
+    std::vector<VkDeviceSize> offsets(vt.mipCount);
+    VkDeviceSize size = 0;
+    for (uint32_t m = 0; m < vt.mipCount; m++) {
+        offsets[m] = size;
+        uint32_t side = vt.pagesPerSide >> m;
+        size += VkDeviceSize(side) * side * 4;
+    }
+
+    std::vector<uint8_t> texels(size);
+    std::vector<ImageUploadRegion> regions(vt.mipCount);
+    for (uint32_t m = vt.mipCount; m-- > 0;) {
+        uint32_t side = vt.pagesPerSide >> m;
+        uint8_t* level = texels.data() + offsets[m];
+        const uint8_t* parent = m + 1 < vt.mipCount ? texels.data() + offsets[m + 1] : nullptr;
+        for (uint32_t y = 0; y < side; y++) {
+            for (uint32_t x = 0; x < side; x++) {
+                uint8_t* t = level + (size_t(y) * side + x) * 4;
+                uint32_t slot = vt.slots[m][y * side + x];
+                if (slot != NO_SLOT || !parent) {
+                    // The top page is pinned, so the chain always ends in a resident page
+                    t[0] = static_cast<uint8_t>(slot % m_cachePages);
+                    t[1] = static_cast<uint8_t>(slot / m_cachePages);
+                    t[2] = static_cast<uint8_t>(m);
+                    t[3] = 0;
+                } else {
+                    std::memcpy(t, parent + (size_t(y / 2) * (side / 2) + x / 2) * 4, 4);
+                }
+            }
+        }
+        regions[m].offset = offsets[m];
+        regions[m].mipLevel = m;
+        regions[m].arrayLayer = texture;
+        regions[m].width = side;
+        regions[m].height = side;
+    }
+    m_uploads->updateImage(m_indirection.handle(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        m_indirection.mipLevels(), MAX_TEXTURES, texels.data(), size, regions);
+}
+
+void VirtualTextureSystem::writeParams() {
+    VirtualTextureParams params{};
+    for (uint32_t i = 0; i < m_textures.size(); i++)
+        params.textures[i] = uvec4(m_textures[i].pagesPerSide, m_textures[i].mipCount, 0, 0);
+    // An odd stride visits all 256 pixels of a cell before repeating
+    uint32_t pixel = static_cast<uint32_t>((m_frame * 97) % (FEEDBACK_SCALE * FEEDBACK_SCALE));
+    params.feedback = uvec4(m_feedbackExtent.width, m_feedbackExtent.height,
+                            pixel % FEEDBACK_SCALE, pixel / FEEDBACK_SCALE);
+    params.cache = vec4(1.0f / static_cast<float>(m_cachePages * PAGE_SIZE), m_lodBias, 0.0f, 0.0f);
+    m_params.upload(&params, sizeof(params));
+}
+
+VirtualTextureSystem::Stats VirtualTextureSystem::stats() const {
+    Stats s;
+    s.textures = static_cast<uint32_t>(m_textures.size());
+    s.residentPages = static_cast<uint32_t>(m_resident.size());
+    s.cachePages = static_cast<uint32_t>(m_slots.size());
+    s.pendingLoads = static_cast<uint32_t>(m_pending.size());
+    s.requestedPages = m_requestedPages;
+    s.uploadedPages = m_uploadedPages;
+    return s;
+}
+
+} // namespace lmao
@@ -0,0 +1,175 @@
+#pragma once
+#include "vulkan/Buffer.h"
+#include "vulkan/Image.h"
+#include <volk.h>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lmao {
+
+class VulkanContext;
+class UploadManager;
+class DescriptorManager;
+
+// Writes size x size RGBA8 texels of mip level `mip` starting at texel (x, y) of that level,
+// wrapping coordinates outside it. Called from worker threads, concurrently.
+using VirtualTextureSource = std::function<void(uint32_t mip, int32_t x, int32_t y, uint32_t size, uint8_t* rgba)>;
+
+// Software virtual texturing for large unique textures (terrain, scanned facades).
+//
+// A virtual texture is a square grid of pages with a mip chain down to one page. Resident
+// pages live in one physical page cache texture; a per-texture indirection table (one layer
+// of an RGBA8_UINT array, one texel per page and mip) holds the cache slot and the mip of
+// the page that actually covers it, so a missing page falls back to its nearest resident
+// ancestor. The coarsest page of every texture is pinned. The lookup happens in
+// gbuffer.frag (virtual_texture.glsl) with plain sampled images: no sparse residency.
+//
+// gbuffer.frag also writes the page it wanted into a feedback buffer at 1/16 resolution,
+// one rotating pixel per cell each frame. The buffer is copied to host memory after the
+// G-buffer pass and read after the next fence wait. Missing pages are produced by the
+// texture's source and transcoded to BC7 (when the device samples BC) on ThreadPool workers,
+// coarse mips first, and uploaded through UploadManager; the least recently used unpinned
+// pages are evicted to make room.
+//
+// Feedback needs fragmentStoresAndAtomics. Without it the system still provides set 1 for
+// gbuffer_no_feedback.frag, but add() refuses every texture, so materials keep their
+// albedoMap.
+class VirtualTextureSystem {
+public:
+    // Must match shaders/common/virtual_texture.glsl. Pages carry a border on every side so
+    // bilinear filtering never reads a neighbouring page.
+    static constexpr uint32_t PAGE_SIZE = 128;
+    static constexpr uint32_t PAGE_BORDER = 4;
+    static constexpr uint32_t PAGE_PAYLOAD = PAGE_SIZE - 2 * PAGE_BORDER;
+    static constexpr uint32_t MAX_TEXTURES = 8;
+    static constexpr uint32_t MAX_PAGES = 256;     // per side of one virtual texture
+    static constexpr uint32_t FEEDBACK_SCALE = 16; // screen pixels per feedback cell, per side
+
+    static constexpr uint32_t DEFAULT_CACHE_PAGES = 32;  // per side: 4096 x 4096 texels
+    static constexpr uint32_t MAX_PENDING_LOADS = 64;
+    static constexpr uint32_t MAX_UPLOADS_PER_FRAME = 32;
+
+    struct Stats {
+        uint32_t textures = 0;
+        uint32_t residentPages = 0;
+        uint32_t cachePages = 0;
+        uint32_t pendingLoads = 0;
+        uint32_t requestedPages = 0;  // distinct pages in the last feedback
+        uint32_t uploadedPages = 0;   // by the last update()
+    };
+
+    VirtualTextureSystem() = default;
+    ~VirtualTextureSystem();
+
+    VirtualTextureSystem(const VirtualTextureSystem&) = delete;
+    VirtualTextureSystem& operator=(const VirtualTextureSystem&) = delete;
+
+    bool init(VulkanContext& ctx, UploadManager& uploads, DescriptorManager& descriptors,
+              VkExtent2D extent, uint32_t cachePages = DEFAULT_CACHE_PAGES);
+    void shutdown();
+    // The feedback buffer follows the render resolution
+    void resize(VkExtent2D extent);
+
+    // pagesPerSide: power of two up to MAX_PAGES; the texture is pagesPerSide *
+    // PAGE_PAYLOAD texels across. Returns the id for MaterialParams::virtualTexture, or -1.
+    int32_t add(const std::string& name, uint32_t pagesPerSide, VirtualTextureSource source);
+
+    // Source reading a .ktx2 whose RGBA8 mip chain starts at pagesPerSide * PAGE_PAYLOAD
+    // texels square (cooked uncompressed); the file stays mapped. Empty on failure.
+    static VirtualTextureSource fileSource(const std::string& path, uint32_t& pagesPerSide);
+
+    // Set 1 of the G-buffer pipeline layout
+    VkDescriptorSetLayout setLayout() const { return m_setLayout; }
+    VkDescriptorSet descriptorSet() const { return m_set; }
+
+    // After the fence wait: reads last frame's feedback, collects finished pages, schedules
+    // loads and uploads the changes into the current UploadManager batch
+    void update();
+
+    // Around the G-buffer pass: clear the feedback before it, copy it out after it
+    void recordFeedbackClear(VkCommandBuffer cmd);
+    void recordFeedbackReadback(VkCommandBuffer cmd);
+
+    // False on devices without fragmentStoresAndAtomics
+    bool enabled() const { return m_enabled; }
+
+    void setLodBias(float bias) { m_lodBias = bias; }
+    float lodBias() const { return m_lodBias; }
+    Stats stats() const;
+
+private:
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+    static constexpr uint32_t NO_PAGE = UINT32_MAX;
+
+    struct VirtualTexture {
+        std::string name;
+        std::shared_ptr<VirtualTextureSource> source;
+        uint32_t pagesPerSide = 0;
+        uint32_t mipCount = 0;
+        std::vector<std::vector<uint32_t>> slots;  // per mip, per page: cache slot or NO_SLOT
+        bool dirty = false;                        // indirection needs re-uploading
+    };
+
+    struct CacheSlot {
+        uint32_t page = NO_PAGE;  // packed key of the page it holds
+        uint64_t lastUsed = 0;
+        bool pinned = false;
+    };
+
+    struct PendingLoad {
+        uint32_t page;
+        std::future<std::vector<uint8_t>> data;
+    };
+
+    // Page keys use the feedback encoding: x | y << 12 | mip << 24 | texture << 28
+    static uint32_t pageKey(uint32_t texture, uint32_t mip, uint32_t x, uint32_t y) {
+        return x | (y << 12) | (mip << 24) | (texture << 28);
+    }
+
+    bool createFeedbackBuffers(VkExtent2D extent);
+    void readFeedback();
+    void touch(uint32_t texture, uint32_t mip, uint32_t x, uint32_t y);
+    std::future<std::vector<uint8_t>> loadPage(uint32_t page);
+    std::vector<uint8_t> producePage(const VirtualTextureSource& source, uint32_t mip, uint32_t x, uint32_t y) const;
+    uint32_t allocateSlot();
+    void uploadIndirection(uint32_t texture);
+    void writeParams();
+
+    VulkanContext* m_ctx = nullptr;
+    UploadManager* m_uploads = nullptr;
+    VkDevice m_device = VK_NULL_HANDLE;
+    bool m_enabled = false;
+
+    VkFormat m_cacheFormat = VK_FORMAT_UNDEFINED;
+    uint32_t m_cachePages = 0;
+    VkDeviceSize m_pageBytes = 0;
+    Image m_cache;
+    Image m_indirection;
+    VkSampler m_cacheSampler = VK_NULL_HANDLE;
+    VkSampler m_indirectionSampler = VK_NULL_HANDLE;
+    Buffer m_params;
+    Buffer m_feedback;
+    Buffer m_feedbackReadback;
+    VkExtent2D m_feedbackExtent{};
+    bool m_feedbackPending = false;
+
+    VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+    VkDescriptorSet m_set = VK_NULL_HANDLE;
+
+    std::vector<VirtualTexture> m_textures;
+    std::vector<CacheSlot> m_slots;
+    std::unordered_map<uint32_t, uint32_t> m_resident;  // page key -> slot
+    std::vector<uint32_t> m_requests;                   // missing pages from the last feedback
+    std::vector<PendingLoad> m_pending;
+
+    uint64_t m_frame = 0;
+    float m_lodBias = 0.0f;
+    uint32_t m_requestedPages = 0;
+    uint32_t m_uploadedPages = 0;
+};
+
+} // namespace lmao
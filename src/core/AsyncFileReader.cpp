@@ -0,0 +1,392 @@
+#include "core/AsyncFileReader.h"
+#include "core/ThreadPool.h"
+#include "core/Log.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define LMAO_IO_URING 1
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace lmao {
+
+#ifdef LMAO_IO_URING
+
+// Raw syscalls: glibc has no wrappers and liburing would be one more dependency
+namespace {
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+// The ring indices are shared with the kernel
+unsigned loadAcquire(unsigned* p) { return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire); }
+void storeRelease(unsigned* p, unsigned v) { std::atomic_ref<unsigned>(*p).store(v, std::memory_order_release); }
+} // anonymous namespace
+
+struct AsyncFileReader::Ring {
+    // One per read in flight, indexed by the SQE's user_data. There are as many as SQ
+    // entries, so a free chunk always has a free SQE.
+    struct Chunk {
+        Request* request = nullptr;
+        uint64_t offset = 0;  // into the request
+        uint32_t length = 0;
+    };
+
+    int fd = -1;
+    void* sqMap = MAP_FAILED;
+    size_t sqMapSize = 0;
+    void* cqMap = MAP_FAILED;
+    size_t cqMapSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    std::vector<Chunk> chunks;
+    std::vector<uint32_t> freeChunks;
+    std::vector<uint32_t> retries;  // short or interrupted reads to resubmit
+    bool buffersRegistered = false;
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqMap != MAP_FAILED && cqMap != sqMap) munmap(cqMap, cqMapSize);
+        if (sqMap != MAP_FAILED) munmap(sqMap, sqMapSize);
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool init(uint32_t depth) {
+        io_uring_params params{};
+        fd = ioUringSetup(depth, &params);
+        if (fd < 0) {
+            LOG(Assets, Info, "io_uring unavailable (%s), file reads use the thread pool", std::strerror(errno));
+            return false;
+        }
+
+        // IORING_OP_READ needs Linux 5.6, as does the probe itself
+        std::vector<uint8_t> probeStorage(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op));
+        auto* probe = reinterpret_cast<io_uring_probe*>(probeStorage.data());
+        if (ioUringRegister(fd, IORING_REGISTER_PROBE, probe, 256) < 0 || probe->last_op < IORING_OP_READ ||
+            !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED)) {
+            LOG(Assets, Info, "io_uring lacks IORING_OP_READ, file reads use the thread pool");
+            return false;
+        }
+
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMap) sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+
+        sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqMap == MAP_FAILED) return false;
+        cqMap = singleMap ? sqMap
+                          : mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                 IORING_OFF_CQ_RING);
+        if (cqMap == MAP_FAILED) return false;
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(
+            mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) return false;
+
+        auto* sq = static_cast<uint8_t*>(sqMap);
+        auto* cq = static_cast<uint8_t*>(cqMap);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // SQE i always sits in array slot i
+        auto* array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        for (unsigned i = 0; i < params.sq_entries; i++) array[i] = i;
+
+        chunks.resize(params.sq_entries);
+        for (uint32_t i = params.sq_entries; i-- > 0;) freeChunks.push_back(i);
+        return true;
+    }
+
+    uint32_t inFlight() const { return static_cast<uint32_t>(chunks.size() - freeChunks.size()); }
+};
+
+#else
+
+struct AsyncFileReader::Ring {};
+
+#endif
+
+namespace {
+// The thread-pool path: one blocking read per request
+bool readRange(const std::string& path, uint64_t offset, uint64_t size, void* dst) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        LOG(Assets, Error, "Failed to open %s", path.c_str());
+        return false;
+    }
+    file.seekg(static_cast<std::streamoff>(offset));
+    file.read(static_cast<char*>(dst), static_cast<std::streamsize>(size));
+    if (static_cast<uint64_t>(file.gcount()) != size) {
+        LOG(Assets, Error, "Failed to read %s: unexpected end of file", path.c_str());
+        return false;
+    }
+    return true;
+}
+} // anonymous namespace
+
+AsyncFileReader::AsyncFileReader() = default;
+AsyncFileReader::~AsyncFileReader() { shutdown(); }
+
+bool AsyncFileReader::init([[maybe_unused]] uint32_t queueDepth) {
+    shutdown();
+#ifdef LMAO_IO_URING
+    auto ring = std::make_unique<Ring>();
+    if (ring->init(queueDepth)) {
+        m_ring = std::move(ring);
+        LOG(Assets, Debug, "File reads: io_uring, %u entries", static_cast<uint32_t>(m_ring->chunks.size()));
+        return true;
+    }
+#endif
+    LOG(Assets, Debug, "File reads: %u thread-pool workers", ThreadPool::shared().threadCount());
+    return true;
+}
+
+void AsyncFileReader::shutdown() {
+    wait();
+    m_buffers.clear();
+    m_ring.reset();
+}
+
+bool AsyncFileReader::registerBuffer(void* data, size_t size) {
+    m_buffers.push_back({data, size});
+    if (!m_ring) return false;
+    wait();
+    if (updateRegisteredBuffers()) return true;
+    m_buffers.pop_back();
+    updateRegisteredBuffers();
+    return false;
+}
+
+void AsyncFileReader::unregisterBuffer(void* data) {
+    auto it = std::find_if(m_buffers.begin(), m_buffers.end(),
+                           [data](const RegisteredBuffer& buffer) { return buffer.data == data; });
+    if (it == m_buffers.end()) return;
+    wait();
+    m_buffers.erase(it);
+    if (m_ring) updateRegisteredBuffers();
+}
+
+void AsyncFileReader::read(FileReadRequest read) {
+    Request& request = m_requests.emplace_back();
+    request.read = std::move(read);
+    if (!m_ring) {
+        const FileReadRequest& r = request.read;
+        request.fallback = ThreadPool::shared().submit(
+            [path = r.path, offset = r.offset, size = r.size, dst = r.dst]() {
+                return readRange(path, offset, size, dst);
+            });
+        return;
+    }
+
+#ifdef LMAO_IO_URING
+    request.fd = ::open(request.read.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (request.fd < 0) {
+        LOG(Assets, Error, "Failed to open %s", request.read.path.c_str());
+        request.failed = true;
+        return;
+    }
+    if (m_ring->buffersRegistered) {
+        auto* dst = static_cast<uint8_t*>(request.read.dst);
+        for (size_t i = 0; i < m_buffers.size(); i++) {
+            auto* begin = static_cast<uint8_t*>(m_buffers[i].data);
+            if (dst >= begin && dst + request.read.size <= begin + m_buffers[i].size) {
+                request.bufferIndex = static_cast<int>(i);
+                break;
+            }
+        }
+    }
+#endif
+}
+
+uint32_t AsyncFileReader::poll() {
+    if (m_ring) {
+        submit();
+        reap(false);
+    }
+    return finishRequests();
+}
+
+void AsyncFileReader::wait() {
+    // Callbacks may queue more reads; those are waited for too
+    while (!m_requests.empty()) {
+        if (m_ring) {
+            submit();
+            reap(true);
+        } else {
+            m_requests.front().fallback.wait();
+        }
+        finishRequests();
+    }
+}
+
+bool AsyncFileReader::fileSize(const std::string& path, uint64_t& size) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    return !ec;
+}
+
+#ifdef LMAO_IO_URING
+
+void AsyncFileReader::submit() {
+    Ring& ring = *m_ring;
+    unsigned tail = *ring.sqTail;  // only written here
+    auto push = [&](uint32_t index) {
+        const Ring::Chunk& chunk = ring.chunks[index];
+        const Request& request = *chunk.request;
+        io_uring_sqe& sqe = ring.sqes[tail & ring.sqMask];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = request.bufferIndex >= 0 ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe.fd = request.fd;
+        sqe.off = request.read.offset + chunk.offset;
+        sqe.addr = reinterpret_cast<uint64_t>(static_cast<uint8_t*>(request.read.dst) + chunk.offset);
+        sqe.len = chunk.length;
+        sqe.buf_index = static_cast<uint16_t>(std::max(request.bufferIndex, 0));
+        sqe.user_data = index;
+        tail++;
+    };
+
+    for (uint32_t index : ring.retries) push(index);
+    ring.retries.clear();
+
+    // Oldest requests first, split into chunks while SQ entries last
+    for (Request& request : m_requests) {
+        if (ring.freeChunks.empty()) break;
+        while (!request.failed && request.queued < request.read.size && !ring.freeChunks.empty()) {
+            uint32_t index = ring.freeChunks.back();
+            ring.freeChunks.pop_back();
+            auto length = static_cast<uint32_t>(std::min<uint64_t>(CHUNK_SIZE, request.read.size - request.queued));
+            ring.chunks[index] = {&request, request.queued, length};
+            request.queued += length;
+            request.inFlight++;
+            push(index);
+        }
+    }
+    storeRelease(ring.sqTail, tail);
+}
+
+void AsyncFileReader::reap(bool block) {
+    Ring& ring = *m_ring;
+    unsigned toSubmit = *ring.sqTail - loadAcquire(ring.sqHead);
+    bool waiting = block && ring.inFlight() > 0;
+    if (toSubmit > 0 || waiting) {
+        // Entries the kernel did not take (EAGAIN, EINTR) stay in the SQ for the next call
+        int r = ioUringEnter(ring.fd, toSubmit, waiting ? 1 : 0, waiting ? IORING_ENTER_GETEVENTS : 0);
+        if (r < 0 && errno != EAGAIN && errno != EINTR && errno != EBUSY)
+            LOG(Assets, Error, "io_uring_enter failed: %s", std::strerror(errno));
+    }
+
+    unsigned head = *ring.cqHead;
+    unsigned tail = loadAcquire(ring.cqTail);
+    for (; head != tail; head++) {
+        const io_uring_cqe& cqe = ring.cqes[head & ring.cqMask];
+        auto index = static_cast<uint32_t>(cqe.user_data);
+        Ring::Chunk& chunk = ring.chunks[index];
+        Request& request = *chunk.request;
+
+        if (!request.failed && (cqe.res == -EAGAIN || cqe.res == -EINTR)) {
+            ring.retries.push_back(index);
+            continue;
+        }
+        if (!request.failed && cqe.res > 0 && static_cast<uint32_t>(cqe.res) < chunk.length) {
+            // Short read: resubmit the rest
+            chunk.offset += static_cast<uint32_t>(cqe.res);
+            chunk.length -= static_cast<uint32_t>(cqe.res);
+            request.completed += static_cast<uint32_t>(cqe.res);
+            ring.retries.push_back(index);
+            continue;
+        }
+        if (cqe.res > 0) {
+            request.completed += static_cast<uint32_t>(cqe.res);
+        } else if (!request.failed) {
+            LOG(Assets, Error, "Failed to read %s: %s", request.read.path.c_str(),
+                cqe.res == 0 ? "unexpected end of file" : std::strerror(-cqe.res));
+            request.failed = true;
+        }
+        request.inFlight--;
+        ring.freeChunks.push_back(index);
+    }
+    storeRelease(ring.cqHead, head);
+}
+
+bool AsyncFileReader::updateRegisteredBuffers() {
+    Ring& ring = *m_ring;
+    if (ring.buffersRegistered) {
+        ioUringRegister(ring.fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+        ring.buffersRegistered = false;
+    }
+    if (m_buffers.empty()) return true;
+
+    std::vector<iovec> iovecs(m_buffers.size());
+    for (size_t i = 0; i < m_buffers.size(); i++) iovecs[i] = {m_buffers[i].data, m_buffers[i].size};
+    if (ioUringRegister(ring.fd, IORING_REGISTER_BUFFERS, iovecs.data(), static_cast<unsigned>(iovecs.size())) < 0) {
+        LOG(Assets, Warn, "io_uring refused to register %zu read buffers: %s", iovecs.size(), std::strerror(errno));
+        return false;
+    }
+    ring.buffersRegistered = true;
+    return true;
+}
+
+#else
+
+void AsyncFileReader::submit() {}
+void AsyncFileReader::reap(bool) {}
+bool AsyncFileReader::updateRegisteredBuffers() { return false; }
+
+#endif
+
+uint32_t AsyncFileReader::finishRequests() {
+    std::list<Request> finished;
+    for (auto it = m_requests.begin(); it != m_requests.end();) {
+        auto next = std::next(it);
+        bool done = m_ring ? it->inFlight == 0 && (it->failed || it->completed == it->read.size)
+                           : it->fallback.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        if (done) finished.splice(finished.end(), m_requests, it);
+        it = next;
+    }
+
+    // Callbacks run last: they may queue more reads
+    for (Request& request : finished) {
+        bool ok = m_ring ? !request.failed : request.fallback.get();
+#ifdef LMAO_IO_URING
+        if (request.fd >= 0) ::close(request.fd);
+#endif
+        if (request.read.onComplete) request.read.onComplete(ok);
+    }
+    return static_cast<uint32_t>(finished.size());
+}
+
+} // namespace lmao
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lmao {
+
+// Runs on the thread calling AsyncFileReader::poll/wait; ok when every requested byte arrived
+using FileReadCallback = std::function<void(bool ok)>;
+
+struct FileReadRequest {
+    std::string path;
+    uint64_t offset = 0;
+    uint64_t size = 0;      // bytes to read into dst; the file must hold all of them
+    void* dst = nullptr;    // must stay valid until onComplete
+    FileReadCallback onComplete;
+};
+
+// Batched asynchronous file reads.
+//
+// On Linux the reads go through an io_uring: large requests are split into CHUNK_SIZE
+// reads so one file keeps several in flight, and up to the queue depth of them are handed
+// to the kernel per syscall, which is what keeps an NVMe drive busy. Reads into a
+// registerBuffer() range (persistently mapped staging memory) use the ring's fixed buffers,
+// so the kernel pins those pages once instead of on every read. Elsewhere, or when the
+// kernel refuses io_uring (old kernel, seccomp), each request is one ThreadPool::shared()
+// task. Not thread-safe: queue, poll and wait from one thread, which runs the callbacks.
+class AsyncFileReader {
+public:
+    static constexpr uint32_t DEFAULT_QUEUE_DEPTH = 64;
+    static constexpr uint32_t CHUNK_SIZE = 1024 * 1024;
+
+    AsyncFileReader();
+    ~AsyncFileReader();
+
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+    // Falls back to the thread pool (and still succeeds) when io_uring is unavailable
+    bool init(uint32_t queueDepth = DEFAULT_QUEUE_DEPTH);
+    // Finishes every queued read first
+    void shutdown();
+
+    // Registers [data, data + size) for fixed-buffer reads; returns false (reads into it
+    // still work) without io_uring or when the kernel refuses, usually over RLIMIT_MEMLOCK.
+    // The ring's buffer table is replaced as a whole, so this waits for queued reads.
+    bool registerBuffer(void* data, size_t size);
+    void unregisterBuffer(void* data);
+
+    // Queues a read; the file is opened here but nothing is read before the next poll/wait
+    void read(FileReadRequest request);
+
+    // Submits queued reads and runs the callbacks of finished ones; returns how many finished
+    uint32_t poll();
+    // Blocks until every queued read has finished and its callback ran
+    void wait();
+
+    uint32_t pending() const { return static_cast<uint32_t>(m_requests.size()); }
+    bool usesIoUring() const { return m_ring != nullptr; }
+
+    static bool fileSize(const std::string& path, uint64_t& size);
+
+private:
+    struct Ring;  // io_uring state, Linux only
+    struct Request {
+        FileReadRequest read;
+        int fd = -1;
+        int bufferIndex = -1;   // registered buffer holding dst
+        uint64_t queued = 0;    // bytes handed to the ring
+        uint64_t completed = 0;
+        uint32_t inFlight = 0;  // chunk reads
+        bool failed = false;
+        std::future<bool> fallback;  // thread-pool read without io_uring
+    };
+    struct RegisteredBuffer {
+        void* data;
+        size_t size;
+    };
+
+    void submit();
+    void reap(bool block);
+    uint32_t finishRequests();
+    bool updateRegisteredBuffers();
+
+    std::unique_ptr<Ring> m_ring;
+    std::list<Request> m_requests;
+    std::vector<RegisteredBuffer> m_buffers;
+};
+
+} // namespace lmao
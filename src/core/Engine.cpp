@@ -13,12 +13,14 @@
 #include <GLFW/glfw3.h>
 #include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
 
 namespace lmao {
 
 namespace {
-std::shared_ptr<Texture> createBrickNormalMap(VulkanContext& ctx, CommandPool& cmdPool) {
+CookedTexture cookBrickNormalMap(VulkanContext& ctx) {
     constexpr uint32_t size = 256;
     std::vector<uint8_t> pixels(size * size * 4);
 
@@ -58,43 +60,71 @@ std::shared_ptr<Texture> createBrickNormalMap(VulkanContext& ctx, CommandPool& c
         }
     }
 
-    VkDeviceSize imageSize = size * size * 4;
-
-    Buffer staging;
-    staging.init(ctx.allocator(), imageSize,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VMA_MEMORY_USAGE_AUTO,
-        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
-    staging.upload(pixels.data(), imageSize);
-
-    Image::CreateInfo imgCI{};
-    imgCI.width = size;
-    imgCI.height = size;
-    imgCI.format = VK_FORMAT_R8G8B8A8_UNORM;
-    imgCI.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-
-    Image image;
-    image.init(ctx.allocator(), ctx.device(), imgCI);
-
-    cmdPool.submitImmediate(ctx.graphicsQueue(), [&](VkCommandBuffer cmd) {
-        Image::transitionLayout(cmd, image.handle(),
-            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-        VkBufferImageCopy region{};
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.layerCount = 1;
-        region.imageExtent = {size, size, 1};
-        vkCmdCopyBufferToImage(cmd, staging.handle(), image.handle(),
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    // Cooked like an imported normal map: renormalized mips, BC5 where supported
+    TextureCookOptions options;
+    options.usage = TextureUsage::Normal;
+    options.compress = ctx.features().textureCompressionBC;
+    CookedTexture cooked;
+    TextureCooker::cook(pixels.data(), size, size, options, cooked);
+    return cooked;
+}
 
-        Image::transitionLayout(cmd, image.handle(),
-            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    });
-    staging.shutdown();
+// Procedural terrain albedo (sRGB) for the virtual texturing demo: grass, soil and rock from
+// tileable value noise. A mip only sums the octaves its texel spacing can represent and
+// takes the mean of the rest, so coarse pages come out band-limited instead of aliased.
+VirtualTextureSource terrainAlbedoSource(uint32_t pagesPerSide) {
+    const uint32_t size = pagesPerSide * VirtualTextureSystem::PAGE_PAYLOAD;
+    return [size](uint32_t mip, int32_t x, int32_t y, uint32_t count, uint8_t* rgba) {
+        auto lattice = [](uint32_t ix, uint32_t iy, uint32_t seed) {
+            uint32_t h = ix * 0x8da6b343u ^ iy * 0xd8163841u ^ seed * 0xcb1ab31fu;
+            h ^= h >> 13;
+            h *= 0x5bd1e995u;
+            h ^= h >> 15;
+            return static_cast<float>(h & 0xFFFFu) / 65535.0f;
+        };
+        const float spacing = static_cast<float>(1u << mip);  // mip 0 texels per texel
+        auto fbm = [&](float u, float v, uint32_t seed) {
+            float sum = 0.0f, amplitude = 0.5f;
+            for (uint32_t cells = 4; cells * 2 <= size; cells *= 2, amplitude *= 0.6f, seed++) {
+                if (static_cast<float>(size) / static_cast<float>(cells) < 2.0f * spacing) {
+                    sum += amplitude * 0.5f;
+                    continue;
+                }
+                float fx = u * static_cast<float>(cells), fy = v * static_cast<float>(cells);
+                uint32_t x0 = static_cast<uint32_t>(fx) % cells, y0 = static_cast<uint32_t>(fy) % cells;
+                uint32_t x1 = (x0 + 1) % cells, y1 = (y0 + 1) % cells;
+                float tx = fx - std::floor(fx), ty = fy - std::floor(fy);
+                tx = tx * tx * (3.0f - 2.0f * tx);
+                ty = ty * ty * (3.0f - 2.0f * ty);
+                float top = glm::mix(lattice(x0, y0, seed), lattice(x1, y0, seed), tx);
+                float bottom = glm::mix(lattice(x0, y1, seed), lattice(x1, y1, seed), tx);
+                sum += amplitude * glm::mix(top, bottom, ty);
+            }
+            return sum;
+        };
 
-    auto tex = std::make_shared<Texture>();
-    tex->initFromImage(ctx.device(), std::move(image), true, 1.0f);
-    return tex;
+        const vec3 grass(0.30f, 0.42f, 0.16f), soil(0.45f, 0.36f, 0.25f), rock(0.55f, 0.53f, 0.50f);
+        const int32_t levelSize = static_cast<int32_t>(size >> mip);
+        for (uint32_t row = 0; row < count; row++) {
+            int32_t ty = ((y + static_cast<int32_t>(row)) % levelSize + levelSize) % levelSize;
+            float v = (static_cast<float>(ty) + 0.5f) / static_cast<float>(levelSize);
+            for (uint32_t col = 0; col < count; col++) {
+                int32_t tx = ((x + static_cast<int32_t>(col)) % levelSize + levelSize) % levelSize;
+                float u = (static_cast<float>(tx) + 0.5f) / static_cast<float>(levelSize);
+
+                float height = fbm(u, v, 0);
+                float moisture = fbm(u, v, 32);
+                float shade = 0.75f + 0.5f * fbm(u, v, 64);
+                vec3 color = glm::mix(grass, soil, glm::smoothstep(0.45f, 0.55f, moisture));
+                color = glm::mix(color, rock, glm::smoothstep(0.55f, 0.62f, height)) * shade;
+
+                uint8_t* texel = rgba + (size_t(row) * count + col) * 4;
+                for (int c = 0; c < 3; c++)
+                    texel[c] = static_cast<uint8_t>(std::clamp(color[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+                texel[3] = 255;
+            }
+        }
+    };
 }
 
 float halton(int index, int base) {
@@ -106,6 +136,47 @@ float halton(int index, int base) {
     }
     return result;
 }
+
+// World-space frustum planes (normals pointing inside) from a Vulkan [0,1]-depth clip matrix.
+// Degenerate planes, e.g. the far plane of an infinite projection, never cull.
+void extractFrustumPlanes(const mat4& m, vec4 planes[6]) {
+    vec4 r0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    vec4 r1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    vec4 r2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    vec4 r3(m[0][3], m[1][3], m[2][3], m[3][3]);
+    planes[0] = r3 + r0;
+    planes[1] = r3 - r0;
+    planes[2] = r3 + r1;
+    planes[3] = r3 - r1;
+    planes[4] = r2;
+    planes[5] = r3 - r2;
+    for (int i = 0; i < 6; i++) {
+        float len = glm::length(vec3(planes[i]));
+        planes[i] = len > 1e-6f ? planes[i] / len : vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+}
+
+// World-space bounding sphere (xyz = center, w = radius) of local bounds under model
+vec4 boundingSphere(const AABB& bounds, const mat4& model) {
+    vec3 scale(glm::length(vec3(model[0])), glm::length(vec3(model[1])), glm::length(vec3(model[2])));
+    vec3 center = vec3(model * vec4((bounds.min + bounds.max) * 0.5f, 1.0f));
+    float radius = glm::length((bounds.max - bounds.min) * 0.5f) * std::max({scale.x, scale.y, scale.z});
+    return vec4(center, radius);
+}
+
+void memoryBarrier(VkCommandBuffer cmd, VkPipelineStageFlags2 srcStage, VkAccessFlags2 srcAccess,
+                   VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess) {
+    VkMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+    barrier.srcStageMask = srcStage;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstStageMask = dstStage;
+    barrier.dstAccessMask = dstAccess;
+
+    VkDependencyInfo dep{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    dep.memoryBarrierCount = 1;
+    dep.pMemoryBarriers = &barrier;
+    vkCmdPipelineBarrier2(cmd, &dep);
+}
 } // anonymous namespace
 
 Engine::~Engine() { shutdown(); }
@@ -127,10 +198,22 @@ bool Engine::init() {
     if (!m_swapchain.init(m_vkCtx, m_window.width(), m_window.height())) return false;
     LOG(Core, Debug, "Swapchain image count: %u", m_swapchain.imageCount());
     if (!m_cmdPool.init(m_vkCtx.device(), m_vkCtx.queueFamilies().graphics)) return false;
+    if (!m_uploads.init(m_vkCtx)) return false;
     // Use 1 frame in flight to avoid TAA ping-pong data race
     // (2 history buffers require the previous frame's TAA write to be complete)
     if (!m_frameSync.init(m_vkCtx.device(), 1)) return false;
+    if (!m_frameAlloc.init(m_vkCtx, m_frameSync.frameCount(), sizeof(uint32_t) * MAX_VISIBLE_POINT_LIGHTS))
+        return false;
     if (!m_descriptors.init(m_vkCtx.device())) return false;
+    // Shaders and assets come from the pack when the build produced one, else loose files
+    if (std::filesystem::exists(PACK_PATH) && m_pack.open(PACK_PATH))
+        PackFile::mount(&m_pack);
+    if (!m_assets.init(m_vkCtx, m_uploads)) return false;
+    if (!m_fileReader.init()) return false;
+    if (!m_textureDecoder.init(m_vkCtx, m_uploads, m_fileReader)) return false;
+    if (!m_textureStreamer.init(m_vkCtx, m_uploads, TextureStreamer::DEFAULT_BUDGET, m_frameSync.frameCount()))
+        return false;
+    if (!m_virtualTextures.init(m_vkCtx, m_uploads, m_descriptors, m_swapchain.extent())) return false;
 
     m_cmdBuffers = m_cmdPool.allocate(1);
 
@@ -166,8 +249,17 @@ bool Engine::init() {
     // LDR image
     createLDRImage();
 
-    // Shadow map
-    createShadowMap();
+    // EVSM moments are written by compute and sampled trilinearly by the lighting pass
+    VkFormatProperties momentProps;
+    vkGetPhysicalDeviceFormatProperties(m_vkCtx.physicalDevice(), VK_FORMAT_R32G32B32A32_SFLOAT, &momentProps);
+    const VkFormatFeatureFlags momentFeatures =
+        VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    m_evsmSupported = (momentProps.optimalTilingFeatures & momentFeatures) == momentFeatures;
+    if (!m_evsmSupported)
+        LOG(Render, Warn, "RGBA32F cannot be filtered, EVSM shadows unavailable");
+
+    // Shadow atlas + EVSM moments
+    createShadowAtlas();
 
     // Nearest sampler (for G-buffer, velocity)
     {
@@ -220,18 +312,37 @@ bool Engine::init() {
         VK_CHECK(vkCreateSampler(m_vkCtx.device(), &sampCI, nullptr, &m_shadowSampler));
     }
 
-    // Global UBO + point light SSBO descriptor set layout
-    VkDescriptorSetLayoutBinding globalBindings[10] = {
-        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1,
-         VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+    // EVSM moment sampler (trilinear; nearest where RGBA32F cannot be filtered, EVSM is
+    // unavailable then and the binding only has to stay valid)
+    {
+        VkFilter filter = m_evsmSupported ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+        VkSamplerCreateInfo sampCI{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+        sampCI.magFilter = filter;
+        sampCI.minFilter = filter;
+        sampCI.mipmapMode = m_evsmSupported ? VK_SAMPLER_MIPMAP_MODE_LINEAR : VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        sampCI.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampCI.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampCI.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        sampCI.maxLod = VK_LOD_CLAMP_NONE;
+        VK_CHECK(vkCreateSampler(m_vkCtx.device(), &sampCI, nullptr, &m_shadowMomentsSampler));
+    }
+
+    // Global UBO + visible light list (dynamic offsets into m_frameAlloc), point light SSBO,
+    // G-buffer / shadow / IBL / SSAO textures, the light cluster lists written by
+    // light_cluster.comp, the lighting tile lists written by tile_classify.comp and the
+    // sky cubemap, EVSM moments, the visible depth bounds reduced by tile_classify.comp and
+    // the local light shadow atlas with its view matrices
+    VkDescriptorSetLayoutBinding globalBindings[19] = {
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1,
+         VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
         {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
-         VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+         VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
         {2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
-         VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+         VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
         {3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
-         VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+         VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
         {4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
-         VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+         VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
         {5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
          VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
         {6, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
@@ -242,39 +353,48 @@ bool Engine::init() {
          VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
         {9, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
          VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+        {10, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+         VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {11, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+         VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {12, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+         VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {13, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+         VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+        {14, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1,
+         VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {15, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+         VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+        {16, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+         VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {17, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1,
+         VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+        {18, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1,
+         VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
     };
-    m_globalSetLayout = m_descriptors.getOrCreateLayout(globalBindings, 10);
-
-    for (uint32_t i = 0; i < m_swapchain.imageCount(); i++) {
-        m_uniformBuffers[i].init(m_vkCtx.allocator(), sizeof(GlobalUBO),
-            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VMA_MEMORY_USAGE_AUTO,
-            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
-
-        m_pointLightBuffers[i].init(m_vkCtx.allocator(),
-            sizeof(GPUPointLight) * MAX_POINT_LIGHTS,
-            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-            VMA_MEMORY_USAGE_AUTO,
-            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT);
+    m_globalSetLayout = m_descriptors.getOrCreateLayout(globalBindings, 19);
 
-        m_globalSets[i] = m_descriptors.allocate(m_globalSetLayout);
-
-        DescriptorManager::writeBuffer(m_vkCtx.device(), m_globalSets[i], 0,
-            m_uniformBuffers[i].handle(), sizeof(GlobalUBO));
-        DescriptorManager::writeBuffer(m_vkCtx.device(), m_globalSets[i], 1,
-            m_pointLightBuffers[i].handle(), sizeof(GPUPointLight) * MAX_POINT_LIGHTS,
-            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
-    }
+    m_globalSet = m_descriptors.allocate(m_globalSetLayout);
+    DescriptorManager::writeBuffer(m_vkCtx.device(), m_globalSet, 0,
+        m_frameAlloc.buffer(), sizeof(GlobalUBO), VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+    DescriptorManager::writeBuffer(m_vkCtx.device(), m_globalSet, 14,
+        m_frameAlloc.buffer(), sizeof(uint32_t) * MAX_VISIBLE_POINT_LIGHTS,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC);
+    if (!growPointLightBuffer(INITIAL_POINT_LIGHT_CAPACITY)) return false;
 
     // Write G-buffer samplers to global descriptor sets
     updateLightingDescriptors();
 
+    if (!initMeshletCullPass()) return false;
+    if (!initLightClusterPass()) return false;
+    if (!initTileClassifyPass()) return false;
     if (!initShadowPass()) return false;
+    if (!initShadowFilterPass()) return false;
+    if (!initLocalShadowPass()) return false;
     if (!initGBufferPass()) return false;
     initIBL();
     if (!initSSAOPass()) return false;
     if (!initLightingPass()) return false;
-    if (!initSkyboxPass()) return false;
     if (!initBloomPass()) return false;
     if (!initMotionPass()) return false;
     if (!initTAAPass()) return false;
@@ -289,6 +409,7 @@ bool Engine::init() {
     updateAADescriptors();
 
     setupDemoScene();
+    m_uploads.submit();
 
     m_timer.reset();
     LOG(Core, Info, "Engine initialized (deferred PBR + TAA/FXAA)");
@@ -358,56 +479,189 @@ void Engine::createLDRImage() {
     m_ldrImage.init(m_vkCtx.allocator(), m_vkCtx.device(), ci);
 }
 
-void Engine::createShadowMap() {
+// Shelf-packs the cascades, largest first, into an atlas as wide as the largest cascade
+// or twice that, whichever wastes less. Sizes are powers of two, so a shelf only leaves
+// a gap at its end.
+void Engine::layoutShadowAtlas() {
+    const uint32_t maxDimension = m_vkCtx.physicalDeviceProperties().limits.maxImageDimension2D;
+    ShadowSettings& settings = m_shadowSettings;
+    const uint32_t count = settings.cascadeCount;
+
+    for (;;) {
+        uint32_t order[MAX_SHADOW_CASCADES];
+        for (uint32_t c = 0; c < count; c++) order[c] = c;
+        std::sort(order, order + count, [&](uint32_t a, uint32_t b) {
+            return settings.cascadeSize[a] > settings.cascadeSize[b];
+        });
+        const uint32_t largest = settings.cascadeSize[order[0]];
+
+        auto pack = [&](uint32_t shelfWidth, ShadowAtlasRect* rects) {
+            uint32_t x = 0, y = 0, shelfHeight = 0, width = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t size = settings.cascadeSize[order[i]];
+                if (x + size > shelfWidth) {
+                    y += shelfHeight;
+                    x = shelfHeight = 0;
+                }
+                rects[order[i]] = {x, y, size};
+                x += size;
+                width = std::max(width, x);
+                shelfHeight = std::max(shelfHeight, size);
+            }
+            return VkExtent2D{width, y + shelfHeight};
+        };
+
+        ShadowAtlasRect narrowRects[MAX_SHADOW_CASCADES], wideRects[MAX_SHADOW_CASCADES];
+        VkExtent2D narrow = pack(largest, narrowRects);
+        VkExtent2D wide = pack(largest * 2, wideRects);
+        bool narrowFits = std::max(narrow.width, narrow.height) <= maxDimension;
+        bool wideFits = std::max(wide.width, wide.height) <= maxDimension;
+        bool useWide = wideFits && (!narrowFits || uint64_t(wide.width) * wide.height <
+                                                   uint64_t(narrow.width) * narrow.height);
+        if (narrowFits || wideFits) {
+            m_shadowAtlasExtent = useWide ? wide : narrow;
+            std::copy_n(useWide ? wideRects : narrowRects, count, m_shadowAtlasRects);
+            return;
+        }
+
+        // Too large for the device: halve every cascade until it fits
+        LOG(Render, Warn, "Shadow atlas exceeds %u texels, halving cascade sizes", maxDimension);
+        for (uint32_t c = 0; c < count; c++)
+            settings.cascadeSize[c] = std::max(settings.cascadeSize[c] / 2, MIN_SHADOW_CASCADE_SIZE);
+        m_shadowSettingsUI = settings;
+    }
+}
+
+void Engine::createShadowAtlas() {
+    layoutShadowAtlas();
+    const uint32_t cascadeCount = m_shadowSettings.cascadeCount;
+    m_shadowFormat = m_shadowSettings.depth16 ? VK_FORMAT_D16_UNORM : VK_FORMAT_D32_SFLOAT;
+
     Image::CreateInfo ci{};
-    ci.width = SHADOW_MAP_SIZE;
-    ci.height = SHADOW_MAP_SIZE;
-    ci.arrayLayers = SHADOW_CASCADE_COUNT;
-    ci.format = VK_FORMAT_D32_SFLOAT;
-    ci.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    ci.width = m_shadowAtlasExtent.width;
+    ci.height = m_shadowAtlasExtent.height;
+    ci.format = m_shadowFormat;
+    ci.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+               VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     ci.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
-    ci.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
     m_shadowMap.init(m_vkCtx.allocator(), m_vkCtx.device(), ci);
 
-    // Create per-layer views for rendering
-    for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+    // Static caster cache: same layout, cascades are cleared and rendered in place and
+    // copied from
+    ci.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    m_shadowStaticCache.init(m_vkCtx.allocator(), m_vkCtx.device(), ci);
+
+    Image::CreateInfo momentCI{};
+    momentCI.width = SHADOW_MOMENTS_SIZE;
+    momentCI.height = SHADOW_MOMENTS_SIZE;
+    momentCI.arrayLayers = cascadeCount;
+    momentCI.mipLevels = SHADOW_MOMENTS_MIP_COUNT;
+    momentCI.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    momentCI.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    momentCI.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    momentCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    m_shadowMoments.init(m_vkCtx.allocator(), m_vkCtx.device(), momentCI);
+
+    momentCI.mipLevels = 1;
+    momentCI.usage = VK_IMAGE_USAGE_STORAGE_BIT;
+    m_shadowMomentsTemp.init(m_vkCtx.allocator(), m_vkCtx.device(), momentCI);
+
+    // Per-mip array views for imageStore
+    for (uint32_t mip = 0; mip < SHADOW_MOMENTS_MIP_COUNT; mip++) {
         VkImageViewCreateInfo viewCI{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
-        viewCI.image = m_shadowMap.handle();
-        viewCI.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        viewCI.format = VK_FORMAT_D32_SFLOAT;
-        viewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-        viewCI.subresourceRange.baseMipLevel = 0;
+        viewCI.image = m_shadowMoments.handle();
+        viewCI.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        viewCI.format = VK_FORMAT_R32G32B32A32_SFLOAT;
+        viewCI.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewCI.subresourceRange.baseMipLevel = mip;
         viewCI.subresourceRange.levelCount = 1;
-        viewCI.subresourceRange.baseArrayLayer = i;
-        viewCI.subresourceRange.layerCount = 1;
-        VK_CHECK(vkCreateImageView(m_vkCtx.device(), &viewCI, nullptr, &m_shadowLayerViews[i]));
+        viewCI.subresourceRange.baseArrayLayer = 0;
+        viewCI.subresourceRange.layerCount = cascadeCount;
+        VK_CHECK(vkCreateImageView(m_vkCtx.device(), &viewCI, nullptr, &m_shadowMomentsMipViews[mip]));
     }
 
-    // Transition to shader read for initial descriptor validity
+    // Transition to shader read for initial descriptor validity; the cache rests in TRANSFER_SRC
+    // and the blur intermediate in GENERAL
     m_cmdPool.submitImmediate(m_vkCtx.graphicsQueue(), [&](VkCommandBuffer cmd) {
         Image::transitionLayout(cmd, m_shadowMap.handle(),
             VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            VK_IMAGE_ASPECT_DEPTH_BIT, 1, SHADOW_CASCADE_COUNT);
+            VK_IMAGE_ASPECT_DEPTH_BIT);
+        Image::transitionLayout(cmd, m_shadowStaticCache.handle(),
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_ASPECT_DEPTH_BIT);
+        Image::transitionLayout(cmd, m_shadowMoments.handle(),
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_ASPECT_COLOR_BIT, SHADOW_MOMENTS_MIP_COUNT, cascadeCount);
+        Image::transitionLayout(cmd, m_shadowMomentsTemp.handle(),
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+            VK_IMAGE_ASPECT_COLOR_BIT, 1, cascadeCount);
     });
+
+    const uint32_t texelBytes = m_shadowSettings.depth16 ? 2 : 4;
+    double atlasMB = double(m_shadowAtlasExtent.width) * m_shadowAtlasExtent.height * texelBytes / (1024.0 * 1024.0);
+    LOG(Render, Info, "Shadow atlas %ux%u %s, %u cascades, %.1f MB (+ same for the static cache)",
+        m_shadowAtlasExtent.width, m_shadowAtlasExtent.height, m_shadowSettings.depth16 ? "D16" : "D32",
+        cascadeCount, atlasMB);
+}
+
+void Engine::destroyShadowAtlas() {
+    for (auto& view : m_shadowMomentsMipViews) {
+        if (view) vkDestroyImageView(m_vkCtx.device(), view, nullptr);
+        view = VK_NULL_HANDLE;
+    }
+    m_shadowMoments.shutdown();
+    m_shadowMomentsTemp.shutdown();
+    m_shadowMap.shutdown();
+    m_shadowStaticCache.shutdown();
+}
+
+// Applies m_shadowSettingsUI: new atlas, moments and (for a new depth format) pipelines.
+// Every cascade starts over with a full refresh.
+void Engine::rebuildShadowAtlas() {
+    m_shadowAtlasDirty = false;
+    m_vkCtx.waitIdle();
+
+    m_shadowSettings = m_shadowSettingsUI;
+    destroyShadowAtlas();
+    createShadowAtlas();
+    createShadowPipelines();
+    updateLightingDescriptors();
+    updateShadowFilterDescriptors();
+
+    for (auto& cache : m_shadowCache) cache = {};
 }
 
-void Engine::computeCascades(mat4 cascadeVP[SHADOW_CASCADE_COUNT], vec4& splits) {
+void Engine::computeCascades(CascadeFit fits[MAX_SHADOW_CASCADES], vec4& splits) {
     const Camera& cam = m_scene.camera();
-    const vec3& lightDir = m_scene.directionalLight().direction;
-    const float nearClip = cam.nearPlane();
-    const float farClip = SHADOW_DISTANCE;
+    const uint32_t cascadeCount = m_shadowSettings.cascadeCount;
+    float nearClip = cam.nearPlane();
+    float farClip = SHADOW_DISTANCE;
     const float lambda = 0.75f;
 
+    // Sample distribution: split only the depth range that is actually visible. The bounds
+    // are snapped outwards to quarter octaves so cached cascades survive small changes.
+    if (m_sdsmEnabled && m_visibleDepthRange.y > m_visibleDepthRange.x) {
+        float visibleNear = std::exp2(std::floor(std::log2(m_visibleDepthRange.x) * 4.0f) * 0.25f);
+        float visibleFar = std::exp2(std::ceil(std::log2(m_visibleDepthRange.y) * 4.0f) * 0.25f);
+        nearClip = std::max(nearClip, visibleNear);
+        farClip = std::min(farClip, visibleFar);
+        if (farClip <= nearClip) {
+            nearClip = cam.nearPlane();
+            farClip = SHADOW_DISTANCE;
+        }
+    }
+
     // Practical split scheme
-    float cascadeSplits[SHADOW_CASCADE_COUNT + 1];
+    float cascadeSplits[MAX_SHADOW_CASCADES + 1];
     cascadeSplits[0] = nearClip;
-    for (uint32_t i = 1; i < SHADOW_CASCADE_COUNT; i++) {
-        float p = static_cast<float>(i) / static_cast<float>(SHADOW_CASCADE_COUNT);
+    for (uint32_t i = 1; i < cascadeCount; i++) {
+        float p = static_cast<float>(i) / static_cast<float>(cascadeCount);
         float logSplit = nearClip * std::pow(farClip / nearClip, p);
         float linSplit = nearClip + (farClip - nearClip) * p;
         cascadeSplits[i] = lambda * logSplit + (1.0f - lambda) * linSplit;
     }
-    cascadeSplits[SHADOW_CASCADE_COUNT] = farClip;
+    for (uint32_t i = cascadeCount; i <= MAX_SHADOW_CASCADES; i++)
+        cascadeSplits[i] = farClip;
 
     splits = vec4(cascadeSplits[1], cascadeSplits[2], cascadeSplits[3], 0.002f);
 
@@ -415,10 +669,7 @@ void Engine::computeCascades(mat4 cascadeVP[SHADOW_CASCADE_COUNT], vec4& splits)
     float tanHalfFov = std::tan(glm::radians(cam.fovY()) * 0.5f);
     float aspect = cam.aspect();
 
-    vec3 lightDirN = glm::normalize(lightDir);
-    vec3 up = (std::abs(lightDirN.y) > 0.99f) ? vec3(0, 0, 1) : vec3(0, 1, 0);
-
-    for (uint32_t c = 0; c < SHADOW_CASCADE_COUNT; c++) {
+    for (uint32_t c = 0; c < cascadeCount; c++) {
         float cNear = cascadeSplits[c];
         float cFar = cascadeSplits[c + 1];
 
@@ -453,53 +704,161 @@ void Engine::computeCascades(mat4 cascadeVP[SHADOW_CASCADE_COUNT], vec4& splits)
         // Snap radius to reduce shimmer
         radius = std::ceil(radius * 16.0f) / 16.0f;
 
-        // Build light view/proj
-        float zMult = 2.0f;
-        mat4 lightView = glm::lookAt(center - lightDirN * radius * zMult, center, up);
-        mat4 lightProj = glm::ortho(-radius, radius, -radius, radius,
-                                     0.0f, radius * zMult * 2.0f);
+        fits[c] = {center, radius};
+    }
+}
 
-        // Texel snapping: align shadow map texels to world positions
-        // This prevents shadow edge shimmer when the camera translates
-        mat4 shadowMatrix = lightProj * lightView;
-        vec4 origin = shadowMatrix * vec4(0.0f, 0.0f, 0.0f, 1.0f);
-        float halfSM = static_cast<float>(SHADOW_MAP_SIZE) * 0.5f;
-        float texelX = origin.x * halfSM;
-        float texelY = origin.y * halfSM;
-        float dx = std::round(texelX) - texelX;
-        float dy = std::round(texelY) - texelY;
-        lightProj[3][0] += dx / halfSM;
-        lightProj[3][1] += dy / halfSM;
+mat4 Engine::cascadeViewProj(const vec3& center, float radius, const vec3& lightDir, uint32_t resolution) const {
+    vec3 lightDirN = glm::normalize(lightDir);
+    vec3 up = (std::abs(lightDirN.y) > 0.99f) ? vec3(0, 0, 1) : vec3(0, 1, 0);
 
-        cascadeVP[c] = lightProj * lightView;
-    }
+    // Build light view/proj
+    float zMult = 2.0f;
+    mat4 lightView = glm::lookAt(center - lightDirN * radius * zMult, center, up);
+    mat4 lightProj = glm::ortho(-radius, radius, -radius, radius,
+                                 0.0f, radius * zMult * 2.0f);
+
+    // Texel snapping: align shadow map texels to world positions
+    // This prevents shadow edge shimmer when the camera translates
+    mat4 shadowMatrix = lightProj * lightView;
+    vec4 origin = shadowMatrix * vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    float halfSM = static_cast<float>(resolution) * 0.5f;
+    float texelX = origin.x * halfSM;
+    float texelY = origin.y * halfSM;
+    float dx = std::round(texelX) - texelX;
+    float dy = std::round(texelY) - texelY;
+    lightProj[3][0] += dx / halfSM;
+    lightProj[3][1] += dy / halfSM;
+
+    return lightProj * lightView;
 }
 
-void Engine::updateLightingDescriptors() {
-    for (uint32_t i = 0; i < m_swapchain.imageCount(); i++) {
-        DescriptorManager::writeImage(m_vkCtx.device(), m_globalSets[i], 2,
-            m_gbufferRT0.view(), m_nearestSampler);
-        DescriptorManager::writeImage(m_vkCtx.device(), m_globalSets[i], 3,
-            m_gbufferRT1.view(), m_nearestSampler);
-        DescriptorManager::writeImage(m_vkCtx.device(), m_globalSets[i], 4,
-            m_depthImage.view(), m_nearestSampler);
-        DescriptorManager::writeImage(m_vkCtx.device(), m_globalSets[i], 5,
-            m_shadowMap.view(), m_shadowSampler);
-        if (m_irradianceMap.handle()) {
-            DescriptorManager::writeImage(m_vkCtx.device(), m_globalSets[i], 6,
-                m_irradianceMap.view(), m_cubemapSampler);
-            DescriptorManager::writeImage(m_vkCtx.device(), m_globalSets[i], 7,
-                m_prefilteredMap.view(), m_cubemapSampler);
-            DescriptorManager::writeImage(m_vkCtx.device(), m_globalSets[i], 8,
-                m_brdfLUT.view(), m_linearSampler);
+// Decides per cascade whether last frame's atlas region can be reused. A cascade is
+// re-fitted (static region re-rendered) when the camera drifted past SHADOW_CACHE_MARGIN, the
+// light turned or the cascade size changed, or static geometry changed. Otherwise only
+// moved dynamic casters overlapping it force a refresh, which far cascades take in turns.
+void Engine::updateShadowCascades(vec4& splits) {
+    const uint32_t cascadeCount = m_shadowSettings.cascadeCount;
+    CascadeFit fits[MAX_SHADOW_CASCADES];
+    computeCascades(fits, splits);
+
+    vec3 lightDir = m_scene.directionalLight().direction;
+    uint64_t staticVersion = m_scene.staticGeometryVersion();
+    for (uint32_t c = 0; c < cascadeCount; c++) {
+        ShadowCascadeCache& cache = m_shadowCache[c];
+        float drift = glm::length(fits[c].center - cache.center);
+        if (!m_shadowCachingEnabled || cache.radius != fits[c].radius || cache.lightDir != lightDir ||
+            drift > fits[c].radius * SHADOW_CACHE_MARGIN) {
+            float padding = m_shadowCachingEnabled ? 1.0f + SHADOW_CACHE_MARGIN : 1.0f;
+            cache.viewProj = cascadeViewProj(fits[c].center, fits[c].radius * padding, lightDir,
+                                             m_shadowSettings.cascadeSize[c]);
+            cache.center = fits[c].center;
+            cache.radius = fits[c].radius;
+            cache.lightDir = lightDir;
+            cache.staticValid = false;
+        }
+        if (cache.staticVersion != staticVersion) {
+            cache.staticVersion = staticVersion;
+            cache.staticValid = false;
+        }
+        m_cascadeVP[c] = cache.viewProj;
+    }
+
+    // A moved dynamic caster dirties every cascade that covers its old or new bounds
+    vec4 planes[MAX_SHADOW_CASCADES][6];
+    for (uint32_t c = 0; c < cascadeCount; c++)
+        extractFrustumPlanes(m_cascadeVP[c], planes[c]);
+    auto overlaps = [](const vec4* cascadePlanes, const vec4& sphere) {
+        for (int p = 0; p < 6; p++)
+            if (glm::dot(cascadePlanes[p], vec4(vec3(sphere), 1.0f)) < -sphere.w) return false;
+        return true;
+    };
+
+    const auto& entities = m_scene.entities();
+    m_shadowCasterTransforms.resize(entities.size(), mat4(0.0f));
+    m_hasDynamicCasters = false;
+    m_movedCasterSpheres.clear();
+    for (size_t i = 0; i < entities.size(); i++) {
+        const auto& entity = entities[i];
+        const Mesh* mesh = m_assets.meshes().get(entity.mesh);
+        if (!mesh || !entity.dynamic) continue;
+        m_hasDynamicCasters = true;
+
+        mat4 model = entity.transform.modelMatrix();
+        mat4& previous = m_shadowCasterTransforms[i];
+        if (model == previous) continue;
+        bool seen = previous != mat4(0.0f);
+        vec4 sphere = boundingSphere(mesh->bounds(), model);
+        vec4 previousSphere = seen ? boundingSphere(mesh->bounds(), previous) : sphere;
+        m_movedCasterSpheres.push_back(sphere);
+        if (seen) m_movedCasterSpheres.push_back(previousSphere);
+        for (uint32_t c = 0; c < cascadeCount; c++) {
+            if (overlaps(planes[c], sphere) || overlaps(planes[c], previousSphere))
+                m_shadowCache[c].dynamicDirty = true;
         }
-        if (m_ssaoBlurred.handle()) {
-            DescriptorManager::writeImage(m_vkCtx.device(), m_globalSets[i], 9,
-                m_ssaoBlurred.view(), m_linearSampler);
+        previous = model;
+    }
+
+    for (uint32_t c = 0; c < cascadeCount; c++) {
+        ShadowCascadeCache& cache = m_shadowCache[c];
+        bool turn = c == 0 || (m_frameCount + c) % SHADOW_FAR_CASCADE_INTERVAL == 0;
+        if (!cache.staticValid) {
+            m_shadowRefresh[c] = ShadowRefresh::Full;
+            cache.staticValid = true;
+            cache.dynamicDirty = false;
+        } else if (cache.dynamicDirty && turn) {
+            m_shadowRefresh[c] = ShadowRefresh::Dynamic;
+            cache.dynamicDirty = false;
+        } else {
+            m_shadowRefresh[c] = ShadowRefresh::None;
         }
     }
 }
 
+// Picks up the visible depth range tile_classify.comp reduced in the last submitted frame,
+// whose fence has been waited on
+void Engine::readDepthBounds() {
+    if (!m_depthBoundsPending) return;
+    m_depthBoundsPending = false;
+
+    vmaInvalidateAllocation(m_vkCtx.allocator(), m_depthBoundsReadback.allocation(), 0, VK_WHOLE_SIZE);
+    uint32_t bits[2];
+    std::memcpy(bits, m_depthBoundsReadback.mapped(), sizeof(bits));
+    if (bits[0] > bits[1]) {
+        m_visibleDepthRange = vec2(0.0f); // only sky
+        return;
+    }
+    std::memcpy(&m_visibleDepthRange.x, &bits[0], sizeof(float));
+    std::memcpy(&m_visibleDepthRange.y, &bits[1], sizeof(float));
+}
+
+void Engine::updateLightingDescriptors() {
+    DescriptorManager::writeImage(m_vkCtx.device(), m_globalSet, 2,
+        m_gbufferRT0.view(), m_nearestSampler);
+    DescriptorManager::writeImage(m_vkCtx.device(), m_globalSet, 3,
+        m_gbufferRT1.view(), m_nearestSampler);
+    DescriptorManager::writeImage(m_vkCtx.device(), m_globalSet, 4,
+        m_depthImage.view(), m_nearestSampler);
+    DescriptorManager::writeImage(m_vkCtx.device(), m_globalSet, 5,
+        m_shadowMap.view(), m_shadowSampler);
+    DescriptorManager::writeImage(m_vkCtx.device(), m_globalSet, 15,
+        m_shadowMoments.view(), m_shadowMomentsSampler);
+    if (m_irradianceMap.handle()) {
+        DescriptorManager::writeImage(m_vkCtx.device(), m_globalSet, 6,
+            m_irradianceMap.view(), m_cubemapSampler);
+        DescriptorManager::writeImage(m_vkCtx.device(), m_globalSet, 7,
+            m_prefilteredMap.view(), m_cubemapSampler);
+        DescriptorManager::writeImage(m_vkCtx.device(), m_globalSet, 8,
+            m_brdfLUT.view(), m_linearSampler);
+        DescriptorManager::writeImage(m_vkCtx.device(), m_globalSet, 13,
+            m_envCubemap.view(), m_cubemapSampler);
+    }
+    if (m_ssaoBlurred.handle()) {
+        DescriptorManager::writeImage(m_vkCtx.device(), m_globalSet, 9,
+            m_ssaoBlurred.view(), m_linearSampler);
+    }
+}
+
 void Engine::updateAADescriptors() {
     VkDevice device = m_vkCtx.device();
 
@@ -549,37 +908,338 @@ void Engine::updateAADescriptors() {
     }
 }
 
+bool Engine::initMeshletCullPass() {
+    if (!m_vkCtx.features().drawIndirectCount) {
+        LOG(Pipeline, Warn, "Meshlet culling disabled: drawIndirectCount not supported");
+        m_meshletCullingEnabled = false;
+        return true;
+    }
+
+    VkDevice device = m_vkCtx.device();
+
+    if (!m_meshletCullComp.loadFromFile(device, "shaders/deferred/meshlet_cull.comp.spv")) return false;
+
+    // 0 = views, 1 = objects (both in m_frameAlloc), 2 = draw commands, 3 = draw counts
+    VkDescriptorSetLayoutBinding bindings[4] = {
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+    };
+    m_meshletCullSetLayout = m_descriptors.getOrCreateLayout(bindings, 4);
+
+    VkPushConstantRange pushRange{};
+    pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushRange.offset = 0;
+    pushRange.size = sizeof(MeshletCullPushConstants);
+
+    VkPipelineLayoutCreateInfo layoutCI{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    layoutCI.setLayoutCount = 1;
+    layoutCI.pSetLayouts = &m_meshletCullSetLayout;
+    layoutCI.pushConstantRangeCount = 1;
+    layoutCI.pPushConstantRanges = &pushRange;
+    VK_CHECK(vkCreatePipelineLayout(device, &layoutCI, nullptr, &m_meshletCullPipelineLayout));
+
+    VkComputePipelineCreateInfo pipeCI{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    pipeCI.stage = m_meshletCullComp.stageInfo(VK_SHADER_STAGE_COMPUTE_BIT);
+    pipeCI.layout = m_meshletCullPipelineLayout;
+    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeCI, nullptr, &m_meshletCullPipeline));
+
+    // Object / draw bindings are sized on first use by updateMeshletCulling()
+    for (uint32_t i = 0; i < m_swapchain.imageCount(); i++) {
+        auto& cull = m_meshletCull[i];
+        cull.set = m_descriptors.allocate(m_meshletCullSetLayout);
+        DescriptorManager::writeBuffer(device, cull.set, 0,
+            m_frameAlloc.buffer(), sizeof(GPUCullView) * CULL_VIEW_COUNT,
+            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+    }
+
+    LOG(Pipeline, Info, "Meshlet cull pipeline created");
+    return true;
+}
+
+bool Engine::initLightClusterPass() {
+    VkDevice device = m_vkCtx.device();
+
+    if (!m_lightClusterComp.loadFromFile(device, "shaders/deferred/light_cluster.comp.spv")) return false;
+
+    VkPipelineLayoutCreateInfo layoutCI{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    layoutCI.setLayoutCount = 1;
+    layoutCI.pSetLayouts = &m_globalSetLayout;
+    VK_CHECK(vkCreatePipelineLayout(device, &layoutCI, nullptr, &m_lightClusterPipelineLayout));
+
+    VkComputePipelineCreateInfo pipeCI{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    pipeCI.stage = m_lightClusterComp.stageInfo(VK_SHADER_STAGE_COMPUTE_BIT);
+    pipeCI.layout = m_lightClusterPipelineLayout;
+    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeCI, nullptr, &m_lightClusterPipeline));
+
+    // Written and consumed within a frame, so one copy serves every frame in flight
+    VkDeviceSize gridSize = sizeof(uint32_t) * 2 * CLUSTER_COUNT;
+    VkDeviceSize indicesSize = sizeof(uint32_t) * (1 + CLUSTER_LIGHT_INDEX_CAPACITY);
+    if (!m_clusterGrid.init(m_vkCtx.allocator(), gridSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE))
+        return false;
+    if (!m_clusterLightIndices.init(m_vkCtx.allocator(), indicesSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE))
+        return false;
+
+    DescriptorManager::writeBuffer(device, m_globalSet, 10, m_clusterGrid.handle(), gridSize,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    DescriptorManager::writeBuffer(device, m_globalSet, 11, m_clusterLightIndices.handle(), indicesSize,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+    LOG(Pipeline, Info, "Light cluster pipeline created (%ux%ux%u froxels)",
+        CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z);
+    return true;
+}
+
+void Engine::createTileClassBuffer() {
+    m_tileGridX = (m_swapchain.extent().width + LIGHTING_TILE_SIZE - 1) / LIGHTING_TILE_SIZE;
+    m_tileGridY = (m_swapchain.extent().height + LIGHTING_TILE_SIZE - 1) / LIGHTING_TILE_SIZE;
+
+    // Every class list can hold every tile, so classification never overflows
+    VkDeviceSize size = sizeof(VkDrawIndirectCommand) * TILE_CLASS_COUNT +
+                        sizeof(uint32_t) * TILE_CLASS_COUNT * m_tileGridX * m_tileGridY;
+    m_tileClassBuffer.init(m_vkCtx.allocator(), size,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+
+    DescriptorManager::writeBuffer(m_vkCtx.device(), m_globalSet, 12, m_tileClassBuffer.handle(), size,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+}
+
+bool Engine::initTileClassifyPass() {
+    VkDevice device = m_vkCtx.device();
+
+    if (!m_tileClassifyComp.loadFromFile(device, "shaders/deferred/tile_classify.comp.spv")) return false;
+
+    VkPipelineLayoutCreateInfo layoutCI{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    layoutCI.setLayoutCount = 1;
+    layoutCI.pSetLayouts = &m_globalSetLayout;
+    VK_CHECK(vkCreatePipelineLayout(device, &layoutCI, nullptr, &m_tileClassifyPipelineLayout));
+
+    VkComputePipelineCreateInfo pipeCI{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    pipeCI.stage = m_tileClassifyComp.stageInfo(VK_SHADER_STAGE_COMPUTE_BIT);
+    pipeCI.layout = m_tileClassifyPipelineLayout;
+    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeCI, nullptr, &m_tileClassifyPipeline));
+
+    createTileClassBuffer();
+    if (!m_tileClassBuffer.handle()) return false;
+
+    // Visible depth bounds for the shadow cascade fit, copied out after every classification
+    if (!m_depthBoundsBuffer.init(m_vkCtx.allocator(), sizeof(uint32_t) * 2,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE))
+        return false;
+    if (!m_depthBoundsReadback.init(m_vkCtx.allocator(), sizeof(uint32_t) * 2,
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_AUTO,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT))
+        return false;
+    DescriptorManager::writeBuffer(device, m_globalSet, 16, m_depthBoundsBuffer.handle(), sizeof(uint32_t) * 2,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+    LOG(Pipeline, Info, "Tile classify pipeline created (%ux%u tiles)", m_tileGridX, m_tileGridY);
+    return true;
+}
+
 bool Engine::initShadowPass() {
     VkDevice device = m_vkCtx.device();
 
-    if (!m_shadowVert.loadFromFile(device, "shaders/deferred/shadow.vert.spv")) return false;
+    // One pass for all cascades: instances routed to per-cascade viewports, or one pass
+    // per cascade without vertex shader viewport index output
+    const bool singlePass = m_vkCtx.features().shaderOutputViewportIndex;
+    const char* shadowVertPath = singlePass ? "shaders/deferred/shadow.vert.spv"
+                                            : "shaders/deferred/shadow_single.vert.spv";
+    if (!m_shadowVert.loadFromFile(device, shadowVertPath)) return false;
 
     VkPushConstantRange pushRange{};
     pushRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
     pushRange.offset = 0;
-    pushRange.size = sizeof(mat4);
+    pushRange.size = sizeof(ShadowPushConstants);
 
     VkPipelineLayoutCreateInfo layoutCI{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    layoutCI.setLayoutCount = 1;
+    layoutCI.pSetLayouts = &m_globalSetLayout;
     layoutCI.pushConstantRangeCount = 1;
     layoutCI.pPushConstantRanges = &pushRange;
     VK_CHECK(vkCreatePipelineLayout(device, &layoutCI, nullptr, &m_shadowPipelineLayout));
 
-    auto binding = Vertex::bindingDesc();
-    auto attrs = Vertex::attributeDescs();
-
-    m_shadowPipeline = PipelineBuilder()
-        .addShaderStage(m_shadowVert.stageInfo(VK_SHADER_STAGE_VERTEX_BIT))
-        .setVertexInput(&binding, 1, attrs.data(), static_cast<uint32_t>(attrs.size()))
-        .setDepthFormat(VK_FORMAT_D32_SFLOAT)
-        .setColorBlendAttachment(0, false)
-        .setCullMode(VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
-        .setDepthTest(true, true, VK_COMPARE_OP_LESS_OR_EQUAL)
-        .setDepthBias(true, 4.0f, 1.5f)
-        .setDynamicStates({VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR, VK_DYNAMIC_STATE_DEPTH_BIAS})
-        .setLayout(m_shadowPipelineLayout)
-        .build(device);
+    createShadowPipelines();
 
-    LOG(Pipeline, Info, "Shadow pipeline created");
+    LOG(Pipeline, Info, "Shadow pipelines created (%s)", singlePass ? "single pass" : "pass per cascade");
+    return true;
+}
+
+// Depth-only: consume just the mesh position stream. The stride is dynamic so meshes
+// without a separate stream can still bind their interleaved buffer. Recreated when the
+// atlas depth format changes.
+void Engine::createShadowPipelines() {
+    VkDevice device = m_vkCtx.device();
+    const bool singlePass = m_vkCtx.features().shaderOutputViewportIndex;
+
+    for (uint32_t e = 0; e < POSITION_ENCODING_COUNT; e++) {
+        if (m_shadowPipelines[e]) vkDestroyPipeline(device, m_shadowPipelines[e], nullptr);
+
+        auto encoding = static_cast<PositionEncoding>(e);
+        VkVertexInputBindingDescription binding{0, VertexPacking::positionStride(encoding),
+                                                VK_VERTEX_INPUT_RATE_VERTEX};
+        VkVertexInputAttributeDescription position{0, 0, VertexPacking::positionFormat(encoding), 0};
+
+        m_shadowPipelines[e] = PipelineBuilder()
+            .addShaderStage(m_shadowVert.stageInfo(VK_SHADER_STAGE_VERTEX_BIT))
+            .setVertexInput(&binding, 1, &position, 1)
+            .setDepthFormat(m_shadowFormat)
+            .setViewportCount(singlePass ? MAX_SHADOW_CASCADES : 1)
+            .setColorBlendAttachment(0, false)
+            .setCullMode(VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
+            .setDepthTest(true, true, VK_COMPARE_OP_LESS_OR_EQUAL)
+            .setDepthBias(true, 4.0f, 1.5f)
+            .setDynamicStates({VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR, VK_DYNAMIC_STATE_DEPTH_BIAS,
+                               VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE})
+            .setLayout(m_shadowPipelineLayout)
+            .build(device);
+    }
+}
+
+bool Engine::initShadowFilterPass() {
+    VkDevice device = m_vkCtx.device();
+
+    if (!m_evsmResolveComp.loadFromFile(device, "shaders/deferred/evsm_resolve.comp.spv")) return false;
+    if (!m_evsmBlurComp.loadFromFile(device, "shaders/deferred/evsm_blur.comp.spv")) return false;
+    if (!m_evsmDownsampleComp.loadFromFile(device, "shaders/deferred/evsm_downsample.comp.spv")) return false;
+
+    VkDescriptorSetLayoutBinding bindings[3] = {
+        {0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+    };
+    m_shadowFilterSetLayout = m_descriptors.getOrCreateLayout(bindings, 3);
+
+    VkPushConstantRange pushRange{};
+    pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushRange.size = sizeof(ShadowFilterPushConstants);
+
+    VkPipelineLayoutCreateInfo layoutCI{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    layoutCI.setLayoutCount = 1;
+    layoutCI.pSetLayouts = &m_shadowFilterSetLayout;
+    layoutCI.pushConstantRangeCount = 1;
+    layoutCI.pPushConstantRanges = &pushRange;
+    VK_CHECK(vkCreatePipelineLayout(device, &layoutCI, nullptr, &m_shadowFilterPipelineLayout));
+
+    VkComputePipelineCreateInfo pipeCI{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    pipeCI.layout = m_shadowFilterPipelineLayout;
+    pipeCI.stage = m_evsmResolveComp.stageInfo(VK_SHADER_STAGE_COMPUTE_BIT);
+    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeCI, nullptr, &m_evsmResolvePipeline));
+    pipeCI.stage = m_evsmBlurComp.stageInfo(VK_SHADER_STAGE_COMPUTE_BIT);
+    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeCI, nullptr, &m_evsmBlurPipeline));
+    pipeCI.stage = m_evsmDownsampleComp.stageInfo(VK_SHADER_STAGE_COMPUTE_BIT);
+    VK_CHECK(vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &pipeCI, nullptr, &m_evsmDownsamplePipeline));
+
+    m_evsmResolveSet = m_descriptors.allocate(m_shadowFilterSetLayout);
+    m_evsmBlurSets[0] = m_descriptors.allocate(m_shadowFilterSetLayout);
+    m_evsmBlurSets[1] = m_descriptors.allocate(m_shadowFilterSetLayout);
+    for (uint32_t mip = 1; mip < SHADOW_MOMENTS_MIP_COUNT; mip++)
+        m_evsmDownsampleSets[mip] = m_descriptors.allocate(m_shadowFilterSetLayout);
+    updateShadowFilterDescriptors();
+
+    LOG(Pipeline, Info, "EVSM prefilter pipelines created (%ux%u moments per cascade, %u mips)",
+        SHADOW_MOMENTS_SIZE, SHADOW_MOMENTS_SIZE, SHADOW_MOMENTS_MIP_COUNT);
+    return true;
+}
+
+// Shadow atlas depth -> moments mip 0 -> temp -> moments mip 0 -> mips 1..N-1
+void Engine::updateShadowFilterDescriptors() {
+    VkDevice device = m_vkCtx.device();
+    DescriptorManager::writeImage(device, m_evsmResolveSet, 0, m_shadowMap.view(), m_nearestSampler);
+    DescriptorManager::writeStorageImage(device, m_evsmResolveSet, 2, m_shadowMomentsMipViews[0]);
+
+    DescriptorManager::writeStorageImage(device, m_evsmBlurSets[0], 1, m_shadowMomentsMipViews[0]);
+    DescriptorManager::writeStorageImage(device, m_evsmBlurSets[0], 2, m_shadowMomentsTemp.view());
+    DescriptorManager::writeStorageImage(device, m_evsmBlurSets[1], 1, m_shadowMomentsTemp.view());
+    DescriptorManager::writeStorageImage(device, m_evsmBlurSets[1], 2, m_shadowMomentsMipViews[0]);
+
+    for (uint32_t mip = 1; mip < SHADOW_MOMENTS_MIP_COUNT; mip++) {
+        DescriptorManager::writeStorageImage(device, m_evsmDownsampleSets[mip], 1, m_shadowMomentsMipViews[mip - 1]);
+        DescriptorManager::writeStorageImage(device, m_evsmDownsampleSets[mip], 2, m_shadowMomentsMipViews[mip]);
+    }
+}
+
+bool Engine::initLocalShadowPass() {
+    VkDevice device = m_vkCtx.device();
+
+    if (!m_localShadowVert.loadFromFile(device, "shaders/deferred/local_shadow.vert.spv")) return false;
+
+    VkPushConstantRange pushRange{};
+    pushRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushRange.size = sizeof(MeshPushConstants);
+
+    VkPipelineLayoutCreateInfo layoutCI{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    layoutCI.pushConstantRangeCount = 1;
+    layoutCI.pPushConstantRanges = &pushRange;
+    VK_CHECK(vkCreatePipelineLayout(device, &layoutCI, nullptr, &m_localShadowPipelineLayout));
+
+    for (uint32_t e = 0; e < POSITION_ENCODING_COUNT; e++) {
+        auto encoding = static_cast<PositionEncoding>(e);
+        VkVertexInputBindingDescription binding{0, VertexPacking::positionStride(encoding),
+                                                VK_VERTEX_INPUT_RATE_VERTEX};
+        VkVertexInputAttributeDescription position{0, 0, VertexPacking::positionFormat(encoding), 0};
+
+        m_localShadowPipelines[e] = PipelineBuilder()
+            .addShaderStage(m_localShadowVert.stageInfo(VK_SHADER_STAGE_VERTEX_BIT))
+            .setVertexInput(&binding, 1, &position, 1)
+            .setDepthFormat(VK_FORMAT_D16_UNORM)
+            .setColorBlendAttachment(0, false)
+            .setCullMode(VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
+            .setDepthTest(true, true, VK_COMPARE_OP_LESS_OR_EQUAL)
+            .setDepthBias(true, 2.0f, 2.0f)
+            .setDynamicStates({VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR,
+                               VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE})
+            .setLayout(m_localShadowPipelineLayout)
+            .build(device);
+    }
+
+    Image::CreateInfo ci{};
+    ci.width = LOCAL_SHADOW_ATLAS_SIZE;
+    ci.height = LOCAL_SHADOW_ATLAS_SIZE;
+    ci.format = VK_FORMAT_D16_UNORM;
+    ci.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    ci.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    m_localShadowAtlas.init(m_vkCtx.allocator(), device, ci);
+    m_cmdPool.submitImmediate(m_vkCtx.graphicsQueue(), [&](VkCommandBuffer cmd) {
+        Image::transitionLayout(cmd, m_localShadowAtlas.handle(),
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_ASPECT_DEPTH_BIT);
+    });
+
+    VkDeviceSize viewsSize = sizeof(GPULocalShadowView) * MAX_SHADOWED_LOCAL_LIGHTS * LOCAL_SHADOW_FACES;
+    if (!m_localShadowViews.init(m_vkCtx.allocator(), viewsSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE))
+        return false;
+
+    DescriptorManager::writeImage(device, m_globalSet, 17, m_localShadowAtlas.view(), m_shadowSampler);
+    DescriptorManager::writeBuffer(device, m_globalSet, 18, m_localShadowViews.handle(), viewsSize,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+
+    uint32_t originY = 0;
+    uint32_t tileCount = 0;
+    for (uint32_t c = 0; c < LOCAL_SHADOW_TILE_CLASSES; c++) {
+        LocalShadowPool& pool = m_localShadowPools[c];
+        pool.tileSize = LOCAL_SHADOW_TILE_SIZES[c];
+        pool.originY = originY;
+        pool.columns = LOCAL_SHADOW_ATLAS_SIZE / pool.tileSize;
+        pool.owner.assign(pool.columns * (LOCAL_SHADOW_BAND_HEIGHTS[c] / pool.tileSize), UINT32_MAX);
+        originY += LOCAL_SHADOW_BAND_HEIGHTS[c];
+        tileCount += static_cast<uint32_t>(pool.owner.size());
+    }
+    for (uint32_t slot = MAX_SHADOWED_LOCAL_LIGHTS; slot-- > 0;)
+        m_freeLocalShadowSlots.push_back(slot);
+
+    LOG(Pipeline, Info, "Local shadow atlas %ux%u D16 (%u tiles, %u shadowed lights max)",
+        LOCAL_SHADOW_ATLAS_SIZE, LOCAL_SHADOW_ATLAS_SIZE, tileCount, MAX_SHADOWED_LOCAL_LIGHTS);
     return true;
 }
 
@@ -587,7 +1247,12 @@ bool Engine::initGBufferPass() {
     VkDevice device = m_vkCtx.device();
 
     if (!m_gbufferVert.loadFromFile(device, "shaders/deferred/gbuffer.vert.spv")) return false;
-    if (!m_gbufferFrag.loadFromFile(device, "shaders/deferred/gbuffer.frag.spv")) return false;
+    if (!m_gbufferPackedVert.loadFromFile(device, "shaders/deferred/gbuffer_packed.vert.spv")) return false;
+    // Virtual texture feedback is a fragment shader store; without them the variant that
+    // writes nothing is used (virtual texturing is off)
+    const char* gbufferFragPath = m_vkCtx.features().fragmentStoresAndAtomics
+        ? "shaders/deferred/gbuffer.frag.spv" : "shaders/deferred/gbuffer_no_feedback.frag.spv";
+    if (!m_gbufferFrag.loadFromFile(device, gbufferFragPath)) return false;
 
     // Material descriptor set layout (set 2): 4 bindings
     VkDescriptorSetLayoutBinding matBindings[4] = {
@@ -598,18 +1263,13 @@ bool Engine::initGBufferPass() {
     };
     m_materialSetLayout = m_descriptors.getOrCreateLayout(matBindings, 4);
 
-    // Pipeline layout: set 0 = global, set 1 = empty (reserved), set 2 = material
-    VkDescriptorSetLayout emptyLayout;
-    VkDescriptorSetLayoutCreateInfo emptyCI{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
-    emptyCI.bindingCount = 0;
-    VK_CHECK(vkCreateDescriptorSetLayout(device, &emptyCI, nullptr, &emptyLayout));
-
-    VkDescriptorSetLayout setLayouts[] = {m_globalSetLayout, emptyLayout, m_materialSetLayout};
+    // Pipeline layout: set 0 = global, set 1 = virtual texturing, set 2 = material
+    VkDescriptorSetLayout setLayouts[] = {m_globalSetLayout, m_virtualTextures.setLayout(), m_materialSetLayout};
 
     VkPushConstantRange pushRange{};
     pushRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
     pushRange.offset = 0;
-    pushRange.size = sizeof(mat4);
+    pushRange.size = sizeof(MeshPushConstants);
 
     VkPipelineLayoutCreateInfo layoutCI{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
     layoutCI.setLayoutCount = 3;
@@ -618,25 +1278,28 @@ bool Engine::initGBufferPass() {
     layoutCI.pPushConstantRanges = &pushRange;
     VK_CHECK(vkCreatePipelineLayout(device, &layoutCI, nullptr, &m_gbufferPipelineLayout));
 
-    vkDestroyDescriptorSetLayout(device, emptyLayout, nullptr);
-
-    // Build pipeline (2 color attachments + depth)
-    auto binding = Vertex::bindingDesc();
-    auto attrs = Vertex::attributeDescs();
-
-    m_gbufferPipeline = PipelineBuilder()
-        .addShaderStage(m_gbufferVert.stageInfo(VK_SHADER_STAGE_VERTEX_BIT))
-        .addShaderStage(m_gbufferFrag.stageInfo(VK_SHADER_STAGE_FRAGMENT_BIT))
-        .setVertexInput(&binding, 1, attrs.data(), static_cast<uint32_t>(attrs.size()))
-        .setColorFormats({VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R16G16B16A16_SFLOAT})
-        .setColorBlendAttachment(2, false)
-        .setDepthFormat(VK_FORMAT_D32_SFLOAT)
-        .setCullMode(VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
-        .setDepthTest(true, true, VK_COMPARE_OP_GREATER_OR_EQUAL)
-        .setLayout(m_gbufferPipelineLayout)
-        .build(device);
+    // Build pipelines (2 color attachments + depth). Packed formats share one
+    // vertex shader and differ only in the position attribute format / stride.
+    for (uint32_t f = 0; f < VERTEX_FORMAT_COUNT; f++) {
+        auto format = static_cast<VertexFormat>(f);
+        auto binding = VertexPacking::bindingDesc(format);
+        auto attrs = VertexPacking::attributeDescs(format);
+        const ShaderModule& vert = (format == VertexFormat::Standard) ? m_gbufferVert : m_gbufferPackedVert;
+
+        m_gbufferPipelines[f] = PipelineBuilder()
+            .addShaderStage(vert.stageInfo(VK_SHADER_STAGE_VERTEX_BIT))
+            .addShaderStage(m_gbufferFrag.stageInfo(VK_SHADER_STAGE_FRAGMENT_BIT))
+            .setVertexInput(&binding, 1, attrs.data(), static_cast<uint32_t>(attrs.size()))
+            .setColorFormats({VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R16G16B16A16_SFLOAT})
+            .setColorBlendAttachment(2, false)
+            .setDepthFormat(VK_FORMAT_D32_SFLOAT)
+            .setCullMode(VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
+            .setDepthTest(true, true, VK_COMPARE_OP_GREATER_OR_EQUAL)
+            .setLayout(m_gbufferPipelineLayout)
+            .build(device);
+    }
 
-    LOG(Pipeline, Info, "G-Buffer pipeline created");
+    LOG(Pipeline, Info, "G-Buffer pipelines created");
     return true;
 }
 
@@ -958,44 +1621,6 @@ void Engine::initIBL() {
     LOG(Core, Info, "IBL resources initialized");
 }
 
-bool Engine::initSkyboxPass() {
-    VkDevice device = m_vkCtx.device();
-
-    if (!m_skyboxVert.loadFromFile(device, "shaders/deferred/skybox.vert.spv")) return false;
-    if (!m_skyboxFrag.loadFromFile(device, "shaders/deferred/skybox.frag.spv")) return false;
-
-    // Skybox descriptor set layout (set 1): env cubemap
-    VkDescriptorSetLayoutBinding skyboxBinding{};
-    skyboxBinding.binding = 0;
-    skyboxBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    skyboxBinding.descriptorCount = 1;
-    skyboxBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    m_skyboxSetLayout = m_descriptors.getOrCreateLayout(&skyboxBinding, 1);
-    m_skyboxSet = m_descriptors.allocate(m_skyboxSetLayout);
-    DescriptorManager::writeImage(device, m_skyboxSet, 0, m_envCubemap.view(), m_cubemapSampler);
-
-    // Pipeline layout: set 0 = global, set 1 = skybox cubemap
-    VkDescriptorSetLayout setLayouts[] = {m_globalSetLayout, m_skyboxSetLayout};
-
-    VkPipelineLayoutCreateInfo layoutCI{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
-    layoutCI.setLayoutCount = 2;
-    layoutCI.pSetLayouts = setLayouts;
-    VK_CHECK(vkCreatePipelineLayout(device, &layoutCI, nullptr, &m_skyboxPipelineLayout));
-
-    m_skyboxPipeline = PipelineBuilder()
-        .addShaderStage(m_skyboxVert.stageInfo(VK_SHADER_STAGE_VERTEX_BIT))
-        .addShaderStage(m_skyboxFrag.stageInfo(VK_SHADER_STAGE_FRAGMENT_BIT))
-        .setColorFormats({VK_FORMAT_R16G16B16A16_SFLOAT})
-        .setDepthTest(false, false)
-        .setCullMode(VK_CULL_MODE_NONE)
-        .setLayout(m_skyboxPipelineLayout)
-        .build(device);
-
-    LOG(Pipeline, Info, "Skybox pipeline created");
-    return true;
-}
-
 void Engine::createSSAOImages() {
     uint32_t w = m_swapchain.extent().width / 2;
     uint32_t h = m_swapchain.extent().height / 2;
@@ -1101,13 +1726,6 @@ bool Engine::initSSAOPass() {
             noisePixels[i].rg[1] = std::sin(angle);
         }
 
-        Buffer staging;
-        staging.init(m_vkCtx.allocator(), sizeof(noisePixels),
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VMA_MEMORY_USAGE_AUTO,
-            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
-        staging.upload(noisePixels, sizeof(noisePixels));
-
         Image::CreateInfo ci{};
         ci.width = 4;
         ci.height = 4;
@@ -1115,19 +1733,9 @@ bool Engine::initSSAOPass() {
         ci.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
         m_ssaoNoise.init(m_vkCtx.allocator(), device, ci);
 
-        m_cmdPool.submitImmediate(m_vkCtx.graphicsQueue(), [&](VkCommandBuffer cmd) {
-            Image::transitionLayout(cmd, m_ssaoNoise.handle(),
-                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-            VkBufferImageCopy region{};
-            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            region.imageSubresource.layerCount = 1;
-            region.imageExtent = {4, 4, 1};
-            vkCmdCopyBufferToImage(cmd, staging.handle(), m_ssaoNoise.handle(),
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-            Image::transitionLayout(cmd, m_ssaoNoise.handle(),
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-        });
-        staging.shutdown();
+        m_uploads.uploadImage(m_ssaoNoise.handle(), noisePixels, sizeof(noisePixels), 4, 4);
+        Image::transitionLayout(m_uploads.graphicsCommands(), m_ssaoNoise.handle(),
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
     }
 
     // SSAO descriptor set layout (set 1): noise texture + kernel UBO
@@ -1274,7 +1882,7 @@ bool Engine::initBloomPass() {
 bool Engine::initLightingPass() {
     VkDevice device = m_vkCtx.device();
 
-    if (!m_fullscreenVert.loadFromFile(device, "shaders/deferred/fullscreen.vert.spv")) return false;
+    if (!m_tileVert.loadFromFile(device, "shaders/deferred/tile.vert.spv")) return false;
     if (!m_lightingFrag.loadFromFile(device, "shaders/deferred/lighting.frag.spv")) return false;
 
     VkDescriptorSetLayout setLayouts[] = {m_globalSetLayout};
@@ -1282,7 +1890,7 @@ bool Engine::initLightingPass() {
     VkPushConstantRange pushRange{};
     pushRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
     pushRange.offset = 0;
-    pushRange.size = sizeof(uint32_t);
+    pushRange.size = sizeof(uint32_t) * 2; // debugMode + shadowFilter
 
     VkPipelineLayoutCreateInfo layoutCI{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
     layoutCI.setLayoutCount = 1;
@@ -1291,16 +1899,32 @@ bool Engine::initLightingPass() {
     layoutCI.pPushConstantRanges = &pushRange;
     VK_CHECK(vkCreatePipelineLayout(device, &layoutCI, nullptr, &m_lightingPipelineLayout));
 
-    m_lightingPipeline = PipelineBuilder()
-        .addShaderStage(m_fullscreenVert.stageInfo(VK_SHADER_STAGE_VERTEX_BIT))
-        .addShaderStage(m_lightingFrag.stageInfo(VK_SHADER_STAGE_FRAGMENT_BIT))
-        .setColorFormats({VK_FORMAT_R16G16B16A16_SFLOAT})
-        .setDepthTest(false, false)
-        .setCullMode(VK_CULL_MODE_NONE)
-        .setLayout(m_lightingPipelineLayout)
-        .build(device);
+    // One variant per tile class: constant_id 0 (TILE_CLASS) selects both the tile list
+    // tile.vert reads and the shading path lighting.frag compiles down to
+    VkSpecializationMapEntry specEntry{0, 0, sizeof(uint32_t)};
+    for (uint32_t tileClass = 0; tileClass < TILE_CLASS_COUNT; tileClass++) {
+        VkSpecializationInfo specInfo{};
+        specInfo.mapEntryCount = 1;
+        specInfo.pMapEntries = &specEntry;
+        specInfo.dataSize = sizeof(uint32_t);
+        specInfo.pData = &tileClass;
+
+        VkPipelineShaderStageCreateInfo vertStage = m_tileVert.stageInfo(VK_SHADER_STAGE_VERTEX_BIT);
+        VkPipelineShaderStageCreateInfo fragStage = m_lightingFrag.stageInfo(VK_SHADER_STAGE_FRAGMENT_BIT);
+        vertStage.pSpecializationInfo = &specInfo;
+        fragStage.pSpecializationInfo = &specInfo;
+
+        m_lightingPipelines[tileClass] = PipelineBuilder()
+            .addShaderStage(vertStage)
+            .addShaderStage(fragStage)
+            .setColorFormats({VK_FORMAT_R16G16B16A16_SFLOAT})
+            .setDepthTest(false, false)
+            .setCullMode(VK_CULL_MODE_NONE)
+            .setLayout(m_lightingPipelineLayout)
+            .build(device);
+    }
 
-    LOG(Pipeline, Info, "Lighting pipeline created");
+    LOG(Pipeline, Info, "Lighting pipelines created (%u tile classes)", TILE_CLASS_COUNT);
     return true;
 }
 
@@ -1529,10 +2153,108 @@ void Engine::buildImGui() {
             ImGui::SliderFloat("Intensity##ibl", &m_iblIntensityUI, 0.0f, 3.0f, "%.2f");
         }
 
+        if (ImGui::CollapsingHeader("Point Lights")) {
+            ImGui::Text("Lights: %zu (%u visible, buffer %u)", m_scene.pointLights().size(),
+                        m_visiblePointLightCount, m_pointLightCapacity);
+            if (ImGui::SliderInt("Scattered", &m_extraPointLightsUI, 0, 16384))
+                scatterPointLights(static_cast<uint32_t>(m_extraPointLightsUI));
+            ImGui::Checkbox("Shadows##local", &m_localShadowsEnabled);
+            ImGui::SliderInt("Shadow views / frame", &m_localShadowBudgetUI, 1, 48);
+            ImGui::Text("Shadowed: %zu (%zu views rendered, %u waiting)", m_shadowedLights.size(),
+                        m_localShadowRenders.size(), m_localShadowPending);
+        }
+
+        if (ImGui::CollapsingHeader("Shadows")) {
+            int filter = static_cast<int>(m_shadowFilter);
+            const char* filters[] = {"PCF (16 taps)", "EVSM"};
+            ImGui::BeginDisabled(!m_evsmSupported);
+            if (ImGui::Combo("Filter", &filter, filters, 2)) {
+                m_shadowFilter = static_cast<ShadowFilter>(filter);
+                // Moments are only kept up to date while EVSM is on: rebuild every cascade
+                for (auto& cache : m_shadowCache) cache.staticValid = false;
+            }
+            ImGui::EndDisabled();
+            ImGui::Checkbox("Cache cascades", &m_shadowCachingEnabled);
+            ImGui::Checkbox("Spin torus", &m_spinDynamicCaster);
+            ImGui::Checkbox("Fit to visible depth", &m_sdsmEnabled);
+
+            // Atlas layout changes are applied at the start of the next frame
+            int cascadeCount = static_cast<int>(m_shadowSettingsUI.cascadeCount);
+            if (ImGui::SliderInt("Cascades", &cascadeCount, 1, MAX_SHADOW_CASCADES)) {
+                m_shadowSettingsUI.cascadeCount = static_cast<uint32_t>(cascadeCount);
+                m_shadowAtlasDirty = true;
+            }
+            const char* sizes[] = {"256", "512", "1024", "2048", "4096"};
+            for (uint32_t c = 0; c < m_shadowSettingsUI.cascadeCount; c++) {
+                int sizeIndex = static_cast<int>(std::log2(m_shadowSettingsUI.cascadeSize[c] / MIN_SHADOW_CASCADE_SIZE));
+                char label[32];
+                std::snprintf(label, sizeof(label), "Cascade %u size", c);
+                if (ImGui::Combo(label, &sizeIndex, sizes, 5)) {
+                    m_shadowSettingsUI.cascadeSize[c] = MIN_SHADOW_CASCADE_SIZE << sizeIndex;
+                    m_shadowAtlasDirty = true;
+                }
+            }
+            if (ImGui::Checkbox("16-bit depth", &m_shadowSettingsUI.depth16))
+                m_shadowAtlasDirty = true;
+
+            ImGui::Text("Atlas: %ux%u %s", m_shadowAtlasExtent.width, m_shadowAtlasExtent.height,
+                        m_shadowFormat == VK_FORMAT_D16_UNORM ? "D16" : "D32");
+            ImGui::Text("Visible depth: %.2f - %.2f", m_visibleDepthRange.x, m_visibleDepthRange.y);
+            const char* refresh[] = {"cached", "dynamic", "full"};
+            for (uint32_t c = 0; c < m_shadowSettings.cascadeCount; c++) {
+                if (c) ImGui::SameLine();
+                ImGui::Text("%s%s", c ? "/ " : "Refresh: ", refresh[static_cast<int>(m_shadowRefresh[c])]);
+            }
+        }
+
+        if (ImGui::CollapsingHeader("Meshlet Culling")) {
+            ImGui::BeginDisabled(!m_meshletCullPipeline);
+            ImGui::Checkbox("Enable##meshlets", &m_meshletCullingEnabled);
+            ImGui::Checkbox("Normal cones", &m_meshletConeCullingEnabled);
+            ImGui::EndDisabled();
+        }
+
+        if (ImGui::CollapsingHeader("Texture Streaming")) {
+            if (ImGui::SliderInt("Budget (MB)", &m_textureBudgetMB, 16, 4096))
+                m_textureStreamer.setBudget(static_cast<VkDeviceSize>(m_textureBudgetMB) << 20);
+            int mipBias = m_textureStreamer.mipBias();
+            if (ImGui::SliderInt("Mip bias", &mipBias, -2, 4))
+                m_textureStreamer.setMipBias(mipBias);
+            TextureStreamer::Stats stats = m_textureStreamer.stats();
+            ImGui::Text("Resident: %.1f / %.1f MB (%u textures)",
+                stats.residentBytes / (1024.0 * 1024.0), stats.fullBytes / (1024.0 * 1024.0), stats.textures);
+            ImGui::Text("Pending: %u, uploaded %.1f KB this frame", stats.pending, stats.uploadedBytes / 1024.0);
+            ImGui::Text("Mips streamed: %llu, evicted: %llu",
+                static_cast<unsigned long long>(stats.streamedMips), static_cast<unsigned long long>(stats.evictedMips));
+        }
+
+        if (ImGui::CollapsingHeader("Virtual Texturing")) {
+            float lodBias = m_virtualTextures.lodBias();
+            if (ImGui::SliderFloat("LOD bias", &lodBias, -1.0f, 4.0f, "%.1f"))
+                m_virtualTextures.setLodBias(lodBias);
+            VirtualTextureSystem::Stats stats = m_virtualTextures.stats();
+            ImGui::Text("Pages: %u / %u resident (%u textures)", stats.residentPages, stats.cachePages, stats.textures);
+            ImGui::Text("Requested: %u, loading: %u, uploaded this frame: %u",
+                stats.requestedPages, stats.pendingLoads, stats.uploadedPages);
+        }
+
+        if (ImGui::CollapsingHeader("Assets")) {
+            auto row = [](const char* name, const auto& pool) {
+                auto stats = pool.stats();
+                ImGui::Text("%s: %u (%u in use), %.1f / %.0f MB, %llu evicted", name, stats.count, stats.referenced,
+                    stats.residentBytes / (1024.0f * 1024.0f), pool.budget() / (1024.0f * 1024.0f),
+                    static_cast<unsigned long long>(stats.evicted));
+            };
+            row("Meshes", m_assets.meshes());
+            row("Textures", m_assets.textures());
+            row("Materials", m_assets.materials());
+        }
+
         if (ImGui::CollapsingHeader("Debug View")) {
             int mode = static_cast<int>(m_debugMode);
-            const char* modes[] = {"Final", "Albedo", "Metallic", "Roughness", "Normals", "Depth", "SSAO", "Cascades"};
-            if (ImGui::Combo("Mode", &mode, modes, 8)) {
+            const char* modes[] = {"Final", "Albedo", "Metallic", "Roughness", "Normals", "Depth", "SSAO", "Cascades",
+                                   "Light Clusters", "Tile Classes"};
+            if (ImGui::Combo("Mode", &mode, modes, 10)) {
                 m_debugMode = static_cast<DebugMode>(mode);
             }
         }
@@ -1560,7 +2282,6 @@ void Engine::recordImGuiPass(VkCommandBuffer cmd, uint32_t imageIndex) {
 
 void Engine::setupDemoScene() {
     auto alloc = m_vkCtx.allocator();
-    auto queue = m_vkCtx.graphicsQueue();
 
     // Camera
     float aspect = static_cast<float>(m_swapchain.extent().width) / m_swapchain.extent().height;
@@ -1574,13 +2295,14 @@ void Engine::setupDemoScene() {
     light.color = vec3(1.0f, 0.95f, 0.9f);
     light.intensity = 2.0f;
 
-    // Point lights
+    // Shadowed point lights and a spot light
     {
         auto& pl = m_scene.createPointLight();
         pl.position = vec3(3.0f, 2.5f, 2.0f);
         pl.color = vec3(1.0f, 0.3f, 0.1f);
         pl.intensity = 5.0f;
         pl.range = 12.0f;
+        pl.castShadows = true;
     }
     {
         auto& pl = m_scene.createPointLight();
@@ -1588,6 +2310,7 @@ void Engine::setupDemoScene() {
         pl.color = vec3(0.1f, 0.4f, 1.0f);
         pl.intensity = 5.0f;
         pl.range = 12.0f;
+        pl.castShadows = true;
     }
     {
         auto& pl = m_scene.createPointLight();
@@ -1595,6 +2318,7 @@ void Engine::setupDemoScene() {
         pl.color = vec3(0.2f, 1.0f, 0.3f);
         pl.intensity = 4.0f;
         pl.range = 10.0f;
+        pl.castShadows = true;
     }
     {
         auto& pl = m_scene.createPointLight();
@@ -1602,56 +2326,80 @@ void Engine::setupDemoScene() {
         pl.color = vec3(1.0f, 0.8f, 0.2f);
         pl.intensity = 3.0f;
         pl.range = 8.0f;
+        pl.castShadows = true;
+    }
+    {
+        auto& spot = m_scene.createPointLight();
+        spot.type = LocalLightType::Spot;
+        spot.position = vec3(5.0f, 4.0f, -4.0f);
+        spot.direction = glm::normalize(vec3(-0.6f, -1.0f, 0.5f));
+        spot.color = vec3(1.0f, 0.95f, 0.8f);
+        spot.intensity = 8.0f;
+        spot.range = 14.0f;
+        spot.castShadows = true;
     }
 
-    // Generate meshes
-    auto cubeMesh = MeshGenerator::createCube(alloc, queue, m_cmdPool, 1.0f);
-    auto sphereMesh = MeshGenerator::createSphere(alloc, queue, m_cmdPool, 1.0f, 32, 16);
-    auto planeMesh = MeshGenerator::createPlane(alloc, queue, m_cmdPool, 20.0f, 20.0f, 1, 1);
-    auto torusMesh = MeshGenerator::createTorus(alloc, queue, m_cmdPool, 1.0f, 0.35f, 48, 24);
-    auto cylinderMesh = MeshGenerator::createCylinder(alloc, queue, m_cmdPool, 0.5f, 2.0f, 32);
-    auto coneMesh = MeshGenerator::createCone(alloc, queue, m_cmdPool, 0.7f, 1.5f, 32);
-    m_meshes = {cubeMesh, sphereMesh, planeMesh, torusMesh, cylinderMesh, coneMesh};
+    // Generate meshes (16-byte quantized vertices)
+    MeshOptions meshOpts;
+    meshOpts.vertexFormat = VertexFormat::Packed;
+    auto& meshes = m_assets.meshes();
+    MeshHandle cubeMesh = meshes.add(MeshGenerator::createCube(alloc, m_uploads, 1.0f, meshOpts), "generated:cube");
+    MeshHandle sphereMesh = meshes.add(MeshGenerator::createSphere(alloc, m_uploads, 1.0f, 32, 16, meshOpts), "generated:sphere");
+    MeshHandle planeMesh = meshes.add(MeshGenerator::createPlane(alloc, m_uploads, 20.0f, 20.0f, 1, 1, meshOpts), "generated:plane");
+    MeshHandle torusMesh = meshes.add(MeshGenerator::createTorus(alloc, m_uploads, 1.0f, 0.35f, 48, 24, meshOpts), "generated:torus");
+    MeshHandle cylinderMesh = meshes.add(MeshGenerator::createCylinder(alloc, m_uploads, 0.5f, 2.0f, 32, meshOpts), "generated:cylinder");
+    MeshHandle coneMesh = meshes.add(MeshGenerator::createCone(alloc, m_uploads, 0.7f, 1.5f, 32, meshOpts), "generated:cone");
 
     // Create textures
-    auto whiteTex = TextureLoader::createSolidColor(m_vkCtx, m_cmdPool, vec4(1, 1, 1, 1));
-    auto checkerTex = TextureLoader::createCheckerboard(m_vkCtx, m_cmdPool, 512, 32);
+    auto whiteTex = TextureLoader::createSolidColor(m_vkCtx, m_uploads, vec4(1, 1, 1, 1));
+    auto checkerTex = TextureLoader::createCheckerboard(m_vkCtx, m_uploads, 512, 32);
 
-    auto flatNormalTex = TextureLoader::createSolidColor(m_vkCtx, m_cmdPool,
+    auto flatNormalTex = TextureLoader::createSolidColor(m_vkCtx, m_uploads,
         vec4(128.0f/255.0f, 128.0f/255.0f, 1.0f, 1.0f), false);
 
-    auto defaultMRTex = TextureLoader::createSolidColor(m_vkCtx, m_cmdPool,
+    auto defaultMRTex = TextureLoader::createSolidColor(m_vkCtx, m_uploads,
         vec4(1, 1, 1, 1), false);
 
-    auto brickNormalTex = createBrickNormalMap(m_vkCtx, m_cmdPool);
+    auto brickNormalTex = m_textureStreamer.add(cookBrickNormalMap(m_vkCtx), "brick normal map");
 
-    auto roughPlasticMR = TextureLoader::createSolidColor(m_vkCtx, m_cmdPool,
+    auto roughPlasticMR = TextureLoader::createSolidColor(m_vkCtx, m_uploads,
         vec4(0, 1, 0, 1), false);
-    auto polishedMetalMR = TextureLoader::createSolidColor(m_vkCtx, m_cmdPool,
+    auto polishedMetalMR = TextureLoader::createSolidColor(m_vkCtx, m_uploads,
         vec4(0, 0.15f, 1, 1), false);
-    auto brushedMetalMR = TextureLoader::createSolidColor(m_vkCtx, m_cmdPool,
+    auto brushedMetalMR = TextureLoader::createSolidColor(m_vkCtx, m_uploads,
         vec4(0, 0.4f, 1, 1), false);
 
-    m_textures = {whiteTex, checkerTex, flatNormalTex, defaultMRTex,
-                  brickNormalTex, roughPlasticMR, polishedMetalMR, brushedMetalMR};
+    // Materials hold these, so they stay referenced for as long as a material uses them
+    auto& textures = m_assets.textures();
+    textures.add(whiteTex, "generated:white");
+    textures.add(checkerTex, "generated:checker");
+    textures.add(flatNormalTex, "generated:flat normal");
+    textures.add(defaultMRTex, "generated:default metal-rough");
+    textures.add(brickNormalTex, "generated:brick normal");
+    textures.add(roughPlasticMR, "generated:rough plastic metal-rough");
+    textures.add(polishedMetalMR, "generated:polished metal metal-rough");
+    textures.add(brushedMetalMR, "generated:brushed metal metal-rough");
 
     auto makeMat = [&](std::shared_ptr<Texture> albedo,
                        std::shared_ptr<Texture> normal,
                        std::shared_ptr<Texture> mr,
-                       const vec4& color, float metal, float rough, float normScale = 1.0f) {
+                       const vec4& color, float metal, float rough, float normScale = 1.0f,
+                       int32_t virtualTexture = -1) {
         MaterialParams p;
         p.albedoColor = color;
         p.metallic = metal;
         p.roughness = rough;
         p.normalScale = normScale;
+        p.virtualTexture = virtualTexture;
         auto mat = std::make_shared<Material>();
         mat->init(m_vkCtx, m_descriptors, m_materialSetLayout, albedo, normal, mr, p);
-        m_materials.push_back(mat);
-        return mat;
+        return m_assets.materials().add(std::move(mat), "");
     };
 
+    // The ground's albedo is a 7680^2 virtual texture; checkerTex stays bound but unused
+    int32_t terrainVT = m_virtualTextures.add("terrain albedo", 64, terrainAlbedoSource(64));
     auto groundMat = makeMat(checkerTex, brickNormalTex, defaultMRTex,
-        vec4(1, 1, 1, 1), 0.0f, 0.8f, 1.0f);
+        vec4(1, 1, 1, 1), 0.0f, 0.8f, 1.0f, terrainVT);
     auto redMat = makeMat(whiteTex, flatNormalTex, roughPlasticMR,
         vec4(0.9f, 0.15f, 0.1f, 1), 0.0f, 0.7f);
     auto blueMat = makeMat(whiteTex, flatNormalTex, defaultMRTex,
@@ -1682,6 +2430,8 @@ void Engine::setupDemoScene() {
     torus.transform.position = {3.0f, 1.0f, 0.0f};
     torus.mesh = torusMesh;
     torus.material = goldMat;
+    torus.dynamic = true; // spun from the UI, redrawn over the cached static shadows
+    m_dynamicDemoEntity = m_scene.entities().size() - 1;
 
     auto& cyl = m_scene.createEntity("Cylinder");
     cyl.transform.position = {-1.5f, 1.0f, -3.0f};
@@ -1749,72 +2499,853 @@ void Engine::setupDemoScene() {
     lyingCyl.mesh = cylinderMesh;
     lyingCyl.material = greenMat;
 
-    LOG(Scene, Info, "Demo scene: %zu entities, %zu meshes, %zu materials, %zu point lights",
-        m_scene.entities().size(), m_meshes.size(), m_materials.size(),
+    m_demoPointLightCount = static_cast<uint32_t>(m_scene.pointLights().size());
+
+    LOG(Scene, Info, "Demo scene: %zu entities, %u meshes, %u materials, %zu point lights",
+        m_scene.entities().size(), m_assets.meshes().stats().count, m_assets.materials().stats().count,
         m_scene.pointLights().size());
 }
 
-void Engine::recordShadowPass(VkCommandBuffer cmd) {
-    // Transition shadow map to depth attachment
-    Image::transitionLayout(cmd, m_shadowMap.handle(),
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-        VK_IMAGE_ASPECT_DEPTH_BIT, 1, SHADOW_CASCADE_COUNT);
+// Stress-test lights over the ground plane. Halton points keep the existing lights in place
+// when the count changes, so only newly added lights are marked dirty.
+void Engine::scatterPointLights(uint32_t count) {
+    uint32_t existing = static_cast<uint32_t>(m_scene.pointLights().size()) - m_demoPointLightCount;
+    m_scene.resizePointLights(m_demoPointLightCount + count);
+    for (uint32_t i = existing; i < count; i++) {
+        int idx = static_cast<int>(i) + 1;
+        float hue = halton(idx, 7) * 6.0f;
+
+        PointLight pl;
+        pl.position = vec3((halton(idx, 2) - 0.5f) * 20.0f, 0.3f + halton(idx, 5) * 2.0f,
+                           (halton(idx, 3) - 0.5f) * 20.0f);
+        pl.color = glm::clamp(vec3(std::abs(hue - 3.0f) - 1.0f, 2.0f - std::abs(hue - 2.0f),
+                                   2.0f - std::abs(hue - 4.0f)), 0.0f, 1.0f);
+        pl.intensity = 2.0f;
+        pl.range = 1.5f + halton(idx, 11) * 1.5f;
+        m_scene.editPointLight(m_demoPointLightCount + i) = pl;
+    }
+}
 
-    VkViewport viewport{};
-    viewport.x = 0;
-    viewport.y = 0;
-    viewport.width = static_cast<float>(SHADOW_MAP_SIZE);
-    viewport.height = static_cast<float>(SHADOW_MAP_SIZE);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
+// Replaces the point light SSBO with one of at least lightCount entries (doubling) and
+// re-uploads every light. Growth is rare, so it waits for the device to go idle rather
+// than deferring the old buffer's destruction and the descriptor rewrite.
+bool Engine::growPointLightBuffer(uint32_t lightCount) {
+    uint32_t capacity = std::max(m_pointLightCapacity, INITIAL_POINT_LIGHT_CAPACITY);
+    while (capacity < lightCount) capacity *= 2;
+
+    if (m_pointLightBuffer.handle()) m_vkCtx.waitIdle();
+    m_pointLightBuffer.shutdown();
+    VkDeviceSize size = sizeof(GPUPointLight) * capacity;
+    if (!m_pointLightBuffer.init(m_vkCtx.allocator(), size,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)) {
+        m_pointLightCapacity = 0;
+        return false;
+    }
+    m_pointLightCapacity = capacity;
+    DescriptorManager::writeBuffer(m_vkCtx.device(), m_globalSet, 1, m_pointLightBuffer.handle(), size,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
 
-    VkRect2D scissor{{0, 0}, {SHADOW_MAP_SIZE, SHADOW_MAP_SIZE}};
+    m_dirtyPointLights.clear();
+    uint32_t existing = static_cast<uint32_t>(m_scene.pointLights().size());
+    if (existing > 0) m_dirtyPointLights.push_back({0, existing});
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_shadowPipeline);
-    vkCmdSetViewport(cmd, 0, 1, &viewport);
-    vkCmdSetScissor(cmd, 0, 1, &scissor);
-    vkCmdSetDepthBias(cmd, 4.0f, 0.0f, 1.5f);
+    LOG(Memory, Debug, "Point light buffer: %u lights (%llu KB)", capacity,
+        (unsigned long long)(size / 1024));
+    return true;
+}
 
-    for (uint32_t c = 0; c < SHADOW_CASCADE_COUNT; c++) {
-        VkRenderingAttachmentInfo depthAttach{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
-        depthAttach.imageView = m_shadowLayerViews[c];
-        depthAttach.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-        depthAttach.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttach.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        depthAttach.clearValue.depthStencil = {1.0f, 0};
+// Uploads the lights changed since last frame and writes this frame's camera-visible,
+// compacted light list. Returns the number of visible lights.
+uint32_t Engine::updatePointLights(const mat4& cameraViewProj) {
+    const auto& lights = m_scene.pointLights();
+    uint32_t lightCount = static_cast<uint32_t>(lights.size());
 
-        VkRenderingInfo renderInfo{VK_STRUCTURE_TYPE_RENDERING_INFO};
-        renderInfo.renderArea = {{0, 0}, {SHADOW_MAP_SIZE, SHADOW_MAP_SIZE}};
-        renderInfo.layerCount = 1;
-        renderInfo.pDepthAttachment = &depthAttach;
+    m_scene.takeDirtyPointLights(m_dirtyPointLights);
+    if (lightCount > m_pointLightCapacity && !growPointLightBuffer(lightCount)) {
+        m_dirtyPointLights.clear();
+        return 0;
+    }
 
-        vkCmdBeginRendering(cmd, &renderInfo);
+    // The previous frame's fence has been waited on, so ranges are overwritten in place
+    for (const PointLightRange& range : m_dirtyPointLights) {
+        VkDeviceSize size = sizeof(GPUPointLight) * range.count;
+        StagingAllocation staging = m_uploads.allocateStaging(size);
+        GPUPointLight* dst = static_cast<GPUPointLight*>(staging.data);
+        for (uint32_t i = 0; i < range.count; i++) {
+            const PointLight& light = lights[range.first + i];
+            uint32_t lightIndex = range.first + i;
+            bool spot = light.type == LocalLightType::Spot;
+            dst[i].positionAndRange = vec4(light.position, light.range);
+            dst[i].colorAndIntensity = vec4(light.color, light.intensity);
+            dst[i].spotDirAndCosOuter = spot ? vec4(glm::normalize(light.direction), std::cos(light.outerAngle))
+                                             : vec4(0.0f, 0.0f, 0.0f, -1.0f);
+            dst[i].spotCosInner = spot ? std::cos(light.innerAngle) : -1.0f;
+            dst[i].shadowSlot = lightIndex < m_localShadows.size() ? m_localShadows[lightIndex].gpuSlot : UINT32_MAX;
+            dst[i].padding[0] = dst[i].padding[1] = 0;
+        }
+        m_uploads.copyToBuffer(staging, m_pointLightBuffer.handle(),
+            sizeof(GPUPointLight) * range.first, size);
+    }
+    m_dirtyPointLights.clear();
+
+    // Frustum-cull light spheres; the binding covers MAX_VISIBLE_POINT_LIGHTS indices
+    vec4 planes[6];
+    extractFrustumPlanes(cameraViewProj, planes);
+    uint32_t maxVisible = std::min(lightCount, MAX_VISIBLE_POINT_LIGHTS);
+    uint32_t* visible = m_frameAlloc.allocate<uint32_t>(std::max(maxVisible, 1u), m_globalOffsets[1]);
+    uint32_t visibleCount = 0;
+    if (!visible) return 0;
+    for (uint32_t i = 0; i < lightCount && visibleCount < maxVisible; i++) {
+        vec4 center(lights[i].position, 1.0f);
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p++)
+            inside = glm::dot(planes[p], center) >= -lights[i].range;
+        if (inside) visible[visibleCount++] = i;
+    }
+    return visibleCount;
+}
 
-        for (const auto& entity : m_scene.entities()) {
-            if (!entity.mesh) continue;
+// Point lights look down the major axes (+X, -X, +Y, -Y, +Z, -Z, the face order of
+// sampleLocalShadow in lighting.frag) with a 90 degree frustum; spot lights cover their cone.
+mat4 Engine::localShadowViewProj(const PointLight& light, uint32_t face) const {
+    static const vec3 faceDirs[LOCAL_SHADOW_FACES] = {
+        {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    static const vec3 faceUps[LOCAL_SHADOW_FACES] = {
+        {0, -1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {0, -1, 0}, {0, -1, 0}};
+
+    float nearPlane = std::max(light.range * 0.01f, 0.02f);
+    if (light.type == LocalLightType::Spot) {
+        vec3 dir = glm::normalize(light.direction);
+        vec3 up = (std::abs(dir.y) > 0.99f) ? vec3(0, 0, 1) : vec3(0, 1, 0);
+        return glm::perspective(2.0f * light.outerAngle, 1.0f, nearPlane, light.range) *
+               glm::lookAt(light.position, light.position + dir, up);
+    }
+    return glm::perspective(HALF_PI, 1.0f, nearPlane, light.range) *
+           glm::lookAt(light.position, light.position + faceDirs[face], faceUps[face]);
+}
 
-            mat4 model = entity.transform.modelMatrix();
-            mat4 mvp = m_cascadeVP[c] * model;
+// Takes tileCount tiles of tileClass (and a view slot if the light has none) for a light,
+// evicting the least recently used lights that were not needed this frame. The light's
+// previous tiles are only given up once the new ones are secured.
+bool Engine::allocateLocalShadow(uint32_t lightIndex, uint32_t tileClass, uint32_t tileCount) {
+    LocalShadowPool& pool = m_localShadowPools[tileClass];
+    LocalShadow& shadow = m_localShadows[lightIndex];
+    auto freeTiles = [&] {
+        return static_cast<uint32_t>(std::count(pool.owner.begin(), pool.owner.end(), UINT32_MAX));
+    };
+
+    for (;;) {
+        bool needTiles = freeTiles() < tileCount;
+        bool needSlot = shadow.slot == UINT32_MAX && m_freeLocalShadowSlots.empty();
+        if (!needTiles && !needSlot) break;
+
+        uint32_t victim = UINT32_MAX;
+        uint64_t oldest = m_localShadowClock;
+        for (uint32_t other : m_shadowedLights) {
+            const LocalShadow& candidate = m_localShadows[other];
+            if (candidate.lastUsed >= oldest) continue; // needed this frame
+            if (needTiles && candidate.tileClass != tileClass) continue;
+            oldest = candidate.lastUsed;
+            victim = other;
+        }
+        if (victim == UINT32_MAX) return false;
+        releaseLocalShadow(victim);
+    }
+
+    if (shadow.slot == UINT32_MAX) {
+        shadow.slot = m_freeLocalShadowSlots.back();
+        m_freeLocalShadowSlots.pop_back();
+        m_shadowedLights.push_back(lightIndex);
+    } else {
+        for (uint32_t t = 0; t < shadow.tileCount; t++)
+            m_localShadowPools[shadow.tileClass].owner[shadow.tiles[t]] = UINT32_MAX;
+    }
+    shadow.tileClass = tileClass;
+    shadow.tileCount = tileCount;
+    for (uint32_t tile = 0, assigned = 0; assigned < tileCount; tile++) {
+        if (pool.owner[tile] != UINT32_MAX) continue;
+        pool.owner[tile] = lightIndex;
+        shadow.tiles[assigned++] = tile;
+    }
+    shadow.rendered = false;
+    return true;
+}
+
+void Engine::releaseLocalShadow(uint32_t lightIndex) {
+    LocalShadow& shadow = m_localShadows[lightIndex];
+    if (shadow.slot == UINT32_MAX) return;
+    for (uint32_t t = 0; t < shadow.tileCount; t++)
+        m_localShadowPools[shadow.tileClass].owner[shadow.tiles[t]] = UINT32_MAX;
+    m_freeLocalShadowSlots.push_back(shadow.slot);
+    m_shadowedLights.erase(std::find(m_shadowedLights.begin(), m_shadowedLights.end(), lightIndex));
+
+    // The light goes back to unshadowed; removed lights are no longer uploaded
+    if (shadow.gpuSlot != UINT32_MAX && lightIndex < m_scene.pointLights().size())
+        m_dirtyPointLights.push_back({lightIndex, 1});
+    shadow = {};
+}
+
+// Assigns atlas tiles to the visible shadow-casting lights and schedules this frame's
+// re-renders. Lights are ranked by the screen radius of their range sphere, which picks
+// their tile size; when a pool is full the least recently used lights are evicted, and
+// lights that still find no tiles stay unshadowed. Tiles are only re-rendered when the
+// light changed, static geometry changed or a moved dynamic caster overlaps the light,
+// at most m_localShadowBudgetUI views per frame (never-rendered lights first, then by rank).
+void Engine::updateLocalShadows(const mat4& cameraViewProj) {
+    const auto& lights = m_scene.pointLights();
+    const uint32_t lightCount = static_cast<uint32_t>(lights.size());
+    m_localShadowRenders.clear();
+
+    // Lights that were removed or stopped casting give their tiles back
+    for (size_t i = m_shadowedLights.size(); i-- > 0;) {
+        uint32_t light = m_shadowedLights[i];
+        if (light >= lightCount || !lights[light].castShadows || !m_localShadowsEnabled)
+            releaseLocalShadow(light);
+    }
+    m_localShadows.resize(lightCount);
+    if (!m_localShadowsEnabled) return;
+    // Not m_frameCount: a resize resets that, which would leave every held light "newer"
+    // than the current frame and so never evicted
+    m_localShadowClock++;
+
+    struct Candidate {
+        uint32_t light;
+        float radiusPixels;
+    };
+    std::vector<Candidate> candidates;
+    vec4 planes[6];
+    extractFrustumPlanes(cameraViewProj, planes);
+    const Camera& camera = m_scene.camera();
+    const float pixelScale = camera.projectionMatrix()[1][1] * 0.5f * static_cast<float>(m_swapchain.extent().height);
+    for (uint32_t i = 0; i < lightCount; i++) {
+        const PointLight& light = lights[i];
+        if (!light.castShadows) continue;
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p++)
+            inside = glm::dot(planes[p], vec4(light.position, 1.0f)) >= -light.range;
+        if (!inside) continue;
+
+        float dist = glm::length(light.position - camera.position());
+        float radiusPixels = dist > light.range
+            ? light.range / std::sqrt(dist * dist - light.range * light.range) * pixelScale
+            : std::numeric_limits<float>::max();
+        candidates.push_back({i, radiusPixels});
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.radiusPixels > b.radiusPixels; });
+
+    const uint64_t staticVersion = m_scene.staticGeometryVersion();
+    for (const Candidate& candidate : candidates) {
+        const PointLight& light = lights[candidate.light];
+        LocalShadow& shadow = m_localShadows[candidate.light];
+        shadow.lastUsed = m_localShadowClock;
+
+        // Largest tile not above the sphere's screen radius; a held tile size is kept until
+        // the light shrinks to half of it, so lights near a threshold do not flip-flop
+        uint32_t wanted = 0;
+        while (wanted + 1 < LOCAL_SHADOW_TILE_CLASSES && LOCAL_SHADOW_TILE_SIZES[wanted] > candidate.radiusPixels)
+            wanted++;
+        uint32_t tileCount = light.type == LocalLightType::Spot ? 1 : LOCAL_SHADOW_FACES;
+        bool held = shadow.slot != UINT32_MAX && shadow.tileCount == tileCount;
+        if (held && shadow.tileClass < wanted &&
+            candidate.radiusPixels * 2.0f >= LOCAL_SHADOW_TILE_SIZES[shadow.tileClass])
+            wanted = shadow.tileClass;
+        if (!held || shadow.tileClass != wanted) {
+            // Fall back to smaller tiles. A light that already holds tiles only trades them
+            // for larger ones, or for the wanted smaller size; otherwise it keeps them.
+            for (uint32_t c = wanted; c < LOCAL_SHADOW_TILE_CLASSES; c++) {
+                if (held && c == shadow.tileClass) break;
+                if (allocateLocalShadow(candidate.light, c, tileCount)) break;
+                if (held && c > shadow.tileClass) break;
+            }
+        }
+        if (shadow.slot == UINT32_MAX || shadow.tileCount != tileCount) continue;
+
+        const PointLight& rendered = shadow.renderedLight;
+        if (!shadow.rendered || shadow.staticVersion != staticVersion ||
+            rendered.type != light.type || rendered.position != light.position ||
+            rendered.range != light.range || rendered.direction != light.direction ||
+            rendered.outerAngle != light.outerAngle)
+            shadow.dirty = true;
+        for (const vec4& sphere : m_movedCasterSpheres) {
+            if (glm::length(vec3(sphere) - light.position) < sphere.w + light.range)
+                shadow.dirty = true;
+        }
+    }
+
+    // Spend the budget: lights without any shadow yet first, then stale ones, by rank
+    uint32_t budget = static_cast<uint32_t>(m_localShadowBudgetUI);
+    m_localShadowPending = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        for (const Candidate& candidate : candidates) {
+            LocalShadow& shadow = m_localShadows[candidate.light];
+            if (shadow.slot == UINT32_MAX || !shadow.dirty || shadow.rendered != (pass == 1)) continue;
+            if (shadow.tileCount > budget) {
+                m_localShadowPending += shadow.tileCount;
+                continue;
+            }
+            budget -= shadow.tileCount;
+
+            const PointLight& light = lights[candidate.light];
+            const LocalShadowPool& pool = m_localShadowPools[shadow.tileClass];
+            for (uint32_t face = 0; face < shadow.tileCount; face++) {
+                uint32_t tile = shadow.tiles[face];
+                LocalShadowRender render;
+                render.view = shadow.slot * LOCAL_SHADOW_FACES + face;
+                render.tile.offset = {int32_t(tile % pool.columns * pool.tileSize),
+                                      int32_t(pool.originY + tile / pool.columns * pool.tileSize)};
+                render.tile.extent = {pool.tileSize, pool.tileSize};
+                render.data.viewProj = localShadowViewProj(light, face);
+                render.data.atlasRect = vec4(render.tile.offset.x, render.tile.offset.y,
+                                             pool.tileSize, pool.tileSize) / float(LOCAL_SHADOW_ATLAS_SIZE);
+                m_localShadowRenders.push_back(render);
+            }
+            shadow.renderedLight = light;
+            shadow.staticVersion = staticVersion;
+            shadow.rendered = true;
+            shadow.dirty = false;
+        }
+    }
+
+    // Lights whose shadow became usable or went away are re-uploaded with their new slot
+    for (uint32_t lightIndex : m_shadowedLights) {
+        LocalShadow& shadow = m_localShadows[lightIndex];
+        uint32_t gpuSlot = shadow.rendered ? shadow.slot : UINT32_MAX;
+        if (gpuSlot != shadow.gpuSlot) {
+            shadow.gpuSlot = gpuSlot;
+            m_dirtyPointLights.push_back({lightIndex, 1});
+        }
+    }
+}
+
+void Engine::updateMeshletCulling(const mat4& cameraViewProj) {
+    const auto& entities = m_scene.entities();
+    m_entityCullObject.assign(entities.size(), UINT32_MAX);
+    m_cullDrawOffsets.clear();
+    m_cullObjectCount = 0;
+    if (!m_meshletCullingEnabled || !m_meshletCullPipeline) return;
+
+    // Count first so the objects can be written straight into the frame allocator
+    uint32_t objectCount = 0;
+    uint32_t drawCount = 0;
+    for (const auto& entity : entities) {
+        const Mesh* mesh = m_assets.meshes().get(entity.mesh);
+        if (!mesh || !mesh->hasMeshlets()) continue;
+        objectCount++;
+        drawCount += mesh->meshletCount();
+    }
+    if (objectCount == 0) return;
+
+    // Grow this frame's buffers. Its previous submission finished at the fence wait, so
+    // the old buffers and the descriptor set are no longer in use.
+    VkDevice device = m_vkCtx.device();
+    auto& cull = m_meshletCull[m_frameSync.currentFrame()];
+    if (objectCount > cull.objectCapacity) {
+        cull.objectCapacity = std::max({objectCount, cull.objectCapacity * 2, 64u});
+        VkDeviceSize objectsSize = sizeof(GPUCullObject) * cull.objectCapacity;
+        VkDeviceSize countsSize = sizeof(uint32_t) * CULL_VIEW_COUNT * cull.objectCapacity;
+
+        cull.counts.shutdown();
+        cull.counts.init(m_vkCtx.allocator(), countsSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+
+        DescriptorManager::writeBuffer(device, cull.set, 1, m_frameAlloc.buffer(), objectsSize,
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC);
+        DescriptorManager::writeBuffer(device, cull.set, 3, cull.counts.handle(), countsSize,
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    }
+    if (drawCount > cull.drawCapacity) {
+        cull.drawCapacity = std::max({drawCount, cull.drawCapacity * 2, 1024u});
+        VkDeviceSize drawsSize = sizeof(VkDrawIndexedIndirectCommand) * CULL_VIEW_COUNT * cull.drawCapacity;
+
+        cull.draws.shutdown();
+        cull.draws.init(m_vkCtx.allocator(), drawsSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE);
+
+        DescriptorManager::writeBuffer(device, cull.set, 2, cull.draws.handle(), drawsSize,
+            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+    }
+
+    // The objects binding spans objectCapacity entries, so the whole range is reserved.
+    // Out of frame memory: every entity falls back to direct draws this frame.
+    auto* gpuViews = m_frameAlloc.allocate<GPUCullView>(CULL_VIEW_COUNT, cull.dynamicOffsets[0]);
+    auto* objects = m_frameAlloc.allocate<GPUCullObject>(cull.objectCapacity, cull.dynamicOffsets[1]);
+    if (!gpuViews || !objects) return;
+
+    // Each object is assembled on the stack and stored whole, never read back from the mapping
+    uint32_t objectIndex = 0;
+    uint32_t drawOffset = 0;
+    for (size_t i = 0; i < entities.size(); i++) {
+        const auto& entity = entities[i];
+        const Mesh* mesh = m_assets.meshes().get(entity.mesh);
+        if (!mesh || !mesh->hasMeshlets()) continue;
+
+        const vec3& scale = entity.transform.scale;
+        GPUCullObject object{};
+        object.model = entity.transform.modelMatrix();
+        object.meshlets = mesh->meshletAddress();
+        object.meshletCount = mesh->meshletCount();
+        object.drawOffset = drawOffset;
+        object.radiusScale = std::max({std::abs(scale.x), std::abs(scale.y), std::abs(scale.z)});
+        // Normal cones only survive rotation + positive uniform scale
+        float tolerance = 1e-4f * object.radiusScale;
+        bool uniform = std::abs(scale.x - scale.y) <= tolerance && std::abs(scale.x - scale.z) <= tolerance;
+        object.coneCulling = (uniform && scale.x > 0.0f) ? 1u : 0u;
+
+        m_entityCullObject[i] = objectIndex;
+        m_cullDrawOffsets.push_back(drawOffset);
+        objects[objectIndex++] = object;
+        drawOffset += object.meshletCount;
+    }
+
+    GPUCullView views[CULL_VIEW_COUNT]{};
+
+    // Camera: the Y-flipped G-buffer viewport keeps CCW front faces, so back faces are culled
+    extractFrustumPlanes(cameraViewProj, views[CULL_VIEW_CAMERA].frustumPlanes);
+    views[CULL_VIEW_CAMERA].origin = vec4(m_scene.camera().position(), 1.0f);
+    views[CULL_VIEW_CAMERA].direction = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // Cascades render without the flip: the rasterizer drops the light-facing side, so
+    // meshlets facing the light entirely are the ones that produce no shadow texels
+    vec3 lightDir = glm::normalize(m_scene.directionalLight().direction);
+    for (uint32_t c = 0; c < m_shadowSettings.cascadeCount; c++) {
+        extractFrustumPlanes(m_cascadeVP[c], views[1 + c].frustumPlanes);
+        views[1 + c].origin = vec4(0.0f);
+        views[1 + c].direction = vec4(lightDir, -1.0f);
+    }
+    std::memcpy(gpuViews, views, sizeof(views));
+
+    m_cullObjectCount = objectCount;
+}
+
+// CPU streaming feedback: every visible entity asks for the mips its material textures can
+// show at its closest point, from the projected texel density of its mesh. Runs after the
+// fence wait, so swapped images and rewritten material sets are not in use.
+void Engine::updateTextureStreaming(const mat4& cameraViewProj) {
+    vec4 planes[6];
+    extractFrustumPlanes(cameraViewProj, planes);
+    const Camera& camera = m_scene.camera();
+    // Pixels covered by one world unit at distance 1
+    const float pixelScale = camera.projectionMatrix()[1][1] * 0.5f * static_cast<float>(m_swapchain.extent().height);
+
+    for (const auto& entity : m_scene.entities()) {
+        const Mesh* mesh = m_assets.meshes().get(entity.mesh);
+        const Material* material = m_assets.materials().get(entity.material);
+        if (!mesh || !material) continue;
+        mat4 model = entity.transform.modelMatrix();
+        vec4 sphere = boundingSphere(mesh->bounds(), model);
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p++)
+            inside = glm::dot(planes[p], vec4(vec3(sphere), 1.0f)) >= -sphere.w;
+        if (!inside) continue;
+
+        // Meshes without a cooked density are assumed to span their texture once
+        float scale = std::max({glm::length(vec3(model[0])), glm::length(vec3(model[1])), glm::length(vec3(model[2]))});
+        float uvPerUnit = mesh->uvDensity() > 0.0f ? mesh->uvDensity() / scale
+                                                  : 0.5f / std::max(sphere.w, 1e-4f);
+        float dist = std::max(glm::length(vec3(sphere) - camera.position()) - sphere.w, camera.nearPlane());
+        float uvPerPixel = uvPerUnit * dist / pixelScale;
+
+        m_textureStreamer.request(material->albedoTexture().get(), uvPerPixel);
+        m_textureStreamer.request(material->normalTexture().get(), uvPerPixel);
+        m_textureStreamer.request(material->metalRoughTexture().get(), uvPerPixel);
+    }
+
+    m_textureStreamer.update();
+    VkDevice device = m_vkCtx.device();
+    m_assets.materials().forEach([device](Material& material) { material.refreshTextures(device); });
+}
+
+void Engine::recordMeshletCullPass(VkCommandBuffer cmd) {
+    if (m_cullObjectCount == 0) return;
+
+    auto& cull = m_meshletCull[m_frameSync.currentFrame()];
+
+    vkCmdFillBuffer(cmd, cull.counts.handle(), 0, VK_WHOLE_SIZE, 0);
+    memoryBarrier(cmd,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    MeshletCullPushConstants pc{};
+    pc.objectCount = m_cullObjectCount;
+    pc.objectStride = cull.objectCapacity;
+    pc.drawStride = cull.drawCapacity;
+    pc.flags = 1u | (m_meshletConeCullingEnabled ? 2u : 0u);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_meshletCullPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+        m_meshletCullPipelineLayout, 0, 1, &cull.set, 2, cull.dynamicOffsets);
+    vkCmdPushConstants(cmd, m_meshletCullPipelineLayout,
+        VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+    vkCmdDispatch(cmd, m_cullObjectCount, 1 + m_shadowSettings.cascadeCount, 1);
+
+    memoryBarrier(cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT);
+}
+
+void Engine::recordLightClusterPass(VkCommandBuffer cmd) {
+    // The previous frame's tile classification and lighting pass may still be reading the
+    // lists (execution dependency only)
+    memoryBarrier(cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_NONE);
+    vkCmdFillBuffer(cmd, m_clusterLightIndices.handle(), 0, sizeof(uint32_t), 0);
+    memoryBarrier(cmd,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_lightClusterPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+        m_lightClusterPipelineLayout, 0, 1, &m_globalSet, 2, m_globalOffsets);
+    vkCmdDispatch(cmd, CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z);
+
+    memoryBarrier(cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+        VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+}
+
+void Engine::drawEntityMesh(VkCommandBuffer cmd, size_t entityIndex, uint32_t cullView) {
+    const Mesh& mesh = *m_assets.meshes().get(m_scene.entities()[entityIndex].mesh);
+    uint32_t object = entityIndex < m_entityCullObject.size() ? m_entityCullObject[entityIndex] : UINT32_MAX;
+
+    if (object == UINT32_MAX) {
+        for (const auto& sm : mesh.submeshes())
+            vkCmdDrawIndexed(cmd, sm.indexCount, 1, sm.firstIndex, sm.vertexOffset, 0);
+        return;
+    }
+
+    // Surviving meshlets of this object, compacted by meshlet_cull.comp
+    const auto& cull = m_meshletCull[m_frameSync.currentFrame()];
+    VkDeviceSize drawOffset = (static_cast<VkDeviceSize>(cullView) * cull.drawCapacity + m_cullDrawOffsets[object]) *
+                              sizeof(VkDrawIndexedIndirectCommand);
+    VkDeviceSize countOffset = (static_cast<VkDeviceSize>(cullView) * cull.objectCapacity + object) * sizeof(uint32_t);
+    vkCmdDrawIndexedIndirectCount(cmd, cull.draws.handle(), drawOffset, cull.counts.handle(), countOffset,
+        mesh.meshletCount(), sizeof(VkDrawIndexedIndirectCommand));
+}
+
+// Draws the static or dynamic casters into every cascade of cascadeMask: one pass over the
+// casters with instance i routed to viewport i, or a pass per cascade without viewport
+// index output. Regions in clearMask are cleared first; the others keep their contents
+// (LOAD, and shadow.vert drops instances of cascades outside the mask).
+void Engine::recordShadowCasters(VkCommandBuffer cmd, VkImageView target, uint32_t cascadeMask,
+                                 uint32_t clearMask, bool dynamicCasters) {
+    const bool singlePass = m_vkCtx.features().shaderOutputViewportIndex;
+    const uint32_t cascadeCount = m_shadowSettings.cascadeCount;
+
+    VkRenderingAttachmentInfo depthAttach{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+    depthAttach.imageView = target;
+    depthAttach.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthAttach.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    depthAttach.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+    VkRenderingInfo renderInfo{VK_STRUCTURE_TYPE_RENDERING_INFO};
+    renderInfo.renderArea = {{0, 0}, m_shadowAtlasExtent};
+    renderInfo.layerCount = 1;
+    renderInfo.pDepthAttachment = &depthAttach;
+
+    vkCmdBeginRendering(cmd, &renderInfo);
+
+    if (clearMask) {
+        VkClearAttachment clear{};
+        clear.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        clear.clearValue.depthStencil = {1.0f, 0};
+        VkClearRect rects[MAX_SHADOW_CASCADES];
+        uint32_t rectCount = 0;
+        for (uint32_t c = 0; c < cascadeCount; c++) {
+            if (!(clearMask & (1u << c))) continue;
+            const ShadowAtlasRect& r = m_shadowAtlasRects[c];
+            rects[rectCount++] = {{{int32_t(r.x), int32_t(r.y)}, {r.size, r.size}}, 0, 1};
+        }
+        vkCmdClearAttachments(cmd, 1, &clear, rectCount, rects);
+    }
+
+    auto drawCasters = [&](uint32_t mask) {
+        // Direct draws instance over the cascades from the first to the last one in the mask
+        uint32_t firstCascade = 0;
+        while (!(mask & (1u << firstCascade))) firstCascade++;
+        uint32_t cascadeSpan = 0;
+        for (uint32_t c = firstCascade; c < cascadeCount; c++)
+            if (mask & (1u << c)) cascadeSpan = c - firstCascade + 1;
+
+        VkPipeline boundPipeline = VK_NULL_HANDLE;
+        const auto& entities = m_scene.entities();
+        for (size_t i = 0; i < entities.size(); i++) {
+            const auto& entity = entities[i];
+            const Mesh* mesh = m_assets.meshes().get(entity.mesh);
+            if (!mesh || entity.dynamic != dynamicCasters) continue;
+
+            VkPipeline pipeline = m_shadowPipelines[static_cast<uint32_t>(mesh->positionEncoding())];
+            if (pipeline != boundPipeline) {
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                boundPipeline = pipeline;
+            }
+
+            ShadowPushConstants pc{};
+            pc.model = entity.transform.modelMatrix();
+            pc.positionScale = mesh->positionScale();
+            pc.positionOffset = mesh->positionOffset();
+            pc.cascadeMask = mask;
             vkCmdPushConstants(cmd, m_shadowPipelineLayout,
-                VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mat4), &mvp);
+                VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pc), &pc);
 
-            VkBuffer vb = entity.mesh->vertexBuffer();
+            VkBuffer vb = mesh->positionBuffer();
             VkDeviceSize offset = 0;
-            vkCmdBindVertexBuffers(cmd, 0, 1, &vb, &offset);
-            vkCmdBindIndexBuffer(cmd, entity.mesh->indexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-            vkCmdDrawIndexed(cmd, entity.mesh->indexCount(), 1, 0, 0, 0);
+            VkDeviceSize stride = mesh->positionStride();
+            vkCmdBindVertexBuffers2(cmd, 0, 1, &vb, &offset, nullptr, &stride);
+            vkCmdBindIndexBuffer(cmd, mesh->indexBuffer(), 0, mesh->indexType());
+
+            // Meshlet-culled draws differ per cascade and carry it as firstInstance
+            bool culled = i < m_entityCullObject.size() && m_entityCullObject[i] != UINT32_MAX;
+            if (culled) {
+                for (uint32_t c = firstCascade; c < firstCascade + cascadeSpan; c++)
+                    if (mask & (1u << c)) drawEntityMesh(cmd, i, 1 + c);
+            } else {
+                for (const auto& sm : mesh->submeshes())
+                    vkCmdDrawIndexed(cmd, sm.indexCount, cascadeSpan, sm.firstIndex, sm.vertexOffset, firstCascade);
+            }
         }
+    };
 
-        vkCmdEndRendering(cmd);
+    if (singlePass) {
+        drawCasters(cascadeMask);
+    } else {
+        for (uint32_t c = 0; c < cascadeCount; c++) {
+            if (!(cascadeMask & (1u << c))) continue;
+            const ShadowAtlasRect& r = m_shadowAtlasRects[c];
+            VkViewport viewport{float(r.x), float(r.y), float(r.size), float(r.size), 0.0f, 1.0f};
+            VkRect2D scissor{{int32_t(r.x), int32_t(r.y)}, {r.size, r.size}};
+            vkCmdSetViewport(cmd, 0, 1, &viewport);
+            vkCmdSetScissor(cmd, 0, 1, &scissor);
+            drawCasters(1u << c);
+        }
+    }
+
+    vkCmdEndRendering(cmd);
+}
+
+void Engine::recordShadowPass(VkCommandBuffer cmd) {
+    const uint32_t cascadeCount = m_shadowSettings.cascadeCount;
+    uint32_t refreshMask = 0;
+    uint32_t fullMask = 0;
+    for (uint32_t c = 0; c < cascadeCount; c++) {
+        if (m_shadowRefresh[c] != ShadowRefresh::None) refreshMask |= 1u << c;
+        if (m_shadowRefresh[c] == ShadowRefresh::Full) fullMask |= 1u << c;
+    }
+    // Every region still matches its cascade: last frame's atlas is reused as is
+    if (!refreshMask) return;
+
+    // One viewport per cascade region; the slots past cascadeCount are never selected
+    VkViewport viewports[MAX_SHADOW_CASCADES];
+    VkRect2D scissors[MAX_SHADOW_CASCADES];
+    for (uint32_t c = 0; c < MAX_SHADOW_CASCADES; c++) {
+        const ShadowAtlasRect& r = m_shadowAtlasRects[std::min(c, cascadeCount - 1)];
+        viewports[c] = {float(r.x), float(r.y), float(r.size), float(r.size), 0.0f, 1.0f};
+        scissors[c] = {{int32_t(r.x), int32_t(r.y)}, {r.size, r.size}};
+    }
+    const uint32_t viewportCount = m_vkCtx.features().shaderOutputViewportIndex ? MAX_SHADOW_CASCADES : 1;
+    vkCmdSetViewport(cmd, 0, viewportCount, viewports);
+    vkCmdSetScissor(cmd, 0, viewportCount, scissors);
+    vkCmdSetDepthBias(cmd, 4.0f, 0.0f, 1.5f);
+
+    // Cascade matrices come from GlobalUBO::cascadeViewProj
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+        m_shadowPipelineLayout, 0, 1, &m_globalSet, 2, m_globalOffsets);
+
+    // Re-render the static casters of re-fitted cascades into the cache. Only their
+    // regions are cleared, the others are loaded untouched.
+    if (fullMask) {
+        Image::transitionLayout(cmd, m_shadowStaticCache.handle(),
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            VK_IMAGE_ASPECT_DEPTH_BIT);
+        recordShadowCasters(cmd, m_shadowStaticCache.view(), fullMask, fullMask, false);
+        Image::transitionLayout(cmd, m_shadowStaticCache.handle(),
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_ASPECT_DEPTH_BIT);
     }
 
-    // Transition shadow map to shader read for lighting
+    // Refreshed regions restart from their static casters
     Image::transitionLayout(cmd, m_shadowMap.handle(),
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_ASPECT_DEPTH_BIT);
+
+    VkImageCopy regions[MAX_SHADOW_CASCADES];
+    uint32_t regionCount = 0;
+    for (uint32_t c = 0; c < cascadeCount; c++) {
+        if (!(refreshMask & (1u << c))) continue;
+        const ShadowAtlasRect& r = m_shadowAtlasRects[c];
+        VkImageCopy& region = regions[regionCount++];
+        region = {};
+        region.srcSubresource = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1};
+        region.srcOffset = {int32_t(r.x), int32_t(r.y), 0};
+        region.dstSubresource = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1};
+        region.dstOffset = region.srcOffset;
+        region.extent = {r.size, r.size, 1};
+    }
+    vkCmdCopyImage(cmd,
+        m_shadowStaticCache.handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        m_shadowMap.handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        regionCount, regions);
+
+    if (m_hasDynamicCasters) {
+        Image::transitionLayout(cmd, m_shadowMap.handle(),
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            VK_IMAGE_ASPECT_DEPTH_BIT);
+        recordShadowCasters(cmd, m_shadowMap.view(), refreshMask, 0, true);
+        Image::transitionLayout(cmd, m_shadowMap.handle(),
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_ASPECT_DEPTH_BIT);
+    } else {
+        Image::transitionLayout(cmd, m_shadowMap.handle(),
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_ASPECT_DEPTH_BIT);
+    }
+
+    if (m_shadowFilter == ShadowFilter::EVSM)
+        recordShadowFilterPass(cmd, refreshMask);
+}
+
+// Rebuilds the EVSM moments of the cascades in cascadeMask from the freshly rendered
+// shadow atlas: resolve, separable blur, then the mip chain. Untouched cascades keep theirs.
+void Engine::recordShadowFilterPass(VkCommandBuffer cmd, uint32_t cascadeMask) {
+    // The shadow map was transitioned for fragment reads; extend that to compute
+    memoryBarrier(cmd,
+        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT);
+    const uint32_t cascadeCount = m_shadowSettings.cascadeCount;
+    Image::transitionLayout(cmd, m_shadowMoments.handle(),
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,
+        VK_IMAGE_ASPECT_COLOR_BIT, SHADOW_MOMENTS_MIP_COUNT, cascadeCount);
+
+    ShadowFilterPushConstants pc{};
+    pc.cascadeMask = cascadeMask;
+    for (uint32_t c = 0; c < cascadeCount; c++) {
+        const ShadowAtlasRect& r = m_shadowAtlasRects[c];
+        pc.atlasRects[c][0] = r.x;
+        pc.atlasRects[c][1] = r.y;
+        pc.atlasRects[c][2] = r.size;
+    }
+
+    auto dispatch = [&](VkPipeline pipeline, VkDescriptorSet set, uint32_t horizontal, uint32_t size) {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+            m_shadowFilterPipelineLayout, 0, 1, &set, 0, nullptr);
+        pc.horizontal = horizontal;
+        vkCmdPushConstants(cmd, m_shadowFilterPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pc), &pc);
+        vkCmdDispatch(cmd, (size + 7) / 8, (size + 7) / 8, cascadeCount);
+        memoryBarrier(cmd,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+            VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+    };
+
+    dispatch(m_evsmResolvePipeline, m_evsmResolveSet, 0, SHADOW_MOMENTS_SIZE);
+    dispatch(m_evsmBlurPipeline, m_evsmBlurSets[0], 1, SHADOW_MOMENTS_SIZE);
+    dispatch(m_evsmBlurPipeline, m_evsmBlurSets[1], 0, SHADOW_MOMENTS_SIZE);
+    for (uint32_t mip = 1; mip < SHADOW_MOMENTS_MIP_COUNT; mip++)
+        dispatch(m_evsmDownsamplePipeline, m_evsmDownsampleSets[mip], 0, SHADOW_MOMENTS_SIZE >> mip);
+
+    Image::transitionLayout(cmd, m_shadowMoments.handle(),
+        VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT, SHADOW_MOMENTS_MIP_COUNT, cascadeCount);
+}
+
+// Re-renders the local shadow views updateLocalShadows() scheduled, each into its own atlas
+// tile. Every other tile keeps last frame's contents.
+void Engine::recordLocalShadowPass(VkCommandBuffer cmd) {
+    if (m_localShadowRenders.empty()) return;
+
+    // The previous frame's lighting may still read the entries being replaced
+    memoryBarrier(cmd,
+        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_NONE);
+    for (const LocalShadowRender& render : m_localShadowRenders)
+        vkCmdUpdateBuffer(cmd, m_localShadowViews.handle(), sizeof(GPULocalShadowView) * render.view,
+            sizeof(GPULocalShadowView), &render.data);
+    memoryBarrier(cmd,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+
+    Image::transitionLayout(cmd, m_localShadowAtlas.handle(),
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+        VK_IMAGE_ASPECT_DEPTH_BIT);
+
+    VkRenderingAttachmentInfo depthAttach{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+    depthAttach.imageView = m_localShadowAtlas.view();
+    depthAttach.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthAttach.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    depthAttach.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+
+    VkRenderingInfo renderInfo{VK_STRUCTURE_TYPE_RENDERING_INFO};
+    renderInfo.renderArea = {{0, 0}, {LOCAL_SHADOW_ATLAS_SIZE, LOCAL_SHADOW_ATLAS_SIZE}};
+    renderInfo.layerCount = 1;
+    renderInfo.pDepthAttachment = &depthAttach;
+    vkCmdBeginRendering(cmd, &renderInfo);
+
+    std::vector<VkClearRect> clearRects;
+    clearRects.reserve(m_localShadowRenders.size());
+    for (const LocalShadowRender& render : m_localShadowRenders)
+        clearRects.push_back({render.tile, 0, 1});
+    VkClearAttachment clear{};
+    clear.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+    clear.clearValue.depthStencil = {1.0f, 0};
+    vkCmdClearAttachments(cmd, 1, &clear, static_cast<uint32_t>(clearRects.size()), clearRects.data());
+
+    const auto& entities = m_scene.entities();
+    for (const LocalShadowRender& render : m_localShadowRenders) {
+        VkViewport viewport{float(render.tile.offset.x), float(render.tile.offset.y),
+                            float(render.tile.extent.width), float(render.tile.extent.height), 0.0f, 1.0f};
+        vkCmdSetViewport(cmd, 0, 1, &viewport);
+        vkCmdSetScissor(cmd, 0, 1, &render.tile);
+
+        vec4 planes[6];
+        extractFrustumPlanes(render.data.viewProj, planes);
+        VkPipeline boundPipeline = VK_NULL_HANDLE;
+        for (const auto& entity : entities) {
+            const Mesh* mesh = m_assets.meshes().get(entity.mesh);
+            if (!mesh) continue;
+            mat4 model = entity.transform.modelMatrix();
+            vec4 sphere = boundingSphere(mesh->bounds(), model);
+            bool inside = true;
+            for (int p = 0; p < 6 && inside; p++)
+                inside = glm::dot(planes[p], vec4(vec3(sphere), 1.0f)) >= -sphere.w;
+            if (!inside) continue;
+
+            VkPipeline pipeline = m_localShadowPipelines[static_cast<uint32_t>(mesh->positionEncoding())];
+            if (pipeline != boundPipeline) {
+                vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                boundPipeline = pipeline;
+            }
+
+            MeshPushConstants pc{};
+            pc.transform = render.data.viewProj * model;
+            pc.positionScale = mesh->positionScale();
+            pc.positionOffset = mesh->positionOffset();
+            vkCmdPushConstants(cmd, m_localShadowPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pc), &pc);
+
+            VkBuffer vb = mesh->positionBuffer();
+            VkDeviceSize offset = 0;
+            VkDeviceSize stride = mesh->positionStride();
+            vkCmdBindVertexBuffers2(cmd, 0, 1, &vb, &offset, nullptr, &stride);
+            vkCmdBindIndexBuffer(cmd, mesh->indexBuffer(), 0, mesh->indexType());
+            for (const auto& sm : mesh->submeshes())
+                vkCmdDrawIndexed(cmd, sm.indexCount, 1, sm.firstIndex, sm.vertexOffset, 0);
+        }
+    }
+
+    vkCmdEndRendering(cmd);
+    Image::transitionLayout(cmd, m_localShadowAtlas.handle(),
         VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-        VK_IMAGE_ASPECT_DEPTH_BIT, 1, SHADOW_CASCADE_COUNT);
+        VK_IMAGE_ASPECT_DEPTH_BIT);
 }
 
 void Engine::recordGBufferPass(VkCommandBuffer cmd) {
+    m_virtualTextures.recordFeedbackClear(cmd);
+
     // Transition G-buffer images to attachment
     Image::transitionLayout(cmd, m_gbufferRT0.handle(),
         VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
@@ -1869,28 +3400,43 @@ void Engine::recordGBufferPass(VkCommandBuffer cmd) {
     VkRect2D scissor{{0, 0}, m_swapchain.extent()};
     vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_gbufferPipeline);
-
-    uint32_t frame = m_frameSync.currentFrame();
+    // All G-buffer pipelines share one layout, so the global set survives pipeline switches
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-        m_gbufferPipelineLayout, 0, 1, &m_globalSets[frame], 0, nullptr);
-
-    for (const auto& entity : m_scene.entities()) {
-        if (!entity.mesh || !entity.material) continue;
+        m_gbufferPipelineLayout, 0, 1, &m_globalSet, 2, m_globalOffsets);
+    VkDescriptorSet vtSet = m_virtualTextures.descriptorSet();
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
+        m_gbufferPipelineLayout, 1, 1, &vtSet, 0, nullptr);
+
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    const auto& entities = m_scene.entities();
+    for (size_t i = 0; i < entities.size(); i++) {
+        const auto& entity = entities[i];
+        const Mesh* mesh = m_assets.meshes().get(entity.mesh);
+        const Material* material = m_assets.materials().get(entity.material);
+        if (!mesh || !material) continue;
+
+        VkPipeline pipeline = m_gbufferPipelines[static_cast<uint32_t>(mesh->vertexFormat())];
+        if (pipeline != boundPipeline) {
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            boundPipeline = pipeline;
+        }
 
-        mat4 model = entity.transform.modelMatrix();
+        MeshPushConstants pc{};
+        pc.transform = entity.transform.modelMatrix();
+        pc.positionScale = mesh->positionScale();
+        pc.positionOffset = mesh->positionOffset();
         vkCmdPushConstants(cmd, m_gbufferPipelineLayout,
-            VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mat4), &model);
+            VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(pc), &pc);
 
-        VkDescriptorSet matSet = entity.material->descriptorSet();
+        VkDescriptorSet matSet = material->descriptorSet();
         vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
             m_gbufferPipelineLayout, 2, 1, &matSet, 0, nullptr);
 
-        VkBuffer vb = entity.mesh->vertexBuffer();
+        VkBuffer vb = mesh->vertexBuffer();
         VkDeviceSize offset = 0;
         vkCmdBindVertexBuffers(cmd, 0, 1, &vb, &offset);
-        vkCmdBindIndexBuffer(cmd, entity.mesh->indexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-        vkCmdDrawIndexed(cmd, entity.mesh->indexCount(), 1, 0, 0, 0);
+        vkCmdBindIndexBuffer(cmd, mesh->indexBuffer(), 0, mesh->indexType());
+        drawEntityMesh(cmd, i, CULL_VIEW_CAMERA);
     }
 
     vkCmdEndRendering(cmd);
@@ -1903,6 +3449,48 @@ void Engine::recordGBufferPass(VkCommandBuffer cmd) {
     Image::transitionLayout(cmd, m_depthImage.handle(),
         VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
         VK_IMAGE_ASPECT_DEPTH_BIT);
+
+    // Pages the pass asked for, read in next frame's update
+    m_virtualTextures.recordFeedbackReadback(cmd);
+}
+
+void Engine::recordTileClassifyPass(VkCommandBuffer cmd) {
+    // The previous frame's lighting draws may still be reading the lists (execution dependency only)
+    memoryBarrier(cmd,
+        VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT, VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_NONE);
+
+    // One instanced quad per tile; the classifier only bumps instanceCount
+    VkDrawIndirectCommand draws[TILE_CLASS_COUNT];
+    for (auto& draw : draws)
+        draw = {6, 0, 0, 0};
+    vkCmdUpdateBuffer(cmd, m_tileClassBuffer.handle(), 0, sizeof(draws), draws);
+    const uint32_t depthBounds[2] = {0xFFFFFFFFu, 0u};
+    vkCmdUpdateBuffer(cmd, m_depthBoundsBuffer.handle(), 0, sizeof(depthBounds), depthBounds);
+
+    // G-buffer was transitioned for fragment reads; chain the compute reads behind it
+    memoryBarrier(cmd,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_tileClassifyPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE,
+        m_tileClassifyPipelineLayout, 0, 1, &m_globalSet, 2, m_globalOffsets);
+    vkCmdDispatch(cmd, m_tileGridX, m_tileGridY, 1);
+
+    memoryBarrier(cmd,
+        VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+        VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_TRANSFER_READ_BIT);
+
+    // Visible depth range for next frame's cascade fit, read after the fence wait
+    VkBufferCopy copy{0, 0, sizeof(uint32_t) * 2};
+    vkCmdCopyBuffer(cmd, m_depthBoundsBuffer.handle(), m_depthBoundsReadback.handle(), 1, &copy);
+    memoryBarrier(cmd,
+        VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_HOST_BIT, VK_ACCESS_2_HOST_READ_BIT);
+    m_depthBoundsPending = true;
 }
 
 void Engine::recordSSAOPass(VkCommandBuffer cmd) {
@@ -1934,9 +3522,8 @@ void Engine::recordSSAOPass(VkCommandBuffer cmd) {
     vkCmdSetScissor(cmd, 0, 1, &scissor);
 
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_ssaoPipeline);
-    uint32_t frame = m_frameSync.currentFrame();
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-        m_ssaoPipelineLayout, 0, 1, &m_globalSets[frame], 0, nullptr);
+        m_ssaoPipelineLayout, 0, 1, &m_globalSet, 2, m_globalOffsets);
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
         m_ssaoPipelineLayout, 1, 1, &m_ssaoSet, 0, nullptr);
     vkCmdDraw(cmd, 3, 1, 0, 0);
@@ -1992,9 +3579,8 @@ void Engine::recordLightingPass(VkCommandBuffer cmd) {
     VkRenderingAttachmentInfo colorAttach{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
     colorAttach.imageView = m_hdrImage.view();
     colorAttach.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    colorAttach.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttach.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE; // every pixel lies in exactly one tile
     colorAttach.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttach.clearValue.color = {{0.0f, 0.0f, 0.0f, 1.0f}};
 
     VkRenderingInfo renderInfo{VK_STRUCTURE_TYPE_RENDERING_INFO};
     renderInfo.renderArea = {{0, 0}, m_swapchain.extent()};
@@ -2016,60 +3602,20 @@ void Engine::recordLightingPass(VkCommandBuffer cmd) {
     VkRect2D scissor{{0, 0}, m_swapchain.extent()};
     vkCmdSetScissor(cmd, 0, 1, &scissor);
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_lightingPipeline);
-
-    uint32_t frame = m_frameSync.currentFrame();
+    // All variants share one layout, so the set and push constant survive pipeline switches
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-        m_lightingPipelineLayout, 0, 1, &m_globalSets[frame], 0, nullptr);
+        m_lightingPipelineLayout, 0, 1, &m_globalSet, 2, m_globalOffsets);
 
-    uint32_t debugMode = static_cast<uint32_t>(m_debugMode);
+    uint32_t pc[2] = {static_cast<uint32_t>(m_debugMode), static_cast<uint32_t>(m_shadowFilter)};
     vkCmdPushConstants(cmd, m_lightingPipelineLayout,
-        VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(uint32_t), &debugMode);
-
-    vkCmdDraw(cmd, 3, 1, 0, 0);
-
-    vkCmdEndRendering(cmd);
-
-    // HDR stays in COLOR_ATTACHMENT_OPTIMAL for skybox pass
-}
-
-void Engine::recordSkyboxPass(VkCommandBuffer cmd) {
-    // HDR is still in COLOR_ATTACHMENT_OPTIMAL from lighting pass
-    VkRenderingAttachmentInfo colorAttach{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
-    colorAttach.imageView = m_hdrImage.view();
-    colorAttach.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    colorAttach.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-    colorAttach.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-
-    VkRenderingInfo renderInfo{VK_STRUCTURE_TYPE_RENDERING_INFO};
-    renderInfo.renderArea = {{0, 0}, m_swapchain.extent()};
-    renderInfo.layerCount = 1;
-    renderInfo.colorAttachmentCount = 1;
-    renderInfo.pColorAttachments = &colorAttach;
-
-    vkCmdBeginRendering(cmd, &renderInfo);
-
-    VkViewport viewport{};
-    viewport.x = 0;
-    viewport.y = 0;
-    viewport.width = static_cast<float>(m_swapchain.extent().width);
-    viewport.height = static_cast<float>(m_swapchain.extent().height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(cmd, 0, 1, &viewport);
+        VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pc), pc);
 
-    VkRect2D scissor{{0, 0}, m_swapchain.extent()};
-    vkCmdSetScissor(cmd, 0, 1, &scissor);
-
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_skyboxPipeline);
-
-    uint32_t frame = m_frameSync.currentFrame();
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-        m_skyboxPipelineLayout, 0, 1, &m_globalSets[frame], 0, nullptr);
-    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-        m_skyboxPipelineLayout, 1, 1, &m_skyboxSet, 0, nullptr);
-
-    vkCmdDraw(cmd, 3, 1, 0, 0);
+    // One indirect draw per tile class; sky tiles only run the environment lookup
+    for (uint32_t tileClass = 0; tileClass < TILE_CLASS_COUNT; tileClass++) {
+        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_lightingPipelines[tileClass]);
+        vkCmdDrawIndirect(cmd, m_tileClassBuffer.handle(), sizeof(VkDrawIndirectCommand) * tileClass,
+            1, sizeof(VkDrawIndirectCommand));
+    }
 
     vkCmdEndRendering(cmd);
 
@@ -2263,9 +3809,8 @@ void Engine::recordMotionPass(VkCommandBuffer cmd) {
 
     vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, m_motionPipeline);
 
-    uint32_t frame = m_frameSync.currentFrame();
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS,
-        m_motionPipelineLayout, 0, 1, &m_globalSets[frame], 0, nullptr);
+        m_motionPipelineLayout, 0, 1, &m_globalSet, 2, m_globalOffsets);
 
     vkCmdDraw(cmd, 3, 1, 0, 0);
 
@@ -2435,12 +3980,15 @@ void Engine::recordCommands(VkCommandBuffer cmd, uint32_t imageIndex) {
     VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
     VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
 
-    recordShadowPass(cmd);     // Depth-only per cascade
+    recordMeshletCullPass(cmd); // Frustum + normal cone culling per view
+    recordLightClusterPass(cmd); // Point lights -> per-froxel index lists
+    recordShadowPass(cmd);     // Depth-only, all cascades into their atlas regions
+    recordLocalShadowPass(cmd); // Depth-only, re-rendered point/spot light views into their tiles
     recordGBufferPass(cmd);    // G-buffer pass
+    recordTileClassifyPass(cmd); // 16x16 tiles -> sky / unlit / simple / complex lists
     recordSSAOPass(cmd);       // Half-res SSAO sampling
     recordSSAOBlurPass(cmd);   // Bilateral blur SSAO
-    recordLightingPass(cmd);   // Read G-buffer + shadow map + SSAO, output HDR
-    recordSkyboxPass(cmd);     // Render sky into HDR for far-plane pixels
+    recordLightingPass(cmd);   // Per-class tile draws: G-buffer + shadow map + SSAO or sky, output HDR
     recordBloomPass(cmd);      // Progressive downsample + upsample bloom
     recordMotionPass(cmd);     // Read depth, output velocity
     recordTAAPass(cmd);        // Read HDR + velocity + history, output to history
@@ -2460,7 +4008,13 @@ void Engine::recordCommands(VkCommandBuffer cmd, uint32_t imageIndex) {
 
 void Engine::drawFrame() {
     VkDevice device = m_vkCtx.device();
+    if (m_shadowAtlasDirty)
+        rebuildShadowAtlas();
+
     m_frameSync.waitForFence(device);
+    readDepthBounds();
+    // Nothing submitted is in flight now, so assets the scene stopped using can be released
+    m_assets.collect(m_scene);
 
     uint32_t imageIndex = m_swapchain.acquireNextImage(device, m_frameSync.imageAvailableSemaphore());
     if (imageIndex == UINT32_MAX) {
@@ -2475,6 +4029,12 @@ void Engine::drawFrame() {
         m_scene.camera().update(m_timer.dt());
     }
 
+    // Demo dynamic shadow caster: only the cascades it overlaps get refreshed
+    if (m_spinDynamicCaster && m_dynamicDemoEntity < m_scene.entities().size()) {
+        auto& rotation = m_scene.entities()[m_dynamicDemoEntity].transform.rotation;
+        rotation = glm::normalize(glm::angleAxis(m_timer.dt() * 0.8f, glm::normalize(vec3(1.0f, 1.0f, 0.0f))) * rotation);
+    }
+
     // Compute TAA jitter (Halton 2,3 sequence)
     float w = static_cast<float>(m_swapchain.extent().width);
     float h = static_cast<float>(m_swapchain.extent().height);
@@ -2490,17 +4050,21 @@ void Engine::drawFrame() {
 
     mat4 viewMat = m_scene.camera().viewMatrix();
 
-    // Update UBO
+    // Per-frame GPU data is written straight into this frame's region of m_frameAlloc.
+    // The region is write-combined memory: fields are only ever stored, never read back.
     uint32_t frame = m_frameSync.currentFrame();
-    GlobalUBO ubo{};
+    m_frameAlloc.beginFrame(frame);
+
+    // Update UBO
+    GlobalUBO& ubo = *m_frameAlloc.allocate<GlobalUBO>(1, m_globalOffsets[0]);
+    mat4 viewProj = jitteredProj * viewMat;
     ubo.view = viewMat;
     ubo.proj = jitteredProj;
-    ubo.viewProj = jitteredProj * viewMat;
-    ubo.invViewProj = glm::inverse(ubo.viewProj);
+    ubo.viewProj = viewProj;
+    ubo.invViewProj = glm::inverse(viewProj);
     ubo.prevViewProj = m_prevViewProj;
     ubo.cameraPos = vec4(m_scene.camera().position(), 1.0f);
     ubo.time = m_timer.elapsed();
-    ubo.pointLightCount = static_cast<uint32_t>(m_scene.pointLights().size());
     ubo.jitterX = jitterX;
     ubo.jitterY = jitterY;
 
@@ -2511,33 +4075,38 @@ void Engine::drawFrame() {
 
     // Compute cascade shadow map matrices
     vec4 cascadeSplits;
-    computeCascades(m_cascadeVP, cascadeSplits);
-    for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++) {
+    updateShadowCascades(cascadeSplits);
+    const float atlasW = static_cast<float>(m_shadowAtlasExtent.width);
+    const float atlasH = static_cast<float>(m_shadowAtlasExtent.height);
+    for (uint32_t i = 0; i < m_shadowSettings.cascadeCount; i++) {
+        const ShadowAtlasRect& r = m_shadowAtlasRects[i];
         ubo.cascadeViewProj[i] = m_cascadeVP[i];
+        ubo.cascadeAtlasRects[i] = vec4(r.x / atlasW, r.y / atlasH, r.size / atlasW, r.size / atlasH);
     }
     ubo.cascadeSplits = cascadeSplits;
+    ubo.cascadeCount = m_shadowSettings.cascadeCount;
     ubo.iblIntensity = m_iblIntensityUI;
     ubo.ssaoRadius = m_ssaoEnabled ? m_ssaoRadiusUI : 0.0f;
     ubo.ssaoBias = m_ssaoBiasUI;
     ubo.bloomIntensity = m_bloomEnabled ? m_bloomIntensityUI : 0.0f;
 
-    m_uniformBuffers[frame].upload(&ubo, sizeof(ubo));
+    // Exponential slices: slice = log(viewZ) * scale + bias, 0 at the near plane
+    float zNear = m_scene.camera().nearPlane();
+    float zFar = m_scene.camera().farPlane();
+    float sliceScale = static_cast<float>(CLUSTER_GRID_Z) / std::log(zFar / zNear);
+    ubo.clusterParams = vec4(sliceScale, -std::log(zNear) * sliceScale, zNear, zFar);
+
+    updateLocalShadows(viewProj);
+    m_visiblePointLightCount = updatePointLights(viewProj);
+    ubo.pointLightCount = m_visiblePointLightCount;
+
+    updateMeshletCulling(viewProj);
+    updateTextureStreaming(baseProj * viewMat);
+    m_virtualTextures.update();
 
     // Store unjittered viewProj for next frame's motion vectors
     m_prevViewProj = baseProj * viewMat;
 
-    // Upload point lights
-    const auto& pointLights = m_scene.pointLights();
-    if (!pointLights.empty()) {
-        std::vector<GPUPointLight> gpuLights(pointLights.size());
-        for (size_t i = 0; i < pointLights.size(); i++) {
-            gpuLights[i].positionAndRange = vec4(pointLights[i].position, pointLights[i].range);
-            gpuLights[i].colorAndIntensity = vec4(pointLights[i].color, pointLights[i].intensity);
-        }
-        m_pointLightBuffers[frame].upload(gpuLights.data(),
-            sizeof(GPUPointLight) * gpuLights.size());
-    }
-
     // ImGui frame
     if (m_imguiInitialized) {
         ImGui_ImplVulkan_NewFrame();
@@ -2547,9 +4116,16 @@ void Engine::drawFrame() {
         ImGui::Render();
     }
 
+    // Pending uploads go ahead of the frame on the graphics queue; finished ones are recycled.
+    // The decoder polls the file reader, so reads completed since last frame start decoding.
+    m_textureDecoder.update();
+    m_uploads.submit();
+    m_uploads.poll();
+
     VkCommandBuffer cmd = m_cmdBuffers[frame];
     VK_CHECK(vkResetCommandBuffer(cmd, 0));
     recordCommands(cmd, imageIndex);
+    m_frameAlloc.flush();
 
     VkSemaphore waitSems[] = {m_frameSync.imageAvailableSemaphore()};
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
@@ -2601,6 +4177,7 @@ void Engine::handleResize() {
         }
     }
     m_bloomMipChain.shutdown();
+    m_tileClassBuffer.shutdown();
 
     m_frameSync.shutdown();
     m_swapchain.recreate(m_vkCtx, m_window.width(), m_window.height());
@@ -2621,6 +4198,8 @@ void Engine::handleResize() {
     createVelocityImage();
     createTAAImages();
     createLDRImage();
+    createTileClassBuffer();
+    m_virtualTextures.resize(m_swapchain.extent());
     updateLightingDescriptors();
     updateAADescriptors();
 
@@ -2662,7 +4241,7 @@ void Engine::run() {
         if (Input::keyPressed(GLFW_KEY_ESCAPE))
             glfwSetWindowShouldClose(m_window.handle(), GLFW_TRUE);
 
-        // Debug mode switching (keys 1-6)
+        // Debug mode switching (keys 1-9)
         if (Input::keyPressed(GLFW_KEY_1)) m_debugMode = DebugMode::Final;
         if (Input::keyPressed(GLFW_KEY_2)) m_debugMode = DebugMode::Albedo;
         if (Input::keyPressed(GLFW_KEY_3)) m_debugMode = DebugMode::Metallic;
@@ -2670,6 +4249,8 @@ void Engine::run() {
         if (Input::keyPressed(GLFW_KEY_5)) m_debugMode = DebugMode::Normals;
         if (Input::keyPressed(GLFW_KEY_6)) m_debugMode = DebugMode::Depth;
         if (Input::keyPressed(GLFW_KEY_7)) m_debugMode = DebugMode::Cascades;
+        if (Input::keyPressed(GLFW_KEY_8)) m_debugMode = DebugMode::LightClusters;
+        if (Input::keyPressed(GLFW_KEY_9)) m_debugMode = DebugMode::TileClasses;
 
         drawFrame();
         Input::endFrame();
@@ -2685,14 +4266,16 @@ void Engine::shutdown() {
 
     m_vkCtx.waitIdle();
 
-    // Clear scene entities (releases shared_ptrs)
+    // Clear scene entities
     m_scene.entities().clear();
-    m_scene.pointLights().clear();
+    m_scene.clearPointLights();
 
     // Release assets
-    m_materials.clear();
-    m_textures.clear();
-    m_meshes.clear();
+    m_assets.shutdown();
+    m_textureDecoder.shutdown();
+    m_fileReader.shutdown();
+    m_textureStreamer.shutdown();
+    m_virtualTextures.shutdown();
 
     // Destroy ImGui
     if (m_imguiInitialized) {
@@ -2712,13 +4295,25 @@ void Engine::shutdown() {
     if (m_bloomDownPipelineLayout) vkDestroyPipelineLayout(device, m_bloomDownPipelineLayout, nullptr);
     if (m_bloomUpPipeline) vkDestroyPipeline(device, m_bloomUpPipeline, nullptr);
     if (m_bloomUpPipelineLayout) vkDestroyPipelineLayout(device, m_bloomUpPipelineLayout, nullptr);
-    if (m_skyboxPipeline) vkDestroyPipeline(device, m_skyboxPipeline, nullptr);
-    if (m_skyboxPipelineLayout) vkDestroyPipelineLayout(device, m_skyboxPipelineLayout, nullptr);
-    if (m_shadowPipeline) vkDestroyPipeline(device, m_shadowPipeline, nullptr);
+    for (auto& p : m_shadowPipelines) {
+        if (p) vkDestroyPipeline(device, p, nullptr);
+        p = VK_NULL_HANDLE;
+    }
     if (m_shadowPipelineLayout) vkDestroyPipelineLayout(device, m_shadowPipelineLayout, nullptr);
-    if (m_gbufferPipeline) vkDestroyPipeline(device, m_gbufferPipeline, nullptr);
+    for (auto& p : m_localShadowPipelines) {
+        if (p) vkDestroyPipeline(device, p, nullptr);
+        p = VK_NULL_HANDLE;
+    }
+    if (m_localShadowPipelineLayout) vkDestroyPipelineLayout(device, m_localShadowPipelineLayout, nullptr);
+    for (auto& p : m_gbufferPipelines) {
+        if (p) vkDestroyPipeline(device, p, nullptr);
+        p = VK_NULL_HANDLE;
+    }
     if (m_gbufferPipelineLayout) vkDestroyPipelineLayout(device, m_gbufferPipelineLayout, nullptr);
-    if (m_lightingPipeline) vkDestroyPipeline(device, m_lightingPipeline, nullptr);
+    for (auto& p : m_lightingPipelines) {
+        if (p) vkDestroyPipeline(device, p, nullptr);
+        p = VK_NULL_HANDLE;
+    }
     if (m_lightingPipelineLayout) vkDestroyPipelineLayout(device, m_lightingPipelineLayout, nullptr);
     if (m_motionPipeline) vkDestroyPipeline(device, m_motionPipeline, nullptr);
     if (m_motionPipelineLayout) vkDestroyPipelineLayout(device, m_motionPipelineLayout, nullptr);
@@ -2728,34 +4323,50 @@ void Engine::shutdown() {
     if (m_tonemapPipelineLayout) vkDestroyPipelineLayout(device, m_tonemapPipelineLayout, nullptr);
     if (m_fxaaPipeline) vkDestroyPipeline(device, m_fxaaPipeline, nullptr);
     if (m_fxaaPipelineLayout) vkDestroyPipelineLayout(device, m_fxaaPipelineLayout, nullptr);
+    if (m_tileClassifyPipeline) vkDestroyPipeline(device, m_tileClassifyPipeline, nullptr);
+    if (m_tileClassifyPipelineLayout) vkDestroyPipelineLayout(device, m_tileClassifyPipelineLayout, nullptr);
+    if (m_lightClusterPipeline) vkDestroyPipeline(device, m_lightClusterPipeline, nullptr);
+    if (m_lightClusterPipelineLayout) vkDestroyPipelineLayout(device, m_lightClusterPipelineLayout, nullptr);
+    if (m_meshletCullPipeline) vkDestroyPipeline(device, m_meshletCullPipeline, nullptr);
+    if (m_meshletCullPipelineLayout) vkDestroyPipelineLayout(device, m_meshletCullPipelineLayout, nullptr);
+    if (m_evsmResolvePipeline) vkDestroyPipeline(device, m_evsmResolvePipeline, nullptr);
+    if (m_evsmBlurPipeline) vkDestroyPipeline(device, m_evsmBlurPipeline, nullptr);
+    if (m_evsmDownsamplePipeline) vkDestroyPipeline(device, m_evsmDownsamplePipeline, nullptr);
+    if (m_shadowFilterPipelineLayout) vkDestroyPipelineLayout(device, m_shadowFilterPipelineLayout, nullptr);
 
     m_ssaoFrag.shutdown();
     m_ssaoBlurFrag.shutdown();
     m_bloomDownFrag.shutdown();
     m_bloomUpFrag.shutdown();
-    m_skyboxVert.shutdown();
-    m_skyboxFrag.shutdown();
     m_shadowVert.shutdown();
+    m_localShadowVert.shutdown();
     m_gbufferVert.shutdown();
+    m_gbufferPackedVert.shutdown();
     m_gbufferFrag.shutdown();
     m_fullscreenVert.shutdown();
+    m_tileVert.shutdown();
     m_lightingFrag.shutdown();
     m_motionFrag.shutdown();
     m_taaFrag.shutdown();
     m_tonemapFrag.shutdown();
     m_fxaaFrag.shutdown();
+    m_meshletCullComp.shutdown();
+    m_lightClusterComp.shutdown();
+    m_tileClassifyComp.shutdown();
+    m_evsmResolveComp.shutdown();
+    m_evsmBlurComp.shutdown();
+    m_evsmDownsampleComp.shutdown();
 
     if (m_nearestSampler) vkDestroySampler(device, m_nearestSampler, nullptr);
     if (m_linearSampler) vkDestroySampler(device, m_linearSampler, nullptr);
     if (m_repeatSampler) vkDestroySampler(device, m_repeatSampler, nullptr);
     if (m_shadowSampler) vkDestroySampler(device, m_shadowSampler, nullptr);
+    if (m_shadowMomentsSampler) vkDestroySampler(device, m_shadowMomentsSampler, nullptr);
     if (m_cubemapSampler) vkDestroySampler(device, m_cubemapSampler, nullptr);
 
-    for (auto& v : m_shadowLayerViews) {
-        if (v) vkDestroyImageView(device, v, nullptr);
-        v = VK_NULL_HANDLE;
-    }
-    m_shadowMap.shutdown();
+    destroyShadowAtlas();
+    m_localShadowAtlas.shutdown();
+    m_localShadowViews.shutdown();
 
     m_envCubemap.shutdown();
     m_irradianceMap.shutdown();
@@ -2775,8 +4386,17 @@ void Engine::shutdown() {
     }
     m_bloomMipChain.shutdown();
 
-    for (auto& ub : m_uniformBuffers) ub.shutdown();
-    for (auto& plb : m_pointLightBuffers) plb.shutdown();
+    m_frameAlloc.shutdown();
+    m_clusterGrid.shutdown();
+    m_clusterLightIndices.shutdown();
+    m_tileClassBuffer.shutdown();
+    m_depthBoundsBuffer.shutdown();
+    m_depthBoundsReadback.shutdown();
+    m_pointLightBuffer.shutdown();
+    for (auto& cull : m_meshletCull) {
+        cull.draws.shutdown();
+        cull.counts.shutdown();
+    }
 
     m_gbufferRT0.shutdown();
     m_gbufferRT1.shutdown();
@@ -2789,10 +4409,14 @@ void Engine::shutdown() {
 
     m_descriptors.shutdown();
     m_frameSync.shutdown();
+    m_uploads.shutdown();
     m_cmdPool.shutdown();
     m_swapchain.shutdown(device);
     m_vkCtx.shutdown();
     m_window.shutdown();
+
+    PackFile::mount(nullptr);
+    m_pack.close();
 }
 
 } // namespace lmao
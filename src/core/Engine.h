@@ -1,9 +1,12 @@
 #pragma once
 #include "core/Window.h"
 #include "core/Timer.h"
+#include "core/AsyncFileReader.h"
 #include "vulkan/VulkanContext.h"
 #include "vulkan/Swapchain.h"
 #include "vulkan/CommandPool.h"
+#include "vulkan/UploadManager.h"
+#include "vulkan/FrameAllocator.h"
 #include "vulkan/SyncObjects.h"
 #include "vulkan/DescriptorManager.h"
 #include "vulkan/Buffer.h"
@@ -11,6 +14,12 @@
 #include "vulkan/ShaderModule.h"
 #include "vulkan/Pipeline.h"
 #include "scene/Scene.h"
+#include "assets/AssetRegistry.h"
+#include "assets/PackFile.h"
+#include "assets/TextureDecodePool.h"
+#include "assets/TextureStreamer.h"
+#include "assets/VirtualTexture.h"
+#include "assets/VertexFormat.h"
 #include "math/MathUtils.h"
 #include <imgui.h>
 #include <memory>
@@ -22,10 +31,16 @@ class Mesh;
 class Texture;
 class Material;
 
+// Must match GPUPointLight in lighting.frag / light_cluster.comp
 struct GPUPointLight {
     vec4 positionAndRange;   // xyz = position, w = range
     vec4 colorAndIntensity;  // xyz = color, w = intensity
+    vec4 spotDirAndCosOuter; // xyz = spot direction, w = cos(outer angle), -1 for point lights
+    float spotCosInner;
+    uint32_t shadowSlot;     // local shadow view slot, UINT32_MAX = unshadowed
+    uint32_t padding[2];
 };
+static_assert(sizeof(GPUPointLight) == 64, "GPUPointLight must match lighting.frag");
 
 enum class DebugMode : uint32_t {
     Final = 0,
@@ -36,6 +51,14 @@ enum class DebugMode : uint32_t {
     Depth = 5,
     SSAO = 6,
     Cascades = 7,
+    LightClusters = 8,
+    TileClasses = 9,
+};
+
+// Directional shadow filtering in lighting.frag (shadowFilter push constant)
+enum class ShadowFilter : uint32_t {
+    PCF = 0,  // 16-tap rotated Poisson disk on the depth array
+    EVSM = 1, // one filtered tap of the prefiltered moment array
 };
 
 class Engine {
@@ -49,17 +72,58 @@ public:
 
 private:
     static constexpr uint32_t MAX_SWAPCHAIN_IMAGES = 4;
-    static constexpr uint32_t MAX_POINT_LIGHTS = 256;
-    static constexpr uint32_t SHADOW_MAP_SIZE = 4096;
-    static constexpr uint32_t SHADOW_CASCADE_COUNT = 3;
+    // Point light SSBO starts at this many lights and doubles on demand
+    static constexpr uint32_t INITIAL_POINT_LIGHT_CAPACITY = 256;
+    // Per-frame cap of the camera-visible light list light_cluster.comp iterates
+    static constexpr uint32_t MAX_VISIBLE_POINT_LIGHTS = 4096;
+    // Directional shadows: up to MAX_SHADOW_CASCADES cascades of power-of-two sizes, packed
+    // into one depth atlas. Count, sizes and depth format are runtime ShadowSettings.
+    static constexpr uint32_t MAX_SHADOW_CASCADES = 4;
+    static constexpr uint32_t MIN_SHADOW_CASCADE_SIZE = 256;
+    static constexpr uint32_t MAX_SHADOW_CASCADE_SIZE = 4096;
     static constexpr float SHADOW_DISTANCE = 100.0f;
+    // Cached cascades are fitted this much larger than needed, so the camera can drift by
+    // that fraction of the cascade radius before the cascade is re-fitted and re-rendered
+    static constexpr float SHADOW_CACHE_MARGIN = 0.1f;
+    // Cascades past the first redraw moved dynamic casters only every Nth frame, staggered
+    static constexpr uint32_t SHADOW_FAR_CASCADE_INTERVAL = 2;
+    // EVSM moments: RGBA32F per cascade, each texel resolves 4x4 shadow map texels
+    static constexpr uint32_t SHADOW_MOMENTS_SIZE = 1024;
+    static constexpr uint32_t SHADOW_MOMENTS_MIP_COUNT = 4;
+    // Shadowed point and spot lights: one D16 atlas split into bands of fixed-size square
+    // tiles, LOCAL_SHADOW_TILE_SIZES[c] texels in a band LOCAL_SHADOW_BAND_HEIGHTS[c] high.
+    // A shadowed light holds one view slot of LOCAL_SHADOW_FACES views (point lights use
+    // all six cube faces, spot lights the first) and one tile per view, all of one size.
+    static constexpr uint32_t LOCAL_SHADOW_ATLAS_SIZE = 4096;
+    static constexpr uint32_t LOCAL_SHADOW_TILE_CLASSES = 3;
+    static constexpr uint32_t LOCAL_SHADOW_TILE_SIZES[LOCAL_SHADOW_TILE_CLASSES] = {512, 256, 128};
+    static constexpr uint32_t LOCAL_SHADOW_BAND_HEIGHTS[LOCAL_SHADOW_TILE_CLASSES] = {2048, 1024, 1024};
+    static constexpr uint32_t LOCAL_SHADOW_FACES = 6;         // must match lighting.frag
+    static constexpr uint32_t MAX_SHADOWED_LOCAL_LIGHTS = 64; // view slots
     static constexpr uint32_t BLOOM_MIP_COUNT = 6;
-
+    // Meshlet culling views: camera + one per shadow cascade (CULL_VIEW_COUNT in meshlet_cull.comp)
+    static constexpr uint32_t CULL_VIEW_COUNT = 1 + MAX_SHADOW_CASCADES;
+    static constexpr uint32_t CULL_VIEW_CAMERA = 0;
+    // Clustered lighting froxel grid: screen tiles x exponential depth slices (light_cluster.comp)
+    static constexpr uint32_t CLUSTER_GRID_X = 16;
+    static constexpr uint32_t CLUSTER_GRID_Y = 9;
+    static constexpr uint32_t CLUSTER_GRID_Z = 24;
+    static constexpr uint32_t CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+    static constexpr uint32_t CLUSTER_MAX_LIGHTS = 256;           // per froxel
+    static constexpr uint32_t CLUSTER_LIGHT_INDEX_CAPACITY = CLUSTER_COUNT * 64;
+    // Lighting pass tile classes: sky, unlit, simple, complex (tile_classify.comp)
+    static constexpr uint32_t LIGHTING_TILE_SIZE = 16;
+    static constexpr uint32_t TILE_CLASS_COUNT = 4;
+
+    bool initMeshletCullPass();
+    bool initLightClusterPass();
+    bool initTileClassifyPass();
     bool initShadowPass();
+    bool initShadowFilterPass();
+    bool initLocalShadowPass();
     bool initGBufferPass();
     void initIBL();
     bool initLightingPass();
-    bool initSkyboxPass();
     bool initSSAOPass();
     bool initBloomPass();
     bool initMotionPass();
@@ -70,13 +134,18 @@ private:
     void buildImGui();
     void recordImGuiPass(VkCommandBuffer cmd, uint32_t imageIndex);
     void setupDemoScene();
+    void scatterPointLights(uint32_t count);
     void recordCommands(VkCommandBuffer cmd, uint32_t imageIndex);
+    void recordMeshletCullPass(VkCommandBuffer cmd);
+    void recordLightClusterPass(VkCommandBuffer cmd);
     void recordShadowPass(VkCommandBuffer cmd);
+    void recordShadowFilterPass(VkCommandBuffer cmd, uint32_t cascadeMask);
+    void recordLocalShadowPass(VkCommandBuffer cmd);
     void recordGBufferPass(VkCommandBuffer cmd);
+    void recordTileClassifyPass(VkCommandBuffer cmd);
     void recordSSAOPass(VkCommandBuffer cmd);
     void recordSSAOBlurPass(VkCommandBuffer cmd);
     void recordLightingPass(VkCommandBuffer cmd);
-    void recordSkyboxPass(VkCommandBuffer cmd);
     void recordBloomPass(VkCommandBuffer cmd);
     void recordMotionPass(VkCommandBuffer cmd);
     void recordTAAPass(VkCommandBuffer cmd);
@@ -89,11 +158,35 @@ private:
     void createVelocityImage();
     void createTAAImages();
     void createLDRImage();
-    void createShadowMap();
+    void layoutShadowAtlas();
+    void createShadowAtlas();
+    void destroyShadowAtlas();
+    void rebuildShadowAtlas();
+    void createShadowPipelines();
     void createSSAOImages();
     void createBloomImages();
-    void computeCascades(mat4 cascadeVP[SHADOW_CASCADE_COUNT], vec4& splits);
+    void createTileClassBuffer();
+    struct CascadeFit {
+        vec3 center;
+        float radius;
+    };
+    void computeCascades(CascadeFit fits[MAX_SHADOW_CASCADES], vec4& splits);
+    mat4 cascadeViewProj(const vec3& center, float radius, const vec3& lightDir, uint32_t resolution) const;
+    void updateShadowCascades(vec4& splits);
+    void readDepthBounds();
+    void recordShadowCasters(VkCommandBuffer cmd, VkImageView target, uint32_t cascadeMask,
+                             uint32_t clearMask, bool dynamicCasters);
+    void updateLocalShadows(const mat4& cameraViewProj);
+    bool allocateLocalShadow(uint32_t lightIndex, uint32_t tileClass, uint32_t tileCount);
+    void releaseLocalShadow(uint32_t lightIndex);
+    mat4 localShadowViewProj(const PointLight& light, uint32_t face) const;
+    void updateMeshletCulling(const mat4& cameraViewProj);
+    void updateTextureStreaming(const mat4& cameraViewProj);
+    bool growPointLightBuffer(uint32_t lightCount);
+    uint32_t updatePointLights(const mat4& cameraViewProj);
+    void drawEntityMesh(VkCommandBuffer cmd, size_t entityIndex, uint32_t cullView);
     void updateLightingDescriptors();
+    void updateShadowFilterDescriptors();
     void updateAADescriptors();
 
     Window m_window;
@@ -101,8 +194,16 @@ private:
     VulkanContext m_vkCtx;
     Swapchain m_swapchain;
     CommandPool m_cmdPool;
+    UploadManager m_uploads;
     FrameSync m_frameSync;
+    FrameAllocator m_frameAlloc; // per-frame UBO / light / cull data, bound with dynamic offsets
     DescriptorManager m_descriptors;
+    static constexpr const char* PACK_PATH = "data.lpak";
+    PackFile m_pack;                    // mounted for every file loader while open
+    AsyncFileReader m_fileReader;       // io_uring reads feeding m_textureDecoder
+    TextureDecodePool m_textureDecoder; // texture files read, decoded and uploaded in a pipeline
+    TextureStreamer m_textureStreamer;
+    VirtualTextureSystem m_virtualTextures; // set 1 of the G-buffer pass
 
     std::vector<VkCommandBuffer> m_cmdBuffers;
 
@@ -125,9 +226,86 @@ private:
     // LDR intermediate (tonemap output, FXAA input)
     Image m_ldrImage;
 
-    // Shadow map (D32_SFLOAT 2D array, 3 cascades)
+    // Directional shadow configuration. The UI edits m_shadowSettingsUI; the atlas is
+    // rebuilt with it before the next frame.
+    struct ShadowSettings {
+        uint32_t cascadeCount = 3;
+        uint32_t cascadeSize[MAX_SHADOW_CASCADES] = {2048, 2048, 1024, 1024};
+        bool depth16 = false; // D16_UNORM instead of D32_SFLOAT
+    };
+    struct ShadowAtlasRect {
+        uint32_t x, y;  // texel offset in the atlas
+        uint32_t size;  // square, ShadowSettings::cascadeSize
+    };
+    ShadowSettings m_shadowSettings;
+    ShadowSettings m_shadowSettingsUI;
+    bool m_shadowAtlasDirty = false;
+
+    // Shadow atlas: one 2D depth image holding every cascade at its own resolution,
+    // rendered in one pass through per-cascade viewports. Each cascade's static casters
+    // are cached in m_shadowStaticCache (same layout); a refresh copies that region over
+    // and draws the dynamic casters on top.
     Image m_shadowMap;
-    VkImageView m_shadowLayerViews[SHADOW_CASCADE_COUNT]{};
+    Image m_shadowStaticCache;
+    VkFormat m_shadowFormat = VK_FORMAT_D32_SFLOAT;
+    VkExtent2D m_shadowAtlasExtent{};
+    ShadowAtlasRect m_shadowAtlasRects[MAX_SHADOW_CASCADES]{};
+
+    // Sample distribution shadow maps: tile_classify.comp reduces the view-depth range of
+    // the visible geometry, which is copied to host memory and fits next frame's cascades
+    Buffer m_depthBoundsBuffer;   // uint min/max view Z bits, reset every frame
+    Buffer m_depthBoundsReadback; // host-visible copy
+    bool m_depthBoundsPending = false;
+    vec2 m_visibleDepthRange{0.0f}; // last read back, y <= x when nothing was visible
+
+    // Local light shadow atlas (D16, LOCAL_SHADOW_ATLAS_SIZE square) and the matrix and
+    // atlas rect of every view slot (set 0 bindings 17/18). A view's entry is only replaced
+    // when the view is re-rendered, so stale tiles stay consistent with their matrices.
+    struct LocalShadowPool {
+        uint32_t tileSize = 0;
+        uint32_t originY = 0;       // first atlas row of the band
+        uint32_t columns = 0;
+        std::vector<uint32_t> owner; // per tile: light index, UINT32_MAX when free
+    };
+    // Per point light, see updateLocalShadows()
+    struct LocalShadow {
+        uint32_t slot = UINT32_MAX;  // view slot, UINT32_MAX while the light holds no tiles
+        uint32_t tileClass = 0;
+        uint32_t tileCount = 0;
+        uint32_t tiles[LOCAL_SHADOW_FACES]{};
+        uint64_t lastUsed = 0;       // LRU key: m_localShadowClock when last visible and shadowed
+        PointLight renderedLight;    // light state the tiles were rendered with
+        uint64_t staticVersion = 0;  // Scene::staticGeometryVersion() of the tiles
+        bool rendered = false;       // tiles hold this light's shadow (possibly stale)
+        bool dirty = false;          // re-render when the budget allows
+        uint32_t gpuSlot = UINT32_MAX; // GPUPointLight::shadowSlot as last uploaded
+    };
+    struct GPULocalShadowView { // must match LocalShadowView in lighting.frag
+        mat4 viewProj;
+        vec4 atlasRect;            // xy = offset, zw = size in atlas UV
+    };
+    struct LocalShadowRender {
+        uint32_t view;             // slot * LOCAL_SHADOW_FACES + face
+        GPULocalShadowView data;
+        VkRect2D tile;
+    };
+    Image m_localShadowAtlas;
+    Buffer m_localShadowViews;
+    LocalShadowPool m_localShadowPools[LOCAL_SHADOW_TILE_CLASSES];
+    std::vector<LocalShadow> m_localShadows;      // indexed like Scene::pointLights()
+    std::vector<uint32_t> m_shadowedLights;       // lights holding a slot
+    std::vector<uint32_t> m_freeLocalShadowSlots;
+    uint64_t m_localShadowClock = 0;              // ticks once per updateLocalShadows(), never reset
+    std::vector<LocalShadowRender> m_localShadowRenders; // views re-rendered this frame
+    std::vector<vec4> m_movedCasterSpheres;       // old and new bounds of dynamic casters moved this frame
+
+    // EVSM moments of the shadow atlas (RGBA32F 2D array, one layer per cascade,
+    // SHADOW_MOMENTS_MIP_COUNT mips), only maintained while the EVSM filter is selected
+    Image m_shadowMoments;
+    Image m_shadowMomentsTemp; // blur intermediate, mip 0 only
+    VkImageView m_shadowMomentsMipViews[SHADOW_MOMENTS_MIP_COUNT]{};
+    VkSampler m_shadowMomentsSampler = VK_NULL_HANDLE; // trilinear, clamp-to-edge
+    bool m_evsmSupported = false; // RGBA32F storage + linear filtering
 
     // IBL resources
     Image m_envCubemap;        // 512x512 sky cubemap
@@ -151,18 +329,70 @@ private:
     // Scene
     Scene m_scene;
 
-    // Shadow pass
+    // Meshlet culling (compute, feeds indirect draws of the shadow and G-buffer passes)
+    struct MeshletCullFrame {
+        Buffer draws;      // VkDrawIndexedIndirectCommand, CULL_VIEW_COUNT x drawCapacity
+        Buffer counts;     // surviving draws per (view, object)
+        VkDescriptorSet set = VK_NULL_HANDLE;
+        uint32_t objectCapacity = 0;
+        uint32_t drawCapacity = 0;
+        // Frame allocator offsets: GPUCullView[CULL_VIEW_COUNT], GPUCullObject[objectCapacity]
+        uint32_t dynamicOffsets[2]{};
+    };
+    MeshletCullFrame m_meshletCull[MAX_SWAPCHAIN_IMAGES];
+    VkPipelineLayout m_meshletCullPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_meshletCullPipeline = VK_NULL_HANDLE;
+    ShaderModule m_meshletCullComp;
+    VkDescriptorSetLayout m_meshletCullSetLayout = VK_NULL_HANDLE;
+    std::vector<uint32_t> m_entityCullObject; // entity index -> cull object, UINT32_MAX if drawn directly
+    std::vector<uint32_t> m_cullDrawOffsets;  // cull object -> first draw slot in each view range
+    uint32_t m_cullObjectCount = 0;
+
+    // Clustered light assignment (compute, feeds the lighting pass through set 0 bindings 10/11)
+    VkPipelineLayout m_lightClusterPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_lightClusterPipeline = VK_NULL_HANDLE;
+    ShaderModule m_lightClusterComp;
+    Buffer m_clusterGrid;          // uvec2 (first index, count) per froxel
+    Buffer m_clusterLightIndices;  // uint counter followed by CLUSTER_LIGHT_INDEX_CAPACITY indices
+
+    // Point lights (set 0 binding 1), persistent and device-local. Only the Scene's dirty
+    // ranges are uploaded; the per-frame visible list goes through m_frameAlloc (binding 14).
+    Buffer m_pointLightBuffer;
+    uint32_t m_pointLightCapacity = 0;
+    uint32_t m_visiblePointLightCount = 0;
+    std::vector<PointLightRange> m_dirtyPointLights;
+
+    // Lighting tile classification (compute, feeds the lighting draws through set 0 binding 12)
+    VkPipelineLayout m_tileClassifyPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_tileClassifyPipeline = VK_NULL_HANDLE;
+    ShaderModule m_tileClassifyComp;
+    Buffer m_tileClassBuffer;      // VkDrawIndirectCommand per class, then TILE_CLASS_COUNT tile lists
+    uint32_t m_tileGridX = 0;
+    uint32_t m_tileGridY = 0;
+
+    // Shadow pass (position stream only, one pipeline per position encoding, dynamic stride)
     VkPipelineLayout m_shadowPipelineLayout = VK_NULL_HANDLE;
-    VkPipeline m_shadowPipeline = VK_NULL_HANDLE;
+    VkPipeline m_shadowPipelines[POSITION_ENCODING_COUNT]{};
     ShaderModule m_shadowVert;
 
-    // Skybox pass
-    VkPipelineLayout m_skyboxPipelineLayout = VK_NULL_HANDLE;
-    VkPipeline m_skyboxPipeline = VK_NULL_HANDLE;
-    ShaderModule m_skyboxVert;
-    ShaderModule m_skyboxFrag;
-    VkDescriptorSetLayout m_skyboxSetLayout = VK_NULL_HANDLE;
-    VkDescriptorSet m_skyboxSet = VK_NULL_HANDLE;
+    // Local light shadow pass (position stream only, light MVP in MeshPushConstants)
+    VkPipelineLayout m_localShadowPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_localShadowPipelines[POSITION_ENCODING_COUNT]{};
+    ShaderModule m_localShadowVert;
+
+    // EVSM prefilter (compute): resolve depth to moments, separable blur, mip chain.
+    // Set bindings: 0 = depth source, 1 = moment source, 2 = moment destination.
+    VkPipelineLayout m_shadowFilterPipelineLayout = VK_NULL_HANDLE;
+    VkPipeline m_evsmResolvePipeline = VK_NULL_HANDLE;
+    VkPipeline m_evsmBlurPipeline = VK_NULL_HANDLE;
+    VkPipeline m_evsmDownsamplePipeline = VK_NULL_HANDLE;
+    ShaderModule m_evsmResolveComp;
+    ShaderModule m_evsmBlurComp;
+    ShaderModule m_evsmDownsampleComp;
+    VkDescriptorSetLayout m_shadowFilterSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSet m_evsmResolveSet = VK_NULL_HANDLE;
+    VkDescriptorSet m_evsmBlurSets[2]{};                        // moments -> temp, temp -> moments
+    VkDescriptorSet m_evsmDownsampleSets[SHADOW_MOMENTS_MIP_COUNT]{}; // [i] writes mip i, [0] unused
 
     // SSAO pass
     VkPipelineLayout m_ssaoPipelineLayout = VK_NULL_HANDLE;
@@ -187,17 +417,19 @@ private:
     ShaderModule m_bloomUpFrag;
     VkDescriptorSetLayout m_bloomSetLayout = VK_NULL_HANDLE;
 
-    // G-Buffer pass
+    // G-Buffer pass (one pipeline per mesh vertex format)
     VkPipelineLayout m_gbufferPipelineLayout = VK_NULL_HANDLE;
-    VkPipeline m_gbufferPipeline = VK_NULL_HANDLE;
+    VkPipeline m_gbufferPipelines[VERTEX_FORMAT_COUNT]{};
     ShaderModule m_gbufferVert;
+    ShaderModule m_gbufferPackedVert;
     ShaderModule m_gbufferFrag;
     VkDescriptorSetLayout m_materialSetLayout = VK_NULL_HANDLE;
 
-    // Lighting pass
+    // Lighting pass (one pipeline per tile class, sky included)
     VkPipelineLayout m_lightingPipelineLayout = VK_NULL_HANDLE;
-    VkPipeline m_lightingPipeline = VK_NULL_HANDLE;
+    VkPipeline m_lightingPipelines[TILE_CLASS_COUNT]{};
     ShaderModule m_fullscreenVert;
+    ShaderModule m_tileVert;
     ShaderModule m_lightingFrag;
 
     // Motion vectors pass
@@ -232,13 +464,10 @@ private:
     VkSampler m_shadowSampler = VK_NULL_HANDLE;  // comparison sampler for shadow maps
     VkSampler m_repeatSampler = VK_NULL_HANDLE;  // nearest, repeat
 
-    // Point lights SSBO
-    Buffer m_pointLightBuffers[MAX_SWAPCHAIN_IMAGES];
-
-    // Global UBO
-    Buffer m_uniformBuffers[MAX_SWAPCHAIN_IMAGES];
+    // Global UBO + visible point light list, both living in m_frameAlloc
     VkDescriptorSetLayout m_globalSetLayout = VK_NULL_HANDLE;
-    VkDescriptorSet m_globalSets[MAX_SWAPCHAIN_IMAGES]{};
+    VkDescriptorSet m_globalSet = VK_NULL_HANDLE;
+    uint32_t m_globalOffsets[2]{}; // dynamic offsets of this frame's GlobalUBO and visible light indices
 
     struct GlobalUBO {
         mat4 view;
@@ -248,25 +477,96 @@ private:
         mat4 prevViewProj;    // unjittered previous
         vec4 cameraPos;
         float time;
-        uint32_t pointLightCount;
+        uint32_t pointLightCount; // entries in the visible light list
         float jitterX;
         float jitterY;
         vec4 dirLightDir;     // xyz = direction, w unused
         vec4 dirLightColor;   // xyz = color, w = intensity
         vec4 resolution;      // xy = width/height, zw = 1/width, 1/height
-        mat4 cascadeViewProj[3];
-        vec4 cascadeSplits;   // xyz = split depths (view-space), w = shadow bias
+        mat4 cascadeViewProj[MAX_SHADOW_CASCADES];
+        vec4 cascadeSplits;   // xyz = far depth (view-space) of cascades 0..2, w = shadow bias
         float iblIntensity;
         float ssaoRadius;
         float ssaoBias;
         float bloomIntensity;
+        vec4 clusterParams;   // x = slice scale, y = slice bias, z = near, w = far
+        vec4 cascadeAtlasRects[MAX_SHADOW_CASCADES]; // xy = offset, zw = size in shadow atlas UV
+        uint32_t cascadeCount;
+    };
+
+    // Meshlet cull inputs, std430 layouts from meshlet_cull.comp
+    struct GPUCullView {
+        vec4 frustumPlanes[6];  // world space, normals pointing inside
+        vec4 origin;            // xyz = eye, w = 1 perspective / 0 orthographic
+        vec4 direction;         // xyz = view direction, w = facing sign of culled triangles
+    };
+
+    struct GPUCullObject {
+        mat4 model;
+        VkDeviceAddress meshlets;
+        uint32_t meshletCount;
+        uint32_t drawOffset;
+        float radiusScale;
+        uint32_t coneCulling;
+        uint32_t padding[2];
+    };
+    static_assert(sizeof(GPUCullObject) == 96, "GPUCullObject must match CullObject in meshlet_cull.comp");
+
+    struct MeshletCullPushConstants {
+        uint32_t objectCount;
+        uint32_t objectStride;
+        uint32_t drawStride;
+        uint32_t flags;         // bit 0 = frustum, bit 1 = normal cone
+    };
+
+    // Per-draw push constants for mesh passes (G-buffer: model, shadow: light MVP)
+    struct MeshPushConstants {
+        mat4 transform;
+        vec4 positionScale;   // mesh dequantization, see Mesh::positionScale()
+        vec4 positionOffset;
+    };
+
+    // Must match ShadowPC in shadow.vert / shadow_single.vert
+    struct ShadowPushConstants {
+        mat4 model;           // cascade matrices come from GlobalUBO::cascadeViewProj
+        vec4 positionScale;
+        vec4 positionOffset;
+        uint32_t cascadeMask;
+    };
+
+    // Must match FilterPC in evsm_resolve.comp (the blur and downsample read the first two)
+    struct ShadowFilterPushConstants {
+        uint32_t cascadeMask;
+        uint32_t horizontal;
+        uint32_t padding[2];
+        uint32_t atlasRects[MAX_SHADOW_CASCADES][4]; // x, y, size, unused
     };
 
     // Previous frame state for TAA
     mat4 m_prevViewProj{1.0f};
 
-    // Cascade shadow map VP matrices (computed per frame, used by recordShadowPass)
-    mat4 m_cascadeVP[SHADOW_CASCADE_COUNT];
+    // Cascade shadow map VP matrices: the ones the current atlas regions were rendered with
+    mat4 m_cascadeVP[MAX_SHADOW_CASCADES];
+
+    // Per-cascade cache validity, see updateShadowCascades()
+    struct ShadowCascadeCache {
+        mat4 viewProj{1.0f};
+        vec3 center{0.0f};          // unpadded fit the regions were rendered for
+        float radius = 0.0f;
+        vec3 lightDir{0.0f};
+        uint64_t staticVersion = 0; // Scene::staticGeometryVersion() of the static region
+        bool staticValid = false;   // static region matches viewProj
+        bool dynamicDirty = false;  // dynamic casters moved since the last refresh
+    };
+    enum class ShadowRefresh : uint8_t {
+        None,    // reuse last frame's region
+        Dynamic, // copy the static region, redraw dynamic casters
+        Full,    // re-render the static region too
+    };
+    ShadowCascadeCache m_shadowCache[MAX_SHADOW_CASCADES];
+    ShadowRefresh m_shadowRefresh[MAX_SHADOW_CASCADES]{};
+    std::vector<mat4> m_shadowCasterTransforms; // per entity, last model matrix seen for dynamic casters
+    bool m_hasDynamicCasters = false;
 
     // ImGui
     VkDescriptorPool m_imguiPool = VK_NULL_HANDLE;
@@ -279,14 +579,25 @@ private:
     float m_ssaoRadiusUI = 0.5f;
     float m_ssaoBiasUI = 0.025f;
     float m_iblIntensityUI = 1.0f;
+    bool m_meshletCullingEnabled = true;
+    bool m_meshletConeCullingEnabled = true;
+    bool m_shadowCachingEnabled = true;
+    bool m_sdsmEnabled = true; // fit cascade splits to the visible depth range
+    bool m_localShadowsEnabled = true;
+    int m_localShadowBudgetUI = 12; // local shadow views re-rendered per frame at most
+    uint32_t m_localShadowPending = 0; // views left waiting for the budget last frame
+    int m_textureBudgetMB = static_cast<int>(TextureStreamer::DEFAULT_BUDGET >> 20);
+    ShadowFilter m_shadowFilter = ShadowFilter::PCF;
+    bool m_spinDynamicCaster = false;
+    size_t m_dynamicDemoEntity = SIZE_MAX;
+    int m_extraPointLightsUI = 0;
+    uint32_t m_demoPointLightCount = 0;  // hand-placed lights, scattered ones follow
 
     // Debug
     DebugMode m_debugMode = DebugMode::Final;
 
-    // Asset caches
-    std::vector<std::shared_ptr<Mesh>> m_meshes;
-    std::vector<std::shared_ptr<Texture>> m_textures;
-    std::vector<std::shared_ptr<Material>> m_materials;
+    // Meshes, textures and materials, addressed by handle from the scene
+    AssetRegistry m_assets;
 
     bool m_resizeNeeded = false;
 };
@@ -0,0 +1,11 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace lmao {
+
+// XXH64 (Yann Collet, xxHash). Used for asset checksums: fast enough to verify a file at
+// disk bandwidth, and the output matches the reference implementation for any seed.
+uint64_t xxHash64(const void* data, size_t size, uint64_t seed = 0);
+
+} // namespace lmao
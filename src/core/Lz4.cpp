@@ -0,0 +1,155 @@
+#include "core/Lz4.h"
+#include <cstring>
+#include <memory>
+
+namespace lmao {
+
+namespace {
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t LAST_LITERALS = 5;  // the block always ends in at least this many literals
+constexpr size_t MF_LIMIT = 12;      // no match may start closer than this to the end
+constexpr size_t MAX_OFFSET = 65535;
+constexpr uint32_t HASH_BITS = 16;
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hashSequence(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - HASH_BITS); }
+
+// Length continuation bytes after a saturated 4-bit token field
+uint8_t* writeLength(uint8_t* out, size_t length) {
+    for (; length >= 255; length -= 255) *out++ = 255;
+    *out++ = static_cast<uint8_t>(length);
+    return out;
+}
+
+bool readLength(const uint8_t*& in, const uint8_t* end, size_t& length) {
+    uint8_t byte;
+    do {
+        if (in >= end) return false;
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+// Token + length bytes + literals + offset + length bytes, worst case
+size_t sequenceBound(size_t literalLength, size_t matchLength) {
+    return 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1;
+}
+} // anonymous namespace
+
+size_t lz4CompressBound(size_t size) { return size + size / 255 + 16; }
+
+size_t lz4Compress(const void* source, size_t size, void* destination, size_t capacity) {
+    const uint8_t* src = static_cast<const uint8_t*>(source);
+    const uint8_t* end = src + size;
+    uint8_t* dst = static_cast<uint8_t*>(destination);
+    uint8_t* dstEnd = dst + capacity;
+    uint8_t* out = dst;
+    const uint8_t* anchor = src;
+
+    if (size > MF_LIMIT) {
+        // Positions of the last occurrence of each hashed 4-byte sequence
+        auto table = std::make_unique<uint32_t[]>(size_t(1) << HASH_BITS);
+        const uint8_t* matchLimit = end - LAST_LITERALS;
+        const uint8_t* mfLimit = end - MF_LIMIT;
+        const uint8_t* ip = src + 1;
+        table[hashSequence(read32(src))] = 0;
+
+        while (ip < mfLimit) {
+            uint32_t sequence = read32(ip);
+            uint32_t& slot = table[hashSequence(sequence)];
+            const uint8_t* ref = src + slot;
+            slot = static_cast<uint32_t>(ip - src);
+            if (ref >= ip || static_cast<size_t>(ip - ref) > MAX_OFFSET || read32(ref) != sequence) {
+                // Step faster through data that keeps missing
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const uint8_t* matchEnd = ip + MIN_MATCH;
+            for (const uint8_t* r = ref + MIN_MATCH; matchEnd < matchLimit && *matchEnd == *r; r++)
+                matchEnd++;
+
+            size_t literalLength = static_cast<size_t>(ip - anchor);
+            size_t matchLength = static_cast<size_t>(matchEnd - ip) - MIN_MATCH;
+            if (sequenceBound(literalLength, matchLength) > static_cast<size_t>(dstEnd - out)) return 0;
+
+            uint8_t* token = out++;
+            *token = static_cast<uint8_t>((literalLength >= 15 ? 15 : literalLength) << 4);
+            if (literalLength >= 15) out = writeLength(out, literalLength - 15);
+            std::memcpy(out, anchor, literalLength);
+            out += literalLength;
+
+            size_t offset = static_cast<size_t>(ip - ref);
+            *out++ = static_cast<uint8_t>(offset);
+            *out++ = static_cast<uint8_t>(offset >> 8);
+            *token |= static_cast<uint8_t>(matchLength >= 15 ? 15 : matchLength);
+            if (matchLength >= 15) out = writeLength(out, matchLength - 15);
+
+            ip = matchEnd;
+            anchor = ip;
+            // Seed the table inside the match so back-to-back repeats are found
+            table[hashSequence(read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - src);
+        }
+    }
+
+    size_t literalLength = static_cast<size_t>(end - anchor);
+    if (1 + literalLength / 255 + 1 + literalLength > static_cast<size_t>(dstEnd - out)) return 0;
+    uint8_t* token = out++;
+    *token = static_cast<uint8_t>((literalLength >= 15 ? 15 : literalLength) << 4);
+    if (literalLength >= 15) out = writeLength(out, literalLength - 15);
+    std::memcpy(out, anchor, literalLength);
+    out += literalLength;
+    return static_cast<size_t>(out - dst);
+}
+
+bool lz4Decompress(const void* source, size_t srcSize, void* destination, size_t dstSize) {
+    const uint8_t* ip = static_cast<const uint8_t*>(source);
+    const uint8_t* ipEnd = ip + srcSize;
+    uint8_t* dst = static_cast<uint8_t*>(destination);
+    uint8_t* op = dst;
+    uint8_t* opEnd = dst + dstSize;
+
+    while (ip < ipEnd) {
+        uint8_t token = *ip++;
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(ip, ipEnd, literalLength)) return false;
+        if (literalLength > static_cast<size_t>(ipEnd - ip) || literalLength > static_cast<size_t>(opEnd - op))
+            return false;
+        std::memcpy(op, ip, literalLength);
+        op += literalLength;
+        ip += literalLength;
+        if (ip == ipEnd) break;  // the last sequence has no match
+
+        if (ipEnd - ip < 2) return false;
+        size_t offset = ip[0] | (size_t(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) return false;
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(ip, ipEnd, matchLength)) return false;
+        matchLength += MIN_MATCH;
+        if (matchLength > static_cast<size_t>(opEnd - op)) return false;
+
+        const uint8_t* match = op - offset;
+        if (offset >= matchLength) {
+            std::memcpy(op, match, matchLength);
+        } else {
+            // Overlapping: the match repeats the last `offset` bytes
+            for (size_t i = 0; i < matchLength; i++) op[i] = match[i];
+        }
+        op += matchLength;
+    }
+    return op == opEnd;
+}
+
+} // namespace lmao
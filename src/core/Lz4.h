@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace lmao {
+
+// LZ4 block format (no frame header): greedy single-probe matcher for packing assets,
+// bounds-checked decoder for loading them. Output decodes with the reference liblz4 and
+// vice versa. The decoder reads back its own output for matches, so decompress into
+// cached memory, not write-combined mappings.
+
+// Worst-case compressed size of size bytes
+size_t lz4CompressBound(size_t size);
+
+// Returns the compressed size, or 0 when it does not fit in capacity
+size_t lz4Compress(const void* src, size_t size, void* dst, size_t capacity);
+
+// dstSize must be the exact decompressed size; false on malformed or truncated input
+bool lz4Decompress(const void* src, size_t srcSize, void* dst, size_t dstSize);
+
+} // namespace lmao
@@ -0,0 +1,128 @@
+#include "core/MappedFile.h"
+#include "core/Log.h"
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lmao {
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile&& o) noexcept { *this = std::move(o); }
+
+MappedFile& MappedFile::operator=(MappedFile&& o) noexcept {
+    if (this != &o) {
+        close();
+        m_data = std::exchange(o.m_data, nullptr);
+        m_size = std::exchange(o.m_size, 0);
+        m_opened = std::exchange(o.m_opened, false);
+#ifdef _WIN32
+        m_file = std::exchange(o.m_file, nullptr);
+        m_mapping = std::exchange(o.m_mapping, nullptr);
+#else
+        m_fd = std::exchange(o.m_fd, -1);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG(Assets, Error, "Failed to open %s", path.c_str());
+        return false;
+    }
+    m_file = file;
+
+    LARGE_INTEGER size{};
+    GetFileSizeEx(file, &size);
+    m_size = static_cast<size_t>(size.QuadPart);
+    m_opened = true;
+    if (m_size == 0) return true;
+
+    m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mapping) {
+        LOG(Assets, Error, "Failed to create file mapping for %s", path.c_str());
+        close();
+        return false;
+    }
+    m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data) {
+        LOG(Assets, Error, "Failed to map %s", path.c_str());
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file) CloseHandle(m_file);
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_file = nullptr;
+    m_size = 0;
+    m_opened = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    m_fd = ::open(path.c_str(), O_RDONLY);
+    if (m_fd < 0) {
+        LOG(Assets, Error, "Failed to open %s", path.c_str());
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(m_fd, &st) != 0) {
+        LOG(Assets, Error, "Failed to stat %s", path.c_str());
+        close();
+        return false;
+    }
+    m_size = static_cast<size_t>(st.st_size);
+    m_opened = true;
+    if (m_size == 0) return true;
+
+    void* ptr = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (ptr == MAP_FAILED) {
+        LOG(Assets, Error, "Failed to map %s", path.c_str());
+        close();
+        return false;
+    }
+    // Whole-file consumers touch every page (often from several threads): start readahead now
+    madvise(ptr, m_size, MADV_WILLNEED);
+    m_data = static_cast<const uint8_t*>(ptr);
+    return true;
+}
+
+void MappedFile::close() {
+    if (m_data) munmap(const_cast<uint8_t*>(m_data), m_size);
+    if (m_fd >= 0) ::close(m_fd);
+    m_data = nullptr;
+    m_fd = -1;
+    m_size = 0;
+    m_opened = false;
+}
+
+#endif
+
+} // namespace lmao
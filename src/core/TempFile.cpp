@@ -0,0 +1,32 @@
+#include "core/TempFile.h"
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace lmao {
+
+std::string TempFile::pathFor(const std::string& path) {
+#ifdef _WIN32
+    unsigned long long pid = static_cast<unsigned long long>(_getpid());
+#else
+    unsigned long long pid = static_cast<unsigned long long>(getpid());
+#endif
+    size_t thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    return path + "." + std::to_string(pid) + "-" + std::to_string(thread) + ".tmp";
+}
+
+bool TempFile::replace(const std::string& tmpPath, const std::string& path, std::error_code& ec) {
+    std::filesystem::rename(tmpPath, path, ec);
+    if (!ec) return true;
+    std::error_code removeEc;
+    std::filesystem::remove(tmpPath, removeEc);
+    return false;
+}
+
+} // namespace lmao
@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include <system_error>
+
+namespace lmao {
+
+// Files that are replaced in place are written to a temporary sibling and renamed over
+// the target, so readers never see a partial file.
+class TempFile {
+public:
+    // <path>.<pid>-<thread>.tmp: unique across the processes and threads that may write the
+    // same file at once (e.g. lmao_cook and lmao_demo sharing a DDC)
+    static std::string pathFor(const std::string& path);
+    // Renames tmpPath over path; removes tmpPath when that fails
+    static bool replace(const std::string& tmpPath, const std::string& path, std::error_code& ec);
+};
+
+} // namespace lmao
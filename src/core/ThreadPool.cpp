@@ -0,0 +1,100 @@
+#include "core/ThreadPool.h"
+#include "core/Log.h"
+#include <algorithm>
+#include <atomic>
+
+namespace lmao {
+
+ThreadPool::~ThreadPool() { shutdown(); }
+
+bool ThreadPool::init(uint32_t threadCount) {
+    shutdown();
+    if (threadCount == 0)
+        threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    m_stopping = false;
+    m_workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; i++)
+        m_workers.emplace_back([this]() { workerLoop(); });
+
+    LOG(Core, Debug, "Thread pool started: %u workers", threadCount);
+    return true;
+}
+
+void ThreadPool::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_cv.notify_all();
+    for (auto& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+    m_tasks.clear();
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    if (m_workers.empty()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_cv.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+            if (m_stopping && m_tasks.empty()) return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& fn) {
+    if (count == 0) return;
+
+    struct State {
+        std::atomic<uint32_t> next{0};
+        std::atomic<uint32_t> done{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+    auto state = std::make_shared<State>();
+
+    // Helpers that start after all indices are taken exit without touching fn
+    auto run = [state, count, &fn]() {
+        for (uint32_t i = state->next.fetch_add(1); i < count; i = state->next.fetch_add(1)) {
+            fn(i);
+            if (state->done.fetch_add(1) + 1 == count) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->cv.notify_all();
+            }
+        }
+    };
+
+    uint32_t helpers = std::min(threadCount(), count - 1);
+    for (uint32_t i = 0; i < helpers; i++)
+        enqueue(run);
+    run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&]() { return state->done.load() == count; });
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    static std::once_flag started;
+    std::call_once(started, []() { pool.init(); });
+    return pool;
+}
+
+} // namespace lmao
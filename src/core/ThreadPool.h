@@ -0,0 +1,58 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace lmao {
+
+// Fixed set of worker threads draining a FIFO task queue. Used for CPU-side asset work
+// (parsing, decoding); nothing here touches Vulkan.
+class ThreadPool {
+public:
+    ThreadPool() = default;
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // threadCount = 0 picks hardware_concurrency - 1 (the caller is usually busy too)
+    bool init(uint32_t threadCount = 0);
+    void shutdown();
+
+    uint32_t threadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+    template <typename F>
+    auto submit(F&& fn) -> std::future<std::invoke_result_t<F>> {
+        using R = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(fn));
+        std::future<R> result = task->get_future();
+        enqueue([task]() { (*task)(); });
+        return result;
+    }
+
+    // Runs fn(i) for every i in [0, count) and returns when all calls finished. The calling
+    // thread takes indices too, so this is safe to call from inside a pool task.
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)>& fn);
+
+    // Process-wide pool, started on first use
+    static ThreadPool& shared();
+
+private:
+    void enqueue(std::function<void()> task);
+    void workerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stopping = false;
+};
+
+} // namespace lmao
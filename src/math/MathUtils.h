@@ -18,6 +18,7 @@ using mat4 = glm::mat4;
 using quat = glm::quat;
 using ivec2 = glm::ivec2;
 using uvec2 = glm::uvec2;
+using uvec4 = glm::uvec4;
 
 // Standard vertex format used throughout the engine.
 // Interleaved for GPU cache friendliness: 48 bytes per vertex, aligned to 16-byte boundaries.
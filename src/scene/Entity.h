@@ -1,18 +1,16 @@
 #pragma once
 #include "scene/Transform.h"
-#include <memory>
+#include "assets/AssetHandle.h"
 #include <string>
 
 namespace lmao {
 
-class Mesh;
-class Material;
-
 struct Entity {
     std::string name;
     Transform transform;
-    std::shared_ptr<Mesh> mesh;
-    std::shared_ptr<Material> material;
+    MeshHandle mesh;          // AssetRegistry handles; skipped while they do not resolve
+    MaterialHandle material;
+    bool dynamic = false; // moves at runtime: kept out of the cached static shadow layers
 
     Entity(const std::string& n = "Entity") : name(n) {}
 };
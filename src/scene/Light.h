@@ -10,11 +10,23 @@ struct DirectionalLight {
     float intensity = 1.0f;
 };
 
+enum class LocalLightType : uint32_t {
+    Point = 0,
+    Spot = 1, // cone around direction, outerAngle half-angle
+};
+
+// Local light with a finite range. Stored and uploaded as point lights; spot lights only add
+// the cone.
 struct PointLight {
     vec3 position{0, 0, 0};
     float range = 10.0f;
     vec3 color{1, 1, 1};
     float intensity = 1.0f;
+    LocalLightType type = LocalLightType::Point;
+    vec3 direction{0, -1, 0};  // spot only
+    float innerAngle = 0.35f;  // spot only, radians: full intensity inside
+    float outerAngle = 0.5f;   // spot only, radians: falls off to zero here
+    bool castShadows = false;  // gets tiles in the local shadow atlas, see Engine::updateLocalShadows
 };
 
 } // namespace lmao
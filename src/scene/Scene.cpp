@@ -1,18 +1,69 @@
 #include "scene/Scene.h"
 #include "core/Log.h"
+#include <algorithm>
 
 namespace lmao {
 
 Entity& Scene::createEntity(const std::string& name) {
     m_entities.emplace_back(name);
+    m_staticGeometryVersion++;
     LOG(Scene, Debug, "Entity created: %s", name.c_str());
     return m_entities.back();
 }
 
 PointLight& Scene::createPointLight() {
     m_pointLights.emplace_back();
+    markPointLightsDirty(static_cast<uint32_t>(m_pointLights.size() - 1), 1);
     LOG(Scene, Debug, "Point light created (total: %zu)", m_pointLights.size());
     return m_pointLights.back();
 }
 
+PointLight& Scene::editPointLight(size_t index) {
+    markPointLightsDirty(static_cast<uint32_t>(index), 1);
+    return m_pointLights[index];
+}
+
+void Scene::resizePointLights(size_t count) {
+    size_t oldCount = m_pointLights.size();
+    m_pointLights.resize(count);
+    if (count > oldCount)
+        markPointLightsDirty(static_cast<uint32_t>(oldCount), static_cast<uint32_t>(count - oldCount));
+}
+
+void Scene::clearPointLights() {
+    m_pointLights.clear();
+    m_dirtyPointLights.clear();
+}
+
+void Scene::markPointLightsDirty(uint32_t first, uint32_t count) {
+    // Sequential edits extend the last range; takeDirtyPointLights() merges the rest
+    if (!m_dirtyPointLights.empty()) {
+        PointLightRange& last = m_dirtyPointLights.back();
+        if (first >= last.first && first <= last.first + last.count) {
+            last.count = std::max(last.count, first + count - last.first);
+            return;
+        }
+    }
+    m_dirtyPointLights.push_back({first, count});
+}
+
+void Scene::takeDirtyPointLights(std::vector<PointLightRange>& out) {
+    std::sort(m_dirtyPointLights.begin(), m_dirtyPointLights.end(),
+              [](const PointLightRange& a, const PointLightRange& b) { return a.first < b.first; });
+
+    // Ranges past the end belong to lights removed since they were marked
+    uint32_t lightCount = static_cast<uint32_t>(m_pointLights.size());
+    size_t begin = out.size();
+    for (const PointLightRange& range : m_dirtyPointLights) {
+        uint32_t end = std::min(range.first + range.count, lightCount);
+        if (range.first >= end) continue;
+        if (out.size() > begin && range.first <= out.back().first + out.back().count) {
+            out.back().count = std::max(out.back().count, end - out.back().first);
+            continue;
+        }
+        out.push_back({range.first, end - range.first});
+    }
+    m_dirtyPointLights.clear();
+}
+
 } // namespace lmao
@@ -6,6 +6,12 @@
 
 namespace lmao {
 
+// Point lights [first, first + count) changed since the renderer last consumed them
+struct PointLightRange {
+    uint32_t first = 0;
+    uint32_t count = 0;
+};
+
 class Scene {
 public:
     Scene() = default;
@@ -14,21 +20,38 @@ public:
     const std::vector<Entity>& entities() const { return m_entities; }
     std::vector<Entity>& entities() { return m_entities; }
 
+    // Changes whenever static geometry may have changed; cached shadow layers are rebuilt
+    // then. createEntity() bumps it, in-place edits of static entities must call
+    // markStaticGeometryChanged(). Dynamic entities are tracked by the renderer.
+    uint64_t staticGeometryVersion() const { return m_staticGeometryVersion; }
+    void markStaticGeometryChanged() { m_staticGeometryVersion++; }
+
     Camera& camera() { return m_camera; }
     const Camera& camera() const { return m_camera; }
 
     DirectionalLight& directionalLight() { return m_dirLight; }
     const DirectionalLight& directionalLight() const { return m_dirLight; }
 
+    // Point lights are only mutable through these calls so the renderer can upload just
+    // the lights that changed
     PointLight& createPointLight();
+    PointLight& editPointLight(size_t index);
+    void resizePointLights(size_t count);
+    void clearPointLights();
     const std::vector<PointLight>& pointLights() const { return m_pointLights; }
-    std::vector<PointLight>& pointLights() { return m_pointLights; }
+
+    // Appends the sorted, merged dirty ranges to out and clears them
+    void takeDirtyPointLights(std::vector<PointLightRange>& out);
 
 private:
+    void markPointLightsDirty(uint32_t first, uint32_t count);
+
     Camera m_camera;
     DirectionalLight m_dirLight;
     std::vector<Entity> m_entities;
+    uint64_t m_staticGeometryVersion = 0;
     std::vector<PointLight> m_pointLights;
+    std::vector<PointLightRange> m_dirtyPointLights;
 };
 
 } // namespace lmao
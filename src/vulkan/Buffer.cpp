@@ -74,6 +74,15 @@ void Buffer::upload(const void* data, VkDeviceSize size, VkDeviceSize offset) {
     }
 }
 
+VkDeviceAddress Buffer::deviceAddress() const {
+    VmaAllocatorInfo allocatorInfo{};
+    vmaGetAllocatorInfo(m_allocator, &allocatorInfo);
+
+    VkBufferDeviceAddressInfo info{VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
+    info.buffer = m_buffer;
+    return vkGetBufferDeviceAddress(allocatorInfo.device, &info);
+}
+
 void Buffer::release() {
     if (m_buffer && m_allocator) {
         if (m_mapped) {
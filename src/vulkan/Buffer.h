@@ -28,6 +28,8 @@ public:
     VkBuffer handle() const { return m_buffer; }
     VkDeviceSize size() const { return m_size; }
     VmaAllocation allocation() const { return m_allocation; }
+    // Requires VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
+    VkDeviceAddress deviceAddress() const;
 
     // For persistently mapped buffers
     void* mapped() const { return m_mapped; }
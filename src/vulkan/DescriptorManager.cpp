@@ -14,6 +14,8 @@ bool DescriptorManager::init(VkDevice device, uint32_t maxSets) {
         {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, maxSets * 4},
         {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxSets * 8},
         {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxSets * 2},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, maxSets},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, maxSets},
         {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, maxSets * 2},
         {VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, maxSets},
     };
@@ -75,6 +77,10 @@ VkDescriptorSet DescriptorManager::allocate(VkDescriptorSetLayout layout) {
     return set;
 }
 
+void DescriptorManager::free(VkDescriptorSet set) {
+    if (m_pool) vkFreeDescriptorSets(m_device, m_pool, 1, &set);
+}
+
 void DescriptorManager::writeBuffer(VkDevice device, VkDescriptorSet set, uint32_t binding,
                                      VkBuffer buffer, VkDeviceSize size,
                                      VkDescriptorType type, VkDeviceSize offset) {
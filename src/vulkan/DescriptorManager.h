@@ -23,6 +23,8 @@ public:
 
     // Allocate a descriptor set
     VkDescriptorSet allocate(VkDescriptorSetLayout layout);
+    // Return a set to the pool; it must not be in use by pending work
+    void free(VkDescriptorSet set);
 
     // Write helpers
     static void writeBuffer(VkDevice device, VkDescriptorSet set, uint32_t binding,
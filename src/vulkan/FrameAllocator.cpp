@@ -0,0 +1,70 @@
+#include "vulkan/FrameAllocator.h"
+#include "vulkan/VulkanContext.h"
+#include "core/Log.h"
+#include <algorithm>
+
+namespace lmao {
+
+namespace {
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // anonymous namespace
+
+FrameAllocator::~FrameAllocator() { shutdown(); }
+
+bool FrameAllocator::init(VulkanContext& ctx, uint32_t frameCount, VkDeviceSize maxBindingRange,
+                          VkDeviceSize frameSize) {
+    const VkPhysicalDeviceLimits& limits = ctx.physicalDeviceProperties().limits;
+    m_alignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+    m_frameSize = alignUp(frameSize, m_alignment);
+    m_frameCount = frameCount;
+    m_allocator = ctx.allocator();
+
+    VkDeviceSize size = m_frameSize * m_frameCount + alignUp(maxBindingRange, m_alignment);
+    if (!m_buffer.init(m_allocator, size,
+            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VMA_MEMORY_USAGE_AUTO,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT))
+        return false;
+
+    m_frameBegin = m_head = 0;
+    LOG(Memory, Debug, "Frame allocator: %u x %llu KB, alignment %llu", m_frameCount,
+        (unsigned long long)(m_frameSize / 1024), (unsigned long long)m_alignment);
+    return true;
+}
+
+void FrameAllocator::shutdown() {
+    m_buffer.shutdown();
+    m_frameCount = 0;
+}
+
+void FrameAllocator::beginFrame(uint32_t frame) {
+    m_frameBegin = m_head = m_frameSize * frame;
+    m_exhausted = false;
+}
+
+void FrameAllocator::flush() {
+    if (m_head > m_frameBegin)
+        vmaFlushAllocation(m_allocator, m_buffer.allocation(), m_frameBegin, m_head - m_frameBegin);
+}
+
+FrameAllocation FrameAllocator::allocate(VkDeviceSize size) {
+    FrameAllocation alloc;
+    VkDeviceSize offset = alignUp(m_head, m_alignment);
+    if (offset + size > m_frameBegin + m_frameSize) {
+        if (!m_exhausted)
+            LOG(Memory, Warn, "Frame allocator exhausted (%llu of %llu bytes used, %llu requested)",
+                (unsigned long long)(m_head - m_frameBegin), (unsigned long long)m_frameSize,
+                (unsigned long long)size);
+        m_exhausted = true;
+        return alloc;
+    }
+
+    m_head = offset + size;
+    alloc.data = static_cast<uint8_t*>(m_buffer.mapped()) + offset;
+    alloc.offset = static_cast<uint32_t>(offset);
+    return alloc;
+}
+
+} // namespace lmao
@@ -0,0 +1,70 @@
+#pragma once
+#include "vulkan/Buffer.h"
+#include <volk.h>
+#include <cstdint>
+
+namespace lmao {
+
+class VulkanContext;
+
+// Sub-allocation from the current frame's region. offset is the dynamic offset to bind
+// the chunk with; data is null when the region is exhausted.
+struct FrameAllocation {
+    void* data = nullptr;
+    uint32_t offset = 0;
+
+    explicit operator bool() const { return data != nullptr; }
+};
+
+// Linear allocator for data rebuilt every frame (global UBO, light lists, per-object data).
+//
+// One persistently mapped buffer is split into a region per frame in flight. Producers
+// sub-allocate aligned chunks and write in place, descriptors reference the buffer once
+// with VK_DESCRIPTOR_TYPE_*_DYNAMIC and each bind passes the chunk offsets. A guard of
+// maxBindingRange bytes after the last region keeps fixed-range bindings in bounds even
+// when the chunk behind them is smaller than the range.
+class FrameAllocator {
+public:
+    static constexpr VkDeviceSize DEFAULT_FRAME_SIZE = 4ull * 1024 * 1024;
+
+    FrameAllocator() = default;
+    ~FrameAllocator();
+
+    FrameAllocator(const FrameAllocator&) = delete;
+    FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+    bool init(VulkanContext& ctx, uint32_t frameCount, VkDeviceSize maxBindingRange,
+              VkDeviceSize frameSize = DEFAULT_FRAME_SIZE);
+    void shutdown();
+
+    // Rewinds frame's region; its previous contents must no longer be in use by the GPU
+    void beginFrame(uint32_t frame);
+    // Makes this frame's writes visible to the device (no-op on host-coherent memory)
+    void flush();
+
+    FrameAllocation allocate(VkDeviceSize size);
+
+    template <typename T>
+    T* allocate(uint32_t count, uint32_t& offset) {
+        FrameAllocation alloc = allocate(sizeof(T) * count);
+        offset = alloc.offset;
+        return static_cast<T*>(alloc.data);
+    }
+
+    VkBuffer buffer() const { return m_buffer.handle(); }
+    VkDeviceSize frameSize() const { return m_frameSize; }
+    VkDeviceSize used() const { return m_head - m_frameBegin; }
+
+private:
+    Buffer m_buffer;
+    VmaAllocator m_allocator = VK_NULL_HANDLE;
+    VkDeviceSize m_alignment = 1;
+    VkDeviceSize m_frameSize = 0;
+    uint32_t m_frameCount = 0;
+
+    VkDeviceSize m_frameBegin = 0;
+    VkDeviceSize m_head = 0;
+    bool m_exhausted = false;
+};
+
+} // namespace lmao
@@ -10,7 +10,7 @@ Image::Image(Image&& o) noexcept
     : m_allocator(o.m_allocator), m_device(o.m_device), m_image(o.m_image),
       m_allocation(o.m_allocation), m_view(o.m_view), m_format(o.m_format),
       m_width(o.m_width), m_height(o.m_height), m_mipLevels(o.m_mipLevels),
-      m_samples(o.m_samples) {
+      m_samples(o.m_samples), m_memorySize(o.m_memorySize) {
     o.m_image = VK_NULL_HANDLE;
     o.m_allocation = VK_NULL_HANDLE;
     o.m_view = VK_NULL_HANDLE;
@@ -29,6 +29,7 @@ Image& Image::operator=(Image&& o) noexcept {
         m_height = o.m_height;
         m_mipLevels = o.m_mipLevels;
         m_samples = o.m_samples;
+        m_memorySize = o.m_memorySize;
         o.m_image = VK_NULL_HANDLE;
         o.m_allocation = VK_NULL_HANDLE;
         o.m_view = VK_NULL_HANDLE;
@@ -63,7 +64,9 @@ bool Image::init(VmaAllocator allocator, VkDevice device, const CreateInfo& info
     VmaAllocationCreateInfo allocInfo{};
     allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
 
-    VK_CHECK(vmaCreateImage(m_allocator, &imgInfo, &allocInfo, &m_image, &m_allocation, nullptr));
+    VmaAllocationInfo allocationInfo{};
+    VK_CHECK(vmaCreateImage(m_allocator, &imgInfo, &allocInfo, &m_image, &m_allocation, &allocationInfo));
+    m_memorySize = allocationInfo.size;
 
     VkImageViewCreateInfo viewInfo{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
     viewInfo.image = m_image;
@@ -111,6 +114,9 @@ void Image::transitionLayout(VkCommandBuffer cmd, VkImage image,
     } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
         barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
         barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_NONE;
     } else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
         barrier.srcStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
         barrier.srcAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
@@ -131,6 +137,9 @@ void Image::transitionLayout(VkCommandBuffer cmd, VkImage image,
     } else if (newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
         barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
         barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    } else if (newLayout == VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) {
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT;
     } else if (newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
         barrier.dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
         barrier.dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT;
@@ -159,6 +168,7 @@ void Image::release() {
         m_image = VK_NULL_HANDLE;
         m_allocation = VK_NULL_HANDLE;
     }
+    m_memorySize = 0;
 }
 
 } // namespace lmao
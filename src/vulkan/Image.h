@@ -38,6 +38,8 @@ public:
     uint32_t height() const { return m_height; }
     uint32_t mipLevels() const { return m_mipLevels; }
     VkSampleCountFlagBits samples() const { return m_samples; }
+    // Bytes of device memory backing the image (alignment and tiling padding included)
+    VkDeviceSize memorySize() const { return m_memorySize; }
 
     // Transition image layout using a command buffer
     static void transitionLayout(VkCommandBuffer cmd, VkImage image,
@@ -56,6 +58,7 @@ private:
     VkFormat m_format = VK_FORMAT_UNDEFINED;
     uint32_t m_width = 0, m_height = 0, m_mipLevels = 1;
     VkSampleCountFlagBits m_samples = VK_SAMPLE_COUNT_1_BIT;
+    VkDeviceSize m_memorySize = 0;
 };
 
 } // namespace lmao
@@ -132,6 +132,11 @@ PipelineBuilder& PipelineBuilder::setLayout(VkPipelineLayout layout) {
     return *this;
 }
 
+PipelineBuilder& PipelineBuilder::setViewportCount(uint32_t count) {
+    m_viewportCount = count;
+    return *this;
+}
+
 PipelineBuilder& PipelineBuilder::setColorFormats(const std::vector<VkFormat>& formats) {
     m_colorFormats = formats;
     return *this;
@@ -155,8 +160,8 @@ VkPipeline PipelineBuilder::build(VkDevice device) {
     m_dynamicState.pDynamicStates = m_dynamicStates.data();
 
     VkPipelineViewportStateCreateInfo viewportState{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
-    viewportState.viewportCount = 1;
-    viewportState.scissorCount = 1;
+    viewportState.viewportCount = m_viewportCount;
+    viewportState.scissorCount = m_viewportCount;
 
     // Dynamic rendering
     m_renderingInfo.colorAttachmentCount = static_cast<uint32_t>(m_colorFormats.size());
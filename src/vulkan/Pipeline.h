@@ -23,6 +23,7 @@ public:
     PipelineBuilder& setMultisample(VkSampleCountFlagBits samples);
     PipelineBuilder& setDynamicStates(const std::vector<VkDynamicState>& states);
     PipelineBuilder& setLayout(VkPipelineLayout layout);
+    PipelineBuilder& setViewportCount(uint32_t count); // viewports + scissors, all dynamic or all static
 
     // Dynamic rendering (Vulkan 1.3)
     PipelineBuilder& setColorFormats(const std::vector<VkFormat>& formats);
@@ -42,6 +43,7 @@ private:
     std::vector<VkDynamicState> m_dynamicStates;
     VkPipelineDynamicStateCreateInfo m_dynamicState{};
     VkPipelineLayout m_layout = VK_NULL_HANDLE;
+    uint32_t m_viewportCount = 1;
 
     // Dynamic rendering
     std::vector<VkFormat> m_colorFormats;
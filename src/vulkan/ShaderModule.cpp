@@ -1,5 +1,6 @@
 #include "vulkan/ShaderModule.h"
 #include "vulkan/VulkanUtils.h"
+#include "assets/PackFile.h"
 #include "core/Log.h"
 #include <fstream>
 
@@ -25,16 +26,26 @@ ShaderModule& ShaderModule::operator=(ShaderModule&& o) noexcept {
 bool ShaderModule::loadFromFile(VkDevice device, const std::string& path) {
     m_device = device;
 
-    std::ifstream file(path, std::ios::ate | std::ios::binary);
-    if (!file.is_open()) {
-        LOG(Pipeline, Error, "Failed to open shader file: %s", path.c_str());
-        return false;
-    }
+    // The mounted pack wins over loose files
+    std::vector<uint32_t> code;
+    size_t size = 0;
+    const PackFile* pack = PackFile::mounted();
+    if (const PackEntry* entry = pack ? pack->find(path) : nullptr) {
+        size = entry->size;
+        code.resize((size + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+        if (!pack->read(*entry, code.data())) return false;
+    } else {
+        std::ifstream file(path, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) {
+            LOG(Pipeline, Error, "Failed to open shader file: %s", path.c_str());
+            return false;
+        }
 
-    size_t size = static_cast<size_t>(file.tellg());
-    std::vector<uint32_t> code(size / sizeof(uint32_t));
-    file.seekg(0);
-    file.read(reinterpret_cast<char*>(code.data()), static_cast<std::streamsize>(size));
+        size = static_cast<size_t>(file.tellg());
+        code.resize(size / sizeof(uint32_t));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(code.data()), static_cast<std::streamsize>(size));
+    }
 
     VkShaderModuleCreateInfo ci{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
     ci.codeSize = size;
@@ -0,0 +1,488 @@
+#include "vulkan/UploadManager.h"
+#include "vulkan/VulkanContext.h"
+#include "vulkan/VulkanUtils.h"
+#include "vulkan/Image.h"
+#include "core/Log.h"
+#include <algorithm>
+#include <cstring>
+
+namespace lmao {
+
+namespace {
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VkSemaphore createTimeline(VkDevice device) {
+    VkSemaphoreTypeCreateInfo typeInfo{VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo ci{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    ci.pNext = &typeInfo;
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateSemaphore(device, &ci, nullptr, &semaphore));
+    return semaphore;
+}
+
+void submitWithTimeline(VkQueue queue, VkCommandBuffer cmd,
+                        VkSemaphore wait, uint64_t waitValue, VkPipelineStageFlags2 waitStage,
+                        VkSemaphore signal, uint64_t signalValue) {
+    VkCommandBufferSubmitInfo cmdInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO};
+    cmdInfo.commandBuffer = cmd;
+
+    VkSemaphoreSubmitInfo waitInfo{VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO};
+    waitInfo.semaphore = wait;
+    waitInfo.value = waitValue;
+    waitInfo.stageMask = waitStage;
+
+    VkSemaphoreSubmitInfo signalInfo{VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO};
+    signalInfo.semaphore = signal;
+    signalInfo.value = signalValue;
+    signalInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    VkSubmitInfo2 submit{VK_STRUCTURE_TYPE_SUBMIT_INFO_2};
+    submit.waitSemaphoreInfoCount = wait ? 1 : 0;
+    submit.pWaitSemaphoreInfos = &waitInfo;
+    submit.commandBufferInfoCount = 1;
+    submit.pCommandBufferInfos = &cmdInfo;
+    submit.signalSemaphoreInfoCount = 1;
+    submit.pSignalSemaphoreInfos = &signalInfo;
+    VK_CHECK(vkQueueSubmit2(queue, 1, &submit, VK_NULL_HANDLE));
+}
+
+void beginOneTime(VkCommandBuffer cmd) {
+    VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+}
+} // anonymous namespace
+
+UploadManager::~UploadManager() { shutdown(); }
+
+bool UploadManager::init(VulkanContext& ctx, VkDeviceSize stagingSize) {
+    m_device = ctx.device();
+    m_allocator = ctx.allocator();
+    m_graphicsQueue = ctx.graphicsQueue();
+    m_graphicsFamily = ctx.queueFamilies().graphics;
+    m_dedicatedTransfer = ctx.queueFamilies().transfer != UINT32_MAX;
+    m_transferQueue = m_dedicatedTransfer ? ctx.transferQueue() : m_graphicsQueue;
+    m_transferFamily = m_dedicatedTransfer ? ctx.queueFamilies().transfer : m_graphicsFamily;
+
+    if (!m_graphicsPool.init(m_device, m_graphicsFamily)) return false;
+    if (m_dedicatedTransfer && !m_transferPool.init(m_device, m_transferFamily)) return false;
+
+    m_stagingSize = stagingSize;
+    if (!m_staging.init(m_allocator, m_stagingSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_AUTO,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT))
+        return false;
+    m_head = m_tail = m_used = 0;
+
+    m_timeline = createTimeline(m_device);
+    if (m_dedicatedTransfer)
+        m_transferTimeline = createTimeline(m_device);
+    m_lastTicket = 0;
+
+    LOG(Vulkan, Debug, "Upload manager: %.0f MB staging ring, %s", m_stagingSize / (1024.0 * 1024.0),
+        m_dedicatedTransfer ? "dedicated transfer queue" : "graphics queue");
+    return true;
+}
+
+void UploadManager::shutdown() {
+    if (!m_device) return;
+    flush();
+
+    if (m_timeline) vkDestroySemaphore(m_device, m_timeline, nullptr);
+    if (m_transferTimeline) vkDestroySemaphore(m_device, m_transferTimeline, nullptr);
+    m_timeline = VK_NULL_HANDLE;
+    m_transferTimeline = VK_NULL_HANDLE;
+
+    m_staging.shutdown();
+    m_freeTransferCmds.clear();
+    m_freeGraphicsCmds.clear();
+    m_transferPool.shutdown();
+    m_graphicsPool.shutdown();
+    m_device = VK_NULL_HANDLE;
+}
+
+UploadManager::Batch& UploadManager::recording() {
+    if (m_recording) return *m_recording;
+
+    m_recording = std::make_unique<Batch>();
+    Batch& batch = *m_recording;
+    auto take = [](std::vector<VkCommandBuffer>& freeList, CommandPool& pool) {
+        if (freeList.empty()) return pool.allocate();
+        VkCommandBuffer cmd = freeList.back();
+        freeList.pop_back();
+        return cmd;
+    };
+
+    if (m_dedicatedTransfer) {
+        batch.transferCmd = take(m_freeTransferCmds, m_transferPool);
+        batch.graphicsCmd = take(m_freeGraphicsCmds, m_graphicsPool);
+    } else {
+        batch.transferCmd = batch.graphicsCmd = take(m_freeGraphicsCmds, m_graphicsPool);
+        batch.graphicsBegun = true;
+    }
+    beginOneTime(batch.transferCmd);
+    return batch;
+}
+
+void UploadManager::beginGraphics(Batch& batch) {
+    if (batch.graphicsBegun) return;
+    beginOneTime(batch.graphicsCmd);
+    batch.graphicsBegun = true;
+}
+
+bool UploadManager::tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset) {
+    if (m_used == 0) m_head = m_tail = 0;
+
+    VkDeviceSize aligned = alignUp(m_head, alignment);
+    VkDeviceSize consumed = 0;
+    if (m_used == 0 || m_head > m_tail) {
+        // Free space is [head, end) followed by [0, tail)
+        if (aligned + size <= m_stagingSize) {
+            offset = aligned;
+            consumed = aligned - m_head + size;
+        } else if (size <= m_tail) {
+            offset = 0;
+            consumed = m_stagingSize - m_head + size;
+        } else {
+            return false;
+        }
+    } else {
+        // Free space is [head, tail); empty when head == tail (ring full)
+        if (aligned + size > m_tail) return false;
+        offset = aligned;
+        consumed = aligned - m_head + size;
+    }
+
+    m_head = offset + size;
+    m_used += consumed;
+    Batch& batch = recording();
+    batch.ringBytes += consumed;
+    batch.ringEnd = m_head;
+    return true;
+}
+
+StagingAllocation UploadManager::stage(const void* data, VkDeviceSize size, VkDeviceSize alignment) {
+    StagingAllocation alloc;
+    if (size > m_stagingSize) {
+        // Larger than the whole ring: one-off staging buffer owned by the batch
+        Batch& batch = recording();
+        Buffer& overflow = batch.overflow.emplace_back();
+        overflow.init(m_allocator, size,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VMA_MEMORY_USAGE_AUTO,
+            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+        alloc.buffer = overflow.handle();
+        alloc.data = overflow.mapped();
+    } else {
+        VkDeviceSize offset = 0;
+        while (!tryAllocate(size, alignment, offset)) {
+            // Out of space: recycle the oldest batch, submitting our own if it is all there is
+            if (!retireOldest(true))
+                submit();
+        }
+        alloc.buffer = m_staging.handle();
+        alloc.offset = offset;
+        alloc.data = static_cast<uint8_t*>(m_staging.mapped()) + offset;
+    }
+
+    if (data)
+        std::memcpy(alloc.data, data, size);
+    return alloc;
+}
+
+StagingAllocation UploadManager::allocateStaging(VkDeviceSize size, VkDeviceSize alignment) {
+    return stage(nullptr, size, alignment);
+}
+
+void UploadManager::uploadBuffer(VkBuffer dst, const void* data, VkDeviceSize size, VkDeviceSize dstOffset) {
+    if (size == 0) return;
+    StagingAllocation src = stage(data, size, 16);
+    copyToBuffer(src, dst, dstOffset, size);
+}
+
+void UploadManager::copyToBuffer(const StagingAllocation& src, VkBuffer dst, VkDeviceSize dstOffset,
+                                 VkDeviceSize size) {
+    Batch& batch = recording();
+    VkBufferCopy copy{};
+    copy.srcOffset = src.offset;
+    copy.dstOffset = dstOffset;
+    copy.size = size;
+    vkCmdCopyBuffer(batch.transferCmd, src.buffer, dst, 1, &copy);
+    batch.hasWork = true;
+    batch.hasBufferWrites = true;
+
+    if (m_dedicatedTransfer) {
+        VkBufferMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2};
+        barrier.buffer = dst;
+        barrier.offset = dstOffset;
+        barrier.size = size;
+        releaseToGraphics(&barrier, nullptr);
+    }
+}
+
+void UploadManager::uploadImage(VkImage image, const void* data, VkDeviceSize size,
+                                uint32_t width, uint32_t height, uint32_t mipLevels) {
+    StagingAllocation src = stage(data, size, 16);
+    ImageUploadLevel level{0, width, height};
+    copyToImage(src, image, {&level, 1}, mipLevels);
+}
+
+void UploadManager::uploadImage(VkImage image, Buffer&& staging, uint32_t width, uint32_t height,
+                                uint32_t mipLevels) {
+    StagingAllocation src;
+    src.buffer = staging.handle();
+    src.data = staging.mapped();
+    recording().overflow.push_back(std::move(staging));
+    ImageUploadLevel level{0, width, height};
+    copyToImage(src, image, {&level, 1}, mipLevels);
+}
+
+void UploadManager::uploadImageLevels(VkImage image, const void* data, VkDeviceSize size,
+                                      std::span<const ImageUploadLevel> levels, uint32_t mipLevels) {
+    StagingAllocation src = stage(data, size, 16);
+    copyToImage(src, image, levels, std::max(mipLevels, static_cast<uint32_t>(levels.size())));
+}
+
+void UploadManager::uploadImageLevels(VkImage image, const StagingAllocation& src,
+                                      std::span<const ImageUploadLevel> levels, uint32_t mipLevels) {
+    copyToImage(src, image, levels, std::max(mipLevels, static_cast<uint32_t>(levels.size())));
+}
+
+void UploadManager::uploadImageLevels(VkImage image, Buffer&& staging, VkDeviceSize srcOffset,
+                                      std::span<const ImageUploadLevel> levels, uint32_t mipLevels) {
+    StagingAllocation src;
+    src.buffer = staging.handle();
+    src.offset = srcOffset;
+    src.data = static_cast<uint8_t*>(staging.mapped()) + srcOffset;
+    recording().overflow.push_back(std::move(staging));
+    uploadImageLevels(image, src, levels, mipLevels);
+}
+
+void UploadManager::copyToImage(const StagingAllocation& src, VkImage image,
+                                std::span<const ImageUploadLevel> levels, uint32_t mipLevels) {
+    Batch& batch = recording();
+
+    Image::transitionLayout(batch.transferCmd, image,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
+
+    std::vector<VkBufferImageCopy> regions(levels.size());
+    for (uint32_t i = 0; i < levels.size(); i++) {
+        regions[i].bufferOffset = src.offset + levels[i].offset;
+        regions[i].imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, i, 0, 1};
+        regions[i].imageExtent = {levels[i].width, levels[i].height, 1};
+    }
+    vkCmdCopyBufferToImage(batch.transferCmd, src.buffer, image,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+    batch.hasWork = true;
+
+    if (m_dedicatedTransfer) {
+        VkImageMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.image = image;
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1};
+        releaseToGraphics(nullptr, &barrier);
+    }
+}
+
+void UploadManager::updateImage(VkImage image, VkImageLayout layout, uint32_t mipLevels, uint32_t arrayLayers,
+                                const void* data, VkDeviceSize size, std::span<const ImageUploadRegion> regions) {
+    if (regions.empty()) return;
+    StagingAllocation src = stage(data, size, 16);
+    VkCommandBuffer cmd = graphicsCommands();
+
+    Image::transitionLayout(cmd, image, layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, arrayLayers);
+    std::vector<VkBufferImageCopy> copies(regions.size());
+    for (size_t i = 0; i < regions.size(); i++) {
+        const ImageUploadRegion& r = regions[i];
+        copies[i].bufferOffset = src.offset + r.offset;
+        copies[i].imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, r.mipLevel, r.arrayLayer, 1};
+        copies[i].imageOffset = {r.x, r.y, 0};
+        copies[i].imageExtent = {r.width, r.height, 1};
+    }
+    vkCmdCopyBufferToImage(cmd, src.buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        static_cast<uint32_t>(copies.size()), copies.data());
+    Image::transitionLayout(cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, layout,
+        VK_IMAGE_ASPECT_COLOR_BIT, mipLevels, arrayLayers);
+}
+
+// Queue family ownership transfer: the release half goes into the transfer command buffer,
+// the matching acquire into the graphics half of the same batch
+void UploadManager::releaseToGraphics(const VkBufferMemoryBarrier2* buffer, const VkImageMemoryBarrier2* image) {
+    Batch& batch = recording();
+    VkBufferMemoryBarrier2 bufferBarrier{};
+    VkImageMemoryBarrier2 imageBarrier{};
+    VkDependencyInfo dep{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+    if (buffer) {
+        bufferBarrier = *buffer;
+        dep.bufferMemoryBarrierCount = 1;
+        dep.pBufferMemoryBarriers = &bufferBarrier;
+    }
+    if (image) {
+        imageBarrier = *image;
+        dep.imageMemoryBarrierCount = 1;
+        dep.pImageMemoryBarriers = &imageBarrier;
+    }
+
+    auto setup = [&](auto& b, bool release) {
+        b.srcQueueFamilyIndex = m_transferFamily;
+        b.dstQueueFamilyIndex = m_graphicsFamily;
+        if (release) {
+            b.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+            b.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            b.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+            b.dstAccessMask = VK_ACCESS_2_NONE;
+        } else {
+            b.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+            b.srcAccessMask = VK_ACCESS_2_NONE;
+            b.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+            b.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+        }
+    };
+
+    setup(bufferBarrier, true);
+    setup(imageBarrier, true);
+    vkCmdPipelineBarrier2(batch.transferCmd, &dep);
+
+    beginGraphics(batch);
+    setup(bufferBarrier, false);
+    setup(imageBarrier, false);
+    vkCmdPipelineBarrier2(batch.graphicsCmd, &dep);
+}
+
+VkCommandBuffer UploadManager::graphicsCommands() {
+    Batch& batch = recording();
+    beginGraphics(batch);
+    batch.hasWork = true;
+    return batch.graphicsCmd;
+}
+
+void UploadManager::onComplete(std::function<void()> callback) {
+    recording().callbacks.push_back(std::move(callback));
+}
+
+UploadTicket UploadManager::submit() {
+    if (!m_recording) return m_lastTicket;
+
+    std::unique_ptr<Batch> batch = std::move(m_recording);
+    if (!batch->hasWork && batch->callbacks.empty() && batch->ringBytes == 0) {
+        // Nothing recorded: hand the command buffers back unsubmitted
+        vkEndCommandBuffer(batch->transferCmd);
+        if (batch->graphicsCmd != batch->transferCmd && batch->graphicsBegun)
+            vkEndCommandBuffer(batch->graphicsCmd);
+        retire(*batch);
+        return m_lastTicket;
+    }
+
+    // Make buffer writes visible to everything submitted after this batch. On the
+    // transfer-queue path the acquire barriers already did this.
+    if (!m_dedicatedTransfer && batch->hasBufferWrites) {
+        VkMemoryBarrier2 barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER_2};
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+        VkDependencyInfo dep{VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+        dep.memoryBarrierCount = 1;
+        dep.pMemoryBarriers = &barrier;
+        vkCmdPipelineBarrier2(batch->graphicsCmd, &dep);
+    }
+
+    // No-ops on host-coherent memory
+    if (batch->ringBytes > 0)
+        vmaFlushAllocation(m_allocator, m_staging.allocation(), 0, VK_WHOLE_SIZE);
+    for (auto& overflow : batch->overflow)
+        vmaFlushAllocation(m_allocator, overflow.allocation(), 0, VK_WHOLE_SIZE);
+
+    batch->ticket = ++m_lastTicket;
+    if (m_dedicatedTransfer) {
+        beginGraphics(*batch);
+        VK_CHECK(vkEndCommandBuffer(batch->transferCmd));
+        VK_CHECK(vkEndCommandBuffer(batch->graphicsCmd));
+        submitWithTimeline(m_transferQueue, batch->transferCmd, VK_NULL_HANDLE, 0, VK_PIPELINE_STAGE_2_NONE,
+                           m_transferTimeline, batch->ticket);
+        submitWithTimeline(m_graphicsQueue, batch->graphicsCmd, m_transferTimeline, batch->ticket,
+                           VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, m_timeline, batch->ticket);
+    } else {
+        VK_CHECK(vkEndCommandBuffer(batch->graphicsCmd));
+        submitWithTimeline(m_graphicsQueue, batch->graphicsCmd, VK_NULL_HANDLE, 0, VK_PIPELINE_STAGE_2_NONE,
+                           m_timeline, batch->ticket);
+    }
+
+    m_inFlight.push_back(std::move(batch));
+    return m_lastTicket;
+}
+
+bool UploadManager::isComplete(UploadTicket ticket) const {
+    if (ticket == 0) return true;
+    uint64_t value = 0;
+    VK_CHECK(vkGetSemaphoreCounterValue(m_device, m_timeline, &value));
+    return value >= ticket;
+}
+
+void UploadManager::wait(UploadTicket ticket) {
+    if (ticket == 0) return;
+    VkSemaphoreWaitInfo waitInfo{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &m_timeline;
+    waitInfo.pValues = &ticket;
+    VK_CHECK(vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX));
+    poll();
+}
+
+void UploadManager::flush() {
+    submit();
+    while (retireOldest(true)) {}
+}
+
+void UploadManager::poll() {
+    while (retireOldest(false)) {}
+}
+
+bool UploadManager::retireOldest(bool block) {
+    if (m_inFlight.empty()) return false;
+    Batch& oldest = *m_inFlight.front();
+    if (!isComplete(oldest.ticket)) {
+        if (!block) return false;
+        VkSemaphoreWaitInfo waitInfo{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &m_timeline;
+        waitInfo.pValues = &oldest.ticket;
+        VK_CHECK(vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX));
+    }
+
+    std::unique_ptr<Batch> batch = std::move(m_inFlight.front());
+    m_inFlight.pop_front();
+    retire(*batch);
+    return true;
+}
+
+void UploadManager::retire(Batch& batch) {
+    if (batch.ringBytes > 0) {
+        m_tail = batch.ringEnd;
+        m_used -= batch.ringBytes;
+    }
+    batch.overflow.clear();
+
+    VK_CHECK(vkResetCommandBuffer(batch.transferCmd, 0));
+    if (m_dedicatedTransfer) {
+        VK_CHECK(vkResetCommandBuffer(batch.graphicsCmd, 0));
+        m_freeTransferCmds.push_back(batch.transferCmd);
+        m_freeGraphicsCmds.push_back(batch.graphicsCmd);
+    } else {
+        m_freeGraphicsCmds.push_back(batch.graphicsCmd);
+    }
+
+    for (auto& callback : batch.callbacks)
+        callback();
+}
+
+} // namespace lmao
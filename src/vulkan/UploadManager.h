@@ -0,0 +1,179 @@
+#pragma once
+#include "vulkan/Buffer.h"
+#include "vulkan/CommandPool.h"
+#include <volk.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace lmao {
+
+class VulkanContext;
+
+// Timeline value of a submitted batch; 0 means "nothing to wait for"
+using UploadTicket = uint64_t;
+
+// One mip level of UploadManager::uploadImageLevels
+struct ImageUploadLevel {
+    VkDeviceSize offset = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+// One rectangle of UploadManager::updateImage
+struct ImageUploadRegion {
+    VkDeviceSize offset = 0;
+    uint32_t mipLevel = 0;
+    uint32_t arrayLayer = 0;
+    int32_t x = 0;
+    int32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+// Where a caller-filled staging range lives (see UploadManager::allocateStaging)
+struct StagingAllocation {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    void* data = nullptr;
+};
+
+// Batched, asynchronous resource uploads.
+//
+// Data is written into a persistently mapped staging ring and copies are recorded into
+// the current batch. submit() hands the batch to the GPU and returns a ticket; nothing
+// blocks until the ring is full. On devices with a transfer-only queue family the copies
+// run there and queue family ownership is released to the graphics queue, whose half of
+// the batch acquires it (and runs follow-up work such as mip generation). Completion is
+// tracked with a timeline semaphore signaled by that final graphics-queue submit, so any
+// later graphics submission already sees the data; tickets are only needed for CPU-side
+// bookkeeping (callbacks, freeing sources).
+//
+// Not thread-safe: record and submit from the thread that owns the graphics queue.
+class UploadManager {
+public:
+    static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 64ull * 1024 * 1024;
+
+    UploadManager() = default;
+    ~UploadManager();
+
+    UploadManager(const UploadManager&) = delete;
+    UploadManager& operator=(const UploadManager&) = delete;
+
+    bool init(VulkanContext& ctx, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+    void shutdown();
+
+    // Copies size bytes into dst at dstOffset
+    void uploadBuffer(VkBuffer dst, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+    // Copies tightly packed texels into mip 0 / layer 0. Every mip level is left in
+    // TRANSFER_DST_OPTIMAL and owned by the graphics queue; the caller finishes the image
+    // (mip generation, final layout) with graphicsCommands().
+    void uploadImage(VkImage image, const void* data, VkDeviceSize size,
+                     uint32_t width, uint32_t height, uint32_t mipLevels = 1);
+    // Same, from a caller-filled staging buffer (e.g. decoded into on a worker thread) that
+    // the batch adopts and frees once it completes: no copy through the ring
+    void uploadImage(VkImage image, Buffer&& staging, uint32_t width, uint32_t height, uint32_t mipLevels = 1);
+    // Copies a prebuilt mip chain in one staging range: level i holds mip i's texels (or
+    // blocks) at levels[i].offset inside data, which must suit the image format's block
+    // size. Leaves the image like uploadImage; mipLevels (0 = levels.size()) may cover
+    // more mips than are uploaded, for callers that fill the rest on the graphics queue.
+    void uploadImageLevels(VkImage image, const void* data, VkDeviceSize size,
+                           std::span<const ImageUploadLevel> levels, uint32_t mipLevels = 0);
+    // Same, from a range of caller-owned staging memory (e.g. file bytes read straight into
+    // a persistently mapped buffer): no copy through the ring. Leave src untouched until
+    // the batch completes (onComplete).
+    void uploadImageLevels(VkImage image, const StagingAllocation& src,
+                           std::span<const ImageUploadLevel> levels, uint32_t mipLevels = 0);
+    // Same, from a caller-filled staging buffer that the batch adopts and frees once it
+    // completes; the level offsets count from srcOffset
+    void uploadImageLevels(VkImage image, Buffer&& staging, VkDeviceSize srcOffset,
+                           std::span<const ImageUploadLevel> levels, uint32_t mipLevels = 0);
+
+    // Overwrites rectangles of an image that is already in use and keeps the rest of its
+    // contents: recorded on the graphics half of the batch (no ownership transfer), the
+    // image goes from layout to TRANSFER_DST_OPTIMAL for the copies and back.
+    void updateImage(VkImage image, VkImageLayout layout, uint32_t mipLevels, uint32_t arrayLayers,
+                     const void* data, VkDeviceSize size, std::span<const ImageUploadRegion> regions);
+
+    // Reserves staging space for the caller to fill (e.g. straight from a mapped file).
+    // Record the copy with copyToBuffer before reserving or uploading anything else: a full
+    // ring submits the current batch and may recycle unclaimed space.
+    StagingAllocation allocateStaging(VkDeviceSize size, VkDeviceSize alignment = 16);
+    void copyToBuffer(const StagingAllocation& src, VkBuffer dst, VkDeviceSize dstOffset, VkDeviceSize size);
+
+    // Graphics-queue command buffer of the current batch, ordered after every upload
+    // recorded so far
+    VkCommandBuffer graphicsCommands();
+
+    // Runs on the recording thread from poll()/wait() once the current batch completes
+    void onComplete(std::function<void()> callback);
+
+    // Submits the current batch. Returns its ticket, or the last ticket if it was empty.
+    UploadTicket submit();
+    bool isComplete(UploadTicket ticket) const;
+    void wait(UploadTicket ticket);
+    // Submits pending work and blocks until everything has completed
+    void flush();
+    // Retires completed batches: recycles staging space and fires callbacks
+    void poll();
+
+    bool usesTransferQueue() const { return m_dedicatedTransfer; }
+    VkDeviceSize stagingSize() const { return m_stagingSize; }
+
+private:
+    struct Batch {
+        VkCommandBuffer transferCmd = VK_NULL_HANDLE;
+        VkCommandBuffer graphicsCmd = VK_NULL_HANDLE;  // == transferCmd without a transfer queue
+        bool graphicsBegun = false;
+        bool hasWork = false;
+        bool hasBufferWrites = false;
+        UploadTicket ticket = 0;
+        VkDeviceSize ringEnd = 0;
+        VkDeviceSize ringBytes = 0;
+        std::vector<Buffer> overflow;   // one-off staging: uploads larger than the ring, adopted buffers
+        std::vector<std::function<void()>> callbacks;
+    };
+
+    Batch& recording();
+    void beginGraphics(Batch& batch);
+    bool tryAllocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+    StagingAllocation stage(const void* data, VkDeviceSize size, VkDeviceSize alignment);
+    void copyToImage(const StagingAllocation& src, VkImage image,
+                     std::span<const ImageUploadLevel> levels, uint32_t mipLevels);
+    void releaseToGraphics(const VkBufferMemoryBarrier2* buffer, const VkImageMemoryBarrier2* image);
+    void retire(Batch& batch);
+    bool retireOldest(bool block);
+
+    VkDevice m_device = VK_NULL_HANDLE;
+    VmaAllocator m_allocator = VK_NULL_HANDLE;
+    VkQueue m_graphicsQueue = VK_NULL_HANDLE;
+    VkQueue m_transferQueue = VK_NULL_HANDLE;
+    uint32_t m_graphicsFamily = 0;
+    uint32_t m_transferFamily = 0;
+    bool m_dedicatedTransfer = false;
+
+    CommandPool m_transferPool;
+    CommandPool m_graphicsPool;
+    std::vector<VkCommandBuffer> m_freeTransferCmds;
+    std::vector<VkCommandBuffer> m_freeGraphicsCmds;
+
+    // Ring: [m_tail, m_head) is in flight or recording, m_used counts wrap padding too
+    Buffer m_staging;
+    VkDeviceSize m_stagingSize = 0;
+    VkDeviceSize m_head = 0;
+    VkDeviceSize m_tail = 0;
+    VkDeviceSize m_used = 0;
+
+    // m_transferTimeline orders the two halves of a batch, m_timeline marks completion
+    VkSemaphore m_timeline = VK_NULL_HANDLE;
+    VkSemaphore m_transferTimeline = VK_NULL_HANDLE;
+    UploadTicket m_lastTicket = 0;
+
+    std::unique_ptr<Batch> m_recording;
+    std::deque<std::unique_ptr<Batch>> m_inFlight;
+};
+
+} // namespace lmao
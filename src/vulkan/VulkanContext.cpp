@@ -10,6 +10,7 @@
 #include <GLFW/glfw3.h>
 #include <cstring>
 #include <set>
+#include <string>
 #include <algorithm>
 
 namespace lmao {
@@ -62,9 +63,15 @@ bool VulkanContext::init(GLFWwindow* window) {
         VK_VERSION_MINOR(m_deviceProps.apiVersion),
         VK_VERSION_PATCH(m_deviceProps.apiVersion));
     LOG(Vulkan, Info, "  Ray tracing: %s", m_features.rayTracing ? "supported" : "not available");
+    LOG(Vulkan, Info, "  Draw indirect count: %s", m_features.drawIndirectCount ? "supported" : "not available");
+    LOG(Vulkan, Info, "  Vertex shader viewport index: %s", m_features.shaderOutputViewportIndex ? "supported" : "not available");
+    LOG(Vulkan, Info, "  BC texture compression: %s", m_features.textureCompressionBC ? "supported" : "not available");
+    LOG(Vulkan, Info, "  Fragment stores: %s", m_features.fragmentStoresAndAtomics ? "supported" : "not available");
     LOG(Vulkan, Debug, "  Graphics queue family: %u", m_queueFamilies.graphics);
     LOG(Vulkan, Debug, "  Present queue family: %u", m_queueFamilies.present);
     LOG(Vulkan, Debug, "  Compute queue family: %u", m_queueFamilies.compute);
+    LOG(Vulkan, Debug, "  Transfer queue family: %s",
+        m_queueFamilies.transfer != UINT32_MAX ? std::to_string(m_queueFamilies.transfer).c_str() : "none");
     return true;
 }
 
@@ -162,6 +169,17 @@ QueueFamilyIndices VulkanContext::findQueueFamilies(VkPhysicalDevice device) con
 
         if (indices.isComplete()) break;
     }
+
+    // Prefer a transfer-only family (copy engine), then any non-graphics one
+    for (uint32_t i = 0; i < count; i++) {
+        VkQueueFlags flags = families[i].queueFlags;
+        if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT)) continue;
+        if (!(flags & VK_QUEUE_COMPUTE_BIT)) {
+            indices.transfer = i;
+            break;
+        }
+        if (indices.transfer == UINT32_MAX) indices.transfer = i;
+    }
     return indices;
 }
 
@@ -232,6 +250,26 @@ bool VulkanContext::pickPhysicalDevice() {
         VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME
     });
 
+    // GPU-driven draws (meshlet culling) need indirect count + multi-draw; shadow draws
+    // pick their cascade through firstInstance
+    VkPhysicalDeviceVulkan12Features supported12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    VkPhysicalDeviceFeatures2 supported{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+    supported.pNext = &supported12;
+    vkGetPhysicalDeviceFeatures2(m_physicalDevice, &supported);
+    m_features.drawIndirectCount = supported12.drawIndirectCount && supported.features.multiDrawIndirect &&
+                                   supported.features.drawIndirectFirstInstance;
+
+    // Single-pass atlas shadows route instances to per-cascade viewports; without it the
+    // cascades are drawn one pass each
+    m_features.shaderOutputViewportIndex = supported12.shaderOutputViewportIndex && supported.features.multiViewport;
+
+    // Cooked textures are block compressed; without BC they are cooked to RGBA8 instead
+    m_features.textureCompressionBC = supported.features.textureCompressionBC == VK_TRUE;
+
+    // Virtual texture feedback is written from gbuffer.frag; without it the G-buffer pass
+    // uses gbuffer_no_feedback.frag and virtual texturing is off
+    m_features.fragmentStoresAndAtomics = supported.features.fragmentStoresAndAtomics == VK_TRUE;
+
     return true;
 }
 
@@ -241,6 +279,8 @@ bool VulkanContext::createLogicalDevice() {
     };
     if (m_queueFamilies.compute != UINT32_MAX)
         uniqueFamilies.insert(m_queueFamilies.compute);
+    if (m_queueFamilies.transfer != UINT32_MAX)
+        uniqueFamilies.insert(m_queueFamilies.transfer);
 
     float priority = 1.0f;
     std::vector<VkDeviceQueueCreateInfo> queueInfos;
@@ -262,13 +302,21 @@ bool VulkanContext::createLogicalDevice() {
 
     VkPhysicalDeviceVulkan12Features features12{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
     features12.pNext = &features13;
+    features12.shaderOutputViewportIndex = m_features.shaderOutputViewportIndex ? VK_TRUE : VK_FALSE;
     features12.bufferDeviceAddress = VK_TRUE;
     features12.descriptorIndexing = VK_TRUE;
+    features12.drawIndirectCount = m_features.drawIndirectCount ? VK_TRUE : VK_FALSE;
+    features12.timelineSemaphore = VK_TRUE;
 
     VkPhysicalDeviceFeatures2 features2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
     features2.pNext = &features12;
     features2.features.samplerAnisotropy = VK_TRUE;
     features2.features.fillModeNonSolid = VK_TRUE;
+    features2.features.fragmentStoresAndAtomics = m_features.fragmentStoresAndAtomics ? VK_TRUE : VK_FALSE;
+    features2.features.multiDrawIndirect = m_features.drawIndirectCount ? VK_TRUE : VK_FALSE;
+    features2.features.drawIndirectFirstInstance = m_features.drawIndirectCount ? VK_TRUE : VK_FALSE;
+    features2.features.multiViewport = m_features.shaderOutputViewportIndex ? VK_TRUE : VK_FALSE;
+    features2.features.textureCompressionBC = m_features.textureCompressionBC ? VK_TRUE : VK_FALSE;
 
     // Ray tracing features (optional)
     VkPhysicalDeviceAccelerationStructureFeaturesKHR accelFeatures{
@@ -310,6 +358,10 @@ bool VulkanContext::createLogicalDevice() {
         vkGetDeviceQueue(m_device, m_queueFamilies.compute, 0, &m_computeQueue);
     else
         m_computeQueue = m_graphicsQueue;
+    if (m_queueFamilies.transfer != UINT32_MAX)
+        vkGetDeviceQueue(m_device, m_queueFamilies.transfer, 0, &m_transferQueue);
+    else
+        m_transferQueue = m_graphicsQueue;
 
     return true;
 }
@@ -12,6 +12,7 @@ struct QueueFamilyIndices {
     uint32_t graphics = UINT32_MAX;
     uint32_t present = UINT32_MAX;
     uint32_t compute = UINT32_MAX;
+    uint32_t transfer = UINT32_MAX;  // transfer-capable family without graphics (DMA engine), if any
     bool isComplete() const {
         return graphics != UINT32_MAX && present != UINT32_MAX;
     }
@@ -21,6 +22,10 @@ struct DeviceFeatures {
     bool rayTracing = false;
     bool dynamicRendering = false;
     bool synchronization2 = false;
+    bool drawIndirectCount = false; // vkCmdDrawIndexedIndirectCount + multiDrawIndirect + firstInstance
+    bool shaderOutputViewportIndex = false; // gl_ViewportIndex from the vertex shader + multiViewport
+    bool textureCompressionBC = false;      // BC1-BC7 sampled images (cooked .ktx2 textures)
+    bool fragmentStoresAndAtomics = false;  // storage writes from fragment shaders (virtual texture feedback)
 };
 
 class VulkanContext {
@@ -43,6 +48,8 @@ public:
     VkQueue graphicsQueue() const { return m_graphicsQueue; }
     VkQueue presentQueue() const { return m_presentQueue; }
     VkQueue computeQueue() const { return m_computeQueue; }
+    // Falls back to the graphics queue when there is no separate transfer family
+    VkQueue transferQueue() const { return m_transferQueue; }
     const QueueFamilyIndices& queueFamilies() const { return m_queueFamilies; }
     const DeviceFeatures& features() const { return m_features; }
 
@@ -72,6 +79,7 @@ private:
     VkQueue m_graphicsQueue = VK_NULL_HANDLE;
     VkQueue m_presentQueue = VK_NULL_HANDLE;
     VkQueue m_computeQueue = VK_NULL_HANDLE;
+    VkQueue m_transferQueue = VK_NULL_HANDLE;
 
     QueueFamilyIndices m_queueFamilies;
     DeviceFeatures m_features;
@@ -0,0 +1,251 @@
+// Cooks source assets into the DerivedDataCache (assets/DerivedDataCache.h) on every core,
+// so the runtime loaders find them there instead of cooking on first use.
+//
+//   lmao_cook [options] <input>...
+//
+// An input is a file, a directory searched recursively for .obj and image files, or a
+// generated primitive "preset:<shape>[:<arg>,...]" as MeshPreset::parse reads it.
+//
+//   --ddc <directory>        cache root (default: ddc)
+//   --usage <usage>          albedo | normal | mask | grayscale for every texture; by default
+//                            it is guessed from the file name (_n, _normal, _orm, _mr, ...)
+//   --uncompressed           cook textures as RGBA8 / RG8 / R8 for devices without BC
+//   --vertex-format <format> standard | packed | packed-float (default: packed)
+//   --force                  cook again even when the cache already holds the entry
+#include "assets/DerivedDataCache.h"
+#include "assets/KtxFile.h"
+#include "assets/MeshFile.h"
+#include "assets/MeshGenerator.h"
+#include "assets/ModelImporter.h"
+#include "assets/TextureLoader.h"
+#include "core/ThreadPool.h"
+#include "core/Log.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace lmao;
+
+namespace {
+
+enum class InputKind { Texture, Model, Preset };
+
+struct CookJob {
+    InputKind kind;
+    std::string path;     // source file, or the preset text
+    MeshPreset preset;
+};
+
+struct CookSettings {
+    bool guessUsage = true;
+    TextureUsage usage = TextureUsage::Albedo;
+    bool compress = true;
+    MeshOptions mesh;
+    bool force = false;
+};
+
+std::string lowercase(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+bool classify(const std::filesystem::path& path, InputKind& kind) {
+    std::string ext = lowercase(path.extension().string());
+    if (ext == ".obj") {
+        kind = InputKind::Model;
+        return true;
+    }
+    if (ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".tga" || ext == ".bmp") {
+        kind = InputKind::Texture;
+        return true;
+    }
+    return false;
+}
+
+bool parseUsage(const char* text, TextureUsage& usage) {
+    static constexpr const char* NAMES[] = {"albedo", "normal", "mask", "grayscale"};
+    static_assert(std::size(NAMES) == static_cast<size_t>(TextureUsage::Count), "Must match TextureUsage");
+    for (size_t i = 0; i < std::size(NAMES); i++) {
+        if (std::strcmp(text, NAMES[i]) == 0) {
+            usage = static_cast<TextureUsage>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseVertexFormat(const char* text, VertexFormat& format) {
+    if (std::strcmp(text, "standard") == 0) format = VertexFormat::Standard;
+    else if (std::strcmp(text, "packed") == 0) format = VertexFormat::Packed;
+    else if (std::strcmp(text, "packed-float") == 0) format = VertexFormat::PackedFloatPosition;
+    else return false;
+    return true;
+}
+
+// The usual texture-set suffixes: albedo unless the name says otherwise
+TextureUsage guessUsage(const std::string& path) {
+    std::string stem = lowercase(std::filesystem::path(path).stem().string());
+    auto endsWith = [&](const char* suffix) { return stem.ends_with(suffix); };
+    if (endsWith("_n") || endsWith("_normal") || endsWith("_nrm")) return TextureUsage::Normal;
+    if (endsWith("_orm") || endsWith("_mr") || endsWith("_rough") || endsWith("_roughness") ||
+        endsWith("_metal") || endsWith("_metallic") || endsWith("_ao"))
+        return TextureUsage::Mask;
+    if (endsWith("_height") || endsWith("_disp") || endsWith("_mask")) return TextureUsage::Grayscale;
+    return TextureUsage::Albedo;
+}
+
+void addInput(const std::string& arg, std::vector<CookJob>& jobs) {
+    if (arg.starts_with("preset:")) {
+        CookJob job{InputKind::Preset, arg.substr(7), {}};
+        if (!MeshPreset::parse(job.path, job.preset)) {
+            LOG(Assets, Warn, "Skipping %s: not a mesh preset", arg.c_str());
+            return;
+        }
+        job.path = job.preset.toString();
+        jobs.push_back(std::move(job));
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::path path = arg;
+    InputKind kind;
+    if (std::filesystem::is_directory(path, ec)) {
+        for (const auto& file : std::filesystem::recursive_directory_iterator(path, ec)) {
+            if (file.is_regular_file() && classify(file.path(), kind))
+                jobs.push_back({kind, file.path().lexically_normal().generic_string(), {}});
+        }
+    } else if (std::filesystem::is_regular_file(path, ec) && classify(path, kind)) {
+        jobs.push_back({kind, path.lexically_normal().generic_string(), {}});
+    } else {
+        LOG(Assets, Warn, "Skipping %s: not an .obj, an image file or a directory", arg.c_str());
+    }
+}
+
+enum class CookResult { Cooked, Cached, Failed };
+
+bool isCached(const std::string& entry, bool force) {
+    std::error_code ec;
+    return !force && std::filesystem::exists(entry, ec);
+}
+
+// Same options, flags and writes as TextureLoader::loadCooked, ModelImporter::loadOBJ and
+// MeshGenerator::create on a cache miss, so the runtime takes these entries as its own
+CookResult cook(const CookJob& job, const CookSettings& settings) {
+    switch (job.kind) {
+    case InputKind::Texture: {
+        TextureCookOptions options;
+        options.usage = settings.guessUsage ? guessUsage(job.path) : settings.usage;
+        options.compress = settings.compress;
+        uint32_t flags = TextureCooker::cookFlags(options);
+        std::string entry = TextureLoader::cookedPath(job.path, flags);
+        if (entry.empty()) return CookResult::Failed;
+        if (isCached(entry, settings.force)) return CookResult::Cached;
+        CookedTexture cooked;
+        if (!TextureLoader::cookFile(job.path, options, cooked)) return CookResult::Failed;
+        return KtxFile::write(entry, cooked, flags) ? CookResult::Cooked : CookResult::Failed;
+    }
+    case InputKind::Model: {
+        std::string entry = ModelImporter::cookedPath(job.path, settings.mesh);
+        if (entry.empty()) return CookResult::Failed;
+        if (isCached(entry, settings.force)) return CookResult::Cached;
+        CookedMesh cooked;
+        if (!ModelImporter::cookOBJ(job.path, settings.mesh, cooked)) return CookResult::Failed;
+        MeshOptions written = settings.mesh;
+        written.splitForIndex16 = true;  // as cookOBJ cooks
+        return MeshFile::write(entry, cooked.data(), MeshFile::cookFlags(written)) ? CookResult::Cooked
+                                                                                   : CookResult::Failed;
+    }
+    case InputKind::Preset: {
+        std::string entry = MeshGenerator::cookedPath(job.preset, settings.mesh);
+        if (entry.empty()) return CookResult::Failed;
+        if (isCached(entry, settings.force)) return CookResult::Cached;
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        MeshGenerator::build(job.preset, vertices, indices);
+        CookedMesh cooked;
+        Mesh::cook(vertices, indices, settings.mesh, cooked);
+        return MeshFile::write(entry, cooked.data(), MeshFile::cookFlags(settings.mesh)) ? CookResult::Cooked
+                                                                                          : CookResult::Failed;
+    }
+    }
+    return CookResult::Failed;
+}
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+        "usage: %s [--ddc <directory>] [--usage albedo|normal|mask|grayscale] [--uncompressed]\n"
+        "       [--vertex-format standard|packed|packed-float] [--force] <file|directory|preset:<shape>[:<args>]>...\n",
+        program);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    CookSettings settings;
+    settings.mesh.vertexFormat = VertexFormat::Packed;  // what the demo scene loads with
+    std::vector<CookJob> jobs;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--ddc") == 0 && hasValue) {
+            DerivedDataCache::setRoot(argv[++i]);
+        } else if (std::strcmp(arg, "--usage") == 0 && hasValue) {
+            settings.guessUsage = false;
+            if (!parseUsage(argv[++i], settings.usage)) {
+                printUsage(argv[0]);
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--vertex-format") == 0 && hasValue) {
+            if (!parseVertexFormat(argv[++i], settings.mesh.vertexFormat)) {
+                printUsage(argv[0]);
+                return 2;
+            }
+        } else if (std::strcmp(arg, "--uncompressed") == 0) {
+            settings.compress = false;
+        } else if (std::strcmp(arg, "--force") == 0) {
+            settings.force = true;
+        } else if (arg[0] == '-' && arg[1] == '-') {
+            printUsage(argv[0]);
+            return 2;
+        } else {
+            addInput(arg, jobs);
+        }
+    }
+    if (jobs.empty() || DerivedDataCache::root().empty()) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    // A file named twice (or found under two input directories) is cooked once
+    std::sort(jobs.begin(), jobs.end(), [](const CookJob& a, const CookJob& b) {
+        return a.kind != b.kind ? a.kind < b.kind : a.path < b.path;
+    });
+    jobs.erase(std::unique(jobs.begin(), jobs.end(), [](const CookJob& a, const CookJob& b) {
+        return a.kind == b.kind && a.path == b.path;
+    }), jobs.end());
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<CookResult> results(jobs.size());
+    std::atomic<uint32_t> done{0};
+    ThreadPool::shared().parallelFor(static_cast<uint32_t>(jobs.size()), [&](uint32_t i) {
+        results[i] = cook(jobs[i], settings);
+        uint32_t finished = done.fetch_add(1) + 1;
+        const char* status = results[i] == CookResult::Cooked ? "cooked" : results[i] == CookResult::Cached ? "cached" : "FAILED";
+        LOG(Assets, Info, "[%u/%zu] %s %s", finished, jobs.size(), status, jobs[i].path.c_str());
+    });
+
+    uint32_t counts[3] = {};
+    for (CookResult result : results) counts[static_cast<uint32_t>(result)]++;
+    float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+    LOG(Assets, Info, "%u cooked, %u cached, %u failed in %.2f s on %u threads (%s)",
+        counts[0], counts[1], counts[2], seconds, ThreadPool::shared().threadCount(),
+        DerivedDataCache::root().c_str());
+    return counts[static_cast<uint32_t>(CookResult::Failed)] == 0 ? 0 : 1;
+}
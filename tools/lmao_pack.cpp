@@ -0,0 +1,41 @@
+// Builds a .lpak archive (assets/PackFile.h) from directory trees.
+//
+//   lmao_pack <output.lpak> <directory>=<prefix> [<directory>=<prefix>...]
+//
+// Every regular file under <directory> is stored as "<prefix>/<relative path>". Missing
+// directories are skipped, so a tree without assets/ still packs its shaders.
+#include "assets/PackFile.h"
+#include "core/Log.h"
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <output.lpak> <directory>=<prefix>...\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<lmao::PackInput> inputs;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.rfind('=');
+        std::filesystem::path dir = arg.substr(0, eq);
+        std::string prefix = eq == std::string::npos ? std::string() : arg.substr(eq + 1);
+
+        std::error_code ec;
+        if (!std::filesystem::is_directory(dir, ec)) {
+            LOG(Assets, Warn, "Skipping %s: not a directory", dir.string().c_str());
+            continue;
+        }
+        for (const auto& file : std::filesystem::recursive_directory_iterator(dir, ec)) {
+            if (!file.is_regular_file()) continue;
+            std::string name = std::filesystem::relative(file.path(), dir).generic_string();
+            if (!prefix.empty()) name = prefix + "/" + name;
+            inputs.push_back({name, file.path().string()});
+        }
+    }
+
+    return lmao::PackFile::write(argv[1], inputs) ? 0 : 1;
+}